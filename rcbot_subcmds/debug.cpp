@@ -852,6 +852,113 @@ CBotCommandInline DebugMstrOffsetSearch("mstr_offset_search", CMD_ACCESS_DEBUG,
 	return COMMAND_ACCESSED;
 }, "usage \"mstr_offset_search\" must be run on cp_dustbowl only");
 
+CBotCommandInline DebugReplayRecordCommand("replay_record", CMD_ACCESS_DEBUG, [](CClient *pClient, BotCommandArgs args)
+{
+	edict_t *pEntity = NULL;
+
+	NEED_ARG(args[0]);
+
+	if ( pClient )
+		pEntity = pClient->getPlayer();
+
+	if ( !CBotReplay::startRecording(args[0],pEntity) )
+		return COMMAND_ERROR;
+
+	return COMMAND_ACCESSED;
+}, "usage \"replay_record <name>\" : records bot inputs every tick for replay_run");
+
+CBotCommandInline DebugReplayStopCommand("replay_stop", CMD_ACCESS_DEBUG, [](CClient *pClient, BotCommandArgs args)
+{
+	edict_t *pEntity = NULL;
+
+	if ( pClient )
+		pEntity = pClient->getPlayer();
+
+	if ( !CBotReplay::isRecording() )
+	{
+		CBotGlobals::botMessage(pEntity,0,"not recording a replay");
+		return COMMAND_ERROR;
+	}
+
+	CBotReplay::stopRecording(pEntity);
+
+	return COMMAND_ACCESSED;
+}, "stops the replay being recorded");
+
+CBotCommandInline DebugReplayRunCommand("replay_run", CMD_ACCESS_DEBUG, [](CClient *pClient, BotCommandArgs args)
+{
+	edict_t *pEntity = NULL;
+
+	NEED_ARG(args[0]);
+
+	if ( pClient )
+		pEntity = pClient->getPlayer();
+
+	if ( !CBotReplay::replay(args[0],pEntity) )
+		return COMMAND_ERROR;
+
+	return COMMAND_ACCESSED;
+}, "usage \"replay_run <name>\" : replays a recording through the waypoint, visibility, route search and event decode stages and shows timings, needs a bot in game for route searches");
+
+CBotCommandInline DebugRouteStatsCommand("route_stats", CMD_ACCESS_DEBUG, [](CClient *pClient, BotCommandArgs args)
+{
+	edict_t *pEntity = NULL;
+
+	if ( pClient )
+		pEntity = pClient->getPlayer();
+
+	CBotRouteScheduler::printStats(pEntity);
+
+	return COMMAND_ACCESSED;
+}, "shows route scheduler queue latency and time spent per frame");
+
+CBotCommandInline DebugEventStatsCommand("event_stats", CMD_ACCESS_DEBUG, [](CClient *pClient, BotCommandArgs args)
+{
+	edict_t *pEntity = NULL;
+
+	if ( pClient )
+		pEntity = pClient->getPlayer();
+
+	CBotEventFanout::printStats(pEntity);
+
+	return COMMAND_ACCESSED;
+}, "shows how many bots each seen or heard game event was handed to");
+
+CBotCommandInline DebugWaypointBenchCommand("wpt_bench", CMD_ACCESS_DEBUG, [](CClient *pClient, BotCommandArgs args)
+{
+	if ( pClient && pClient->getDebugBot()!=NULL )
+	{
+		CBot *pBot = CBots::getBotPointer(pClient->getDebugBot());
+
+		if ( pBot && pBot->inUse() )
+		{
+			int iSearches = 100;
+
+			if ( args[0] && *args[0] )
+				iSearches = atoi(args[0]);
+
+			if ( iSearches > 10000 )
+				iSearches = 10000;
+
+			CWaypoints::benchmark(pBot,pClient->getPlayer(),iSearches);
+		}
+	}
+
+	return COMMAND_ACCESSED;
+}, "usage \"wpt_bench [searches]\" : set a debug bot first, times nearest waypoint, goal query and route searches between the first 64, 128, 256... used waypoints, then with the waypoint bitsets sized up to the waypoint limit");
+
+CBotCommandInline DebugDODAttackTableCommand("dod_attack_table", CMD_ACCESS_DEBUG, [](CClient *pClient, BotCommandArgs args)
+{
+	edict_t *pEntity = NULL;
+
+	if ( pClient )
+		pEntity = pClient->getPlayer();
+
+	CDODMod::generateAttackTable(pEntity);
+
+	return COMMAND_ACCESSED;
+}, "trains the DOD attack/defend net and prints CDODMod::fAttackProbLookUp to paste into bot_dod_mod.cpp");
+
 CBotSubcommands DebugSubcommands("debug", CMD_ACCESS_DEBUG | CMD_ACCESS_DEDICATED, {
 	&DebugGameEventCommand,
 	&DebugBotCommand,
@@ -881,4 +988,11 @@ CBotSubcommands DebugSubcommands("debug", CMD_ACCESS_DEBUG | CMD_ACCESS_DEDICATE
 	&DebugMemoryScanCommand,
 	&DebugMemoryCheckCommand,
 	&DebugMstrOffsetSearch,
+	&DebugReplayRecordCommand,
+	&DebugReplayStopCommand,
+	&DebugReplayRunCommand,
+	&DebugRouteStatsCommand,
+	&DebugEventStatsCommand,
+	&DebugWaypointBenchCommand,
+	&DebugDODAttackTableCommand,
 });
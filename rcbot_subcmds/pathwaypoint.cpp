@@ -238,6 +238,23 @@ CBotCommandInline PathWaypointRemoveFromToCommand("removefromto", CMD_ACCESS_WAY
 	return COMMAND_ERROR;
 });
 
+CBotCommandInline PathWaypointRepathCommand("repath", CMD_ACCESS_WAYPOINT, [](CClient *pClient, BotCommandArgs args)
+{
+	edict_t *pEntity = (pClient!=NULL) ? pClient->getPlayer() : NULL;
+	int iNumWaypoints = CWaypointAutoPath::addAll(pEntity);
+
+	// "now" does the whole map in one go rather than a bit each frame
+	if ( args[0] && *args[0] && (strcmp(args[0],"now") == 0) )
+	{
+		CWaypointAutoPath::workAll();
+		CBotGlobals::botMessage(pEntity,0,"Re-pathed %d waypoints",iNumWaypoints);
+	}
+	else
+		CBotGlobals::botMessage(pEntity,0,"Re-pathing %d waypoints, %u pairs to check",iNumWaypoints,CWaypointAutoPath::pending());
+
+	return COMMAND_ACCESSED;
+}, "adds any paths missing between nearby waypoints over the next frames, or all at once with \"now\"");
+
 CBotSubcommands PathWaypointSubcommands("pathwaypoint", CMD_ACCESS_WAYPOINT | CMD_ACCESS_DEDICATED, {
 	&PathWaypointOnCommand,
 	&PathWaypointOffCommand,
@@ -251,4 +268,5 @@ CBotSubcommands PathWaypointSubcommands("pathwaypoint", CMD_ACCESS_WAYPOINT | CM
 	&PathWaypointDeleteFromCommand,
 	&PathWaypointCreateFromToCommand,
 	&PathWaypointRemoveFromToCommand,
+	&PathWaypointRepathCommand,
 });
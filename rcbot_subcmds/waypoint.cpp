@@ -136,9 +136,10 @@ CBotCommandInline WaypointInfoCommand("info", 0, [](CClient *pClient, BotCommand
 
 CBotCommandInline WaypointSaveCommand("save", CMD_ACCESS_WAYPOINT, [](CClient *pClient, BotCommandArgs args)
 {
+	// the console's "waypoints saved" comes from the save worker once the file
+	// is written, it tells the player too if the write fails
 	if ( CWaypoints::save(false,(pClient!=NULL)?pClient->getPlayer():NULL,((args[0]!=NULL) && (*args[0]!=0))?args[0]:NULL,((args[1]!=NULL) && (*args[1]!=0))?args[1]:NULL) )
 	{
-		CBotGlobals::botMessage(NULL,0,"waypoints saved");
 		if ( pClient )
 			pClient->giveMessage("Waypoints Saved");
 	}
@@ -687,6 +688,18 @@ CBotCommandInline WaypointAutoFix("autofix", 0, [](CClient *pClient, BotCommandA
 	return COMMAND_ACCESSED;
 });
 
+CBotCommandInline WaypointLintCommand("lint", 0, [](CClient *pClient, BotCommandArgs args)
+{
+	int iTeam = 0;
+
+	if ( args[0] && *args[0] )
+		iTeam = atoi(args[0]);
+
+	CWaypointConnectivity::lint((pClient==NULL)?NULL:pClient->getPlayer(),iTeam);
+
+	return COMMAND_ACCESSED;
+}, "usage \"waypoint lint [team]\" : lists dead ends, one way traps and unreachable waypoints, team 0 ignores team only waypoints");
+
 CBotSubcommands WaypointSubcommands("waypoint", CMD_ACCESS_DEDICATED, {
 	&WaypointOnCommand,
 	&WaypointOffCommand,
@@ -711,6 +724,7 @@ CBotSubcommands WaypointSubcommands("waypoint", CMD_ACCESS_DEDICATED, {
 	&WaypointAreaSetToNearest,
 	&WaypointShowCommand,
 	&WaypointCheckCommand,
+	&WaypointLintCommand,
 	&WaypointShowVisCommand,
 	&WaypointAutoWaypointCommand,
 	&WaypointAutoFix
@@ -77,6 +77,8 @@
 
 #include "bot_getprop.h"
 #include "bot_profiling.h"
+#include "bot_replay.h"
+#include "bot_route_scheduler.h"
 
 #include <vector>
 #include <algorithm>
@@ -615,6 +617,11 @@ bool CBot :: isVisible ( edict_t *pEdict )
 	return m_pVisibles->isVisible(pEdict);
 }
 
+bool CBot :: isIndexVisible ( int iIndex )
+{
+	return m_pVisibles->isIndexVisible(iIndex);
+}
+
 bool CBot :: canAvoid ( edict_t *pEntity )
 {
 	float distance;
@@ -1329,6 +1336,8 @@ bool CBot :: recentlyHurt ( float fTime )
 
 void CBot :: spawnInit ()
 {
+	CBotRouteScheduler::cancel(this);
+
 	m_fLastHurtTime = 0.0f;
 	m_bWantToInvestigateSound = true;
 	m_fSpawnTime = engine->Time();
@@ -1516,7 +1525,7 @@ void CBot :: setup ()
 	/////////////////////////////////
 	m_pButtons = new CBotButtons();
 	/////////////////////////////////
-	m_pSchedules = new CBotSchedules();
+	m_pSchedules = new CBotSchedules(this);
 	/////////////////////////////////
 	m_pNavigator = new CWaypointNavigator(this);   
 	/////////////////////////////////
@@ -1832,6 +1841,7 @@ void CBot :: freeMapMemory ()
 	/////////////////////////////////
 	if ( m_pNavigator != NULL )
 	{
+		CBotRouteScheduler::cancel(this);
 		m_pNavigator->beliefSave(true);
 		m_pNavigator->freeMapMemory();
 		delete m_pNavigator;
@@ -3278,6 +3288,8 @@ void CBots :: botThink ()
 
 #endif
 
+	CBotReplay::recordFrame();
+
 	for ( short int i = 0; i < MAX_PLAYERS; i ++ )
 	{
 		pBot = m_Bots[i];
@@ -3307,6 +3319,8 @@ void CBots :: botThink ()
 					}
 
 				#endif
+
+				CBotReplay::recordBot(pBot);
 			}
 			if ( bot_command.GetString() && *bot_command.GetString() )
 			{
@@ -3319,6 +3333,9 @@ void CBots :: botThink ()
 		}
 	}
 
+	// route searches the bots asked for this frame
+	CBotRouteScheduler::think();
+
 #ifdef _DEBUG
 
 	if ( CClients::clientsDebugging(BOT_DEBUG_PROFILE) )
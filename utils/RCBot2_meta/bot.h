@@ -399,6 +399,8 @@ public:
 	bool FVisible ( edict_t *pEdict, bool bCheckHead = false );
 
 	bool isVisible ( edict_t *pEdict );
+	// iIndex is ENTINDEX-1, saves looking it up for every bot
+	bool isIndexVisible ( int iIndex );
 
 	inline void setEnemy ( edict_t *pEnemy )
 	{
@@ -1137,8 +1137,12 @@ void CClients::clientDebugMsg(CBot *pBot, int iLev, const char *fmt, ... )
 	va_list argptr; 
 	static char string[1024];
 
+	// don't format anything nobody is going to see
+	if ( !clientsDebugging(iLev) )
+		return;
+
 	va_start (argptr, fmt);
-	vsprintf (string, fmt, argptr); 
+	vsnprintf (string, sizeof(string), fmt, argptr); 
 	va_end (argptr); 
 
 	clientDebugMsg(iLev,string,pBot);
@@ -40,11 +40,16 @@
 #include "bot_waypoint_locations.h" // for waypoint commands
 #include "ndebugoverlay.h"
 #include "bot_waypoint_visibility.h"
+#include "bot_waypoint_connectivity.h"
+#include "bot_waypoint_autopath.h"
 #include "bot_getprop.h"
 #include "bot_weapons.h"
 #include "bot_menu.h"
 
 #include "bot_tf2_points.h"
+#include "bot_replay.h"
+#include "bot_route_scheduler.h"
+#include "bot_event_fanout.h"
 
 extern IVDebugOverlay *debugoverlay;
 
@@ -85,6 +85,17 @@ ConVar rcbot_bot_squads_percent("rcbot_bot_squads_percent","50",0,"the percentag
 ConVar rcbot_tooltips("rcbot_tooltips","1",0,"Enables/disables help tooltips");
 ConVar rcbot_debug_notasks("rcbot_debug_notasks","0",0,"Debug command, stops bots from doing tasks by themselves");
 ConVar rcbot_debug_dont_shoot("rcbot_debug_dont_shoot","0",0,"Debug command, stops bots from shooting everyone");
+ConVar rcbot_influence_time("rcbot_influence_time","1.0",0,"Seconds between updates of the sentry/sniper/teammate influence used for bot goals and routes, 0 to disable");
+ConVar rcbot_route_budget("rcbot_route_budget","2000",0,"Microseconds per frame shared by all bots for route searches, 0 lets each bot search on its own every think");
+ConVar rcbot_nav_flow("rcbot_nav_flow","1",0,"Bots heading for an objective follow their team's flow field to it instead of searching for a route");
+ConVar rcbot_nav_areas("rcbot_nav_areas","1",0,"Plan routes between waypoint areas first and only search the waypoints in the areas on the way");
+ConVar rcbot_nav_connectivity("rcbot_nav_connectivity","1",0,"Refuse route searches to goals the bot's team has no waypoint paths to");
+ConVar rcbot_autopath_budget("rcbot_autopath_budget","1000",0,"Microseconds per frame for finding paths between new waypoints, 0 paths them straight away");
+ConVar rcbot_wpt_draw_budget("rcbot_wpt_draw_budget","96",0,"Most waypoints and path beams drawn a frame, shared by everyone editing waypoints, 0 for no limit. A waypoint is a few overlays, more with its info shown");
+ConVar rcbot_log_level("rcbot_log_level","2",0,"Most detailed bot messages printed to the server console, 0 errors, 1 warnings, 2 info, 3 debug");
+ConVar rcbot_log_categories("rcbot_log_categories","-1",0,"Bits of the kinds of bot message printed to the server console, 1 general, 2 config files");
+ConVar rcbot_log_rate("rcbot_log_rate","20",0,"Most lines a second printed from any one place in the bot code, 0 for no limit");
+ConVar rcbot_nav_repair("rcbot_nav_repair","1",0,"After a failed move, search only for a way back onto the rest of the old route if it is still usable");
 ConVar rcbot_debug_show_route("rcbot_debug_show_route","0",0,"Debug command, shows waypoint route to host");
 ConVar rcbot_tf2_autoupdate_point_time("rcbot_tf2_autoupdate_point_time","60",0,"Time to automatically update points in TF2 for any changes");
 ConVar rcbot_tf2_payload_dist_retreat("rcbot_tf2_payload_dist_retreat","512.0",0,"Distance for payload bomb to be greater than at cap before defend team retreats");
@@ -95,6 +106,8 @@ ConVar rcbot_gamerules_offset("rcbot_gamerules_offset", "5", 0, "offset for game
 ConVar rcbot_bot_quota_interval("rcbot_bot_quota_interval", "10", 0, "Interval between bot quota checks, 0 or lower to disable");
 ConVar rcbot_show_welcome_msg("rcbot_show_welcome_msg", "1", 0, "Show welcome message on player connect");
 ConVar rcbot_force_class("rcbot_force_class", "0", 0, "Force bots to choose specified class, kills alive bots on change (1 - 9, set to 0 for none)");
+ConVar rcbot_propcache("rcbot_propcache", "1", 0, "Read team, flags, class, velocity and building props of players and buildings once per frame, 0 to read them live");
+ConVar rcbot_tracecache("rcbot_tracecache", "1", 0, "Share world visibility traces with the same start and end within a frame, 0 to disable");
 
 ConVarRef sv_gravity("sv_gravity");
 ConVarRef mp_teamplay("mp_teamplay");
@@ -94,6 +94,19 @@ extern ConVar rcbot_const_point_master_offset;
 /** Additional convars by pongo1231 **/
 extern ConVar rcbot_show_welcome_msg;
 extern ConVar rcbot_force_class;
+extern ConVar rcbot_tracecache;
+extern ConVar rcbot_propcache;
+extern ConVar rcbot_nav_repair;
+extern ConVar rcbot_nav_connectivity;
+extern ConVar rcbot_nav_areas;
+extern ConVar rcbot_nav_flow;
+extern ConVar rcbot_route_budget;
+extern ConVar rcbot_autopath_budget;
+extern ConVar rcbot_influence_time;
+extern ConVar rcbot_wpt_draw_budget;
+extern ConVar rcbot_log_level;
+extern ConVar rcbot_log_categories;
+extern ConVar rcbot_log_rate;
 
 extern ConVarRef sv_gravity;
 extern ConVarRef mp_teamplay;
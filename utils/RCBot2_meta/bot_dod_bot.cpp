@@ -47,6 +47,7 @@
 #include "bot_navigator.h"
 #include "bot_perceptron.h"
 #include "bot_waypoint_visibility.h"
+#include "bot_waypoint_indirect.h"
 
 const char *g_DODClassCmd[2][6] = 
 { {"cls_garand","cls_tommy","cls_bar","cls_spring","cls_30cal","cls_bazooka"},
@@ -186,7 +187,6 @@ bool CDODBot :: setVisible ( edict_t *pEntity, bool bVisible )
 	static const char *szClassname;
 	static bool bNoDraw;
 	static bool bValid;
-	static float fSmokeTime;
 
 	static bool bFriendlyFire;
 
@@ -250,41 +250,9 @@ bool CDODBot :: setVisible ( edict_t *pEntity, bool bVisible )
 		NULLIFY_VISIBLE(m_pNearestWeapon,pEntity,CWaypointLocations::REACHABLE_RANGE);
 	}
 
-	if ( !bNoDraw && (pEntity != m_pNearestSmokeToEnemy) && (strncmp(szClassname,"grenade_smoke",13) == 0) )
-	{
-		fSmokeTime = gpGlobals->curtime - CClassInterface::getSmokeSpawnTime(pEntity);
-
-		if ( (fSmokeTime >= 1.0f) && (fSmokeTime <= 10.0f) )
-		{
-			if ( !m_pNearestSmokeToEnemy )
-			{
-				m_pNearestSmokeToEnemy = pEntity;
-			}
-			else if ( m_pEnemy && hasSomeConditions(CONDITION_SEE_CUR_ENEMY) )
-			{
-				if ( (distanceFrom(pEntity) < distanceFrom(m_pNearestSmokeToEnemy)) || 
-					(distanceFrom(pEntity) < (distanceFrom(m_pEnemy)+SMOKE_RADIUS)) )
-				{
-					// math time - good lord!
-					// choose the best smoke that is worthwhile for checking enemy
-					if ( m_pNearestSmokeToEnemy && (fabs(DotProductFromOrigin(CBotGlobals::entityOrigin(pEntity))-
-							  DotProductFromOrigin(CBotGlobals::entityOrigin(m_pEnemy))) <=
-						 fabs(DotProductFromOrigin(CBotGlobals::entityOrigin(m_pNearestSmokeToEnemy))-
-							  DotProductFromOrigin(CBotGlobals::entityOrigin(m_pEnemy)))) )
-					{
-						m_pNearestSmokeToEnemy = pEntity;
-					}
-				}
-			}
-		}
-	}
-	else if ( pEntity == m_pNearestSmokeToEnemy )
-	{
-		fSmokeTime = gpGlobals->curtime - CClassInterface::getSmokeSpawnTime(pEntity);
-
-		if ( bNoDraw || ((fSmokeTime < 1.0f) || (fSmokeTime > rcbot_smoke_time.GetFloat())) )
-			m_pNearestSmokeToEnemy = NULL;
-	}
+	// tell everyone else about it before the smoke scan gets there
+	if ( bValid && !bNoDraw && (strncmp(szClassname,"grenade_smoke",13) == 0) )
+		CDODMod::m_Smokes.add(pEntity);
 
 	return bValid;
 }
@@ -839,9 +807,9 @@ bool CDODBot :: isEnemy ( edict_t *pEdict,bool bCheckWeapons )
 		// if true continue down -- don't return
 	}
 
-	if ( bCheckWeapons && m_pNearestSmokeToEnemy )
+	if ( bCheckWeapons && (CDODMod::m_Smokes.numThick() > 0) )
 	{
-		if ( !isVisibleThroughSmoke(m_pNearestSmokeToEnemy,pEdict) )
+		if ( !isVisibleThroughSmoke(pEdict) )
 			return false;
 	}
 
@@ -2610,6 +2578,19 @@ bool CDODBot :: executeAction ( CBotUtility *util )
 				CBotWeapon *pWeapon = util->getWeaponChoice();
 				CBotSchedule *pSched = new CBotSchedule();
 				CFindPathTask *pathtask = new CFindPathTask(pWaypoint->getOrigin());
+				int iTarget = CWaypointLocations::NearestWaypoint(m_vLastSeeEnemyBlastWaypoint,BLAST_RADIUS,-1,true,true);
+				int iLaunch, iAim;
+				float fLift;
+
+				// a hidden launch spot close by : throw from there instead
+				if ( CWaypointIndirectFire::getSpot(iTarget,INDIRECT_GRENADE,this,getOrigin(),&iLaunch,&iAim,&fLift) &&
+					(CWaypoints::getWaypoint(iLaunch)->distanceFrom(getOrigin()) < CWaypointLocations::REACHABLE_RANGE) )
+				{
+					CFindPathTask *launchtask = new CFindPathTask(iLaunch);
+
+					pSched->addTask(launchtask);
+					launchtask->setNoInterruptions();
+				}
 
 				pSched->addTask(new CThrowGrenadeTask(pWeapon,getAmmo(pWeapon->getWeaponInfo()->getAmmoIndex1()),m_vLastSeeEnemyBlastWaypoint)); // first - throw
 				pSched->addTask(pathtask); // 2nd -- hide
@@ -3466,7 +3447,7 @@ void CDODBot :: modAim ( edict_t *pEntity, Vector &v_origin,
 	}
 
 	// if I know the enemy is near a smoke grenade i'll fire randomly into the cloud
-	if ( m_pNearestSmokeToEnemy )
+	if ( CDODMod::m_Smokes.numThick() > 0 )
 	{
 		iSlot = ENTINDEX(pEntity)-1;
 
@@ -3485,19 +3466,10 @@ void CDODBot :: modAim ( edict_t *pEntity, Vector &v_origin,
 	//return vAim;
 }
 
-bool CDODBot :: isVisibleThroughSmoke ( edict_t *pSmoke, edict_t *pCheck )
+bool CDODBot :: isVisibleThroughSmoke ( edict_t *pCheck )
 {
-	//if ( isVisible(pCheck) )
-//{
-	static float fSmokeDist,fDist;
-	static smoke_t *smokeinfo;
-	static float fTime, fProb;
-	static Vector vSmoke;
-	static Vector vCheckComp;
-
-	static short int iSlot;
-
-	iSlot = ENTINDEX(pCheck)-1;
+	smoke_t *smokeinfo;
+	int iSlot = ENTINDEX(pCheck)-1;
 
 	// if pCheck is a player
 	if (( iSlot >= 0 ) && ( iSlot < MAX_PLAYERS ))
@@ -3507,55 +3479,27 @@ bool CDODBot :: isVisibleThroughSmoke ( edict_t *pSmoke, edict_t *pCheck )
 		// last time i checked was long enough ago
 		if ( smokeinfo->fLastTime < engine->Time() )
 		{
-			smokeinfo->bVisible = true;
-			smokeinfo->bInSmoke = false;
-
-				vSmoke = CBotGlobals::entityOrigin(pSmoke);
-				fSmokeDist = distanceFrom(vSmoke);
+			// smoke between my eyes and the player, or around either of us
+			smokeinfo->fProb = CDODMod::m_Smokes.getDensity(getEyePosition(),CBotGlobals::entityOrigin(pCheck));
+			smokeinfo->bInSmoke = (smokeinfo->fProb > 0);
 
-				// I'm outside smoke -- but maybe the enemy is inside the smoke
-				if ( fSmokeDist > SMOKE_RADIUS )
-				{
-					fDist = (CBotGlobals::entityOrigin(pCheck) - vSmoke).Length();
-
-					// enemy outside the smoke radius
-					if ( fDist > SMOKE_RADIUS )
-					{
-						// check if enemy is behind the smoke from my perspective
-						vCheckComp = CBotGlobals::entityOrigin(pCheck) - getOrigin();
-						vCheckComp = (vCheckComp / vCheckComp.Length())*fSmokeDist;
-
-						fDist = (vSmoke - (getOrigin() + vCheckComp)).Length();
-					}
-				}
-				else
-					fDist = fSmokeDist;
+			if ( smokeinfo->bInSmoke ) 
+				// smoke gets pretty heavy half way into the smoke grenade
+				smokeinfo->bVisible = (randomFloat(0.0f,0.33f) > smokeinfo->fProb );
+			else
+				smokeinfo->bVisible = true;
 
-				if ( fDist <= SMOKE_RADIUS ) 
-					// smoke gets heavy at 1.0 seconds and diminishes at 10 secs
-				{
-					smokeinfo->fProb = 1.0f-(fDist/SMOKE_RADIUS);
-					smokeinfo->bVisible = (randomFloat(0.0f,0.33f) > smokeinfo->fProb ); 
-					// smoke gets pretty heavy half way into the smoke grenade
-					smokeinfo->bInSmoke = true;
-				}
-				
 			#ifdef _DEBUG
 				if ( CClients::clientsDebugging(BOT_DEBUG_THINK) )
 					CClients::clientDebugMsg(this,BOT_DEBUG_THINK,"Smoke Test (%s to %s) = %s",m_szBotName,engine->GetPlayerNetworkIDString(pCheck),smokeinfo->bVisible ? "visible" : "invisible");
 			#endif
 
+			// check again soon (typical reaction time delay)
+			smokeinfo->fLastTime = engine->Time() + randomFloat(0.15f,0.3f);
 		}
 
-		// check again soon (typical reaction time delay)
-		smokeinfo->fLastTime = engine->Time() + randomFloat(0.15f,0.3f);
-
 		return smokeinfo->bVisible;
-
 	}
 
 	return true;
-//}
-
-	//return false;
 }
@@ -208,7 +208,7 @@ public:
 	void seeFriendlyDie ( edict_t *pDied, edict_t *pKiller, CWeapon *pKillerWeapon );
 	void seeFriendlyKill ( edict_t *pTeamMate, edict_t *pDied, CWeapon *pWeapon );
 
-	bool isVisibleThroughSmoke ( edict_t *pSmoke, edict_t *pCheck );
+	bool isVisibleThroughSmoke ( edict_t *pCheck );
 
 	void grenadeThrown () { addVoiceCommand(DOD_VC_FIRE_IN_THE_HOLE); }
 
@@ -270,7 +270,6 @@ private:
 	MyEHandle m_pEnemyGrenade;
 	float m_fShoutGrenade;
 	MyEHandle m_pOwnGrenade;
-	MyEHandle m_pNearestSmokeToEnemy;
 
 	float m_fChangeClassTime;
 	bool m_bCheckClass;
@@ -31,6 +31,7 @@
 #include "server_class.h"
 
 #include "bot.h"
+#include "bot_cvars.h"
 
 #include "in_buttons.h"
 
@@ -43,10 +44,12 @@
 #include "bot_navigator.h"
 #include "bot_waypoint.h"
 #include "bot_waypoint_locations.h"
+#include "bot_waypoint_flow.h"
 #include "bot_perceptron.h"
 
 edict_t *CDODMod::m_pResourceEntity = NULL;
 CDODFlags CDODMod::m_Flags;
+CDODSmokes CDODMod::m_Smokes;
 edict_t * CDODMod::m_pPlayerResourceEntity = NULL;
 float CDODMod::m_fMapStartTime = 0.0f;
 edict_t * CDODMod::m_pGameRules = NULL;
@@ -55,7 +58,21 @@ bool CDODMod::m_bCommunalBombPoint = false;
 int CDODMod::m_iBombAreaAllies = 0;
 int CDODMod::m_iBombAreaAxis = 0;
 //CPerceptron *CDODMod::gNetAttackOrDefend = NULL;
-float CDODMod::fAttackProbLookUp[MAX_DOD_FLAGS+1][MAX_DOD_FLAGS+1];
+// probability of attacking, indexed by [enemy flags][team flags] out of MAX_DOD_FLAGS
+// generated by CDODMod::generateAttackTable ("rcbot debug dod_attack_table"),
+// paste its output here if the net or its training set changes
+const float CDODMod::fAttackProbLookUp[MAX_DOD_FLAGS+1][MAX_DOD_FLAGS+1] =
+{
+	{ 0.9452f, 0.9464f, 0.9473f, 0.9479f, 0.9483f, 0.9485f, 0.9485f, 0.9482f, 0.9477f },
+	{ 0.9206f, 0.9231f, 0.9251f, 0.9265f, 0.9274f, 0.9279f, 0.9280f, 0.9276f, 0.9268f },
+	{ 0.8666f, 0.8721f, 0.8764f, 0.8797f, 0.8820f, 0.8833f, 0.8838f, 0.8835f, 0.8823f },
+	{ 0.7500f, 0.7607f, 0.7695f, 0.7765f, 0.7817f, 0.7852f, 0.7871f, 0.7874f, 0.7862f },
+	{ 0.5532f, 0.5667f, 0.5785f, 0.5885f, 0.5967f, 0.6031f, 0.6074f, 0.6099f, 0.6104f },
+	{ 0.3530f, 0.3613f, 0.3693f, 0.3766f, 0.3833f, 0.3891f, 0.3941f, 0.3980f, 0.4009f },
+	{ 0.2310f, 0.2338f, 0.2368f, 0.2398f, 0.2428f, 0.2459f, 0.2489f, 0.2518f, 0.2547f },
+	{ 0.1743f, 0.1748f, 0.1755f, 0.1764f, 0.1775f, 0.1787f, 0.1801f, 0.1816f, 0.1833f },
+	{ 0.1495f, 0.1494f, 0.1495f, 0.1497f, 0.1500f, 0.1505f, 0.1510f, 0.1518f, 0.1526f }
+};
 std::vector<edict_wpt_pair_t> CDODMod::m_BombWaypoints;
 std::vector<edict_wpt_pair_t> CDODMod::m_BreakableWaypoints;
 
@@ -116,15 +133,18 @@ bool CDODMod :: shouldAttack ( int iTeam )
 
 	return randomFloat(0.0,1.0) < fAttackProbLookUp[iFlags_0][iFlags_1];//gNetAttackOrDefend->getOutput();
 }
-////////////////////////////////////////////////
-void CDODMod :: initMod ()
-{
-///-------------------------------------------------
-	CBotGlobals::botMessage(NULL,0,"Training DOD:S capture decision 'NN' ... hold on...");
 
+// the net used to be trained on every map load, it only depends on its training set
+void CDODMod :: generateAttackTable ( edict_t *pPrintTo )
+{
+	const unsigned short int iNumRows = (MAX_DOD_FLAGS+1)*(MAX_DOD_FLAGS+1);
 	CBotNeuralNet *nn = new CBotNeuralNet(2,2,2,1,0.4f);
-
 	CTrainingSet *tset = new CTrainingSet(2,1,4);
+	CTrainingSet *rows = new CTrainingSet(2,1,iNumRows);
+	ga_nn_value inputs[iNumRows*2];
+	ga_nn_value outputs[iNumRows];
+	float fMaxDiff = 0.0f;
+	char line[256];
 
 	tset->setScale(0.0,1.0);
 
@@ -137,7 +157,7 @@ void CDODMod :: initMod ()
 	tset->in(4.0/5); // E - enemy flag ratio
 	tset->in(1.0/5); // T - team flag ratio
 	tset->out(0.2f); // probability of attack (mostly defend)
-	
+
 	tset->addSet();
 	tset->in(1.0/5); // E - enemy flag ratio
 	tset->in(4.0/5); // T - team flag ratio
@@ -150,26 +170,63 @@ void CDODMod :: initMod ()
 
 	nn->batch_train(tset,1000);
 
-	// create look up table for probabilities
+	// every [enemy][team] entry in one batch, scaled the same as the training set
+	rows->setScale(0.0,1.0);
+
 	for ( short int i = 0; i <= MAX_DOD_FLAGS; i ++ )
 	{
 		for ( short int j = 0; j <= MAX_DOD_FLAGS; j ++ )
 		{
-			tset->init();
-			tset->addSet();
-			tset->in(((float)i) / MAX_DOD_FLAGS);
-			tset->in(((float)j) / MAX_DOD_FLAGS);
-			nn->execute(tset->getBatches()->in,&(fAttackProbLookUp[i][j]),0.0f,1.0f);
+			rows->addSet();
+			rows->in(((float)i) / MAX_DOD_FLAGS);
+			rows->in(((float)j) / MAX_DOD_FLAGS);
 		}
 	}
 
+	for ( unsigned short int r = 0; r < iNumRows; r ++ )
+	{
+		inputs[r*2] = rows->getBatches()[r].in[0];
+		inputs[r*2+1] = rows->getBatches()[r].in[1];
+	}
+
+	nn->executeBatch(inputs,outputs,iNumRows,0.0f,1.0f);
+
+	CBotGlobals::botMessage(pPrintTo,0,"const float CDODMod::fAttackProbLookUp[MAX_DOD_FLAGS+1][MAX_DOD_FLAGS+1] =");
+	CBotGlobals::botMessage(pPrintTo,0,"{");
+
+	for ( short int i = 0; i <= MAX_DOD_FLAGS; i ++ )
+	{
+		int len = sprintf(line,"\t{ ");
+
+		for ( short int j = 0; j <= MAX_DOD_FLAGS; j ++ )
+		{
+			float fProb = outputs[i*(MAX_DOD_FLAGS+1)+j];
+
+			len += sprintf(&line[len],"%0.4ff%s",fProb,(j < MAX_DOD_FLAGS) ? ", " : " }");
+
+			if ( fabs(fProb - fAttackProbLookUp[i][j]) > fMaxDiff )
+				fMaxDiff = fabs(fProb - fAttackProbLookUp[i][j]);
+		}
+
+		if ( i < MAX_DOD_FLAGS )
+			strcat(line,",");
+
+		CBotGlobals::botMessage(pPrintTo,0,"%s",line);
+	}
+
+	CBotGlobals::botMessage(pPrintTo,0,"};");
+	// the starting weights are random so small differences are expected
+	CBotGlobals::botMessage(pPrintTo,0,"largest difference from the table in use: %0.4f",fMaxDiff);
+
+	rows->freeMemory();
 	tset->freeMemory();
+	delete rows;
 	delete tset;
 	delete nn;
-
-	CBotGlobals::botMessage(NULL,0,"... done!");
-///-------------------------------------------------
-
+}
+////////////////////////////////////////////////
+void CDODMod :: initMod ()
+{
 	CWeapons::loadWeapons((m_szWeaponListName == NULL) ? "DOD" : m_szWeaponListName, DODWeaps);
 	//CWeapons::loadWeapons("DOD", DODWeaps);
 	/*
@@ -187,6 +244,7 @@ void CDODMod :: mapInit ()
 	m_pGameRules = NULL;
 	m_pPlayerResourceEntity = NULL;
 	m_Flags.init();
+	m_Smokes.reset();
 	m_fMapStartTime = engine->Time();
 	m_iMapType = DOD_MAPTYPE_UNKNOWN;
 	m_bCommunalBombPoint = false;
@@ -311,6 +369,35 @@ bool CDODFlags::isTeamMatePlanting ( edict_t *pIgnore, int iTeam, int id )
 	return false;
 }
 
+void CDODFlags::updateFlowFields ()
+{
+	CWaypointBits goals;
+
+	for ( int iTeam = TEAM_ALLIES; iTeam <= TEAM_AXIS; iTeam ++ )
+	{
+		goals.clear();
+
+		for ( short int i = 0; i < m_iNumControlPoints; i ++ )
+		{
+			if ( m_iWaypoint[i] == -1 )
+				continue;
+
+			// enemy flags this team can't capture
+			if ( m_pFlags[i] && m_iOwner && (m_iOwner[i] != iTeam) )
+			{
+				if ( (iTeam == TEAM_ALLIES) && (m_iAlliesReqCappers[i] == 0) )
+					continue;
+				if ( (iTeam == TEAM_AXIS) && (m_iAxisReqCappers[i] == 0) )
+					continue;
+			}
+
+			goals.set(m_iWaypoint[i]);
+		}
+
+		CWaypointFlowField::setObjectives(iTeam,&goals);
+	}
+}
+
 int CDODFlags::findNearestObjective ( Vector vOrigin )
 {
 	float fNearest = 1024.0f;
@@ -821,6 +908,7 @@ void CDODMod ::roundStart()
 
 	// find main map type
 	m_iMapType = m_Flags.setup(m_pResourceEntity);
+	m_Flags.updateFlowFields();
 
 	//if ( m_iMapType == DOD_MAPTYPE_UNKNOWN )
 	//{
@@ -913,7 +1001,120 @@ void CDODMod :: addWaypointFlags (edict_t *pPlayer, edict_t *pEdict, int *iFlags
 
 void CDODMod :: modFrame()
 {
+	m_Smokes.update();
+}
+
+void CDODSmokes :: reset ()
+{
+	for ( short int i = 0; i < MAX_DOD_SMOKES; i ++ )
+		m_pSmokes[i] = NULL;
+
+	m_iNumSmokes = 0;
+	m_iNumThick = 0;
+	m_iScanIndex = 0;
+}
+
+void CDODSmokes :: add ( edict_t *pSmoke )
+{
+	for ( short int i = 0; i < m_iNumSmokes; i ++ )
+	{
+		if ( m_pSmokes[i] == pSmoke )
+			return;
+	}
+
+	if ( m_iNumSmokes < MAX_DOD_SMOKES )
+		m_pSmokes[m_iNumSmokes++] = pSmoke;
+}
+
+void CDODSmokes :: update ()
+{
+	int iMaxEntities = gpGlobals->maxEntities;
+	edict_t *pEdict;
+	int i;
+
+	// look through some of the edicts for new smoke grenades
+	for ( i = 0; i < DOD_SMOKE_SCAN_EDICTS; i ++ )
+	{
+		if ( (m_iScanIndex <= gpGlobals->maxClients) || (m_iScanIndex >= iMaxEntities) )
+			m_iScanIndex = gpGlobals->maxClients+1;
+
+		pEdict = INDEXENT(m_iScanIndex++);
+
+		if ( (pEdict == NULL) || pEdict->IsFree() || (pEdict->GetUnknown() == NULL) )
+			continue;
+
+		if ( strncmp(pEdict->GetClassName(),"grenade_smoke",13) == 0 )
+			add(pEdict);
+	}
+
+	m_iNumThick = 0;
+
+	i = 0;
+
+	while ( i < m_iNumSmokes )
+	{
+		float fSmokeTime;
+
+		pEdict = m_pSmokes[i].get();
+
+		if ( pEdict != NULL )
+		{
+			fSmokeTime = gpGlobals->curtime - CClassInterface::getSmokeSpawnTime(pEdict);
+
+			if ( fSmokeTime <= rcbot_smoke_time.GetFloat() )
+			{
+				if ( fSmokeTime >= DOD_SMOKE_THICK_TIME )
+					m_vThick[m_iNumThick++] = CBotGlobals::entityOrigin(pEdict);
+
+				i++;
+				continue;
+			}
+		}
+
+		// gone or cleared up
+		m_pSmokes[i] = m_pSmokes[--m_iNumSmokes].get();
+		m_pSmokes[m_iNumSmokes] = NULL;
+	}
+}
+
+float CDODSmokes :: getDensity ( const Vector &vFrom, const Vector &vTo )
+{
+	Vector vDir = vTo - vFrom;
+	float fLength = vDir.Length();
+	float fNearestSqr = SMOKE_RADIUS*SMOKE_RADIUS;
+	bool bFound = false;
+
+	if ( m_iNumThick == 0 )
+		return 0.0f;
+
+	if ( fLength > 0 )
+		vDir = vDir / fLength;
+
+	for ( short int i = 0; i < m_iNumThick; i ++ )
+	{
+		// nearest point on the line to the middle of the smoke
+		Vector vToSmoke = m_vThick[i] - vFrom;
+		float fAlong = DotProduct(vToSmoke,vDir);
+		float fDistSqr;
+
+		if ( fAlong < 0 )
+			fAlong = 0;
+		else if ( fAlong > fLength )
+			fAlong = fLength;
+
+		fDistSqr = (vToSmoke - (vDir*fAlong)).LengthSqr();
+
+		if ( fDistSqr <= fNearestSqr )
+		{
+			fNearestSqr = fDistSqr;
+			bFound = true;
+		}
+	}
+
+	if ( !bFound )
+		return 0.0f;
 
+	return 1.0f-(sqrt(fNearestSqr)/SMOKE_RADIUS);
 }
 
 
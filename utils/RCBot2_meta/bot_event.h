@@ -680,6 +680,7 @@ typedef enum
 class IBotEventInterface
 {
 public:
+	virtual ~IBotEventInterface () {}
 	virtual float getFloat ( const char *keyName = 0, float defaultValue = 0 ) = 0;
 	virtual int getInt ( const char *keyName = 0, int defaultValue = 0 ) = 0;
 	virtual const char *getString ( const char *keyName = 0, const char *defaultValue = 0 ) = 0;
@@ -759,6 +760,8 @@ public:
 	static void setupEvents ();
 
 	static void executeEvent( void *pEvent, eBotEventType iType );
+	// run the handler for an event already wrapped, replays use this
+	static bool fireEvent ( IBotEventInterface *pInterface, int iEventId = -1 );
 
 	static void freeMemory ();
 
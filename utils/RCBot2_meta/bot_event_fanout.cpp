@@ -0,0 +1,185 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#include "engine_wrappers.h"
+
+#include "bot.h"
+#include "bot_globals.h"
+#include "bot_event_fanout.h"
+
+int CBotEventFanout::m_iFrame = -1;
+int CBotEventFanout::m_iNumBots = 0;
+short int CBotEventFanout::m_iBots[MAX_PLAYERS];
+Vector CBotEventFanout::m_vOrigins[MAX_PLAYERS];
+short int CBotEventFanout::m_iBuckets[FANOUT_BUCKETS][MAX_PLAYERS];
+short int CBotEventFanout::m_iBucketSize[FANOUT_BUCKETS];
+short int CBotEventFanout::m_iTeamBots[FANOUT_MAX_TEAMS][MAX_PLAYERS];
+short int CBotEventFanout::m_iTeamSize[FANOUT_MAX_TEAMS];
+unsigned int CBotEventFanout::m_iEvents = 0;
+unsigned int CBotEventFanout::m_iDelivered = 0;
+
+void CBotEventFanout :: reset ()
+{
+	m_iFrame = -1;
+	m_iNumBots = 0;
+	m_iEvents = 0;
+	m_iDelivered = 0;
+}
+
+// sort bots into buckets and teams, once a frame
+void CBotEventFanout :: update ()
+{
+	int iTeam;
+	int iBucket;
+
+	if ( m_iFrame == gpGlobals->framecount )
+		return;
+
+	m_iFrame = gpGlobals->framecount;
+	m_iNumBots = 0;
+
+	memset(m_iBucketSize,0,sizeof(m_iBucketSize));
+	memset(m_iTeamSize,0,sizeof(m_iTeamSize));
+
+	for ( short int i = 0; i < MAX_PLAYERS; i ++ )
+	{
+		CBot *pBot = CBots::get(i);
+
+		if ( !pBot->inUse() || !pBot->getEdict() )
+			continue;
+
+		m_iBots[m_iNumBots++] = i;
+		m_vOrigins[i] = pBot->getOrigin();
+
+		iBucket = getBucket(getCell(m_vOrigins[i].x),getCell(m_vOrigins[i].y));
+		m_iBuckets[iBucket][m_iBucketSize[iBucket]++] = i;
+
+		iTeam = pBot->getTeam();
+
+		if ( (iTeam >= 0) && (iTeam < FANOUT_MAX_TEAMS) )
+			m_iTeamBots[iTeam][m_iTeamSize[iTeam]++] = i;
+	}
+}
+
+void CBotEventFanout :: deliver ( IBotFunction *pFunction, int iSlot )
+{
+	m_iDelivered++;
+	pFunction->execute(CBots::get(iSlot));
+}
+
+void CBotEventFanout :: botsInRange ( IBotFunction *pFunction, const Vector &vOrigin, float fRange, int iTeam )
+{
+	float fRangeSqr = fRange*fRange;
+	int iMinX, iMaxX, iMinY, iMaxY;
+	bool bBucketDone[FANOUT_BUCKETS];
+
+	update();
+
+	m_iEvents++;
+
+	iMinX = getCell(vOrigin.x-fRange);
+	iMaxX = getCell(vOrigin.x+fRange);
+	iMinY = getCell(vOrigin.y-fRange);
+	iMaxY = getCell(vOrigin.y+fRange);
+
+	// too far to be worth looking up squares
+	if ( ((iMaxX-iMinX+1)*(iMaxY-iMinY+1)) > FANOUT_MAX_CELLS )
+	{
+		for ( int i = 0; i < m_iNumBots; i ++ )
+		{
+			int iSlot = m_iBots[i];
+
+			if ( iTeam && (CBots::get(iSlot)->getTeam() != iTeam) )
+				continue;
+
+			if ( (m_vOrigins[iSlot]-vOrigin).LengthSqr() <= fRangeSqr )
+				deliver(pFunction,iSlot);
+		}
+
+		return;
+	}
+
+	memset(bBucketDone,0,sizeof(bBucketDone));
+
+	for ( int x = iMinX; x <= iMaxX; x ++ )
+	{
+		for ( int y = iMinY; y <= iMaxY; y ++ )
+		{
+			int iBucket = getBucket(x,y);
+
+			// squares can share a bucket
+			if ( bBucketDone[iBucket] )
+				continue;
+
+			bBucketDone[iBucket] = true;
+
+			for ( int i = 0; i < m_iBucketSize[iBucket]; i ++ )
+			{
+				int iSlot = m_iBuckets[iBucket][i];
+
+				if ( iTeam && (CBots::get(iSlot)->getTeam() != iTeam) )
+					continue;
+
+				if ( (m_vOrigins[iSlot]-vOrigin).LengthSqr() <= fRangeSqr )
+					deliver(pFunction,iSlot);
+			}
+		}
+	}
+}
+
+void CBotEventFanout :: botsThatSee ( IBotFunction *pFunction, edict_t *pSeen, int iTeam )
+{
+	int iIndex;
+
+	if ( (pSeen == NULL) || (iTeam < 0) || (iTeam >= FANOUT_MAX_TEAMS) )
+		return;
+
+	update();
+
+	m_iEvents++;
+
+	iIndex = ENTINDEX(pSeen)-1;
+
+	for ( int i = 0; i < m_iTeamSize[iTeam]; i ++ )
+	{
+		CBot *pBot = CBots::get(m_iTeamBots[iTeam][i]);
+
+		if ( (pBot->getEdict() != pSeen) && pBot->isIndexVisible(iIndex) )
+			deliver(pFunction,m_iTeamBots[iTeam][i]);
+	}
+}
+
+void CBotEventFanout :: printStats ( edict_t *pPrintTo )
+{
+	CBotGlobals::botMessage(pPrintTo,0,"event fan-out: %u events, %u deliveries",m_iEvents,m_iDelivered);
+
+	if ( m_iEvents > 0 )
+		CBotGlobals::botMessage(pPrintTo,0,"%0.2f bots per event instead of %d",(float)m_iDelivered/m_iEvents,CBots::numBots());
+}
@@ -0,0 +1,79 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#ifndef __RCBOT_EVENT_FANOUT_H__
+#define __RCBOT_EVENT_FANOUT_H__
+
+#include "bot.h"
+
+// size of the squares bots are sorted into for range queries
+#define FANOUT_CELL_SIZE 512.0f
+// squares are hashed into this many buckets
+#define FANOUT_BUCKETS 64
+// queries covering more squares than this check every bot instead
+#define FANOUT_MAX_CELLS 16
+#define FANOUT_MAX_TEAMS 4
+
+// hands game events only to the bots that could notice them instead of
+// every bot through CBots::botFunction. Bot positions and teams are sorted
+// once per frame, the first time an event needs them
+class CBotEventFanout
+{
+public:
+	static void reset ();
+
+	// bots within fRange of vOrigin, only bots on iTeam if it isn't 0
+	static void botsInRange ( IBotFunction *pFunction, const Vector &vOrigin, float fRange, int iTeam = 0 );
+
+	// bots on iTeam that can see pSeen right now, except pSeen itself
+	static void botsThatSee ( IBotFunction *pFunction, edict_t *pSeen, int iTeam );
+
+	static void printStats ( edict_t *pPrintTo );
+
+private:
+	static void update ();
+	static inline int getBucket ( int x, int y ) { return (int)((((unsigned int)x)*73856093u)^(((unsigned int)y)*19349663u)) & (FANOUT_BUCKETS-1); }
+	static inline int getCell ( float fCoord ) { return (int)floor(fCoord/FANOUT_CELL_SIZE); }
+	static void deliver ( IBotFunction *pFunction, int iSlot );
+
+	static int m_iFrame;
+	static int m_iNumBots;
+	static short int m_iBots[MAX_PLAYERS]; // bot slots in use this frame
+	static Vector m_vOrigins[MAX_PLAYERS]; // by slot
+	static short int m_iBuckets[FANOUT_BUCKETS][MAX_PLAYERS];
+	static short int m_iBucketSize[FANOUT_BUCKETS];
+	static short int m_iTeamBots[FANOUT_MAX_TEAMS][MAX_PLAYERS];
+	static short int m_iTeamSize[FANOUT_MAX_TEAMS];
+
+	static unsigned int m_iEvents;
+	static unsigned int m_iDelivered;
+};
+
+#endif
@@ -46,6 +46,8 @@
 #include "bot_squads.h"
 #include "bot_schedule.h"
 #include "bot_waypoint_locations.h"
+#include "bot_replay.h"
+#include "bot_event_fanout.h"
 
 std::vector<CBotEvent*> CBotEvents :: m_theEvents;
 ///////////////////////////////////////////////////////
@@ -59,16 +61,10 @@ public:
 		m_pWeapon = CWeapons::getWeaponByShortName(szKillerWeapon);
 		m_pDied = pDied;
 	}
+	// sent to team mates that can see m_pTeammate
 	void execute ( CBot *pBot )
 	{
-		if ( CClassInterface::getTeam(m_pTeammate) != pBot->getTeam() )
-			return;
-
-		if ( pBot->getEdict() != m_pTeammate )
-		{
-			if ( pBot->isVisible(m_pTeammate) )
-				pBot->seeFriendlyKill(m_pTeammate,m_pDied,m_pWeapon);
-		}
+		pBot->seeFriendlyKill(m_pTeammate,m_pDied,m_pWeapon);
 	}
 private:
 	edict_t *m_pTeammate;
@@ -97,16 +93,11 @@ public:
 		m_pWeapon = CWeapons::getWeapon(iWeaponID);
 	}
 
+	// sent to team mates that can see m_pTeammate
 	void execute ( CBot *pBot )
 	{
-		if ( CClassInterface::getTeam(m_pTeammate) != pBot->getTeam() )
-			return;
-
-		if ( pBot->getEdict() != m_pTeammate )
-		{
-			if ( pBot->isVisible(m_pTeammate) && pBot->isVisible(m_pEnemy) )
-				pBot->seeFriendlyHurtEnemy(m_pTeammate,m_pEnemy,m_pWeapon);
-		}
+		if ( pBot->isVisible(m_pEnemy) )
+			pBot->seeFriendlyHurtEnemy(m_pTeammate,m_pEnemy,m_pWeapon);
 	}
 private:
 	edict_t *m_pTeammate;
@@ -145,16 +136,10 @@ public:
 		m_pWeapon = CWeapons::getWeapon(iWeaponID);
 	}
 
+	// sent to team mates that can see m_pTeammate
 	void execute ( CBot *pBot )
 	{
-		if ( CClassInterface::getTeam(m_pTeammate) != pBot->getTeam() )
-			return;
-
-		if ( pBot->getEdict() != m_pTeammate )
-		{
-			if ( pBot->isVisible(m_pTeammate) )
-				pBot->seeEnemyHurtFriendly(m_pTeammate,m_pEnemy,m_pWeapon);
-		}
+		pBot->seeEnemyHurtFriendly(m_pTeammate,m_pEnemy,m_pWeapon);
 	}
 private:
 	edict_t *m_pTeammate;
@@ -172,16 +157,10 @@ public:
 		m_pWeapon = CWeapons::getWeaponByShortName(szKillerWeapon);
 		m_pKiller = pKiller;
 	}
+	// sent to team mates that can see m_pDied
 	void execute ( CBot *pBot )
 	{
-		if ( CClassInterface::getTeam(m_pDied) != pBot->getTeam() )
-			return;
-
-		if ( pBot->getEdict() != m_pDied )
-		{
-			if ( pBot->isVisible(m_pDied) )
-				pBot->seeFriendlyDie(m_pDied,m_pKiller,m_pWeapon);
-		}
+		pBot->seeFriendlyDie(m_pDied,m_pKiller,m_pWeapon);
 	}
 private:
 	edict_t *m_pDied;
@@ -198,6 +177,7 @@ public:
 		m_iWeaponID = iWeaponID;
 	}
 
+	// sent to bots within rcbot_listen_dist of m_pAttacker
 	void execute ( CBot *pBot )
 	{
 		if ( !pBot->hasEnemy() && (pBot->wantToListen()||pBot->isListeningToPlayer(m_pAttacker)) && pBot->wantToListenToPlayerAttack(m_pAttacker,m_iWeaponID) )
@@ -285,8 +265,8 @@ void CPlayerHurtEvent :: execute ( IBotEventInterface *pEvent )
 				CBotSeeFriendlyHurtEnemy func1(pAttacker,m_pActivator,iWeaponId);
 				CBotSeeEnemyHurtFriendly func2(pAttacker,m_pActivator,iWeaponId);
 
-				CBots::botFunction(&func1);
-				CBots::botFunction(&func2);
+				CBotEventFanout::botsThatSee(&func1,pAttacker,CClassInterface::getTeam(pAttacker));
+				CBotEventFanout::botsThatSee(&func2,m_pActivator,CClassInterface::getTeam(m_pActivator));
 			}
 		}
 
@@ -378,8 +358,8 @@ void CPlayerDeathEvent :: execute ( IBotEventInterface *pEvent )
 		CBotSeeFriendlyDie func1(m_pActivator,pAttacker,weapon);
 		CBotSeeFriendlyKill func2(pAttacker,m_pActivator,weapon);
 
-		CBots::botFunction(&func1);
-		CBots::botFunction(&func2);
+		CBotEventFanout::botsThatSee(&func1,m_pActivator,CClassInterface::getTeam(m_pActivator));
+		CBotEventFanout::botsThatSee(&func2,pAttacker,CClassInterface::getTeam(pAttacker));
 	}
 
 	if ( (pPrevSquadLeadersSquad = CBotSquads::FindSquadByLeader (m_pActivator)) != NULL )
@@ -596,7 +576,9 @@ void CTF2ObjectDestroyed :: execute ( IBotEventInterface *pEvent )
 
 	}
 
-
+	// after the bots have had a look at it
+	if ( (type >= 0) && ((eEngiBuild)type != ENGI_SAPPER) )
+		CTeamFortress2Mod::removeBuilding(index);
 }
 
 
@@ -624,6 +606,8 @@ bool 	isbuilder
 */
 void CTF2UpgradeObjectEvent :: execute ( IBotEventInterface *pEvent )
 {
+	CTeamFortress2Mod::buildingUpgraded(pEvent->getInt("index"));
+
 	if ( bot_use_vc_commands.GetBool() && randomInt(0,1) )
 	{
 		eEngiBuild object = (eEngiBuild)pEvent->getInt("object",0);
@@ -658,6 +642,7 @@ void CTF2RoundWinEvent :: execute (IBotEventInterface *pEvent )
 void CTF2SetupFinished ::execute(IBotEventInterface *pEvent )
 {
 	CTeamFortress2Mod::roundStarted();
+	CTeamFortress2Mod::m_ObjectiveResource.pointsChanged();
 }
 
 void CTF2BuiltObjectEvent :: execute ( IBotEventInterface *pEvent )
@@ -789,12 +774,12 @@ void CTF2PointBlockedCapture :: execute ( IBotEventInterface *pEvent )
 void CTF2PointUnlocked :: execute ( IBotEventInterface *pEvent )
 {
 	CTeamFortress2Mod::setPointOpenTime(0);
-	//
+	CTeamFortress2Mod::m_ObjectiveResource.pointsChanged();
 }
 
 void CTF2PointLocked :: execute ( IBotEventInterface *pEvent )
 {
-	//
+	CTeamFortress2Mod::m_ObjectiveResource.pointsChanged();
 }
 
 void CTF2PointStartTouch :: execute ( IBotEventInterface *pEvent )
@@ -878,9 +863,8 @@ void CTF2PointCaptured :: execute ( IBotEventInterface *pEvent )
 	//CTeamFortress2Mod::m_Resource.debugprint();
 	CTeamFortress2Mod::updatePointMaster();
 
-	// update points
-	CTeamFortress2Mod::m_ObjectiveResource.m_fUpdatePointTime = 0;
-	CTeamFortress2Mod::m_ObjectiveResource.m_fNextCheckMonitoredPoint = engine->Time() + 0.2f;
+	// update points next frame
+	CTeamFortress2Mod::m_ObjectiveResource.pointsChanged();
 
     // MUST BE AFTER POINTS HAVE BEEN UPDATED!
     CBots::botFunction(&cap);
@@ -1046,6 +1030,8 @@ void CDODPointCaptured :: execute ( IBotEventInterface *pEvent )
 		}
 	}
 
+	CDODMod::m_Flags.updateFlowFields();
+
 	if ( team )
 	{
 		CBroadcastBombEvent func(DOD_POINT_CAPTURED,cp,team);
@@ -1155,8 +1141,12 @@ void CDODFireWeaponEvent :: execute ( IBotEventInterface *pEvent )
 		edict_t *pAttacker = CBotGlobals::playerByUserId(iAttacker);
 		int iWeaponID = pEvent->getInt("weapon",-1);
 
-		CBotHearPlayerAttack func(pAttacker,iWeaponID);
-		CBots::botFunction(&func);
+		if ( pAttacker )
+		{
+			CBotHearPlayerAttack func(pAttacker,iWeaponID);
+			// nobody further away would pass the distance fuzz
+			CBotEventFanout::botsInRange(&func,CBotGlobals::entityOrigin(pAttacker),rcbot_listen_dist.GetFloat());
+		}
 	}
 
 
@@ -1270,24 +1260,10 @@ void CBotEvents :: freeMemory ()
 	m_theEvents.clear();
 }
 
-void CBotEvents :: executeEvent( void *pEvent, eBotEventType iType )
+// hands the event to the handler for its name, false if there isn't one
+bool CBotEvents :: fireEvent ( IBotEventInterface *pInterface, int iEventId )
 {
 	CBotEvent *pFound;
-	int iEventId = -1; 
-	bool bFound;
-
-	IBotEventInterface *pInterface = NULL;
-
-	if ( iType == TYPE_KEYVALUES )
-		pInterface = new CGameEventInterface1((KeyValues*)pEvent);
-	else if ( iType == TYPE_IGAMEEVENT )
-		pInterface = new CGameEventInterface2((IGameEvent*)pEvent);
-
-	if ( pInterface == NULL )
-		return;
-
-	if ( iType != TYPE_IGAMEEVENT )
-		iEventId = pInterface->getInt("eventid");
 
 	for ( register unsigned short int i = 0; i < m_theEvents.size(); i ++ )
 	{
@@ -1297,9 +1273,7 @@ void CBotEvents :: executeEvent( void *pEvent, eBotEventType iType )
 		//if ( ( iType != TYPE_IGAMEEVENT ) && pFound->hasEventId() )
 		//	bFound = pFound->isEventId(iEventId);
 		//else
-		bFound = pFound->forCurrentMod() && pFound->isType(pInterface->getName());
-
-		if ( bFound )	
+		if ( pFound->forCurrentMod() && pFound->isType(pInterface->getName()) )
 		{
 			int userid = pInterface->getInt("userid",-1);
 			// set pEvent id for quick checking
@@ -1309,9 +1283,40 @@ void CBotEvents :: executeEvent( void *pEvent, eBotEventType iType )
 
 			pFound->execute(pInterface);
 
-			break;
+			return true;
 		}
 	}
 
+	return false;
+}
+
+void CBotEvents :: executeEvent( void *pEvent, eBotEventType iType )
+{
+	int iEventId = -1; 
+
+	IBotEventInterface *pInterface = NULL;
+	CReplayEventInterface *pRecording = NULL;
+
+	if ( iType == TYPE_KEYVALUES )
+		pInterface = new CGameEventInterface1((KeyValues*)pEvent);
+	else if ( iType == TYPE_IGAMEEVENT )
+		pInterface = new CGameEventInterface2((IGameEvent*)pEvent);
+
+	if ( pInterface == NULL )
+		return;
+
+	// remember which keys the handlers read so the event can be replayed
+	if ( CBotReplay::isRecording() )
+	{
+		pRecording = new CReplayEventInterface(pInterface);
+		pInterface = pRecording;
+	}
+
+	if ( iType != TYPE_IGAMEEVENT )
+		iEventId = pInterface->getInt("eventid");
+
+	if ( fireEvent(pInterface,iEventId) && (pRecording != NULL) )
+		CBotReplay::recordEvent(pRecording);
+
 	delete pInterface;
 }
@@ -1292,7 +1292,7 @@ bool CBotTF2 :: needAmmo()
 		{
 			int iMetal = pWeapon->getAmmo(this);
 
-			if ( ( m_pSentryGun.get() == NULL ) || (CClassInterface::getTF2UpgradeLevel(m_pSentryGun) < 3) )
+			if ( ( m_pSentryGun.get() == NULL ) || (CTeamFortress2Mod::getBuildingLevel(m_pSentryGun) < 3) )
 				return ( iMetal < 200 ); // need 200 to upgrade sentry
 			else
 				return iMetal < 125; // need 125 for other stuff (e.g. teleporters)
@@ -2787,6 +2787,9 @@ void CBotTF2::modThink()
 	// mod specific think code here
 	CBotFortress::modThink();
 
+	// pick up attack/defend points changed since last think
+	checkPointsVersion();
+
 	checkBeingHealed();
 
 	if (wantToListen())
@@ -4477,7 +4480,7 @@ void CBotTF2 :: getTasks ( unsigned int iIgnore )
 		if ( m_pSentryGun.get() )
 		{
 			bSentryHasEnemy = (CClassInterface::getSentryEnemy(m_pSentryGun) != NULL);
-			iSentryLevel = CClassInterface::getTF2UpgradeLevel(m_pSentryGun);//CTeamFortress2Mod::getSentryLevel(m_pSentryGun);
+			iSentryLevel = CTeamFortress2Mod::getBuildingLevel(m_pSentryGun);
 			fSentryHealthPercent = ((float)CClassInterface::getSentryHealth(m_pSentryGun))/CClassInterface::getTF2GetBuildingMaxHealth(m_pSentryGun);
 			// move sentry
 			ADD_UTILITY(BOT_UTIL_ENGI_MOVE_SENTRY,(CTeamFortress2Mod::hasRoundStarted()||CTeamFortress2Mod::isMapType(TF_MAP_MVM)) && (!m_bIsCarryingObj || m_bIsCarryingSentry) && 
@@ -4491,7 +4494,7 @@ void CBotTF2 :: getTasks ( unsigned int iIgnore )
 		if ( m_pDispenser.get() )
 		{
 			iMetalInDisp = CClassInterface::getTF2DispMetal(m_pDispenser);
-			iDispenserLevel = CClassInterface::getTF2UpgradeLevel(m_pDispenser); // CTeamFortress2Mod::getDispenserLevel(m_pDispenser);
+			iDispenserLevel = CTeamFortress2Mod::getBuildingLevel(m_pDispenser);
 			fDispenserHealthPercent = ((float)CClassInterface::getDispenserHealth(m_pDispenser)) / CClassInterface::getTF2GetBuildingMaxHealth(m_pDispenser);
 
 			fUseDispFactor = (((float)iMetalInDisp)/400) * (1.0f-fMetalPercent) * ((float)iDispenserLevel/3) * (1000.0f/distanceFrom(m_pDispenser));
@@ -4504,7 +4507,7 @@ void CBotTF2 :: getTasks ( unsigned int iIgnore )
 		if ( m_pNearestDisp && (m_pNearestDisp.get() != m_pDispenser.get()) )
 		{
 			iMetalInDisp = CClassInterface::getTF2DispMetal(m_pNearestDisp);
-			iAllyDispLevel = CClassInterface::getTF2UpgradeLevel(m_pNearestDisp); // CTeamFortress2Mod::getDispenserLevel(m_pDispenser);
+			iAllyDispLevel = CTeamFortress2Mod::getBuildingLevel(m_pNearestDisp);
 			fAllyDispenserHealthPercent = ((float)CClassInterface::getDispenserHealth(m_pNearestDisp)) / CClassInterface::getTF2GetBuildingMaxHealth(m_pNearestDisp);
 
 			fUseDispFactor = (((float)iMetalInDisp)/400) * (1.0f-fMetalPercent) * ((float)iAllyDispLevel/3) * (1000.0f/distanceFrom(m_pNearestDisp));
@@ -4516,7 +4519,7 @@ void CBotTF2 :: getTasks ( unsigned int iIgnore )
 
 		if ( m_pNearestAllySentry && (m_pNearestAllySentry.get() != m_pSentryGun.get()) && !CClassInterface::getTF2BuildingIsMini(m_pNearestAllySentry) )
 		{
-			iAllySentryLevel = CClassInterface::getTF2UpgradeLevel(m_pNearestAllySentry);
+			iAllySentryLevel = CTeamFortress2Mod::getBuildingLevel(m_pNearestAllySentry);
 			fAllySentryHealthPercent = CClassInterface::getSentryHealth(m_pNearestAllySentry);
 			fAllySentryHealthPercent = fAllySentryHealthPercent / CClassInterface::getTF2GetBuildingMaxHealth(m_pNearestAllySentry);
 
@@ -7097,6 +7100,31 @@ void CBotTF2::updateAttackDefendPoints()
 	m_iTeam = getTeam();
 	m_iCurrentAttackArea = CTeamFortress2Mod::m_ObjectiveResource.getRandomValidPointForTeam(m_iTeam,TF2_POINT_ATTACK);
 	m_iCurrentDefendArea = CTeamFortress2Mod::m_ObjectiveResource.getRandomValidPointForTeam(m_iTeam,TF2_POINT_DEFEND);
+	m_iAttackPointsVersion = CTeamFortress2Mod::m_ObjectiveResource.getPointsVersion(m_iTeam,TF2_POINT_ATTACK);
+	m_iDefendPointsVersion = CTeamFortress2Mod::m_ObjectiveResource.getPointsVersion(m_iTeam,TF2_POINT_DEFEND);
+}
+
+void CBotTF2 :: checkPointsVersion ()
+{
+	int iAttackVersion = CTeamFortress2Mod::m_ObjectiveResource.getPointsVersion(m_iTeam,TF2_POINT_ATTACK);
+	int iDefendVersion = CTeamFortress2Mod::m_ObjectiveResource.getPointsVersion(m_iTeam,TF2_POINT_DEFEND);
+
+	if ( (iAttackVersion == m_iAttackPointsVersion) && (iDefendVersion == m_iDefendPointsVersion) )
+		return;
+
+	if ( iAttackVersion != m_iAttackPointsVersion )
+	{
+		m_iAttackPointsVersion = iAttackVersion;
+		updateAttackPoints();
+	}
+
+	if ( iDefendVersion != m_iDefendPointsVersion )
+	{
+		m_iDefendPointsVersion = iDefendVersion;
+		updateDefendPoints();
+	}
+
+	pointsUpdated();
 }
 
 void CBotTF2 :: pointsUpdated()
@@ -7673,6 +7701,8 @@ CBotTF2::CBotTF2()
 		m_fSpySapTime = 0;
 		m_iCurrentDefendArea = 0;
 		m_iCurrentAttackArea = 0;
+		m_iDefendPointsVersion = 0;
+		m_iAttackPointsVersion = 0;
 	    //m_bBlockPushing = false;
 	    //m_fBlockPushTime = 0;
 		m_pDefendPayloadBomb = NULL;
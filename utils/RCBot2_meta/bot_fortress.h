@@ -751,6 +751,8 @@ public:
 
 	void updateAttackPoints ();
 	void updateDefendPoints ();
+	// read the objective resource's points if they changed since last time
+	void checkPointsVersion ();
 
 	// found a new enemy
 	void enemyFound (edict_t *pEnemy);
@@ -928,6 +930,9 @@ private:
 	// 
 	int m_iCurrentDefendArea;
 	int m_iCurrentAttackArea;
+	// versions of the objective resource's points the above were read from
+	int m_iDefendPointsVersion;
+	int m_iAttackPointsVersion;
 	//
 	//bool m_bBlockPushing;
 	//float m_fBlockPushTime;
@@ -5,8 +5,14 @@
 #include "bot.h"
 #include "bot_globals.h"
 #include "bot_getprop.h"
+#include "bot_cvars.h"
 
 CClassInterfaceValue CClassInterface :: g_GetProps[GET_PROPDATA_MAX];
+getprop_snapshot_t CClassInterface :: m_Snapshot[MAX_EDICTS];
+short int CClassInterface :: m_WatchList[MAX_EDICTS];
+int CClassInterface :: m_iNumWatched = 0;
+int CClassInterface :: m_iFrame = 0;
+edict_t *CClassInterface :: m_pEdictBase = NULL;
 bool CClassInterfaceValue :: m_berror = false;
 
 extern IServerGameDLL *servergamedll;
@@ -235,13 +241,13 @@ CBaseHandle *CClassInterfaceValue :: getEntityHandle ( edict_t *edict )
 	return (CBaseHandle *)m_data;
 }
 
-edict_t *CClassInterfaceValue :: getEntity ( edict_t *edict ) 
+edict_t *CClassInterfaceValue :: getEntity ( void *edict, bool bIsEdict ) 
 { 
 	static CBaseHandle *hndl;
 
 	m_berror = false;
 
-	getData(edict); 
+	getData(edict, bIsEdict); 
 
 
 	if (m_berror)
@@ -575,6 +581,119 @@ void CClassInterfaceValue :: getData ( void *edict, bool bIsEdict )
 
 }
 
+void CClassInterface :: frameUpdate ()
+{
+	register short int i;
+
+	m_iFrame = gpGlobals->framecount;
+
+	if ( !rcbot_propcache.GetBool() )
+	{
+		// getters go straight to the entity
+		m_pEdictBase = NULL;
+		return;
+	}
+
+	m_pEdictBase = INDEXENT(0);
+
+	if ( m_pEdictBase == NULL )
+		return;
+
+	for ( i = 1; i <= CBotGlobals::maxClients(); i ++ )
+		snapshotEntity(i,GETPROP_SNAP_PLAYER);
+
+	for ( i = 0; i < m_iNumWatched; i ++ )
+		snapshotEntity(m_WatchList[i],m_Snapshot[m_WatchList[i]].iWatch);
+}
+
+// resolve the entity once and copy the props bots read every think, 
+// only the fields given are read as offsets of other classes are not valid
+void CClassInterface :: snapshotEntity ( int index, int iFields )
+{
+	getprop_snapshot_t *pSnap = &m_Snapshot[index];
+	edict_t *pEdict = m_pEdictBase + index;
+	IServerUnknown *pUnknown;
+	CBaseEntity *pEntity;
+
+	pSnap->iValid = 0;
+
+	if ( pEdict->IsFree() )
+		return;
+
+	pUnknown = (IServerUnknown *)pEdict->GetUnknown();
+
+	if ( pUnknown == NULL )
+		return;
+
+	pEntity = pUnknown->GetBaseEntity();
+
+	if ( pEntity == NULL )
+		return;
+
+	pSnap->iFrame = m_iFrame;
+	pSnap->pUnknown = pUnknown;
+
+	if ( iFields & GETPROP_SNAP_TEAM )
+		pSnap->iTeam = g_GetProps[GETPROP_TEAM].getInt(pEntity,0,false);
+	if ( iFields & GETPROP_SNAP_FLAGS )
+		pSnap->iFlags = g_GetProps[GETPROP_ENTITY_FLAGS].getInt(pEntity,0,false);
+	if ( iFields & GETPROP_SNAP_TF2CLASS )
+		pSnap->iTF2Class = g_GetProps[GETPROP_TF2CLASS].getInt(pEntity,0,false);
+	if ( iFields & GETPROP_SNAP_VELOCITY )
+		pSnap->bVelocity = g_GetProps[GETPROP_VELOCITY].getVector(pEntity,&pSnap->vVelocity,false);
+	if ( iFields & GETPROP_SNAP_SENTRYENEMY )
+		pSnap->pSentryEnemy = g_GetProps[GETPROP_SENTRY_ENEMY].getEntity(pEntity,false);
+	if ( iFields & GETPROP_SNAP_UPGRADELEVEL )
+		pSnap->iUpgradeLevel = g_GetProps[GETPROP_TF2OBJECTUPGRADELEVEL].getInt(pEntity,0,false);
+
+	pSnap->iValid = iFields;
+}
+
+void CClassInterface :: watchEntity ( edict_t *pEdict, int iFields )
+{
+	int index = ENTINDEX(pEdict);
+
+	if ( (index <= CBotGlobals::maxClients()) || (index >= MAX_EDICTS) )
+		return;
+
+	if ( m_Snapshot[index].iWatch == 0 )
+		m_WatchList[m_iNumWatched++] = index;
+
+	m_Snapshot[index].iWatch = iFields;
+	// not read until next frame
+	m_Snapshot[index].iValid = 0;
+}
+
+void CClassInterface :: unwatchEntity ( int index )
+{
+	if ( (index <= 0) || (index >= MAX_EDICTS) || (m_Snapshot[index].iWatch == 0) )
+		return;
+
+	for ( int i = 0; i < m_iNumWatched; i ++ )
+	{
+		if ( m_WatchList[i] == index )
+		{
+			// move the last one into this slot
+			m_WatchList[i] = m_WatchList[--m_iNumWatched];
+			break;
+		}
+	}
+
+	m_Snapshot[index].iWatch = 0;
+	m_Snapshot[index].iValid = 0;
+}
+
+void CClassInterface :: unwatchAll ()
+{
+	for ( int i = 0; i < m_iNumWatched; i ++ )
+	{
+		m_Snapshot[m_WatchList[i]].iWatch = 0;
+		m_Snapshot[m_WatchList[i]].iValid = 0;
+	}
+
+	m_iNumWatched = 0;
+}
+
 edict_t *CClassInterface::FindEntityByClassnameNearest(Vector vstart, const char *classname, float fMindist, edict_t *pOwner)
 {
 	edict_t *current;
@@ -181,7 +181,7 @@ public:
 
 	void getData ( void *edict, bool bIsEdict = true );
 
-	edict_t *getEntity ( edict_t *edict );
+	edict_t *getEntity ( void *edict, bool bIsEdict = true );
 
 	CBaseHandle *getEntityHandle ( edict_t *edict );
 
@@ -262,11 +262,11 @@ public:
 		return NULL;
 	}
 
-	inline bool getVector ( edict_t *edict, Vector *v )
+	inline bool getVector ( void *edict, Vector *v, bool bIsEdict = true )
 	{
 		static float *x;
 
-		getData(edict);
+		getData(edict, bIsEdict);
 
 		if ( m_data )
 		{
@@ -342,6 +342,34 @@ private:
 extern CClassInterfaceValue g_GetProps[GET_PROPDATA_MAX];
 class CTFObjectiveResource;
 class CTeamRoundTimer;
+
+// props read every think, copied once per frame in CClassInterface::frameUpdate
+#define GETPROP_SNAP_TEAM			(1<<0)
+#define GETPROP_SNAP_FLAGS			(1<<1)
+#define GETPROP_SNAP_TF2CLASS		(1<<2)
+#define GETPROP_SNAP_VELOCITY		(1<<3)
+#define GETPROP_SNAP_SENTRYENEMY	(1<<4)
+#define GETPROP_SNAP_UPGRADELEVEL	(1<<5)
+
+#define GETPROP_SNAP_PLAYER (GETPROP_SNAP_TEAM|GETPROP_SNAP_FLAGS|GETPROP_SNAP_TF2CLASS|GETPROP_SNAP_VELOCITY)
+#define GETPROP_SNAP_BUILDING (GETPROP_SNAP_TEAM|GETPROP_SNAP_UPGRADELEVEL)
+#define GETPROP_SNAP_SENTRY (GETPROP_SNAP_BUILDING|GETPROP_SNAP_SENTRYENEMY)
+
+typedef struct
+{
+	int iFrame;
+	IServerUnknown *pUnknown;	// a freed or reused edict has a different one
+	int iValid;					// GETPROP_SNAP_* fields read this frame
+	int iWatch;					// GETPROP_SNAP_* fields to read for a watched entity
+	int iTeam;
+	int iFlags;
+	int iTF2Class;
+	bool bVelocity;
+	Vector vVelocity;
+	edict_t *pSentryEnemy;
+	int iUpgradeLevel;
+}getprop_snapshot_t;
+
 #define DEFINE_GETPROP(id,classname,value,preoffs)\
  g_GetProps[id] = CClassInterfaceValue( CClassInterfaceValue ( classname, value, preoffs ) )
 
@@ -350,6 +378,13 @@ class CClassInterface
 public:
 	static void init ();
 
+	// copies the hot props of players and watched entities, call before bots think
+	static void frameUpdate ();
+	// non player entities to snapshot every frame (e.g. TF2 buildings)
+	static void watchEntity ( edict_t *pEdict, int iFields );
+	static void unwatchEntity ( int index );
+	static void unwatchAll ();
+
 	static const char *FindEntityNetClass(int start, const char *classname);
 	static edict_t *FindEntityByNetClass(int start, const char *classname);
 	static edict_t *FindEntityByNetClassNearest(Vector vstart, const char *classname);
@@ -359,16 +394,42 @@ public:
 	static int getTF2Score ( edict_t *edict );
 	static void setupCTeamRoundTimer ( CTeamRoundTimer *pTimer );
 	inline static float getRageMeter ( edict_t *edict ) { return g_GetProps[GETPROP_TF2_RAGEMETER].getFloat(edict,0); }
-	inline static int getFlags ( edict_t *edict ) { return g_GetProps[GETPROP_ENTITY_FLAGS].getInt(edict,0); }
-	inline static int getTeam ( edict_t *edict ) { return g_GetProps[GETPROP_TEAM].getInt(edict,0); }
+	inline static int getFlags ( edict_t *edict ) 
+	{ 
+		const getprop_snapshot_t *pSnap = getSnapshot(edict,GETPROP_SNAP_FLAGS);
+
+		return pSnap ? pSnap->iFlags : g_GetProps[GETPROP_ENTITY_FLAGS].getInt(edict,0); 
+	}
+	inline static int getTeam ( edict_t *edict ) 
+	{ 
+		const getprop_snapshot_t *pSnap = getSnapshot(edict,GETPROP_SNAP_TEAM);
+
+		return pSnap ? pSnap->iTeam : g_GetProps[GETPROP_TEAM].getInt(edict,0); 
+	}
 	inline static float getPlayerHealth ( edict_t *edict ) { return g_GetProps[GETPROP_PLAYERHEALTH].getFloatFromInt(edict,0); }
 	inline static int getEffects ( edict_t *edict ) { return g_GetProps[GETPROP_EFFECTS].getInt(edict,0); }
 	inline static int *getAmmoList ( edict_t *edict ) { return g_GetProps[GETPROP_AMMO].getIntPointer(edict); }
 	//static unsigned int findOffset(const char *szType,const char *szClass);
 	inline static int getTF2NumHealers ( edict_t *edict ) { return g_GetProps[GETPROP_TF2_NUMHEALERS].getInt(edict,0); }
 	inline static int getTF2Conditions ( edict_t *edict ) { return g_GetProps[GETPROP_TF2_CONDITIONS].getInt(edict,0); }
-	inline static bool getVelocity ( edict_t *edict, Vector *v ) {return g_GetProps[GETPROP_VELOCITY].getVector(edict,v); }
-	inline static int getTF2Class ( edict_t *edict ) { return g_GetProps[GETPROP_TF2CLASS].getInt(edict,0); }
+	inline static bool getVelocity ( edict_t *edict, Vector *v ) 
+	{
+		const getprop_snapshot_t *pSnap = getSnapshot(edict,GETPROP_SNAP_VELOCITY);
+
+		if ( pSnap == NULL )
+			return g_GetProps[GETPROP_VELOCITY].getVector(edict,v); 
+
+		if ( pSnap->bVelocity )
+			*v = pSnap->vVelocity;
+
+		return pSnap->bVelocity;
+	}
+	inline static int getTF2Class ( edict_t *edict ) 
+	{ 
+		const getprop_snapshot_t *pSnap = getSnapshot(edict,GETPROP_SNAP_TF2CLASS);
+
+		return pSnap ? pSnap->iTF2Class : g_GetProps[GETPROP_TF2CLASS].getInt(edict,0); 
+	}
 	inline static float TF2_getEnergyDrinkMeter(edict_t * edict) { return g_GetProps[GETPROP_TF2_ENERGYDRINKMETER].getFloat(edict, 0); }
 	inline static edict_t *TF2_getActiveWeapon(edict_t *edict) { return g_GetProps[GETPROP_TF2_ACTIVEWEAPON].getEntity(edict); }
 	// set weapon
@@ -443,7 +504,12 @@ public:
 	inline static edict_t *getCarriedObj ( edict_t *edict ) { return g_GetProps[GETPROP_TF2_GETCARRIEDOBJ].getEntity(edict); }
 	inline static bool getMedigunHealing ( edict_t *edict ) { return g_GetProps[GETPROP_TF2MEDIGUN_HEALING].getBool(edict,false); }
 	inline static edict_t *getMedigunTarget ( edict_t *edict ) { return g_GetProps[GETPROP_TF2MEDIGUN_TARGETTING].getEntity(edict); }
-	inline static edict_t *getSentryEnemy ( edict_t *edict ) { return g_GetProps[GETPROP_SENTRY_ENEMY].getEntity(edict); }
+	inline static edict_t *getSentryEnemy ( edict_t *edict ) 
+	{ 
+		const getprop_snapshot_t *pSnap = getSnapshot(edict,GETPROP_SNAP_SENTRYENEMY);
+
+		return pSnap ? pSnap->pSentryEnemy : g_GetProps[GETPROP_SENTRY_ENEMY].getEntity(edict); 
+	}
 	inline static edict_t *getOwner ( edict_t *edict ) { return g_GetProps[GETPROP_ALL_ENTOWNER].getEntity(edict); }
 	inline static bool isMedigunTargetting ( edict_t *pgun, edict_t *ptarget) { return (g_GetProps[GETPROP_TF2MEDIGUN_TARGETTING].getEntity(pgun) == ptarget); }
 	//static void setTickBase ( edict_t *edict, int tickbase ) { return ;
@@ -455,7 +521,12 @@ public:
 	inline static float getDispenserHealth ( edict_t *edict ) { return g_GetProps[GETPROP_TF2DISPENSERHEALTH].getFloatFromInt(edict,100); }
 	inline static float getTeleporterHealth ( edict_t *edict ) { return g_GetProps[GETPROP_TF2TELEPORTERHEALTH].getFloatFromInt(edict,100); }
 	inline static bool isObjectCarried ( edict_t *edict ) { return g_GetProps[GETPROP_TF2OBJECTCARRIED].getBool(edict,false); }
-	inline static int getTF2UpgradeLevel ( edict_t *edict ) { return g_GetProps[GETPROP_TF2OBJECTUPGRADELEVEL].getInt(edict,0); }
+	inline static int getTF2UpgradeLevel ( edict_t *edict ) 
+	{ 
+		const getprop_snapshot_t *pSnap = getSnapshot(edict,GETPROP_SNAP_UPGRADELEVEL);
+
+		return pSnap ? pSnap->iUpgradeLevel : g_GetProps[GETPROP_TF2OBJECTUPGRADELEVEL].getInt(edict,0); 
+	}
 	inline static int getTF2SentryUpgradeMetal ( edict_t *edict ) { return g_GetProps[GETPROP_TF2OBJECTUPGRADEMETAL].getInt(edict,0); }
 	inline static int getTF2SentryShells ( edict_t *edict ) { return g_GetProps[GETPROP_TF2OBJECTSHELLS].getInt(edict,0); }
 	inline static int getTF2SentryRockets ( edict_t *edict ) { return g_GetProps[GETPROP_TF2OBJECTROCKETS].getInt(edict,0); }
@@ -676,6 +747,36 @@ public:
 private:
 	static CClassInterfaceValue g_GetProps[GET_PROPDATA_MAX];
 
+	static void snapshotEntity ( int index, int iFields );
+
+	// NULL if the field wasn't copied this frame for this entity
+	inline static const getprop_snapshot_t *getSnapshot ( edict_t *edict, int iField )
+	{
+		const getprop_snapshot_t *pSnap;
+		int index;
+
+		if ( (m_pEdictBase == NULL) || (edict == NULL) )
+			return NULL;
+
+		// edicts are one contiguous array
+		index = (int)(edict - m_pEdictBase);
+
+		if ( (index < 0) || (index >= MAX_EDICTS) )
+			return NULL;
+
+		pSnap = &m_Snapshot[index];
+
+		if ( !(pSnap->iValid & iField) || (pSnap->iFrame != m_iFrame) || (pSnap->pUnknown != edict->GetUnknown()) )
+			return NULL;
+
+		return pSnap;
+	}
+
+	static getprop_snapshot_t m_Snapshot[MAX_EDICTS];
+	static short int m_WatchList[MAX_EDICTS];
+	static int m_iNumWatched;
+	static int m_iFrame;
+	static edict_t *m_pEdictBase;
 };
 
 #endif
\ No newline at end of file
@@ -41,6 +41,7 @@
 #include "bot.h"
 #include "bot_cvars.h"
 #include "bot_globals.h"
+#include "bot_log.h"
 #include "bot_strings.h"
 #include "bot_waypoint_locations.h"
 #include "bot_getprop.h"
@@ -60,6 +61,7 @@ extern IServerGameEnts *servergameents;
 
 ///////////
 trace_t CBotGlobals :: m_TraceResult;
+bot_trace_cache_t CBotGlobals :: m_TraceCache[BOT_TRACE_CACHE_SIZE];
 char * CBotGlobals :: m_szModFolder = NULL;
 eModId CBotGlobals :: m_iCurrentMod = MOD_UNSUPPORTED;
 CBotMod *CBotGlobals :: m_pCurrentMod = NULL;
@@ -113,6 +115,8 @@ void CBotGlobals :: init ()
 {
 	m_iCurrentMod = MOD_UNSUPPORTED;
 	m_szModFolder[0] = 0;
+
+	resetTraceCache();
 }
 
 bool CBotGlobals ::isAlivePlayer ( edict_t *pEntity )
@@ -380,20 +384,14 @@ bool CBotGlobals :: isVisibleHitAllExceptPlayer ( edict_t *pPlayer, Vector vSrc,
 
 bool CBotGlobals :: isVisible ( edict_t *pPlayer, Vector vSrc, Vector vDest)
 {
-	CTraceFilterWorldAndPropsOnly filter;
-
-	traceLine (vSrc,vDest,MASK_SOLID_BRUSHONLY|CONTENTS_OPAQUE,&filter);
+	traceWorld (vSrc,vDest,MASK_SOLID_BRUSHONLY|CONTENTS_OPAQUE,&m_TraceResult);
 
 	return (traceVisible(NULL));
 }
 
 bool CBotGlobals :: isVisible ( edict_t *pPlayer, Vector vSrc, edict_t *pDest )
 {
-	//CTraceFilterWorldAndPropsOnly filter;//	CTraceFilterHitAll filter;
-
-	CTraceFilterWorldAndPropsOnly filter;
-
-	traceLine (vSrc,entityOrigin(pDest),MASK_SOLID_BRUSHONLY|CONTENTS_OPAQUE,&filter);
+	traceWorld (vSrc,entityOrigin(pDest),MASK_SOLID_BRUSHONLY|CONTENTS_OPAQUE,&m_TraceResult);
 
 	return (traceVisible(pDest));
 }
@@ -411,30 +409,116 @@ bool CBotGlobals :: isShotVisible ( edict_t *pPlayer, Vector vSrc, Vector vDest,
 
 bool CBotGlobals :: isVisible (Vector vSrc, Vector vDest)
 {
-	CTraceFilterWorldAndPropsOnly filter;
-
-	traceLine (vSrc,vDest,MASK_SOLID_BRUSHONLY|CONTENTS_OPAQUE,&filter);
+	traceWorld (vSrc,vDest,MASK_SOLID_BRUSHONLY|CONTENTS_OPAQUE,&m_TraceResult);
 
 	return traceVisible(NULL);
 }
 
+bool CBotGlobals :: isVisible ( const Vector &vSrc, const Vector &vDest, trace_t *pTrace )
+{
+	traceWorld (vSrc,vDest,MASK_SOLID_BRUSHONLY|CONTENTS_OPAQUE,pTrace);
+
+	return traceVisible(pTrace,NULL);
+}
+
 void CBotGlobals :: traceLine (Vector vSrc, Vector vDest, unsigned int mask, ITraceFilter *pFilter)
+{
+	traceLine(vSrc,vDest,mask,pFilter,&m_TraceResult);
+}
+
+void CBotGlobals :: traceLine ( const Vector &vSrc, const Vector &vDest, unsigned int mask, ITraceFilter *pFilter, trace_t *pTrace )
 {
 	Ray_t ray;
-	memset(&m_TraceResult,0,sizeof(trace_t));
+	// init the ray first, vSrc/vDest may point into pTrace
 	ray.Init( vSrc, vDest );
-	enginetrace->TraceRay( ray, mask, pFilter, &m_TraceResult );
+	memset(pTrace,0,sizeof(trace_t));
+	enginetrace->TraceRay( ray, mask, pFilter, pTrace );
+}
+
+// world and props only traces do not depend on who is asking, so the
+// same ray traced twice in one frame is only sent to the engine once
+void CBotGlobals :: traceWorld ( const Vector &vSrc, const Vector &vDest, unsigned int mask, trace_t *pTrace )
+{
+	CTraceFilterWorldAndPropsOnly filter;
+	unsigned int iSrc[3];
+	unsigned int iDest[3];
+	unsigned int iHash;
+	bot_trace_cache_t *pEntry;
+
+	if ( !rcbot_tracecache.GetBool() )
+	{
+		traceLine(vSrc,vDest,mask,&filter,pTrace);
+		return;
+	}
+
+	iHash = mask;
+
+	for ( register short int i = 0; i < 3; i ++ )
+	{
+		float fSrc = vSrc[i];
+		float fDest = vDest[i];
+
+		// exact bits, a hit is the same ray so its trace_t is right as stored
+		memcpy(&iSrc[i],&fSrc,sizeof(float));
+		memcpy(&iDest[i],&fDest,sizeof(float));
+
+		iHash = (iHash*31) + iSrc[i];
+		iHash = (iHash*31) + iDest[i];
+	}
+
+	iHash ^= (iHash >> 16);
+
+	pEntry = &m_TraceCache[iHash & (BOT_TRACE_CACHE_SIZE-1)];
+
+	if ( (pEntry->iFrame == gpGlobals->framecount) && (pEntry->iMask == mask) &&
+		!memcmp(pEntry->iSrc,iSrc,sizeof(iSrc)) && !memcmp(pEntry->iDest,iDest,sizeof(iDest)) )
+	{
+		*pTrace = pEntry->tr;
+		return;
+	}
+
+	traceLine(vSrc,vDest,mask,&filter,pTrace);
+
+	pEntry->iFrame = gpGlobals->framecount;
+	pEntry->iMask = mask;
+	memcpy(pEntry->iSrc,iSrc,sizeof(iSrc));
+	memcpy(pEntry->iDest,iDest,sizeof(iDest));
+	pEntry->tr = *pTrace;
+}
+
+void CBotGlobals :: traceLines ( bot_trace_t *pTraces, int iNum )
+{
+	for ( register int i = 0; i < iNum; i ++ )
+	{
+		bot_trace_t *pTrace = &pTraces[i];
+
+		if ( pTrace->pFilter == NULL )
+			traceWorld(pTrace->vSrc,pTrace->vDest,pTrace->iMask,&pTrace->tr);
+		else
+			traceLine(pTrace->vSrc,pTrace->vDest,pTrace->iMask,pTrace->pFilter,&pTrace->tr);
+	}
+}
+
+void CBotGlobals :: resetTraceCache ()
+{
+	memset(m_TraceCache,0,sizeof(m_TraceCache));
+
+	for ( register int i = 0; i < BOT_TRACE_CACHE_SIZE; i ++ )
+		m_TraceCache[i].iFrame = -1;
 }
 
 float CBotGlobals :: quickTraceline (edict_t *pIgnore,Vector vSrc, Vector vDest)
+{
+	return quickTraceline(pIgnore,vSrc,vDest,&m_TraceResult);
+}
+
+float CBotGlobals :: quickTraceline ( edict_t *pIgnore, const Vector &vSrc, const Vector &vDest, trace_t *pTrace )
 {
 	CTraceFilterVis filter = CTraceFilterVis(pIgnore);
 
-	Ray_t ray;
-	memset(&m_TraceResult,0,sizeof(trace_t));
-	ray.Init( vSrc, vDest );
-	enginetrace->TraceRay( ray, MASK_NPCSOLID_BRUSHONLY, &filter, &m_TraceResult );
-	return m_TraceResult.fraction;
+	traceLine(vSrc,vDest,MASK_NPCSOLID_BRUSHONLY,&filter,pTrace);
+
+	return pTrace->fraction;
 }
 
 float CBotGlobals :: DotProductFromOrigin ( edict_t *pEnemy, Vector pOrigin )
@@ -485,7 +569,12 @@ float CBotGlobals :: DotProductFromOrigin ( Vector vPlayer, Vector vFacing, QAng
 
 bool CBotGlobals :: traceVisible (edict_t *pEnt)
 {
-	return (m_TraceResult.fraction >= 1.0)||(m_TraceResult.m_pEnt && pEnt && (m_TraceResult.m_pEnt==pEnt->GetUnknown()->GetBaseEntity()));
+	return traceVisible(&m_TraceResult,pEnt);
+}
+
+bool CBotGlobals :: traceVisible ( const trace_t *pTrace, edict_t *pEnt )
+{
+	return (pTrace->fraction >= 1.0)||(pTrace->m_pEnt && pEnt && (pTrace->m_pEnt==pEnt->GetUnknown()->GetBaseEntity()));
 }
 
 bool CBotGlobals::initModFolder() {
@@ -551,7 +640,7 @@ bool CBotGlobals :: gameStart ()
 
 void CBotGlobals :: levelInit ()
 {
-
+	resetTraceCache();
 }
 
 int CBotGlobals :: countTeamMatesNearOrigin ( Vector vOrigin, float fRange, int iTeam, edict_t *pIgnore )
@@ -704,90 +793,67 @@ bool CBotGlobals :: setWaypointDisplayType ( int iType )
 
 	return false;
 }
-// work on this
-bool CBotGlobals :: walkableFromTo (edict_t *pPlayer, Vector v_src, Vector v_dest)
+float CBotGlobals :: walkableWidth ( edict_t *pPlayer )
 {
-	CTraceFilterVis filter = CTraceFilterVis(pPlayer);
-	float fDistance = sqrt((v_dest - v_src).LengthSqr());
 	CClient *pClient = CClients::get(pPlayer);
-	Vector vcross = v_dest - v_src;
-	Vector vleftsrc,vleftdest, vrightsrc,vrightdest;
 	float fWidth = rcbot_wptplace_width.GetFloat();
 
-	if ( v_dest == v_src )
-		return true;
-
 	// minimum
 	if ( fWidth < 2.0f )
 		fWidth = 2.0f;
 
-	if ( pClient->autoWaypointOn() )
+	if ( pClient && pClient->autoWaypointOn() )
 		fWidth = 4.0f;
 
-	vcross = vcross / vcross.Length();
-	vcross = vcross.Cross(Vector(0,0,1));
-	vcross = vcross * (fWidth*0.5f);
-
-	vleftsrc = v_src - vcross;
-	vrightsrc = v_src + vcross;
-
-	vleftdest = v_dest - vcross;
-	vrightdest = v_dest + vcross;
-
-	if ( fDistance > CWaypointLocations::REACHABLE_RANGE )
-		return false;
-
-	//if ( !CBotGlobals::isVisible(v_src,v_dest) )
-	//	return false;
+	return fWidth;
+}
 
-	// can swim there?
-	if ((enginetrace->GetPointContents( v_src ) == CONTENTS_WATER) &&
-		(enginetrace->GetPointContents( v_dest ) == CONTENTS_WATER))
-	{
-		return true;
-	}
+// find the ground
+Vector CBotGlobals :: groundBelow ( edict_t *pPlayer, const Vector &vOrigin )
+{
+	CTraceFilterVis filter = CTraceFilterVis(pPlayer);
+	trace_t tr;
 
-	// find the ground
-	CBotGlobals::traceLine(v_src,v_src-Vector(0,0,256.0),MASK_NPCSOLID_BRUSHONLY,&filter);
+	CBotGlobals::traceLine(vOrigin,vOrigin-Vector(0,0,256.0),MASK_NPCSOLID_BRUSHONLY,&filter,&tr);
 #ifndef __linux__
-	debugoverlay->AddLineOverlay(v_src,v_src-Vector(0,0,256.0),255,0,255,false,3);
+	debugoverlay->AddLineOverlay(vOrigin,vOrigin-Vector(0,0,256.0),255,0,255,false,3);
 #endif
-	Vector v_ground_src = CBotGlobals::getTraceResult()->endpos + Vector(0,0,1);
+	return tr.endpos + Vector(0,0,1);
+}
 
-	CBotGlobals::traceLine(v_dest,v_dest-Vector(0,0,256.0),MASK_NPCSOLID_BRUSHONLY,&filter);
-#ifndef __linux__
-	debugoverlay->AddLineOverlay(v_dest,v_dest-Vector(0,0,256.0),255,255,0,false,3);
-#endif
-	Vector v_ground_dest = CBotGlobals::getTraceResult()->endpos + Vector(0,0,1);
+// false if there's a step or ledge on the way from v_src that is too high to jump
+bool CBotGlobals :: canStepFromTo ( edict_t *pPlayer, const Vector &v_src, const Vector &v_dest, const Vector &v_ground_src, const Vector &v_ground_dest )
+{
+	CTraceFilterVis filter = CTraceFilterVis(pPlayer);
+	trace_t tr;
+	float fDistance = sqrt((v_dest - v_src).LengthSqr());
 
-	if ( !CBotGlobals::isVisible(pPlayer,v_ground_src,v_ground_dest) )
+	if ( !CBotGlobals::isVisible(v_ground_src,v_ground_dest,&tr) )
 	{
 #ifndef __linux__
 		debugoverlay->AddLineOverlay(v_ground_src,v_ground_dest,0,255,255,false,3);		
 #endif
-		trace_t *tr = CBotGlobals::getTraceResult();
-
 		// no slope there
-		if ( tr->endpos.z > v_src.z )
+		if ( tr.endpos.z > v_src.z )
 		{
 #ifndef __linux__
 			debugoverlay->AddTextOverlay((v_ground_src+v_ground_dest)/2,0,3,"ground fail");
 #endif
 
-			CBotGlobals::traceLine(tr->endpos,tr->endpos-Vector(0,0,45),MASK_NPCSOLID_BRUSHONLY,&filter);
+			CBotGlobals::traceLine(tr.endpos,tr.endpos-Vector(0,0,45),MASK_NPCSOLID_BRUSHONLY,&filter,&tr);
 
-			Vector v_jsrc = tr->endpos;
+			Vector v_jsrc = tr.endpos;
 
 #ifndef __linux__
 			debugoverlay->AddLineOverlay(v_jsrc,v_jsrc-Vector(0,0,45),255,255,255,false,3);	
 #endif
 			// can't jump there
-			if ( ((v_jsrc.z - tr->endpos.z) + (v_dest.z-v_jsrc.z)) > 45.0f )
+			if ( ((v_jsrc.z - tr.endpos.z) + (v_dest.z-v_jsrc.z)) > 45.0f )
 			{
 				//if ( (tr->endpos.z > (v_src.z+45)) && (fDistance > 64.0f) )
 				//{
 #ifndef __linux__
-					debugoverlay->AddTextOverlay(tr->endpos,0,3,"jump fail");
+					debugoverlay->AddTextOverlay(tr.endpos,0,3,"jump fail");
 #endif
 					// check for slope or stairs
 					Vector v_norm = v_dest-v_src;
@@ -798,12 +864,12 @@ bool CBotGlobals :: walkableFromTo (edict_t *pPlayer, Vector v_src, Vector v_des
 						Vector v_checkpoint = v_src + (v_norm * fDistCheck);
 
 						// check jump height again
-						CBotGlobals::traceLine(v_checkpoint,v_checkpoint-Vector(0,0,45.0f),MASK_NPCSOLID_BRUSHONLY,&filter);
+						CBotGlobals::traceLine(v_checkpoint,v_checkpoint-Vector(0,0,45.0f),MASK_NPCSOLID_BRUSHONLY,&filter,&tr);
 
-						if ( CBotGlobals::traceVisible(NULL) )
+						if ( CBotGlobals::traceVisible(&tr,NULL) )
 						{
 #ifndef __linux__
-							debugoverlay->AddTextOverlay(tr->endpos,0,3,"step/jump fail");
+							debugoverlay->AddTextOverlay(tr.endpos,0,3,"step/jump fail");
 #endif
 							return false;
 						}
@@ -813,9 +879,60 @@ bool CBotGlobals :: walkableFromTo (edict_t *pPlayer, Vector v_src, Vector v_des
 		}
 	}
 
-	return CBotGlobals::isVisible(pPlayer,vleftsrc,vleftdest) && CBotGlobals::isVisible(pPlayer,vrightsrc,vrightdest);
+	return true;
+}
+
+// both sides of the path must be clear, the same either way along it
+bool CBotGlobals :: walkableSidesClear ( const Vector &v_src, const Vector &v_dest, float fWidth )
+{
+	bot_trace_t sides[2];
+	Vector vcross = v_dest - v_src;
+
+	vcross = vcross / vcross.Length();
+	vcross = vcross.Cross(Vector(0,0,1));
+	vcross = vcross * (fWidth*0.5f);
+
+	sides[0].vSrc = v_src - vcross;
+	sides[0].vDest = v_dest - vcross;
+	sides[1].vSrc = v_src + vcross;
+	sides[1].vDest = v_dest + vcross;
+
+	for ( register short int i = 0; i < 2; i ++ )
+	{
+		sides[i].iMask = MASK_SOLID_BRUSHONLY|CONTENTS_OPAQUE;
+		sides[i].pFilter = NULL;
+	}
+
+	CBotGlobals::traceLines(sides,2);
+
+	return CBotGlobals::traceVisible(&sides[0].tr,NULL) && CBotGlobals::traceVisible(&sides[1].tr,NULL);
+}
+
+// work on this
+bool CBotGlobals :: walkableFromTo (edict_t *pPlayer, Vector v_src, Vector v_dest)
+{
+	float fDistance = sqrt((v_dest - v_src).LengthSqr());
+
+	if ( v_dest == v_src )
+		return true;
+
+	if ( fDistance > CWaypointLocations::REACHABLE_RANGE )
+		return false;
+
+	//if ( !CBotGlobals::isVisible(v_src,v_dest) )
+	//	return false;
+
+	// can swim there?
+	if ((enginetrace->GetPointContents( v_src ) == CONTENTS_WATER) &&
+		(enginetrace->GetPointContents( v_dest ) == CONTENTS_WATER))
+	{
+		return true;
+	}
+
+	if ( !canStepFromTo(pPlayer,v_src,v_dest,groundBelow(pPlayer,v_src),groundBelow(pPlayer,v_dest)) )
+		return false;
 
-	//return true;
+	return walkableSidesClear(v_src,v_dest,walkableWidth(pPlayer));
 }
 
 #ifdef _LINUX
@@ -890,40 +1007,16 @@ bool CBotGlobals :: linesTouching3d (
 
 void CBotGlobals :: botMessage ( edict_t *pEntity, int iErr, const char *fmt, ... )
 {
-	va_list argptr; 
-	static char string[1024];
-
-	va_start (argptr, fmt);
-	vsprintf (string, fmt, argptr); 
-	va_end (argptr); 
-
-	const char *bot_tag = BOT_TAG;
-	int len = strlen(string);
-	int taglen = strlen(BOT_TAG);
-	// add tag -- push tag into string
-	for ( int i = len + taglen; i >= taglen; i -- )
-		string[i] = string[i-taglen];
-
-	string[len+taglen+1] = 0;
-
-	for ( int i = 0; i < taglen; i ++ )
-		string[i] = bot_tag[i];
+	va_list argptr;
+	int iLevel = iErr ? BOT_LOG_WARNING : BOT_LOG_INFO;
 
-	strcat(string,"\n");
+	// replies to a client always go out, console messages can be filtered
+	if ( (pEntity == NULL) && !CBotLog::wants(iLevel,BOT_LOG_GENERAL) )
+		return;
 
-	if ( pEntity )
-	{
-		engine->ClientPrintf(pEntity,string);
-	}
-	else
-	{
-		if ( iErr )
-		{
-			Warning(string);
-		}
-		else
-			Msg(string);
-	}
+	va_start (argptr, fmt);
+	CBotLog::writeArgs(NULL,iLevel,pEntity,fmt,argptr);
+	va_end (argptr);
 }
 
 bool CBotGlobals :: makeFolders ( char *szFile )
@@ -46,6 +46,28 @@
 #define MAX_PATH_LEN 512
 #define MAX_ENTITIES 2048
 
+// world traces cached per frame, keyed on the exact start/end/mask
+#define BOT_TRACE_CACHE_SIZE 2048 // must be a power of 2
+
+typedef struct
+{
+	int iFrame;
+	unsigned int iSrc[3]; // float bits, only the same ray is a hit
+	unsigned int iDest[3];
+	unsigned int iMask;
+	trace_t tr;
+}bot_trace_cache_t;
+
+// one trace of a batch, a NULL filter traces world and props only
+typedef struct
+{
+	Vector vSrc;
+	Vector vDest;
+	unsigned int iMask;
+	ITraceFilter *pFilter;
+	trace_t tr;
+}bot_trace_t;
+
 class CBotGlobals
 {
 public:
@@ -70,6 +92,11 @@ public:
 	}
 
 	static bool walkableFromTo (edict_t *pPlayer,Vector v_src, Vector v_dest);
+	// walkableFromTo in parts, so checking many pairs can find the ground under each end once
+	static float walkableWidth ( edict_t *pPlayer );
+	static Vector groundBelow ( edict_t *pPlayer, const Vector &vOrigin );
+	static bool canStepFromTo ( edict_t *pPlayer, const Vector &v_src, const Vector &v_dest, const Vector &v_ground_src, const Vector &v_ground_dest );
+	static bool walkableSidesClear ( const Vector &v_src, const Vector &v_dest, float fWidth );
 
 	static void teleportPlayer ( edict_t *pPlayer, Vector v_dest );
 
@@ -155,6 +182,7 @@ public:
 	static Vector rightVec ();
 	static Vector upVec ();*/
 	////////
+	// result of the last trace made without a trace_t of its own (main thread only)
 	static trace_t *getTraceResult () { return &m_TraceResult; }
 	static bool isVisibleHitAllExceptPlayer ( edict_t *pPlayer, Vector vSrc, Vector vDest, edict_t *pDest = NULL );
 	static bool isVisible ( edict_t *pPlayer, Vector vSrc, Vector vDest);
@@ -164,6 +192,15 @@ public:
 	static void traceLine ( Vector vSrc, Vector vDest, unsigned int mask, ITraceFilter *pFilter);
 	static float quickTraceline ( edict_t *pIgnore, Vector vSrc, Vector vDest ); // return fFraction
 	static bool traceVisible (edict_t *pEnt);
+
+	// traces that write to the caller's trace_t instead of getTraceResult()
+	static void traceLine ( const Vector &vSrc, const Vector &vDest, unsigned int mask, ITraceFilter *pFilter, trace_t *pTrace );
+	static void traceWorld ( const Vector &vSrc, const Vector &vDest, unsigned int mask, trace_t *pTrace );
+	static void traceLines ( bot_trace_t *pTraces, int iNum );
+	static float quickTraceline ( edict_t *pIgnore, const Vector &vSrc, const Vector &vDest, trace_t *pTrace );
+	static bool isVisible ( const Vector &vSrc, const Vector &vDest, trace_t *pTrace );
+	static bool traceVisible ( const trace_t *pTrace, edict_t *pEnt );
+	static void resetTraceCache ();
 	////////
 	static inline Vector entityOrigin ( edict_t *pEntity ) 
 	{ 
@@ -228,6 +265,7 @@ private:
 	static int m_iDebugLevels;
 	static bool m_bMapRunning;
 	static trace_t m_TraceResult;
+	static bot_trace_cache_t m_TraceCache[BOT_TRACE_CACHE_SIZE];
 	static int m_iMaxClients;
 	static int m_iEventVersion;
 	static int m_iWaypointDisplayType;
@@ -1,6 +1,7 @@
 #include "bot.h"
 #include "bot_kv.h"
 #include "bot_globals.h"
+#include "bot_log.h"
 
 void CRCBotKeyValueList :: parseFile ( FILE *fp )
 {
@@ -69,7 +70,7 @@ void CRCBotKeyValueList :: parseFile ( FILE *fp )
 		szKey[iKi] = 0;
 		szValue[iVi] = 0;
 
-		CBotGlobals::botMessage(NULL,0,"m_KVs.push_back(%s,%s)",szKey, szValue);
+		BOT_LOG(BOT_LOG_DEBUG,BOT_LOG_CONFIG,"m_KVs.push_back(%s,%s)",szKey, szValue);
 
 		m_KVs.push_back(new CRCBotKeyValue(szKey,szValue));
 
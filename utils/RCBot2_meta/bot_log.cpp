@@ -0,0 +1,238 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#include "engine_wrappers.h"
+
+#include "bot.h"
+#include "bot_cvars.h"
+#include "bot_log.h"
+
+#include "tier0/platform.h"
+
+bot_log_slot_t CBotLog::m_Slots[BOT_LOG_SLOTS];
+std::atomic<unsigned int> CBotLog::m_iWrite(0);
+unsigned int CBotLog::m_iRead = 0;
+std::atomic<unsigned int> CBotLog::m_iDropped(0);
+std::thread::id CBotLog::m_GameThread;
+bool CBotLog::m_bInitialised = false;
+
+void CBotLog :: init ()
+{
+	// each slot starts free for the write at its own position
+	for ( unsigned int i = 0; i < BOT_LOG_SLOTS; i ++ )
+		m_Slots[i].iSequence.store(i,std::memory_order_relaxed);
+
+	m_iWrite.store(0,std::memory_order_relaxed);
+	m_iRead = 0;
+	m_iDropped.store(0,std::memory_order_relaxed);
+	m_GameThread = std::this_thread::get_id();
+	m_bInitialised = true;
+}
+
+void CBotLog :: shutdown ()
+{
+	if ( !m_bInitialised )
+		return;
+
+	drain(BOT_LOG_SLOTS);
+
+	m_bInitialised = false;
+}
+
+bool CBotLog :: wants ( int iLevel, int iCategory )
+{
+	return (iLevel <= rcbot_log_level.GetInt()) && ((iCategory & rcbot_log_categories.GetInt()) != 0);
+}
+
+// the counts aren't atomic, at worst another thread lets an extra line through
+bool CBotLog :: rateLimited ( bot_log_site_t *pSite )
+{
+	int iRate = rcbot_log_rate.GetInt();
+	double fTime;
+
+	if ( iRate <= 0 )
+		return false;
+
+	fTime = Plat_FloatTime();
+
+	if ( (fTime - pSite->fWindowStart) >= 1.0 )
+	{
+		if ( pSite->iSuppressed > 0 )
+			write(NULL,BOT_LOG_WARNING,NULL,"(%u similar messages suppressed)",pSite->iSuppressed);
+
+		pSite->fWindowStart = fTime;
+		pSite->iCount = 0;
+		pSite->iSuppressed = 0;
+	}
+
+	if ( pSite->iCount >= (unsigned int)iRate )
+	{
+		pSite->iSuppressed++;
+		return true;
+	}
+
+	pSite->iCount++;
+
+	return false;
+}
+
+// claim the next free slot, NULL if the ring is full
+bot_log_slot_t *CBotLog :: reserve ( unsigned int *iPosition )
+{
+	unsigned int iPos = m_iWrite.load(std::memory_order_relaxed);
+	bot_log_slot_t *pSlot;
+	int iDiff;
+
+	while ( true )
+	{
+		pSlot = &m_Slots[iPos & (BOT_LOG_SLOTS-1)];
+		iDiff = (int)(pSlot->iSequence.load(std::memory_order_acquire) - iPos);
+
+		if ( iDiff == 0 )
+		{
+			// iPos is reloaded if another writer got here first
+			if ( m_iWrite.compare_exchange_weak(iPos,iPos+1,std::memory_order_relaxed) )
+			{
+				*iPosition = iPos;
+				return pSlot;
+			}
+		}
+		else if ( iDiff < 0 )
+			return NULL; // still waiting to be printed from last time round
+		else
+			iPos = m_iWrite.load(std::memory_order_relaxed);
+	}
+}
+
+void CBotLog :: write ( bot_log_site_t *pSite, int iLevel, edict_t *pEntity, const char *fmt, ... )
+{
+	va_list argptr;
+
+	va_start(argptr,fmt);
+	writeArgs(pSite,iLevel,pEntity,fmt,argptr);
+	va_end(argptr);
+}
+
+void CBotLog :: writeArgs ( bot_log_site_t *pSite, int iLevel, edict_t *pEntity, const char *fmt, va_list args )
+{
+	bot_log_slot_t *pSlot;
+	unsigned int iPos;
+
+	// replies to a client are never limited
+	if ( m_bInitialised && (pEntity == NULL) && (pSite != NULL) && rateLimited(pSite) )
+		return;
+
+	if ( isGameThread() )
+	{
+		char szMsg[BOT_LOG_MSG_LEN];
+
+		// anything other threads are waiting to print goes first
+		drain(BOT_LOG_SLOTS);
+
+		vsnprintf(szMsg,sizeof(szMsg),fmt,args);
+		print(iLevel,pEntity,szMsg);
+
+		return;
+	}
+
+	pSlot = reserve(&iPos);
+
+	if ( pSlot == NULL )
+	{
+		m_iDropped.fetch_add(1,std::memory_order_relaxed);
+		return;
+	}
+
+	vsnprintf(pSlot->szMsg,BOT_LOG_MSG_LEN,fmt,args);
+	pSlot->iLevel = iLevel;
+	pSlot->bToClient = (pEntity != NULL);
+	pSlot->pEntity = MyEHandle(pEntity);
+
+	// ready to print
+	pSlot->iSequence.store(iPos+1,std::memory_order_release);
+}
+
+void CBotLog :: drain ( unsigned int iMaxLines )
+{
+	bot_log_slot_t *pSlot;
+	unsigned int iDropped;
+
+	if ( !m_bInitialised || !isGameThread() )
+		return;
+
+	while ( iMaxLines > 0 )
+	{
+		pSlot = &m_Slots[m_iRead & (BOT_LOG_SLOTS-1)];
+
+		// stop at the first slot still being written
+		if ( pSlot->iSequence.load(std::memory_order_acquire) != (m_iRead+1) )
+			break;
+
+		if ( pSlot->bToClient )
+		{
+			edict_t *pEntity = pSlot->pEntity.get();
+
+			// client has left since
+			if ( pEntity != NULL )
+				print(pSlot->iLevel,pEntity,pSlot->szMsg);
+		}
+		else
+			print(pSlot->iLevel,NULL,pSlot->szMsg);
+
+		pSlot->pEntity = MyEHandle();
+		pSlot->iSequence.store(m_iRead+BOT_LOG_SLOTS,std::memory_order_release);
+		m_iRead++;
+		iMaxLines--;
+	}
+
+	iDropped = m_iDropped.exchange(0,std::memory_order_relaxed);
+
+	if ( iDropped > 0 )
+	{
+		char szMsg[64];
+
+		snprintf(szMsg,sizeof(szMsg),"log buffer full, %u messages dropped",iDropped);
+		print(BOT_LOG_WARNING,NULL,szMsg);
+	}
+}
+
+void CBotLog :: print ( int iLevel, edict_t *pEntity, const char *szMsg )
+{
+	char szLine[BOT_LOG_MSG_LEN+32];
+
+	snprintf(szLine,sizeof(szLine),"%s%s\n",BOT_TAG,szMsg);
+
+	if ( pEntity )
+		engine->ClientPrintf(pEntity,szLine);
+	else if ( iLevel <= BOT_LOG_WARNING )
+		Warning("%s",szLine);
+	else
+		Msg("%s",szLine);
+}
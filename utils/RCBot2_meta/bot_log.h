@@ -0,0 +1,122 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#ifndef __RCBOT_LOG_H__
+#define __RCBOT_LOG_H__
+
+#include <atomic>
+#include <thread>
+#include <stdarg.h>
+
+#include "bot_ehandle.h"
+
+// must be a power of two
+#define BOT_LOG_SLOTS 256
+#define BOT_LOG_MSG_LEN 1024
+// lines from other threads printed a frame, the rest wait for the next
+#define BOT_LOG_DRAIN_LINES 32
+
+typedef enum
+{
+	BOT_LOG_ERROR = 0,
+	BOT_LOG_WARNING,
+	BOT_LOG_INFO,
+	BOT_LOG_DEBUG
+}eBotLogLevel;
+
+// bits of rcbot_log_categories
+#define BOT_LOG_GENERAL		(1<<0)
+#define BOT_LOG_CONFIG		(1<<1) // config and key value files
+
+// rate limit of one place messages are written from
+typedef struct
+{
+	double fWindowStart;
+	unsigned int iCount;
+	unsigned int iSuppressed;
+}bot_log_site_t;
+
+typedef struct
+{
+	std::atomic<unsigned int> iSequence;
+	int iLevel;
+	bool bToClient;
+	MyEHandle pEntity; // print to this client instead of the server console
+	char szMsg[BOT_LOG_MSG_LEN];
+}bot_log_slot_t;
+
+// log a diagnostic message, filtered by level and category before it is
+// formatted and limited to rcbot_log_rate lines a second from each place
+#define BOT_LOG(level,category,...) \
+	do \
+	{ \
+		static bot_log_site_t rcbot_log_site = {0,0,0}; \
+		if ( CBotLog::wants(level,category) ) \
+			CBotLog::write(&rcbot_log_site,level,NULL,__VA_ARGS__); \
+	} while ( 0 )
+
+// the game thread prints its messages straight away. Other threads format
+// theirs into a fixed ring of slots without locking, and the game thread
+// prints a few of those each frame, since the engine's print functions
+// must be called from there. If the ring is full other threads drop the
+// message
+class CBotLog
+{
+public:
+	// remember the game thread, messages print straight away until this is called
+	static void init ();
+	// print everything waiting and go back to printing straight away
+	static void shutdown ();
+
+	static bool wants ( int iLevel, int iCategory );
+
+	// pSite may be NULL for no rate limit
+	static void write ( bot_log_site_t *pSite, int iLevel, edict_t *pEntity, const char *fmt, ... );
+	static void writeArgs ( bot_log_site_t *pSite, int iLevel, edict_t *pEntity, const char *fmt, va_list args );
+
+	// print up to iMaxLines waiting messages, game thread only
+	static void drain ( unsigned int iMaxLines );
+
+	static inline bool isGameThread () { return !m_bInitialised || (std::this_thread::get_id() == m_GameThread); }
+
+private:
+	static bool rateLimited ( bot_log_site_t *pSite );
+	static bot_log_slot_t *reserve ( unsigned int *iPosition );
+	static void print ( int iLevel, edict_t *pEntity, const char *szMsg );
+
+	static bot_log_slot_t m_Slots[BOT_LOG_SLOTS];
+	static std::atomic<unsigned int> m_iWrite;
+	static unsigned int m_iRead; // only the game thread reads
+	static std::atomic<unsigned int> m_iDropped;
+	static std::thread::id m_GameThread;
+	static bool m_bInitialised;
+};
+
+#endif
@@ -240,6 +240,9 @@ public:
 
 	int findNearestObjective ( Vector vOrigin );
 
+	// flags each team can take or has to hold
+	void updateFlowFields ();
+
 	inline int getWaypointAtFlag ( int iFlagId )
 	{
 		return m_iWaypoint[iFlagId];
@@ -517,6 +520,43 @@ private:
 	int m_iNumAxisBombsOnMap;
 };
 
+// smoke grenades older than this hide players
+#define DOD_SMOKE_THICK_TIME 1.0f
+#define MAX_DOD_SMOKES 16
+// edicts looked at each frame for new smoke grenades
+#define DOD_SMOKE_SCAN_EDICTS 128
+
+// smoke grenades on the map, kept once a frame for every bot to check against
+class CDODSmokes
+{
+public:
+	CDODSmokes()
+	{
+		reset();
+	}
+
+	void reset ();
+
+	void update ();
+
+	// found by a bot before the scan got to it
+	void add ( edict_t *pSmoke );
+
+	inline int numThick () { return m_iNumThick; }
+
+	// thickest smoke on the line from vFrom to vTo, 0 for none up to 1
+	// when it goes through the middle of a smoke
+	float getDensity ( const Vector &vFrom, const Vector &vTo );
+
+private:
+	MyEHandle m_pSmokes[MAX_DOD_SMOKES];
+	int m_iNumSmokes;
+	// middle of the smokes thick enough to hide behind
+	Vector m_vThick[MAX_DOD_SMOKES];
+	int m_iNumThick;
+	int m_iScanIndex;
+};
+
 class CDODMod : public CBotMod
 {
 public:
@@ -549,9 +589,13 @@ public:
 	void addWaypointFlags (edict_t *pPlayer, edict_t *pEdict, int *iFlags, int *iArea, float *fMaxDistance );
 
 	static CDODFlags m_Flags;
+	static CDODSmokes m_Smokes;
 
 	static bool shouldAttack ( int iTeam ); // uses the neural net to return probability of attack
 
+	// trains the attack/defend net and prints fAttackProbLookUp as source
+	static void generateAttackTable ( edict_t *pPrintTo );
+
 	static edict_t *getBombTarget ( CWaypoint *pWpt );
 	static edict_t *getBreakable ( CWaypoint *pWpt );
 
@@ -612,7 +656,7 @@ protected:
 	static std::vector<edict_wpt_pair_t> m_BreakableWaypoints;
 
 									// enemy			// team
-	static float fAttackProbLookUp[MAX_DOD_FLAGS+1][MAX_DOD_FLAGS+1];
+	static const float fAttackProbLookUp[MAX_DOD_FLAGS+1][MAX_DOD_FLAGS+1];
 };
 
 class CCounterStrikeSourceMod : public CBotMod
@@ -745,6 +789,22 @@ typedef struct
 //	short builder;
 }tf_disp_t;
 
+// every building by its entity index, so a building or sapper can be looked up
+// without searching each engineer's buildings. The handle's serial number tells
+// if the index has since been reused
+typedef struct
+{
+	MyEHandle building;
+	MyEHandle sapper;
+	short int owner; // entity index of the engineer
+	short int team;
+	eEngiBuild type;
+	int level;
+	short int listindex; // position in m_BuildingList, -1 if not listed
+}tf_building_t;
+
+#define MAX_TF2_BUILDINGS (MAX_PLAYERS*4) // sentry, dispenser, entrance and exit each
+
 
 class CTeamControlPointRound;
 class CTeamControlPointMaster;
@@ -922,6 +982,8 @@ public:
 		m_bHasRoundStarted = true;
 	    m_bRoundOver = false;
 		m_iWinningTeam = 0; 
+		// team only waypoints apply again
+		CWaypoints::teamFiltersChanged();
 	}
 
 	static void roundWon ( int iWinningTeam )
@@ -930,6 +992,7 @@ public:
 		m_bRoundOver = true;
 		m_iWinningTeam = iWinningTeam;
 		m_iLastWinningTeam = m_iWinningTeam;
+		CWaypoints::teamFiltersChanged();
 	}
 
 	static inline bool wonLastRound(int iTeam)
@@ -990,14 +1053,12 @@ public:
 
 	static edict_t *getSentryOwner ( edict_t *pSentry )
 	{
-		//for ( short int i = 1; i <= gpGlobals->maxClients; i ++ )
-		for ( short int i = 0; i < MAX_PLAYERS; i ++ )
-		{			
-			if ( m_SentryGuns[i].sentry.get() == pSentry )
-				return INDEXENT(i+1);
-		}
+		tf_building_t *pEntry = getBuildingEntry(pSentry);
 
-		return NULL;
+		if ( (pEntry == NULL) || (pEntry->type != ENGI_SENTRY) )
+			return NULL;
+
+		return INDEXENT(pEntry->owner);
 	}
 
 	static bool isMySentrySapped ( edict_t *pOwner ) 
@@ -1048,43 +1109,54 @@ public:
 
 	static bool isSentrySapped ( edict_t *pSentry )
 	{
-		unsigned int i;
-
-		for ( i = 0; i < MAX_PLAYERS; i ++ )
-		{
-			if ( m_SentryGuns[i].sentry.get() == pSentry )
-				return m_SentryGuns[i].sapper.get()!=NULL;
-		}
-
-		return false;
+		return isBuildingSapped(pSentry,ENGI_SENTRY);
 	}
 
 	static bool isTeleporterSapped ( edict_t *pTele )
 	{
-		unsigned int i;
+		return isBuildingSapped(pTele,ENGI_TELE);
+	}
 
-		for ( i = 0; i < MAX_PLAYERS; i ++ )
-		{
-			if ( (m_Teleporters[i].entrance.get() == pTele) || (m_Teleporters[i].exit.get() == pTele) )
-				return m_Teleporters[i].sapper.get()!=NULL;
-		}
+	static bool isDispenserSapped ( edict_t *pDisp )
+	{
+		return isBuildingSapped(pDisp,ENGI_DISP);
+	}
 
-		return false;
+	static bool isBuildingSapped ( edict_t *pBuilding, eEngiBuild type )
+	{
+		tf_building_t *pEntry = getBuildingEntry(pBuilding);
+
+		return (pEntry != NULL) && (pEntry->type == type) && (pEntry->sapper.get() != NULL);
 	}
 
-	static bool isDispenserSapped ( edict_t *pDisp )
+	// registered building at this entity, NULL if it isn't one or has gone
+	static tf_building_t *getBuildingEntry ( edict_t *pBuilding )
 	{
-		unsigned int i;
+		int index;
 
-		for ( i = 0; i < MAX_PLAYERS; i ++ )
-		{
-			if ( m_Dispensers[i].disp.get() == pDisp )
-				return m_Dispensers[i].sapper.get()!=NULL;
-		}
+		if ( pBuilding == NULL )
+			return NULL;
 
-		return false;
+		index = ENTINDEX(pBuilding);
+
+		if ( (index <= 0) || (index >= MAX_EDICTS) )
+			return NULL;
+
+		if ( m_Buildings[index].building.get() != pBuilding )
+			return NULL;
+
+		return &(m_Buildings[index]);
 	}
 
+	// level kept by the upgrade events, read from the entity if it isn't registered
+	static int getBuildingLevel ( edict_t *pBuilding );
+
+	static void buildingUpgraded ( int index );
+	static void removeBuilding ( int index );
+
+	// nearest of a team's buildings of a type within fMaxDistance
+	static edict_t *nearestBuilding ( eEngiBuild type, int team, Vector vOrigin, float fMaxDistance );
+
 	static edict_t *findResourceEntity ();
 
 	static void addCapDefender ( edict_t *pPlayer, int iCapIndex )
@@ -1200,6 +1272,14 @@ private:
 	static tf_sentry_t m_SentryGuns[MAX_PLAYERS];	// used to let bots know if sentries have been sapped or not
 	static tf_disp_t  m_Dispensers[MAX_PLAYERS];	// used to let bots know where friendly/enemy dispensers are
 
+	static void addBuilding ( edict_t *pOwner, eEngiBuild type, edict_t *pBuilding );
+	static void resetBuildings ();
+
+	static tf_building_t m_Buildings[MAX_EDICTS];	// by entity index of the building
+	static short int m_SapperBuilding[MAX_EDICTS];	// by entity index of a sapper, the building it is on
+	static short int m_BuildingList[MAX_TF2_BUILDINGS];	// entity indices of registered buildings
+	static int m_iNumBuildings;
+
 	static int m_iArea;
 
 	static float m_fSetupTime;
@@ -44,6 +44,8 @@ class CNavMesh;
 class CWaypointVisibilityTable;
 
 #define MAX_BELIEF 200.0f
+// failed moves on routes to one goal that are repaired before the goal is failed
+#define MAX_ROUTE_REPAIRS 2
 
 class INavigatorNode
 {
@@ -102,6 +104,11 @@ public:
 
 	virtual void getFailedGoals (WaypointList **goals) = 0;
 
+	// the route just worked out, next waypoint first, for other bots to use
+	virtual bool getRoute ( WaypointList *pRoute ) { return false; }
+	// use a route from the current waypoint another bot worked out instead of searching
+	virtual bool setRoute ( const WaypointList &route, float fDistance ) { return false; }
+
 	inline Vector getGoalOrigin () { return m_vGoal; }
 
 	virtual bool nextPointIsOnLadder () { return false; }
@@ -360,11 +367,33 @@ typedef struct
 	bool bSkipped;
 }failedpath_t;
 
+// a value per waypoint, grows with the waypoints in use instead of
+// reserving MAX_WAYPOINTS for every bot
+class CWaypointValues
+{
+public:
+	inline float &operator [] ( int iWpt )
+	{
+		if ( iWpt >= (int)m_fValues.size() )
+			m_fValues.resize(iWpt+1,0.0f);
+
+		return m_fValues[iWpt];
+	}
+
+	// every value back to zero
+	inline void clear () { m_fValues.clear(); }
+
+	inline size_t size () const { return m_fValues.size(); }
+private:
+	std::vector<float> m_fValues;
+};
+
 class CWaypointNavigator : public IBotNavigator
 {
 public:
 	CWaypointNavigator ( CBot *pBot ) 
 	{ 
+		m_RepairBits.clear();
 		init();
 		m_pBot = pBot; 
 		m_fNextClearFailedGoals = 0;
@@ -373,6 +402,8 @@ public:
 		m_bLoadBelief = true;
 		m_bBeliefChanged = false;
 		memset(&m_lastFailedPath,0,sizeof(failedpath_t));
+		clearRepairRoute();
+		m_bCorridor = false;
 	}
 
 	void init ();
@@ -437,6 +468,10 @@ public:
 
 	void getFailedGoals (WaypointList **goals) { *goals = &m_iFailedGoals; }
 
+	bool getRoute ( WaypointList *pRoute );
+
+	bool setRoute ( const WaypointList &route, float fDistance );
+
 	int numPaths ( );
 
 	Vector getPath ( int pathid );
@@ -463,6 +498,12 @@ public:
 	int getPathFlags ( int iPath );
 
 private:
+	bool canRepairRoute ();
+	bool followFlowField ();
+	void resetPaths ();
+	bool isRepairNode ( int iWpt );
+	void clearRepairRoute ();
+
 	CBot *m_pBot;
 
 	//CWaypointVisibilityTable *m_pDangerNodes;
@@ -476,19 +517,37 @@ private:
 
 	failedpath_t m_lastFailedPath;
 
+	// rest of the route when the last move failed, so the next search to the same
+	// goal only needs to find a way back onto it
+	WaypointList m_RepairRoute;
+	CWaypointBits m_RepairBits; // waypoints in m_RepairRoute
+	int m_iRepairGoal;
+	float m_fRepairTime;
+	bool m_bRepairing;
+	// failed moves towards m_iRepairFailGoal, the goal is failed after MAX_ROUTE_REPAIRS
+	int m_iRepairFailGoal;
+	int m_iRepairFails;
+
+	// waypoints the area graph route goes through, the search stays inside them
+	CWaypointBits m_Corridor;
+	bool m_bCorridor;
+
 	std::stack<int> m_currentRoute;
 	std::queue<int> m_oldRoute;
 
 	int m_iLastFailedWpt;
 
-	AStarNode paths[CWaypoints::MAX_WAYPOINTS];
+	// search nodes for the waypoints in use, only the nodes the
+	// last search opened need resetting before the next one
+	std::vector<AStarNode> paths;
+	WaypointList m_OpenedPaths;
 	AStarNode *curr;
 	AStarNode *succ;
 
 	WaypointList m_iFailedGoals;
 	float m_fNextClearFailedGoals;
 
-	float m_fBelief [CWaypoints::MAX_WAYPOINTS];
+	CWaypointValues m_fBelief;
 
 	AStarOpenList m_theOpenList;
 
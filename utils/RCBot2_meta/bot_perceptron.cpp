@@ -34,20 +34,69 @@
 #include "bot_mtrand.h"
 #include "bot_perceptron.h"
 
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+#define BOT_PERCEPTRON_SSE
+#include <xmmintrin.h>
+#endif
+
 ga_nn_value CPerceptron::m_fDefaultLearnRate = 0.5f;
 ga_nn_value CPerceptron::m_fDefaultBias = 1.0f;
 
+inline ga_nn_value nn_sigmoid ( ga_nn_value x )
+{
+	return 1.0f/(1.0f+exp(-x));
+}
+
+ga_nn_value nn_dot ( const ga_nn_value *a, const ga_nn_value *b, unsigned short int iCount )
+{
+	unsigned short int i;
+
+#ifdef BOT_PERCEPTRON_SSE
+	__m128 sum = _mm_setzero_ps();
+	__m128 shuf;
+
+	for ( i = 0; i < iCount; i += NN_ROW_ALIGN )
+		sum = _mm_add_ps(sum,_mm_mul_ps(_mm_loadu_ps(a+i),_mm_loadu_ps(b+i)));
+
+	// horizontal add
+	shuf = _mm_shuffle_ps(sum,sum,_MM_SHUFFLE(2,3,0,1));
+	sum = _mm_add_ps(sum,shuf);
+	shuf = _mm_movehl_ps(shuf,sum);
+	sum = _mm_add_ss(sum,shuf);
+
+	return _mm_cvtss_f32(sum);
+#else
+	ga_nn_value sum = 0;
+
+	for ( i = 0; i < iCount; i ++ )
+		sum += a[i] * b[i];
+
+	return sum;
+#endif
+}
+
 CNeuron :: CNeuron ()
 {
 	m_weights = NULL;
 	m_inputs = NULL;
+	m_iInputs = 0;
+	m_iStride = 0;
 }
 
-CPerceptron :: CPerceptron (unsigned short int iInputs)
+void CNeuron :: alloc ( unsigned short int iInputs )
 {
-	m_inputs = new ga_nn_value [iInputs];//.clear();
-	m_weights = new ga_nn_value[iInputs];
 	m_iInputs = iInputs;
+	m_iStride = nn_stride(iInputs);
+
+	// weights followed by inputs, padding stays zero
+	m_weights = new ga_nn_value[m_iStride*2];
+	memset(m_weights,0,sizeof(ga_nn_value)*m_iStride*2);
+	m_inputs = m_weights + m_iStride;
+}
+
+CPerceptron :: CPerceptron (unsigned short int iInputs)
+{
+	alloc(iInputs);
 	
 	m_LearnRate = 0.4f;
 	// bias weight
@@ -69,24 +118,8 @@ void CNeuron :: input ( ga_nn_value *inputs )
 
 ga_nn_value CPerceptron :: execute ()
 {
-	static unsigned short int i;
-	static ga_nn_value *w;
-	static ga_nn_value *x;
 	// bias weight
-	m_output = m_Bias;
-
-	w = m_weights;
-	x = m_inputs;
-	
-	for ( i = 0; i < m_iInputs; i ++ )
-	{
-		m_output += (*w) * (*x);
-		w++;
-		x++;
-	}
-	
-	// sigmoid function
-	m_output = 1.0f/(1.0f+exp(-m_output)); //m_transferFunction->transfer(fNetInput);
+	m_output = nn_sigmoid(m_Bias + nn_dot(m_weights,m_inputs,m_iStride));
 	
 	return m_output;
 }
@@ -103,298 +136,284 @@ ga_nn_value CPerceptron :: getOutput ()
 
 void CPerceptron :: train ( ga_nn_value expectedOutput )
 {
-	static unsigned short int i;
-	static ga_nn_value *w;
-	static ga_nn_value *x;
-
-	w = m_weights;
-	x = m_inputs;
+	register unsigned short int i;
+	ga_nn_value delta = m_LearnRate*(expectedOutput-m_output);
 
 	// bias
-	m_Bias += m_LearnRate*(expectedOutput-m_output);
+	m_Bias += delta;
 	
 	for ( i = 0; i < m_iInputs; i ++ )
-	{
-		*w = *w + m_LearnRate*(expectedOutput-m_output)* (*x);
-		w++;
-		x++;
-	}
+		m_weights[i] += delta * m_inputs[i];
 }
 
-void CLogisticalNeuron :: train ()// ITransfer *transferFunction, bool usebias )
+static void nn_initLayer ( nn_layer_t *pLayer, unsigned short int iInputs, unsigned short int iNeurons )
 {
-	static unsigned short int i;
-	static ga_nn_value *w;
-	static ga_nn_value *x;
-	static ga_nn_value delta;
+	register unsigned short int i;
+	register unsigned short int j;
 
-	w = m_weights;
-	x = m_inputs;
+	pLayer->iInputs = iInputs;
+	pLayer->iNeurons = iNeurons;
+	pLayer->iStride = nn_stride(iInputs);
 
-	for ( i = 0; i < m_iInputs; i ++ )
+	pLayer->weights = new ga_nn_value[iNeurons*pLayer->iStride];
+	pLayer->bias = new ga_nn_value[iNeurons];
+	pLayer->momentum = new ga_nn_value[iNeurons];
+	pLayer->error = new ga_nn_value[iNeurons];
+	pLayer->output = new ga_nn_value[nn_stride(iNeurons)];
+
+	memset(pLayer->weights,0,sizeof(ga_nn_value)*iNeurons*pLayer->iStride);
+	memset(pLayer->output,0,sizeof(ga_nn_value)*nn_stride(iNeurons));
+
+	for ( i = 0; i < iNeurons; i ++ )
 	{
-		delta = (m_LearnRate * (*x) * m_error);
-		delta += m_momentum * 0.9f;
-		*w = *w + delta;
-		m_momentum = delta;
-		x++;
-		w++;
+		for ( j = 0; j < iInputs; j ++ )
+			pLayer->weights[i*pLayer->iStride+j] = randomFloat(-0.99f,0.99f);
+
+		pLayer->bias[i] = -1.0f;
+		pLayer->momentum[i] = 0;
+		pLayer->error[i] = 0;
 	}
+}
 
-	m_Bias += m_LearnRate * m_error;
+static void nn_freeLayer ( nn_layer_t *pLayer )
+{
+	delete[] pLayer->weights;
+	delete[] pLayer->bias;
+	delete[] pLayer->momentum;
+	delete[] pLayer->error;
+	delete[] pLayer->output;
 }
 
-ga_nn_value CLogisticalNeuron :: execute (  )//, bool usebias )
+CBotNeuralNet :: CBotNeuralNet ( unsigned short int numinputs, unsigned short int numhiddenlayers, 
+							  unsigned short int neuronsperhiddenlayer, unsigned short int numoutputs, 
+								ga_nn_value learnrate)
 {
-	static unsigned short int i;
-	static ga_nn_value *w;
-	static ga_nn_value *x;
+	register unsigned short int l;
 
-	m_netinput = 0;
-	w = m_weights;
-	x = m_inputs;
+	m_numInputs = numinputs;
+	m_numOutputs = numoutputs;
+	m_numHidden = neuronsperhiddenlayer;
+	m_numHiddenLayers = numhiddenlayers;
+	m_LearnRate = learnrate;
 
-	// bias weight
-	m_netinput = m_Bias;
-	
-	for ( i = 0; i < m_iInputs; i ++ )	
-	{
-		m_netinput += (*w) * (*x);
-		w++;
-		x++;
-	}
+	m_numLayers = numhiddenlayers+1;
+	m_pLayers = new nn_layer_t[m_numLayers];
 
-	m_output = 1/(1+exp(-m_netinput));//transferFunction->transfer(m_netinput);
-	
-	return m_output;
+	for ( l = 0; l < numhiddenlayers; l ++ )
+		nn_initLayer(&m_pLayers[l],(l == 0) ? numinputs : neuronsperhiddenlayer,neuronsperhiddenlayer);
+
+	nn_initLayer(&m_pLayers[numhiddenlayers],(numhiddenlayers == 0) ? numinputs : neuronsperhiddenlayer,numoutputs);
+
+	m_iMaxStride = nn_stride(_MAX(numoutputs,_MAX(numinputs,neuronsperhiddenlayer)));
+
+	m_layerinput = new ga_nn_value[nn_stride(numinputs)];
+	memset(m_layerinput,0,sizeof(ga_nn_value)*nn_stride(numinputs));
+
+	m_batchA = NULL;
+	m_batchB = NULL;
+	m_iBatchRows = 0;
 }
 
-void CLogisticalNeuron::init(unsigned short int iInputs, ga_nn_value learnrate)
+CBotNeuralNet :: ~CBotNeuralNet ()
 {
-		m_weights = new ga_nn_value[iInputs];
-		m_inputs = new ga_nn_value[iInputs];
+	for ( unsigned short int l = 0; l < m_numLayers; l ++ )
+		nn_freeLayer(&m_pLayers[l]);
 
-		m_error = 0;
-		m_netinput = 0;
-		m_LearnRate = 0.2f;
-		m_output = 0;
-		m_momentum = 0;
+	delete[] m_pLayers;
+	delete[] m_layerinput;
 
-		// initialise?
-		for ( unsigned short int i = 0; i < iInputs; i ++ )
-			m_weights[i] = randomFloat(-0.99f,0.99f);
+	freeBatch();
+}
 
-		m_iInputs = iInputs;
-		m_LearnRate = learnrate;
+void CBotNeuralNet :: freeBatch ()
+{
+	if ( m_batchA )
+		delete[] m_batchA;
+	if ( m_batchB )
+		delete[] m_batchB;
+
+	m_batchA = NULL;
+	m_batchB = NULL;
+	m_iBatchRows = 0;
 }
 
-CBotNeuralNet :: CBotNeuralNet ( unsigned short int numinputs, unsigned short int numhiddenlayers, 
-							  unsigned short int neuronsperhiddenlayer, unsigned short int numoutputs, 
-								ga_nn_value learnrate)
+// runs m_layerinput through every layer, leaving each layer's output in place
+void CBotNeuralNet :: forward ()
 {
 	register unsigned short int i;
-	register unsigned short int j;
-
-	m_pOutputs = new CLogisticalNeuron[numoutputs];
-	m_pHidden = new CLogisticalNeuron*[numhiddenlayers];
-
-	m_layerinput = new ga_nn_value[_MAX(numinputs,neuronsperhiddenlayer)];
-	m_layeroutput = new ga_nn_value[_MAX(numoutputs,_MAX(numinputs,neuronsperhiddenlayer))];
+	register unsigned short int l;
+	const ga_nn_value *in = m_layerinput;
+	const ga_nn_value *w;
+	nn_layer_t *pLayer;
 
-	for ( j = 0; j < numhiddenlayers; j ++ )
+	for ( l = 0; l < m_numLayers; l ++ )
 	{
-		m_pHidden[j] = new CLogisticalNeuron[neuronsperhiddenlayer];
+		pLayer = &m_pLayers[l];
+		w = pLayer->weights;
 
-		for ( i = 0; i < neuronsperhiddenlayer; i ++ )
+		for ( i = 0; i < pLayer->iNeurons; i ++ )
 		{
-			if ( j == 0 )
-				m_pHidden[j][i].init(numinputs,learnrate);
-			else
-				m_pHidden[j][i].init(neuronsperhiddenlayer,learnrate);
+			pLayer->output[i] = nn_sigmoid(pLayer->bias[i] + nn_dot(w,in,pLayer->iStride));
+			w += pLayer->iStride;
 		}
-	}
-
-	for ( i = 0; i < numoutputs; i ++ )
-		m_pOutputs[i].init(neuronsperhiddenlayer,learnrate);
-
-	//m_transferFunction = new CSigmoidTransfer ();
-
-	m_numInputs = numinputs;
-	m_numOutputs = numoutputs;
-	m_numHidden = neuronsperhiddenlayer;
-	m_numHiddenLayers = numhiddenlayers;
-
 
+		in = pLayer->output;
+	}
 }
 
-#define RCPP_VERB_EPOCHS 1000
-
 void CBotNeuralNet :: batch_train ( CTrainingSet *tset, unsigned short int epochs )
 {
-	ga_nn_value *outs;
-	ga_nn_value exp_out; // expected
 	ga_nn_value act_out; // actual
-	ga_nn_value out_error;
+	ga_nn_value err;
+	ga_nn_value delta;
 	unsigned short int e; // epoch
 	register unsigned short int bi; // batch iterator
 	register unsigned short int i; // ith node
-	register unsigned short int j; //jth output
+	register unsigned short int j; // jth node of the next layer
 	register signed short int l; // layer
-	CLogisticalNeuron *pNode, *pOutputNode;
+	nn_layer_t *pLayer;
+	nn_layer_t *pNext;
+	const ga_nn_value *in;
+	ga_nn_value *w;
 	unsigned short int numbatches = tset->getNumBatches();
 	training_batch_t *batches = tset->getBatches();
-	ga_nn_value min_value = tset->getMinScale();
-	ga_nn_value max_value = tset->getMaxScale();
-
-	outs = new ga_nn_value [m_numOutputs];
+	nn_layer_t *pOutput = &m_pLayers[m_numLayers-1];
 
 	for ( e = 0; e < epochs; e ++ )
 	{
-		/*if ( !(e%RCPP_VERB_EPOCHS) )
-		{
-			system("CLS");
-			printf("-----epoch %d-----\n",e);
-			printf("training... %0.1f percent",(((float)e/epochs))*100);
-			printf("in1\tin2\texp\tact\terr\n");
-		}*/
-
 		for ( bi = 0; bi < numbatches; bi ++ )
 		{
-			memset(outs,0,sizeof(ga_nn_value)*m_numOutputs);
+			memcpy(m_layerinput,batches[bi].in,sizeof(ga_nn_value)*m_numInputs);
 
-			execute(batches[bi].in,outs,min_value,max_value);
-
-			pNode = m_pOutputs;
+			forward();
 
 			// work out error for output layer
 			for ( j = 0; j < m_numOutputs; j ++ )
 			{
-				act_out = pNode->getOutput();
-				exp_out = batches[bi].out[j];
-				out_error = act_out * (1.0f-act_out) * (exp_out - act_out);
-				pNode->setError(out_error);
-				pNode++;
+				act_out = pOutput->output[j];
+				pOutput->error[j] = act_out * (1.0f-act_out) * (batches[bi].out[j] - act_out);
 			}
 
-			/*if (  !(e%RCPP_VERB_EPOCHS) )
+			// send error back through the hidden layers
+			for ( l = (m_numLayers-2); l >= 0; l -- )
 			{
-				printf("%0.2f\t%0.2f\t%0.2f\t%0.6f\t%0.6f\n",batches[bi].in[0],batches[bi].in[1],batches[bi].out[0],outs[0],out_error);
-			}*/
-
-			pNode = m_pHidden[m_numHiddenLayers-1];
+				pLayer = &m_pLayers[l];
+				pNext = &m_pLayers[l+1];
 
-			//Send Error back to Hidden Layer before output
-			for ( i = 0; i < m_numHidden; i ++ )
-			{	
-				ga_nn_value err = 0;
-				pOutputNode = m_pOutputs;
-
-				for ( j = 0; j < m_numOutputs; j ++ )
+				for ( i = 0; i < pLayer->iNeurons; i ++ )
 				{
-					err += pOutputNode->getError(i);
-					pOutputNode++;
-				}
+					err = 0;
 
-				//pNode = &m_pHidden[m_numHiddenLayers-1][i];
+					for ( j = 0; j < pNext->iNeurons; j ++ )
+						err += pNext->error[j] * pNext->weights[j*pNext->iStride+i];
 
-				pNode->setError(pNode->getOutput() * (1.0f-pNode->getOutput()) * err);
-				pNode++;
+					act_out = pLayer->output[i];
+					pLayer->error[i] = act_out * (1.0f-act_out) * err;
+				}
 			}
 
-			for ( l = (m_numHiddenLayers-2); l >= 0; l -- )
-			{
-				pOutputNode = m_pHidden[l];
-				//Send Error back to Input Layer
-				for ( i = 0; i < m_numHidden; i ++ )
-				{	
-					ga_nn_value err = 0;
+			// update weights, each layer learns from the input it was given
+			in = m_layerinput;
 
-					pNode = m_pHidden[l+1];
+			for ( l = 0; l < m_numLayers; l ++ )
+			{
+				pLayer = &m_pLayers[l];
+				w = pLayer->weights;
 
-					for ( j = 0; j < m_numHidden; j ++ )
+				for ( i = 0; i < pLayer->iNeurons; i ++ )
+				{
+					for ( j = 0; j < pLayer->iInputs; j ++ )
 					{
-						// check the error from the next layer
-						err += pNode->getError(i);
-						pNode++;
+						delta = (m_LearnRate * in[j] * pLayer->error[i]);
+						delta += pLayer->momentum[i] * 0.9f;
+						w[j] += delta;
+						pLayer->momentum[i] = delta;
 					}
 
-					pOutputNode->setError((pOutputNode->getOutput() * (1.0f-pOutputNode->getOutput())) * err);
-					pOutputNode ++;
+					pLayer->bias[i] += m_LearnRate * pLayer->error[i];
+					w += pLayer->iStride;
 				}
-			}
 
-			for ( j = 0; j < m_numHiddenLayers; j ++ )
-			{
-				pNode = m_pHidden[j];
-				// update weights for hidden layer (each neuron)
-				for ( i = 0; i < m_numHidden; i ++ )
-				{	
-					pNode->train(); // update weights for this node
-					pNode++;
-				}
-			}
-
-			// update weights for output layer
-			for ( i = 0; i < m_numOutputs; i ++ )
-			{	
-				m_pOutputs[i].train(); // update weights for this node
+				in = pLayer->output;
 			}
 		}
 	}
-
-	delete[] outs;
 }
 
 void CBotNeuralNet :: execute ( ga_nn_value *inputs, ga_nn_value *outputs, ga_nn_value fMin, ga_nn_value fMax )
 {
+	register unsigned short int i;
+	nn_layer_t *pOutput = &m_pLayers[m_numLayers-1];
 
-	static CLogisticalNeuron *pNode;
-	static CLogisticalNeuron *pLayer;
-	static unsigned short int i; // i-th node
-	static unsigned short l; // layer
-	static ga_nn_value *output_it;
-
-	memset(outputs,0,sizeof(ga_nn_value)*m_numOutputs);
-	memset(m_layeroutput,0,sizeof(ga_nn_value)*m_numInputs);
 	memcpy(m_layerinput,inputs,sizeof(ga_nn_value)*m_numInputs);
 
-	// Missing inputs!!!
-	for (i = 0; i < m_numInputs; i++)
-		m_layerinput[i] = inputs[i];
+	forward();
 
-	for ( l = 0; l < m_numHiddenLayers; l ++ )
+	for ( i = 0; i < m_numOutputs; i ++ )
+		outputs[i] = gdescale(pOutput->output[i],fMin,fMax);
+}
+
+// layer by layer over every row so each weight row is loaded once per layer
+void CBotNeuralNet :: executeBatch ( const ga_nn_value *inputs, ga_nn_value *outputs, unsigned short int numrows, ga_nn_value fMin, ga_nn_value fMax )
+{
+	register unsigned short int r; // row
+	register unsigned short int i; // ith node
+	unsigned short int l; // layer
+	nn_layer_t *pLayer;
+	const ga_nn_value *w;
+	ga_nn_value *in;
+	ga_nn_value *out;
+	ga_nn_value *swap;
+
+	if ( numrows == 0 )
+		return;
+
+	if ( numrows > m_iBatchRows )
 	{
-		output_it = m_layeroutput;
+		freeBatch();
 
-		//pLayer = m_pHidden[l];
+		m_batchA = new ga_nn_value[numrows*m_iMaxStride];
+		m_batchB = new ga_nn_value[numrows*m_iMaxStride];
+		m_iBatchRows = numrows;
+	}
 
-		pNode = m_pHidden[l];
+	in = m_batchA;
+	out = m_batchB;
 
-		// execute hidden
-		for ( i = 0; i < m_numHidden; i ++ )
-		{
-			pNode->input(m_layerinput);
-			pNode->execute();//m_transferFunction);
+	for ( r = 0; r < numrows; r ++ )
+	{
+		memset(&in[r*m_iMaxStride],0,sizeof(ga_nn_value)*m_iMaxStride);
+		memcpy(&in[r*m_iMaxStride],&inputs[r*m_numInputs],sizeof(ga_nn_value)*m_numInputs);
+	}
 
-			*output_it = pNode->getOutput();
-			output_it ++;
+	for ( l = 0; l < m_numLayers; l ++ )
+	{
+		pLayer = &m_pLayers[l];
+		w = pLayer->weights;
 
-			pNode++; // next
-			//layeroutput.push_back(pNode->getOutput());
+		for ( i = 0; i < pLayer->iNeurons; i ++ )
+		{
+			for ( r = 0; r < numrows; r ++ )
+				out[r*m_iMaxStride+i] = nn_sigmoid(pLayer->bias[i] + nn_dot(w,&in[r*m_iMaxStride],pLayer->iStride));
+
+			w += pLayer->iStride;
 		}
 
-		memcpy(m_layerinput,m_layeroutput,sizeof(ga_nn_value) * m_numHidden);
+		// keep the padding of each row zero for the next layer
+		for ( r = 0; r < numrows; r ++ )
+		{
+			for ( i = pLayer->iNeurons; i < nn_stride(pLayer->iNeurons); i ++ )
+				out[r*m_iMaxStride+i] = 0;
+		}
 
-		//pLayer++;
+		swap = in;
+		in = out;
+		out = swap;
 	}
 
-	// execute output
-	for ( i = 0; i < m_numOutputs; i ++ )
+	for ( r = 0; r < numrows; r ++ )
 	{
-		pNode = &m_pOutputs[i];
-		pNode->input(m_layeroutput);
-		pNode->execute();//m_transferFunction);
-		outputs[i] = gdescale(pNode->getOutput(),fMin,fMax);
+		for ( i = 0; i < m_numOutputs; i ++ )
+			outputs[r*m_numOutputs+i] = gdescale(in[r*m_iMaxStride+i],fMin,fMax);
 	}
 }
-
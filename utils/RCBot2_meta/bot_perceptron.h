@@ -62,14 +62,25 @@ inline ga_nn_value descale (ga_nn_value x, ga_nn_value min, ga_nn_value max)
 	return x;//((minus_one_to_one) + 1.0f)/2;
 }
 */
+// rows of weights are padded to a multiple of this so dot products
+// can always run four values at a time (padding is kept at zero)
+#define NN_ROW_ALIGN 4
+
+inline unsigned short int nn_stride ( unsigned short int iCount )
+{
+	return (iCount + (NN_ROW_ALIGN-1)) & ~(NN_ROW_ALIGN-1);
+}
+
+// dot product of two padded rows, iCount must be a multiple of NN_ROW_ALIGN
+ga_nn_value nn_dot ( const ga_nn_value *a, const ga_nn_value *b, unsigned short int iCount );
+
 class CNeuron
 {
 public:
 	CNeuron ();
 
-	CNeuron (unsigned short int iInputs);
-
-	~CNeuron() { if ( m_inputs ) delete[] m_inputs; if ( m_weights ) delete[] m_weights; }
+	// weights and inputs share one padded block
+	~CNeuron() { if ( m_weights ) delete[] m_weights; }
 
 	void setWeights ( ga_nn_value *weights );
 
@@ -84,8 +95,11 @@ public:
 	inline ga_nn_value getOutput () { return m_output; }
 
 protected:
+
+	void alloc ( unsigned short int iInputs );
 	
 	unsigned short int m_iInputs;
+	unsigned short int m_iStride; // padded length of m_weights / m_inputs
 	ga_nn_value m_LearnRate;
 	ga_nn_value *m_inputs;
 	ga_nn_value *m_weights;
@@ -115,37 +129,19 @@ public:
 
 };
 
-class CLogisticalNeuron : public CNeuron
+// one fully connected layer of logistic neurons
+// weights are row-major, one padded row per neuron
+typedef struct
 {
-public:
-	CLogisticalNeuron()
-	{
-		m_error = 0;
-		m_netinput = 0;
-		m_LearnRate = 0.2f;
-		m_output = 0;
-		m_iInputs = 0;
-		m_momentum = 0;
-		m_Bias = -1.0f;
-	}
-
-	void init(unsigned short int iInputs, ga_nn_value learnrate);
-
-	void train ();/// ITransfer *transferFunction, bool usebias = true );
-
-	ga_nn_value execute ();//, bool usebias = true );
-
-	inline void setError ( ga_nn_value err ) { m_error = err; }
-	inline void addError ( ga_nn_value err ) { m_error += err; }
-	inline void divError ( unsigned short int samples ) { m_error /= samples; }
-
-	inline ga_nn_value getError ( unsigned short int w ) { return m_error * m_weights[w]; }
-	inline ga_nn_value getMSE () { return m_error; }
-private:
-	ga_nn_value m_error;
-	ga_nn_value m_netinput;
-	ga_nn_value m_momentum;
-};
+	unsigned short int iNeurons;
+	unsigned short int iInputs;
+	unsigned short int iStride; // padded row length (inputs)
+	ga_nn_value *weights; // iNeurons * iStride
+	ga_nn_value *bias; // iNeurons
+	ga_nn_value *momentum; // iNeurons
+	ga_nn_value *error; // iNeurons
+	ga_nn_value *output; // nn_stride(iNeurons), feeds the next layer
+}nn_layer_t;
 
 typedef struct
 {
@@ -281,54 +277,37 @@ public:
 
 	CBotNeuralNet(unsigned short int numinputs, unsigned short int numhiddenlayers, unsigned short int neuronsperhiddenlayer, unsigned short int numoutputs, ga_nn_value learnrate);
 
-	CBotNeuralNet ()
-	{
-		m_pOutputs = NULL;
-		//m_transferFunction = NULL;
-
-		m_numInputs = 0; // number of inputs
-		m_numOutputs = 0; // number of outputs
-		m_numHidden = 0; // neurons per hidden layer
-		m_numHiddenLayers = 0;
-		m_layeroutput = NULL;
-		m_layerinput = NULL;
-	}
+	~CBotNeuralNet ();
 
 	void execute ( ga_nn_value *inputs, ga_nn_value *outputs, ga_nn_value fMin, ga_nn_value fMax );
 
-	void batch_train ( CTrainingSet *tset, unsigned short int epochs );
-
-	~CBotNeuralNet ()
-	{
-		if ( m_pOutputs )
-			delete [] m_pOutputs;
-		//if ( m_transferFunction )
-		//	delete m_transferFunction;
-		if ( m_pHidden )
-		{
-			for ( unsigned short int i = 0; i < m_numHiddenLayers; i ++ )
-				delete [] m_pHidden[i];
-		}
-
-		delete m_layerinput;
-		delete m_layeroutput;
-	}
+	// runs the net over numrows input rows in one go (e.g. one row per bot)
+	// inputs is numrows * numinputs, outputs is numrows * numoutputs
+	void executeBatch ( const ga_nn_value *inputs, ga_nn_value *outputs, unsigned short int numrows, ga_nn_value fMin, ga_nn_value fMax );
 
+	void batch_train ( CTrainingSet *tset, unsigned short int epochs );
 
 private:
-	//ITransfer *m_transferFunction;
+	void forward ();
+	void freeBatch ();
+
 	unsigned short int m_numInputs; // number of inputs
 	unsigned short int m_numOutputs; // number of outputs
 	unsigned short int m_numHidden; // neurons per hidden layer
 	unsigned short int m_numHiddenLayers;
+	ga_nn_value m_LearnRate;
 
-	CLogisticalNeuron *m_pOutputs;
-	CLogisticalNeuron **m_pHidden;
+	// hidden layers followed by the output layer
+	nn_layer_t *m_pLayers;
+	unsigned short int m_numLayers;
+	unsigned short int m_iMaxStride;
 
-	// used for passing values between layers
-	ga_nn_value *m_layeroutput;
+	// padded input row for the first layer
 	ga_nn_value *m_layerinput;
 
-
+	// scratch for batched execute, two numrows * m_iMaxStride buffers
+	ga_nn_value *m_batchA;
+	ga_nn_value *m_batchB;
+	unsigned short int m_iBatchRows;
 };
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,323 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+
+#ifndef __linux__
+#include <windows.h>
+#include <io.h> // for _commit
+#else
+#include <unistd.h> // for fsync
+#endif
+
+#include <errno.h>
+#include <string.h>
+
+#include "engine_wrappers.h"
+
+#include "bot.h"
+#include "bot_globals.h"
+#include "bot_log.h"
+#include "bot_persist.h"
+
+std::deque<bot_persist_job_t> CBotPersist::m_Jobs;
+std::string CBotPersist::m_szWriting;
+bot_persist_job_t *CBotPersist::m_pWriting = NULL;
+std::thread CBotPersist::m_Thread;
+std::mutex CBotPersist::m_Mutex;
+std::condition_variable CBotPersist::m_Work;
+std::condition_variable CBotPersist::m_Done;
+bool CBotPersist::m_bStop = false;
+
+// a joinable std::thread destroyed at exit calls std::terminate, so the
+// worker is dealt with if the process exits without the plugin unloading.
+// Defined after the members above so it is destroyed before them
+class CBotPersistExitGuard
+{
+public:
+	~CBotPersistExitGuard () { CBotPersist::onExit(); }
+};
+
+static CBotPersistExitGuard g_PersistExitGuard;
+
+void CBotPersist :: save ( const char *szFilename, CBotSaveBuffer &buffer, const char *szDone, edict_t *pNotify )
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	if ( !m_Thread.joinable() )
+	{
+		m_bStop = false;
+		m_Thread = std::thread(worker);
+	}
+
+	for ( unsigned int i = 0; i < m_Jobs.size(); i ++ )
+	{
+		// not started yet, only the newest matters
+		if ( m_Jobs[i].szFilename == szFilename )
+		{
+			m_Jobs[i].data.swap(buffer.m_Data);
+			m_Jobs[i].szDone = (szDone != NULL) ? szDone : "";
+			m_Jobs[i].pNotify = MyEHandle(pNotify);
+			buffer.m_Data.clear();
+			return;
+		}
+	}
+
+	m_Jobs.push_back(bot_persist_job_t());
+	m_Jobs.back().szFilename = szFilename;
+	m_Jobs.back().data.swap(buffer.m_Data);
+	m_Jobs.back().szDone = (szDone != NULL) ? szDone : "";
+	m_Jobs.back().pNotify = MyEHandle(pNotify);
+	buffer.m_Data.clear();
+
+	m_Work.notify_one();
+}
+
+void CBotPersist :: wait ( const char *szFilename )
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	while ( true )
+	{
+		bool bPending = (m_szWriting == szFilename);
+
+		for ( unsigned int i = 0; !bPending && (i < m_Jobs.size()); i ++ )
+			bPending = (m_Jobs[i].szFilename == szFilename);
+
+		if ( !bPending )
+			return;
+
+		m_Done.wait(lock);
+	}
+}
+
+bool CBotPersist :: getPending ( const char *szFilename, std::vector<unsigned char> *pData )
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	// the last queued save is the newest, then the one being written
+	for ( int i = (int)m_Jobs.size()-1; i >= 0; i -- )
+	{
+		if ( m_Jobs[i].szFilename == szFilename )
+		{
+			*pData = m_Jobs[i].data;
+			return true;
+		}
+	}
+
+	// the worker only reads the data it is writing
+	if ( (m_pWriting != NULL) && (m_szWriting == szFilename) )
+	{
+		*pData = m_pWriting->data;
+		return true;
+	}
+
+	return false;
+}
+
+void CBotPersist :: shutdown ()
+{
+	{
+		std::unique_lock<std::mutex> lock(m_Mutex);
+
+		if ( !m_Thread.joinable() )
+			return;
+
+		m_bStop = true;
+		m_Work.notify_one();
+	}
+
+	// the worker empties the queue before it stops
+	m_Thread.join();
+}
+
+void CBotPersist :: onExit ()
+{
+	if ( !m_Thread.joinable() )
+		return;
+
+#ifndef __linux__
+	// other threads are already stopped by now or would wait on the loader lock
+	m_Thread.detach();
+#else
+	shutdown();
+#endif
+}
+
+unsigned int CBotPersist :: numPending ()
+{
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	return m_Jobs.size() + (m_szWriting.empty() ? 0 : 1);
+}
+
+void CBotPersist :: worker ()
+{
+	bot_persist_job_t job;
+	std::unique_lock<std::mutex> lock(m_Mutex);
+
+	while ( true )
+	{
+		while ( m_Jobs.empty() && !m_bStop )
+			m_Work.wait(lock);
+
+		if ( m_Jobs.empty() )
+			break; // stopping and nothing left
+
+		job.szFilename.swap(m_Jobs.front().szFilename);
+		job.data.swap(m_Jobs.front().data);
+		job.szDone.swap(m_Jobs.front().szDone);
+		job.pNotify = m_Jobs.front().pNotify;
+		m_Jobs.pop_front();
+		m_szWriting = job.szFilename;
+		m_pWriting = &job;
+
+		lock.unlock();
+
+		if ( writeFile(&job) )
+		{
+			BOT_LOG(BOT_LOG_DEBUG,BOT_LOG_GENERAL,"saved %s (%u bytes)",job.szFilename.c_str(),(unsigned int)job.data.size());
+
+			if ( !job.szDone.empty() )
+				report(&job,0,"%s",job.szDone.c_str());
+		}
+
+		lock.lock();
+
+		m_szWriting.clear();
+		m_pWriting = NULL;
+		m_Done.notify_all();
+	}
+}
+
+// strerror isn't safe off the game thread, errno must be saved by the caller
+// straight after the call that failed
+static const char *persistError ( int iErrno, char *szBuf, size_t iSize )
+{
+#ifndef __linux__
+	strerror_s(szBuf,iSize,iErrno);
+	return szBuf;
+#else
+	// the GNU version, which may return its own string instead of filling szBuf
+	return strerror_r(iErrno,szBuf,iSize);
+#endif
+}
+
+bool CBotPersist :: writeFile ( bot_persist_job_t *pJob )
+{
+	std::string szTemp = pJob->szFilename + ".tmp";
+	char szError[256];
+	int iErrno = 0;
+	bool bOK;
+	FILE *fp;
+
+	// not CBotGlobals::openFile, its messages would change errno first
+	fp = fopen(szTemp.c_str(),"wb");
+
+	if ( fp == NULL )
+	{
+		CBotGlobals::makeFolders((char*)szTemp.c_str());
+
+		fp = fopen(szTemp.c_str(),"wb");
+
+		if ( fp == NULL )
+		{
+			iErrno = errno;
+			report(pJob,1,"can't save %s: %s",pJob->szFilename.c_str(),persistError(iErrno,szError,sizeof(szError)));
+			return false;
+		}
+	}
+
+	bOK = pJob->data.empty() || (fwrite(&pJob->data[0],1,pJob->data.size(),fp) == pJob->data.size());
+
+	if ( bOK && (fflush(fp) != 0) )
+		bOK = false;
+
+	// on the disk before it replaces the old file
+#ifndef __linux__
+	if ( bOK && (_commit(_fileno(fp)) != 0) )
+		bOK = false;
+#else
+	if ( bOK && (fsync(fileno(fp)) != 0) )
+		bOK = false;
+#endif
+
+	if ( !bOK )
+		iErrno = errno;
+
+	if ( (fclose(fp) != 0) && bOK )
+	{
+		iErrno = errno;
+		bOK = false;
+	}
+
+	if ( !bOK )
+	{
+		report(pJob,1,"can't save %s: %s",pJob->szFilename.c_str(),persistError(iErrno,szError,sizeof(szError)));
+		remove(szTemp.c_str());
+		return false;
+	}
+
+#ifndef __linux__
+	// MoveFileExA doesn't set errno
+	if ( MoveFileExA(szTemp.c_str(),pJob->szFilename.c_str(),MOVEFILE_REPLACE_EXISTING|MOVEFILE_WRITE_THROUGH) == 0 )
+	{
+		report(pJob,1,"can't save %s: replacing it failed (error %lu)",pJob->szFilename.c_str(),(unsigned long)GetLastError());
+		remove(szTemp.c_str());
+		return false;
+	}
+#else
+	if ( rename(szTemp.c_str(),pJob->szFilename.c_str()) != 0 )
+	{
+		iErrno = errno;
+		report(pJob,1,"can't save %s: %s",pJob->szFilename.c_str(),persistError(iErrno,szError,sizeof(szError)));
+		remove(szTemp.c_str());
+		return false;
+	}
+#endif
+
+	return true;
+}
+
+// to the console, and the player who asked for the save if there was one
+void CBotPersist :: report ( bot_persist_job_t *pJob, int iErr, const char *fmt, ... )
+{
+	char szMsg[1024];
+	va_list argptr;
+	edict_t *pNotify = pJob->pNotify.get();
+
+	va_start(argptr,fmt);
+	vsnprintf(szMsg,sizeof(szMsg),fmt,argptr);
+	va_end(argptr);
+
+	CBotGlobals::botMessage(NULL,iErr,"%s",szMsg);
+
+	if ( pNotify != NULL )
+		CBotGlobals::botMessage(pNotify,iErr,"%s",szMsg);
+}
@@ -0,0 +1,111 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#ifndef __RCBOT_PERSIST_H__
+#define __RCBOT_PERSIST_H__
+
+#include <vector>
+#include <deque>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+#include "bot_ehandle.h"
+
+// a file built in memory, written the same way as with fwrite
+class CBotSaveBuffer
+{
+public:
+	inline void write ( const void *pData, size_t iSize, size_t iCount )
+	{
+		const unsigned char *pBytes = (const unsigned char*)pData;
+
+		m_Data.insert(m_Data.end(),pBytes,pBytes+(iSize*iCount));
+	}
+
+	inline void reserve ( size_t iSize ) { m_Data.reserve(iSize); }
+
+	inline size_t size () { return m_Data.size(); }
+
+	friend class CBotPersist;
+private:
+	std::vector<unsigned char> m_Data;
+};
+
+typedef struct
+{
+	std::string szFilename;
+	std::vector<unsigned char> data;
+	std::string szDone; // printed once written, empty for nothing
+	MyEHandle pNotify; // player told the outcome as well as the console
+}bot_persist_job_t;
+
+// writes bot data files on a worker thread so saving doesn't hold up the
+// game. Each file goes to a .tmp first and is renamed over the old one
+// once it's all on disk, a crash part way leaves the old file alone.
+// Anything reading a file that may be saving must call wait() first
+class CBotPersist
+{
+public:
+	// takes the contents of buffer, a save of the same file still waiting is replaced.
+	// szDone (if not NULL) is printed when the file is on disk, to pNotify as well
+	static void save ( const char *szFilename, CBotSaveBuffer &buffer, const char *szDone = NULL, edict_t *pNotify = NULL );
+
+	// wait for any save of this file to finish
+	static void wait ( const char *szFilename );
+
+	// copy of the newest save of this file not yet on disk, false if there's none
+	// and the file can be read as it is. Lets the game thread read a file back
+	// without waiting on wait()
+	static bool getPending ( const char *szFilename, std::vector<unsigned char> *pData );
+
+	// finish every save and stop the worker
+	static void shutdown ();
+	// the process is exiting without shutdown() having been called
+	static void onExit ();
+
+	static unsigned int numPending ();
+private:
+	static void worker ();
+	static bool writeFile ( bot_persist_job_t *pJob );
+	static void report ( bot_persist_job_t *pJob, int iErr, const char *fmt, ... );
+
+	static std::deque<bot_persist_job_t> m_Jobs;
+	static std::string m_szWriting; // file the worker has now
+	static bot_persist_job_t *m_pWriting; // and its job, NULL when idle
+	static std::thread m_Thread;
+	static std::mutex m_Mutex;
+	static std::condition_variable m_Work;
+	static std::condition_variable m_Done;
+	static bool m_bStop;
+};
+
+#endif
@@ -42,8 +42,16 @@
 #include "bot_accessclient.h"
 #include "bot_weapons.h"
 #include "bot_waypoint_visibility.h"
+#include "bot_waypoint_influence.h"
+#include "bot_waypoint_indirect.h"
+#include "bot_waypoint_autopath.h"
 #include "bot_kv.h"
 #include "bot_sigscan.h"
+#include "bot_replay.h"
+#include "bot_route_scheduler.h"
+#include "bot_event_fanout.h"
+#include "bot_log.h"
+#include "bot_persist.h"
 
 #include <build_info.h>
 
@@ -320,6 +328,8 @@ bool RCBotPluginMeta::Load(PluginId id, ISmmAPI *ismm, char *error, size_t maxle
 
 	PLUGIN_SAVEVARS();
 
+	CBotLog::init();
+
 	GET_V_IFACE_CURRENT(GetEngineFactory, enginetrace, IEngineTrace, INTERFACEVERSION_ENGINETRACE_SERVER);	
 	GET_V_IFACE_CURRENT(GetEngineFactory, engine, IVEngineServer, INTERFACEVERSION_VENGINESERVER);
 	GET_V_IFACE_CURRENT(GetEngineFactory, gameevents, IGameEventManager2, INTERFACEVERSION_GAMEEVENTSMANAGER2);
@@ -569,6 +579,12 @@ bool RCBotPluginMeta::Unload(char *error, size_t maxlen)
 	//if ( gameevents )
 	//	gameevents->RemoveListener(this);
 
+	// saves still queued finish before the plugin goes
+	CBotPersist::shutdown();
+
+	// print anything left while the cvars are still there
+	CBotLog::shutdown();
+
 	ConVar_Unregister( );
 
 	return true;
@@ -767,8 +783,13 @@ void RCBotPluginMeta::Hook_GameFrame(bool simulating)
 
 	static CBotMod *currentmod;
 
+	// messages from last frame, printed even while paused
+	CBotLog::drain(BOT_LOG_DRAIN_LINES);
+
 	if ( simulating && CBotGlobals::IsMapRunning() )
 	{
+		CClassInterface::frameUpdate();
+		CWaypointInfluence::update();
 		CBots::botThink();
 		CClients::clientThink();
 
@@ -776,6 +797,11 @@ void RCBotPluginMeta::Hook_GameFrame(bool simulating)
 		{
 			CWaypoints::getVisiblity()->workVisibility();
 		}
+		else
+			CWaypointIndirectFire::work();
+
+		// paths for waypoints added recently
+		CWaypointAutoPath::work();
 
 		// Profiling
 #ifdef _DEBUG
@@ -890,6 +916,7 @@ bool RCBotPluginMeta::Hook_LevelInit(const char *pMapName,
 		//CClients::initall();
 	// Must set this
 	CBotGlobals::setMapName(pMapName);
+	CBotGlobals::levelInit();
 
 	Msg( "Level \"%s\" has been loaded\n", pMapName );
 
@@ -942,8 +969,14 @@ void RCBotPluginMeta::Hook_LevelShutdown()
 {
 	META_LOG(g_PLAPI, "Hook_LevelShutdown()");
 
+	// before the clients they are for go
+	CBotLog::drain(BOT_LOG_SLOTS);
+
 	CClients::initall();
 	CWaypointDistances::save();
+	CBotReplay::stopRecording();
+	CBotRouteScheduler::reset();
+	CBotEventFanout::reset();
 
 	CBots::freeMapMemory();	
 	CWaypoints::init();
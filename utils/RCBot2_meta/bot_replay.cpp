@@ -0,0 +1,650 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#include "engine_wrappers.h"
+
+#include "bot.h"
+#include "bot_globals.h"
+#include "bot_event.h"
+#include "bot_navigator.h"
+#include "bot_waypoint.h"
+#include "bot_waypoint_locations.h"
+#include "bot_waypoint_visibility.h"
+#include "bot_wpt_dist.h"
+#include "bot_replay.h"
+
+#include "tier0/platform.h"
+
+FILE *CBotReplay::m_fp = NULL;
+unsigned int CBotReplay::m_iFrames = 0;
+
+///////////////////////////////////////////////////////////////
+// Event wrapper
+
+CReplayEventInterface :: CReplayEventInterface ( IBotEventInterface *pEvent )
+{
+	m_pEvent = pEvent;
+	strncpy(m_szName,pEvent->getName(),REPLAY_MAX_KEY-1);
+	m_szName[REPLAY_MAX_KEY-1] = 0;
+}
+
+CReplayEventInterface :: CReplayEventInterface ( const char *szName, const std::vector<replay_event_key_t> &keys )
+{
+	m_pEvent = NULL;
+	strncpy(m_szName,szName,REPLAY_MAX_KEY-1);
+	m_szName[REPLAY_MAX_KEY-1] = 0;
+	m_Keys = keys;
+}
+
+CReplayEventInterface :: ~CReplayEventInterface ()
+{
+	if ( m_pEvent != NULL )
+		delete m_pEvent;
+	m_pEvent = NULL;
+}
+
+const char *CReplayEventInterface :: findKey ( const char *keyName )
+{
+	for ( unsigned int i = 0; i < m_Keys.size(); i ++ )
+	{
+		if ( strcmp(m_Keys[i].szKey,keyName) == 0 )
+			return m_Keys[i].szValue;
+	}
+
+	return NULL;
+}
+
+void CReplayEventInterface :: storeKey ( const char *keyName, const char *szValue )
+{
+	replay_event_key_t key;
+
+	if ( !keyName || !*keyName )
+		return;
+
+	for ( unsigned int i = 0; i < m_Keys.size(); i ++ )
+	{
+		if ( strcmp(m_Keys[i].szKey,keyName) == 0 )
+		{
+			strncpy(m_Keys[i].szValue,szValue?szValue:"",REPLAY_MAX_VALUE-1);
+			m_Keys[i].szValue[REPLAY_MAX_VALUE-1] = 0;
+			return;
+		}
+	}
+
+	if ( m_Keys.size() >= REPLAY_MAX_EVENT_KEYS )
+		return;
+
+	memset(&key,0,sizeof(replay_event_key_t));
+	strncpy(key.szKey,keyName,REPLAY_MAX_KEY-1);
+	strncpy(key.szValue,szValue?szValue:"",REPLAY_MAX_VALUE-1);
+
+	m_Keys.push_back(key);
+}
+
+float CReplayEventInterface :: getFloat ( const char *keyName, float defaultValue )
+{
+	if ( m_pEvent != NULL )
+	{
+		char szValue[REPLAY_MAX_VALUE];
+		float fValue = m_pEvent->getFloat(keyName,defaultValue);
+
+		snprintf(szValue,REPLAY_MAX_VALUE,"%f",fValue);
+		storeKey(keyName,szValue);
+
+		return fValue;
+	}
+	else
+	{
+		const char *szValue = findKey(keyName);
+
+		return (szValue != NULL) ? (float)atof(szValue) : defaultValue;
+	}
+}
+
+int CReplayEventInterface :: getInt ( const char *keyName, int defaultValue )
+{
+	if ( m_pEvent != NULL )
+	{
+		char szValue[REPLAY_MAX_VALUE];
+		int iValue = m_pEvent->getInt(keyName,defaultValue);
+
+		snprintf(szValue,REPLAY_MAX_VALUE,"%d",iValue);
+		storeKey(keyName,szValue);
+
+		return iValue;
+	}
+	else
+	{
+		const char *szValue = findKey(keyName);
+
+		return (szValue != NULL) ? atoi(szValue) : defaultValue;
+	}
+}
+
+const char *CReplayEventInterface :: getString ( const char *keyName, const char *defaultValue )
+{
+	if ( m_pEvent != NULL )
+	{
+		const char *szValue = m_pEvent->getString(keyName,defaultValue);
+
+		if ( szValue != NULL )
+			storeKey(keyName,szValue);
+
+		return szValue;
+	}
+	else
+	{
+		const char *szValue = findKey(keyName);
+
+		return (szValue != NULL) ? szValue : defaultValue;
+	}
+}
+
+const char *CReplayEventInterface :: getName ()
+{
+	return m_szName;
+}
+
+void CReplayEventInterface :: setInt ( const char *keyName, int value )
+{
+	char szValue[REPLAY_MAX_VALUE];
+
+	if ( m_pEvent != NULL )
+		m_pEvent->setInt(keyName,value);
+
+	snprintf(szValue,REPLAY_MAX_VALUE,"%d",value);
+	storeKey(keyName,szValue);
+}
+
+void CReplayEventInterface :: write ( FILE *fp )
+{
+	int iTag = REPLAY_REC_EVENT;
+	int iNumKeys = (int)m_Keys.size();
+
+	fwrite(&iTag,sizeof(int),1,fp);
+	fwrite(m_szName,sizeof(char),REPLAY_MAX_KEY,fp);
+	fwrite(&iNumKeys,sizeof(int),1,fp);
+
+	for ( unsigned int i = 0; i < m_Keys.size(); i ++ )
+		fwrite(&m_Keys[i],sizeof(replay_event_key_t),1,fp);
+}
+
+///////////////////////////////////////////////////////////////
+// Recording
+
+bool CBotReplay :: startRecording ( const char *szName, edict_t *pPrintTo )
+{
+	char filename[1024];
+	replay_hdr_t hdr;
+	char *szMapName = CBotGlobals::getMapName();
+
+	if ( isRecording() )
+	{
+		CBotGlobals::botMessage(pPrintTo,0,"already recording a replay, stop it first");
+		return false;
+	}
+
+	if ( !szMapName || !*szMapName )
+	{
+		CBotGlobals::botMessage(pPrintTo,0,"no map running, can't record a replay");
+		return false;
+	}
+
+	CBotGlobals::buildFileName(filename,szName,BOT_REPLAY_FOLDER,BOT_REPLAY_EXTENSION,true);
+
+	m_fp = CBotGlobals::openFile(filename,"wb");
+
+	if ( m_fp == NULL )
+	{
+		CBotGlobals::botMessage(pPrintTo,0,"can't open replay file \"%s\" for writing",filename);
+		return false;
+	}
+
+	memset(&hdr,0,sizeof(replay_hdr_t));
+	strncpy(hdr.szFileType,BOT_REPLAY_FILE_TYPE,15);
+	strncpy(hdr.szMapName,szMapName,63);
+	hdr.iVersion = BOT_REPLAY_VERSION;
+	hdr.iMaxClients = CBotGlobals::maxClients();
+	hdr.iVisibleBytes = REPLAY_VISIBLE_BYTES;
+
+	fwrite(&hdr,sizeof(replay_hdr_t),1,m_fp);
+
+	m_iFrames = 0;
+
+	CBotGlobals::botMessage(pPrintTo,0,"recording replay to \"%s\"",filename);
+
+	return true;
+}
+
+void CBotReplay :: stopRecording ( edict_t *pPrintTo )
+{
+	int iTag = REPLAY_REC_END;
+
+	if ( !isRecording() )
+		return;
+
+	fwrite(&iTag,sizeof(int),1,m_fp);
+	fclose(m_fp);
+	m_fp = NULL;
+
+	CBotGlobals::botMessage(pPrintTo,0,"replay stopped after %d frames",m_iFrames);
+}
+
+void CBotReplay :: recordFrame ()
+{
+	static replay_player_t players[MAX_PLAYERS];
+	static edict_t *pPlayer;
+	int iTag = REPLAY_REC_FRAME;
+	int iNumPlayers = 0;
+	float fTime = engine->Time();
+
+	if ( !isRecording() )
+		return;
+
+	for ( register short int i = 1; i <= CBotGlobals::maxClients(); i ++ )
+	{
+		pPlayer = INDEXENT(i);
+
+		if ( !CBotGlobals::entityIsValid(pPlayer) )
+			continue;
+
+		replay_player_t *p = &players[iNumPlayers++];
+		Vector vOrigin = CBotGlobals::entityOrigin(pPlayer);
+
+		p->iIndex = i;
+		p->iTeam = CBotGlobals::getTeam(pPlayer);
+		p->iFlags = 0;
+
+		if ( CBotGlobals::entityIsAlive(pPlayer) )
+			p->iFlags |= REPLAY_PLAYER_ALIVE;
+		if ( CBots::getBotPointer(pPlayer) != NULL )
+			p->iFlags |= REPLAY_PLAYER_BOT;
+
+		p->fOrigin[0] = vOrigin.x;
+		p->fOrigin[1] = vOrigin.y;
+		p->fOrigin[2] = vOrigin.z;
+	}
+
+	fwrite(&iTag,sizeof(int),1,m_fp);
+	fwrite(&fTime,sizeof(float),1,m_fp);
+	fwrite(&iNumPlayers,sizeof(int),1,m_fp);
+	fwrite(players,sizeof(replay_player_t),iNumPlayers,m_fp);
+
+	m_iFrames++;
+}
+
+void CBotReplay :: recordBot ( CBot *pBot )
+{
+	static unsigned char visible[REPLAY_VISIBLE_BYTES];
+	int iTag = REPLAY_REC_BOT;
+	replay_bot_t bot;
+	IBotNavigator *pNav;
+
+	if ( !isRecording() )
+		return;
+
+	pNav = pBot->getNavigator();
+
+	bot.iIndex = ENTINDEX(pBot->getEdict());
+	bot.iCurrentWaypoint = pNav ? pNav->getCurrentWaypointID() : -1;
+	bot.iGoalWaypoint = pNav ? pNav->getCurrentGoalID() : -1;
+
+	memset(visible,0,sizeof(visible));
+
+	for ( register short int i = 1; i <= CBotGlobals::maxClients(); i ++ )
+	{
+		edict_t *pPlayer = INDEXENT(i);
+
+		if ( CBotGlobals::entityIsValid(pPlayer) && pBot->isVisible(pPlayer) )
+			visible[i/8] |= (1<<(i%8));
+	}
+
+	fwrite(&iTag,sizeof(int),1,m_fp);
+	fwrite(&bot,sizeof(replay_bot_t),1,m_fp);
+	fwrite(visible,sizeof(unsigned char),REPLAY_VISIBLE_BYTES,m_fp);
+}
+
+void CBotReplay :: recordEvent ( CReplayEventInterface *pEvent )
+{
+	if ( !isRecording() )
+		return;
+
+	pEvent->write(m_fp);
+}
+
+///////////////////////////////////////////////////////////////
+// Replay
+
+typedef struct
+{
+	const char *szName;
+	unsigned int iCalls;
+	double fTotal;
+	double fMax;
+}replay_stat_t;
+
+enum
+{
+	REPLAY_STAT_NEAREST_WPT = 0,
+	REPLAY_STAT_VISIBILITY,
+	REPLAY_STAT_DISTANCE,
+	REPLAY_STAT_ROUTE,
+	REPLAY_STAT_EVENT,
+	REPLAY_STAT_FRAME, // everything between two recorded frames
+	REPLAY_STATS
+};
+
+static inline double replayStat ( replay_stat_t *pStat, double fStart )
+{
+	double fTime = Plat_FloatTime() - fStart;
+
+	pStat->iCalls++;
+	pStat->fTotal += fTime;
+
+	if ( fTime > pStat->fMax )
+		pStat->fMax = fTime;
+
+	return fTime;
+}
+
+static inline void replayFrameStat ( replay_stat_t *pStat, double fTime )
+{
+	pStat->iCalls++;
+	pStat->fTotal += fTime;
+
+	if ( fTime > pStat->fMax )
+		pStat->fMax = fTime;
+}
+
+// any bot in game, route searches read its team, profile and class rules
+static CBot *replayHostBot ()
+{
+	for ( register short int i = 0; i < MAX_PLAYERS; i ++ )
+	{
+		CBot *pBot = CBots::get(i);
+
+		if ( pBot && pBot->inUse() )
+			return pBot;
+	}
+
+	return NULL;
+}
+
+bool CBotReplay :: replay ( const char *szName, edict_t *pPrintTo )
+{
+	char filename[1024];
+	replay_hdr_t hdr;
+	int iTag;
+	int iPlayerWpt[MAX_PLAYERS+1];
+	unsigned char visible[REPLAY_VISIBLE_BYTES];
+	replay_player_t players[MAX_PLAYERS];
+	replay_stat_t stats[REPLAY_STATS] = {
+		{ "nearest waypoint", 0, 0, 0 },
+		{ "visibility table", 0, 0, 0 },
+		{ "waypoint distance", 0, 0, 0 },
+		{ "route search", 0, 0, 0 },
+		{ "event decode", 0, 0, 0 },
+		{ "whole frame", 0, 0, 0 }
+	};
+	// a navigator of its own for each recorded bot, the host bot's route is left alone
+	std::vector<CWaypointNavigator*> navigators(MAX_PLAYERS+1,(CWaypointNavigator*)NULL);
+	int iLastGoal[MAX_PLAYERS+1];
+	CBot *pHostBot = replayHostBot();
+	double fFrame = 0;
+	unsigned int iFrames = 0;
+	unsigned int iBotTicks = 0;
+	float fFirstTime = 0;
+	float fLastTime = 0;
+	bool bValid = true;
+	char *szMapName = CBotGlobals::getMapName();
+	CWaypointVisibilityTable *pVisTable = CWaypoints::getVisiblity();
+
+	CBotGlobals::buildFileName(filename,szName,BOT_REPLAY_FOLDER,BOT_REPLAY_EXTENSION,true);
+
+	FILE *fp = CBotGlobals::openFile(filename,"rb");
+
+	if ( fp == NULL )
+	{
+		CBotGlobals::botMessage(pPrintTo,0,"can't open replay file \"%s\"",filename);
+		return false;
+	}
+
+	if ( (fread(&hdr,sizeof(replay_hdr_t),1,fp) != 1) || strncmp(hdr.szFileType,BOT_REPLAY_FILE_TYPE,15) || (hdr.iVersion != BOT_REPLAY_VERSION) )
+	{
+		CBotGlobals::botMessage(pPrintTo,0,"\"%s\" is not a valid replay file",filename);
+		fclose(fp);
+		return false;
+	}
+
+	if ( hdr.iVisibleBytes != REPLAY_VISIBLE_BYTES )
+	{
+		CBotGlobals::botMessage(pPrintTo,0,"replay was recorded with a different MAX_PLAYERS");
+		fclose(fp);
+		return false;
+	}
+
+	// waypoint indices in the capture only mean something on the same waypoints
+	if ( !szMapName || strncmp(hdr.szMapName,szMapName,63) || (CWaypoints::numWaypoints() == 0) )
+	{
+		CBotGlobals::botMessage(pPrintTo,0,"replay was recorded on \"%s\", load that map with its waypoints first",hdr.szMapName);
+		fclose(fp);
+		return false;
+	}
+
+	for ( register short int i = 0; i <= MAX_PLAYERS; i ++ )
+	{
+		iPlayerWpt[i] = -1;
+		iLastGoal[i] = -1;
+	}
+
+	if ( pHostBot == NULL )
+		CBotGlobals::botMessage(pPrintTo,0,"no bots in game, route searches won't be timed");
+
+	// route searches must not leave their distances in the live cache
+	CWaypointDistances::setReadOnly(true);
+
+	while ( bValid && (fread(&iTag,sizeof(int),1,fp) == 1) && (iTag != REPLAY_REC_END) )
+	{
+		switch ( iTag )
+		{
+		case REPLAY_REC_FRAME:
+			{
+				float fTime;
+				int iNumPlayers;
+
+				if ( (fread(&fTime,sizeof(float),1,fp) != 1) || (fread(&iNumPlayers,sizeof(int),1,fp) != 1) ||
+					(iNumPlayers < 0) || (iNumPlayers > MAX_PLAYERS) ||
+					(fread(players,sizeof(replay_player_t),iNumPlayers,fp) != (size_t)iNumPlayers) )
+				{
+					bValid = false;
+					break;
+				}
+
+				if ( iFrames == 0 )
+					fFirstTime = fTime;
+				else
+					replayFrameStat(&stats[REPLAY_STAT_FRAME],fFrame);
+
+				fFrame = 0;
+				fLastTime = fTime;
+				iFrames++;
+
+				for ( register short int i = 0; i <= MAX_PLAYERS; i ++ )
+					iPlayerWpt[i] = -1;
+
+				for ( register short int i = 0; i < iNumPlayers; i ++ )
+				{
+					replay_player_t *p = &players[i];
+
+					if ( (p->iIndex < 1) || (p->iIndex > MAX_PLAYERS) || !(p->iFlags & REPLAY_PLAYER_ALIVE) )
+						continue;
+
+					double fStart = Plat_FloatTime();
+
+					// no visibility check : it would trace against the live world
+					iPlayerWpt[p->iIndex] = CWaypointLocations::NearestWaypoint(Vector(p->fOrigin[0],p->fOrigin[1],p->fOrigin[2]),REACHABLE_RANGE,-1,false,false,false,NULL,false,p->iTeam);
+
+					fFrame += replayStat(&stats[REPLAY_STAT_NEAREST_WPT],fStart);
+				}
+			}
+			break;
+		case REPLAY_REC_BOT:
+			{
+				replay_bot_t bot;
+
+				if ( (fread(&bot,sizeof(replay_bot_t),1,fp) != 1) || (fread(visible,sizeof(unsigned char),REPLAY_VISIBLE_BYTES,fp) != REPLAY_VISIBLE_BYTES) )
+				{
+					bValid = false;
+					break;
+				}
+
+				iBotTicks++;
+
+				if ( (bot.iCurrentWaypoint < 0) || (bot.iCurrentWaypoint >= CWaypoints::numWaypoints()) )
+					continue;
+
+				for ( register short int i = 1; i <= MAX_PLAYERS; i ++ )
+				{
+					if ( (pVisTable == NULL) || !(visible[i/8] & (1<<(i%8))) || (iPlayerWpt[i] == -1) )
+						continue;
+
+					double fStart = Plat_FloatTime();
+
+					pVisTable->GetVisibilityFromTo(bot.iCurrentWaypoint,iPlayerWpt[i]);
+
+					fFrame += replayStat(&stats[REPLAY_STAT_VISIBILITY],fStart);
+				}
+
+				if ( (bot.iGoalWaypoint >= 0) && (bot.iGoalWaypoint < CWaypoints::numWaypoints()) )
+				{
+					double fStart = Plat_FloatTime();
+
+					CWaypointDistances::getDistance(bot.iCurrentWaypoint,bot.iGoalWaypoint);
+
+					fFrame += replayStat(&stats[REPLAY_STAT_DISTANCE],fStart);
+
+					// the bot picked a new goal this tick : search for it as the bot would have
+					if ( (pHostBot != NULL) && (bot.iIndex >= 1) && (bot.iIndex <= MAX_PLAYERS) && (bot.iGoalWaypoint != iLastGoal[bot.iIndex]) )
+					{
+						CWaypointNavigator *pNav = navigators[bot.iIndex];
+						Vector vFrom = CWaypoints::getWaypoint(bot.iCurrentWaypoint)->getOrigin();
+						Vector vTo = CWaypoints::getWaypoint(bot.iGoalWaypoint)->getOrigin();
+						bool bFail = false;
+						bool bDone;
+						int iLoops = 0;
+
+						if ( pNav == NULL )
+							pNav = navigators[bot.iIndex] = new CWaypointNavigator(pHostBot);
+
+						fStart = Plat_FloatTime();
+
+						bDone = pNav->workRoute(vFrom,vTo,&bFail,true,true,bot.iGoalWaypoint);
+
+						while ( !bDone && (iLoops++ < CWaypoints::numWaypoints()) )
+							bDone = pNav->workRoute(vFrom,vTo,&bFail,false,true,bot.iGoalWaypoint);
+
+						fFrame += replayStat(&stats[REPLAY_STAT_ROUTE],fStart);
+					}
+				}
+
+				if ( (bot.iIndex >= 1) && (bot.iIndex <= MAX_PLAYERS) )
+					iLastGoal[bot.iIndex] = bot.iGoalWaypoint;
+			}
+			break;
+		case REPLAY_REC_EVENT:
+			{
+				char szEventName[REPLAY_MAX_KEY];
+				int iNumKeys;
+				std::vector<replay_event_key_t> keys;
+
+				if ( (fread(szEventName,sizeof(char),REPLAY_MAX_KEY,fp) != REPLAY_MAX_KEY) || (fread(&iNumKeys,sizeof(int),1,fp) != 1) ||
+					(iNumKeys < 0) || (iNumKeys > REPLAY_MAX_EVENT_KEYS) )
+				{
+					bValid = false;
+					break;
+				}
+
+				szEventName[REPLAY_MAX_KEY-1] = 0;
+				keys.resize(iNumKeys);
+
+				if ( (iNumKeys > 0) && (fread(&keys[0],sizeof(replay_event_key_t),iNumKeys,fp) != (size_t)iNumKeys) )
+				{
+					bValid = false;
+					break;
+				}
+
+				double fStart = Plat_FloatTime();
+
+				// decoded and read back only, the live handlers would resolve the
+				// recorded userids against whoever is connected now
+				CReplayEventInterface event(szEventName,keys);
+
+				for ( register int k = 0; k < iNumKeys; k ++ )
+					event.getString(keys[k].szKey);
+
+				fFrame += replayStat(&stats[REPLAY_STAT_EVENT],fStart);
+			}
+			break;
+		default:
+			bValid = false;
+			break;
+		}
+	}
+
+	fclose(fp);
+
+	CWaypointDistances::setReadOnly(false);
+
+	if ( iFrames > 0 )
+		replayFrameStat(&stats[REPLAY_STAT_FRAME],fFrame);
+
+	for ( register short int i = 0; i <= MAX_PLAYERS; i ++ )
+	{
+		// not freeMapMemory, that would save the host bot's beliefs
+		if ( navigators[i] != NULL )
+			delete navigators[i];
+	}
+
+	if ( !bValid )
+		CBotGlobals::botMessage(pPrintTo,0,"replay file \"%s\" is truncated or corrupt, results are partial",filename);
+
+	CBotGlobals::botMessage(pPrintTo,0,"replay \"%s\" : %d frames (%0.1f sec), %d bot ticks",szName,iFrames,fLastTime-fFirstTime,iBotTicks);
+
+	for ( register short int i = 0; i < REPLAY_STATS; i ++ )
+	{
+		replay_stat_t *pStat = &stats[i];
+
+		CBotGlobals::botMessage(pPrintTo,0,"%-18s calls %8d total %8.3f ms avg %8.3f us max %8.3f us",
+			pStat->szName,pStat->iCalls,pStat->fTotal*1000.0,
+			(pStat->iCalls>0)?(pStat->fTotal*1000000.0/pStat->iCalls):0.0,pStat->fMax*1000000.0);
+	}
+
+	return bValid;
+}
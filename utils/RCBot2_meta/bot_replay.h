@@ -0,0 +1,145 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#ifndef __BOT_REPLAY_H__
+#define __BOT_REPLAY_H__
+
+#include <stdio.h>
+#include <vector>
+
+#include "bot.h"
+#include "bot_event.h"
+
+#define BOT_REPLAY_FOLDER "replays"
+#define BOT_REPLAY_EXTENSION "rcr"
+#define BOT_REPLAY_FILE_TYPE "RCBot2Replay"
+#define BOT_REPLAY_VERSION 1
+
+#define REPLAY_MAX_KEY 32
+#define REPLAY_MAX_VALUE 64
+#define REPLAY_MAX_EVENT_KEYS 16
+// one bit per edict index up to MAX_PLAYERS
+#define REPLAY_VISIBLE_BYTES ((MAX_PLAYERS/8)+1)
+
+// record tags in a replay file
+enum
+{
+	REPLAY_REC_FRAME = 1,
+	REPLAY_REC_BOT,
+	REPLAY_REC_EVENT,
+	REPLAY_REC_END
+};
+
+#define REPLAY_PLAYER_ALIVE 1
+#define REPLAY_PLAYER_BOT 2
+
+typedef struct
+{
+	char szFileType[16];
+	char szMapName[64];
+	int iVersion;
+	int iMaxClients;
+	int iVisibleBytes;
+}replay_hdr_t;
+
+typedef struct
+{
+	int iIndex;
+	int iTeam;
+	int iFlags;
+	float fOrigin[3];
+}replay_player_t;
+
+typedef struct
+{
+	int iIndex;
+	int iCurrentWaypoint;
+	int iGoalWaypoint;
+}replay_bot_t;
+
+typedef struct
+{
+	char szKey[REPLAY_MAX_KEY];
+	char szValue[REPLAY_MAX_VALUE];
+}replay_event_key_t;
+
+// wraps a live game event while recording so that every key the event
+// handlers read is remembered, during replay serves the stored keys back
+// the live event interface is owned and deleted by the wrapper
+class CReplayEventInterface : public IBotEventInterface
+{
+public:
+	CReplayEventInterface ( IBotEventInterface *pEvent );
+	CReplayEventInterface ( const char *szName, const std::vector<replay_event_key_t> &keys );
+	~CReplayEventInterface ();
+
+	float getFloat ( const char *keyName = 0, float defaultValue = 0 );
+	int getInt ( const char *keyName = 0, int defaultValue = 0 );
+	const char *getString ( const char *keyName = 0, const char *defaultValue = 0 );
+	const char *getName ();
+	void setInt ( const char *keyName, int value );
+
+	void write ( FILE *fp );
+private:
+	const char *findKey ( const char *keyName );
+	void storeKey ( const char *keyName, const char *szValue );
+
+	IBotEventInterface *m_pEvent;
+	char m_szName[REPLAY_MAX_KEY];
+	std::vector<replay_event_key_t> m_Keys;
+};
+
+// captures per-tick bot inputs to disk and replays them through the
+// bot's think stages : nearest waypoints for the player snapshots, the
+// visibility table, waypoint distances, route searches on private
+// navigators whenever a bot picked a new goal and decoding the recorded
+// events. Nothing live is changed : events aren't handed to the bots and
+// the distance cache isn't written
+class CBotReplay
+{
+public:
+	static bool startRecording ( const char *szName, edict_t *pPrintTo );
+	static void stopRecording ( edict_t *pPrintTo = NULL );
+	static inline bool isRecording () { return m_fp != NULL; }
+
+	// called once per tick before bots think
+	static void recordFrame ();
+	// called after each bot has thought
+	static void recordBot ( CBot *pBot );
+
+	static void recordEvent ( CReplayEventInterface *pEvent );
+
+	static bool replay ( const char *szName, edict_t *pPrintTo );
+private:
+	static FILE *m_fp;
+	static unsigned int m_iFrames;
+};
+
+#endif
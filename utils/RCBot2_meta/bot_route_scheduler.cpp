@@ -0,0 +1,352 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#include "engine_wrappers.h"
+
+#include "bot.h"
+#include "bot_cvars.h"
+#include "bot_globals.h"
+#include "bot_navigator.h"
+#include "bot_route_scheduler.h"
+#include "bot_waypoint_flow.h"
+
+#include "tier0/platform.h"
+
+route_request_t CBotRouteScheduler::m_Requests[MAX_PLAYERS];
+std::vector<route_shared_t> CBotRouteScheduler::m_Shared;
+
+unsigned int CBotRouteScheduler::m_iNextId = 1;
+unsigned int CBotRouteScheduler::m_iRequests = 0;
+unsigned int CBotRouteScheduler::m_iFinished = 0;
+unsigned int CBotRouteScheduler::m_iShared = 0;
+unsigned int CBotRouteScheduler::m_iSlices = 0;
+unsigned int CBotRouteScheduler::m_iFrames = 0;
+double CBotRouteScheduler::m_fTotalLatency = 0;
+double CBotRouteScheduler::m_fMaxLatency = 0;
+double CBotRouteScheduler::m_fTotalWork = 0;
+double CBotRouteScheduler::m_fMaxFrameWork = 0;
+
+bool CBotRouteScheduler :: isEnabled ()
+{
+	return rcbot_route_budget.GetInt() > 0;
+}
+
+route_request_t *CBotRouteScheduler :: getRequest ( CBot *pBot )
+{
+	int iIndex;
+
+	if ( pBot->getEdict() == NULL )
+		return NULL;
+
+	iIndex = ENTINDEX(pBot->getEdict())-1;
+
+	if ( (iIndex < 0) || (iIndex >= MAX_PLAYERS) )
+		return NULL;
+
+	return &m_Requests[iIndex];
+}
+
+// replaces any search the bot already had queued
+unsigned int CBotRouteScheduler :: request ( CBot *pBot, Vector vTo, int iGoalId, bool bNoInterruptions, int iConditions, int iDangerId, int iPriority )
+{
+	route_request_t *pRequest = getRequest(pBot);
+
+	if ( pRequest == NULL )
+		return 0;
+
+	// 0 is never a request
+	if ( m_iNextId == 0 )
+		m_iNextId++;
+
+	pRequest->pBot = pBot;
+	pRequest->iId = m_iNextId++;
+	pRequest->vTo = vTo;
+	pRequest->iGoalId = iGoalId;
+	pRequest->bNoInterruptions = bNoInterruptions;
+	pRequest->iConditions = iConditions;
+	pRequest->iDangerId = iDangerId;
+	pRequest->iPriority = iPriority;
+	pRequest->bRestart = true;
+	pRequest->fRequestTime = engine->Time();
+	pRequest->fRequestClock = Plat_FloatTime();
+	pRequest->iState = ROUTE_PENDING;
+
+	m_iRequests++;
+
+	return pRequest->iId;
+}
+
+eRouteState CBotRouteScheduler :: getState ( CBot *pBot, unsigned int iRequestId, Vector vTo, int iGoalId )
+{
+	route_request_t *pRequest = getRequest(pBot);
+
+	if ( (pRequest == NULL) || (pRequest->pBot != pBot) )
+		return ROUTE_NONE;
+
+	// the navigator's route is from another search, don't use it
+	if ( (pRequest->iId != iRequestId) || (pRequest->iGoalId != iGoalId) || (pRequest->vTo != vTo) )
+		return ROUTE_NONE;
+
+	return pRequest->iState;
+}
+
+void CBotRouteScheduler :: cancel ( CBot *pBot )
+{
+	route_request_t *pRequest = getRequest(pBot);
+
+	if ( pRequest != NULL )
+	{
+		pRequest->pBot = NULL;
+		pRequest->iState = ROUTE_NONE;
+	}
+}
+
+void CBotRouteScheduler :: reset ()
+{
+	for ( short int i = 0; i < MAX_PLAYERS; i ++ )
+	{
+		m_Requests[i].pBot = NULL;
+		m_Requests[i].iState = ROUTE_NONE;
+	}
+
+	m_Shared.clear();
+}
+
+// highest priority first, waiting raises priority
+route_request_t *CBotRouteScheduler :: nextRequest ( float fTime )
+{
+	route_request_t *pBest = NULL;
+	float fBestScore = 0;
+
+	for ( short int i = 0; i < MAX_PLAYERS; i ++ )
+	{
+		route_request_t *pRequest = &m_Requests[i];
+		float fScore;
+
+		if ( (pRequest->iState != ROUTE_PENDING) && (pRequest->iState != ROUTE_WORKING) )
+			continue;
+
+		if ( (pRequest->pBot == NULL) || !pRequest->pBot->inUse() )
+		{
+			pRequest->iState = ROUTE_NONE;
+			continue;
+		}
+
+		fScore = pRequest->iPriority + ((fTime - pRequest->fRequestTime)/ROUTE_PRIORITY_WAIT);
+
+		if ( (pBest == NULL) || (fScore > fBestScore) )
+		{
+			pBest = pRequest;
+			fBestScore = fScore;
+		}
+	}
+
+	return pBest;
+}
+
+void CBotRouteScheduler :: think ()
+{
+	double fBudget = rcbot_route_budget.GetFloat() / 1000000.0;
+	double fStart;
+	double fWork;
+	float fTime = engine->Time();
+	route_request_t *pRequest;
+	bool bWorked = false;
+
+	if ( !isEnabled() )
+		return;
+
+	fStart = Plat_FloatTime();
+
+	// always work on something so a small budget can't stop routing altogether
+	while ( (pRequest = nextRequest(fTime)) != NULL )
+	{
+		if ( bWorked && ((Plat_FloatTime() - fStart) >= fBudget) )
+			break;
+
+		workRequest(pRequest);
+		bWorked = true;
+	}
+
+	if ( bWorked )
+	{
+		fWork = Plat_FloatTime() - fStart;
+
+		m_iFrames++;
+		m_fTotalWork += fWork;
+
+		if ( fWork > m_fMaxFrameWork )
+			m_fMaxFrameWork = fWork;
+	}
+}
+
+void CBotRouteScheduler :: workRequest ( route_request_t *pRequest )
+{
+	CBot *pBot = pRequest->pBot;
+	IBotNavigator *pNav = pBot->getNavigator();
+	bool bFail = false;
+	bool bFinished;
+	bool bRestart = pRequest->bRestart;
+
+	bFinished = pNav->workRoute(pBot->getOrigin(),
+		pRequest->vTo,
+		&bFail,
+		bRestart,
+		pRequest->bNoInterruptions,
+		pRequest->iGoalId,
+		pRequest->iConditions,
+		pRequest->iDangerId);
+
+	m_iSlices++;
+
+	pRequest->bRestart = false;
+	pRequest->iState = ROUTE_WORKING;
+
+	if ( bFinished )
+	{
+		if ( !bFail )
+			addSharedRoute(pRequest);
+
+		finished(pRequest,bFail);
+	}
+	// the start and goal waypoints are known now, another bot may have just done this one
+	else if ( bRestart && shareRoute(pRequest) )
+	{
+		m_iShared++;
+		finished(pRequest,false);
+	}
+}
+
+void CBotRouteScheduler :: finished ( route_request_t *pRequest, bool bFail )
+{
+	double fLatency = Plat_FloatTime() - pRequest->fRequestClock;
+
+	pRequest->iState = bFail ? ROUTE_FAILED : ROUTE_DONE;
+
+	m_iFinished++;
+	m_fTotalLatency += fLatency;
+
+	if ( fLatency > m_fMaxLatency )
+		m_fMaxLatency = fLatency;
+}
+
+bool CBotRouteScheduler :: shareRoute ( route_request_t *pRequest )
+{
+	IBotNavigator *pNav = pRequest->pBot->getNavigator();
+	int iStart = pNav->getCurrentWaypointID();
+	int iGoal = pNav->getCurrentGoalID();
+	int iTeam = pRequest->pBot->getTeam();
+	float fTime = engine->Time();
+
+	for ( size_t i = 0; i < m_Shared.size(); i ++ )
+	{
+		route_shared_t *pShared = &m_Shared[i];
+
+		if ( (pShared->fTime + ROUTE_SHARE_TIME) < fTime )
+			continue;
+
+		if ( (pShared->iStart == iStart) && (pShared->iGoal == iGoal) && (pShared->iTeam == iTeam) )
+			return pNav->setRoute(pShared->route,pShared->fDistance);
+	}
+
+	return false;
+}
+
+void CBotRouteScheduler :: addSharedRoute ( route_request_t *pRequest )
+{
+	IBotNavigator *pNav = pRequest->pBot->getNavigator();
+	route_shared_t *pShared = NULL;
+	float fTime = engine->Time();
+
+	for ( size_t i = 0; i < m_Shared.size(); i ++ )
+	{
+		if ( (m_Shared[i].fTime + ROUTE_SHARE_TIME) < fTime )
+		{
+			pShared = &m_Shared[i];
+			break;
+		}
+	}
+
+	if ( pShared == NULL )
+	{
+		if ( m_Shared.size() < ROUTE_MAX_SHARED )
+		{
+			m_Shared.push_back(route_shared_t());
+			pShared = &m_Shared.back();
+		}
+		else
+		{
+			// all still fresh, replace the oldest
+			pShared = &m_Shared[0];
+
+			for ( size_t i = 1; i < m_Shared.size(); i ++ )
+			{
+				if ( m_Shared[i].fTime < pShared->fTime )
+					pShared = &m_Shared[i];
+			}
+		}
+	}
+
+	pShared->route.clear();
+
+	if ( !pNav->getRoute(&pShared->route) )
+	{
+		pShared->fTime = 0;
+		return;
+	}
+
+	pShared->iStart = pNav->getCurrentWaypointID();
+	pShared->iGoal = pNav->getCurrentGoalID();
+	pShared->iTeam = pRequest->pBot->getTeam();
+	pShared->fDistance = pNav->getGoalDistance();
+	pShared->fTime = fTime;
+}
+
+void CBotRouteScheduler :: printStats ( edict_t *pPrintTo )
+{
+	int iQueued = 0;
+
+	for ( short int i = 0; i < MAX_PLAYERS; i ++ )
+	{
+		if ( (m_Requests[i].iState == ROUTE_PENDING) || (m_Requests[i].iState == ROUTE_WORKING) )
+			iQueued++;
+	}
+
+	CBotGlobals::botMessage(pPrintTo,0,"route scheduler: %s, budget %dus per frame",isEnabled()?"on":"off",rcbot_route_budget.GetInt());
+	CBotGlobals::botMessage(pPrintTo,0,"requests %u, finished %u, shared %u, queued now %d",m_iRequests,m_iFinished,m_iShared,iQueued);
+
+	if ( m_iFinished > 0 )
+		CBotGlobals::botMessage(pPrintTo,0,"queue latency avg %0.2fms max %0.2fms",(m_fTotalLatency/m_iFinished)*1000.0,m_fMaxLatency*1000.0);
+
+	if ( m_iFrames > 0 )
+		CBotGlobals::botMessage(pPrintTo,0,"work per busy frame avg %0.0fus max %0.0fus, %u slices over %u frames",(m_fTotalWork/m_iFrames)*1000000.0,m_fMaxFrameWork*1000000.0,m_iSlices,m_iFrames);
+
+	CBotGlobals::botMessage(pPrintTo,0,"objective flow fields %d/%d (%s)",CWaypointFlowField::numFields(),MAX_FLOW_FIELDS,rcbot_nav_flow.GetBool()?"on":"off");
+}
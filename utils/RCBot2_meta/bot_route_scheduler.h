@@ -0,0 +1,128 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#ifndef __RCBOT_ROUTE_SCHEDULER_H__
+#define __RCBOT_ROUTE_SCHEDULER_H__
+
+#include <vector>
+
+#include "bot.h"
+#include "bot_waypoint.h"
+
+// higher priorities are worked on first
+#define ROUTE_PRIORITY_ROAM 0
+#define ROUTE_PRIORITY_OBJECTIVE 1
+#define ROUTE_PRIORITY_COMBAT 2
+// seconds of waiting worth one priority level, so nothing waits forever
+#define ROUTE_PRIORITY_WAIT 0.5f
+// how long a finished route can be handed to other bots of the same team
+#define ROUTE_SHARE_TIME 1.0f
+#define ROUTE_MAX_SHARED 32
+
+typedef enum
+{
+	ROUTE_NONE = 0,
+	ROUTE_PENDING,
+	ROUTE_WORKING,
+	ROUTE_DONE,
+	ROUTE_FAILED
+}eRouteState;
+
+typedef struct
+{
+	CBot *pBot;
+	unsigned int iId; // a finished route only belongs to the request with this id
+	Vector vTo;
+	int iGoalId;
+	int iConditions;
+	int iDangerId;
+	int iPriority;
+	bool bNoInterruptions;
+	bool bRestart;
+	float fRequestTime;
+	double fRequestClock;
+	eRouteState iState;
+}route_request_t;
+
+typedef struct
+{
+	int iStart;
+	int iGoal;
+	int iTeam;
+	float fTime;
+	float fDistance;
+	WaypointList route;
+}route_shared_t;
+
+// one queue of route searches for all bots, worked on after the bots
+// think within rcbot_route_budget microseconds a frame
+class CBotRouteScheduler
+{
+public:
+	// returns the id to pass to getState
+	static unsigned int request ( CBot *pBot, Vector vTo, int iGoalId, bool bNoInterruptions, int iConditions, int iDangerId, int iPriority );
+
+	// ROUTE_NONE if the bot's request was replaced or is for another goal
+	static eRouteState getState ( CBot *pBot, unsigned int iRequestId, Vector vTo, int iGoalId );
+
+	static void cancel ( CBot *pBot );
+
+	static void think ();
+
+	static void reset ();
+
+	static void printStats ( edict_t *pPrintTo );
+
+	static bool isEnabled ();
+
+private:
+	static route_request_t *getRequest ( CBot *pBot );
+	static route_request_t *nextRequest ( float fTime );
+	static void workRequest ( route_request_t *pRequest );
+	static bool shareRoute ( route_request_t *pRequest );
+	static void addSharedRoute ( route_request_t *pRequest );
+	static void finished ( route_request_t *pRequest, bool bFail );
+
+	static route_request_t m_Requests[MAX_PLAYERS];
+	static std::vector<route_shared_t> m_Shared;
+
+	static unsigned int m_iNextId;
+	static unsigned int m_iRequests;
+	static unsigned int m_iFinished;
+	static unsigned int m_iShared;
+	static unsigned int m_iSlices;
+	static unsigned int m_iFrames;
+	static double m_fTotalLatency;
+	static double m_fMaxLatency;
+	static double m_fTotalWork;
+	static double m_fMaxFrameWork;
+};
+
+#endif
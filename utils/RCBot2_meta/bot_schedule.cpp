@@ -800,6 +800,10 @@ void CBotSchedule :: execute ( CBot *pBot )
 		}
 	}
 
+	// a route search the task asked for isn't wanted any more
+	if ( pTask->hasFailed() || pTask->isComplete() )
+		CBotRouteScheduler::cancel(pBot);
+
 	if ( pTask->hasFailed() )
 	{
 		m_bFailed = true;
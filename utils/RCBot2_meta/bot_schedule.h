@@ -33,6 +33,7 @@
 
 #include "bot.h"
 #include "bot_task.h"
+#include "bot_route_scheduler.h"
 //#include "bot_fortress.h"
 
 #include <deque>
@@ -187,6 +188,11 @@ private:
 class CBotSchedules
 {
 public:
+	CBotSchedules ( CBot *pBot )
+	{
+		m_pBot = pBot;
+	}
+
 	bool hasSchedule ( eBotSchedule iSchedule )
 	{
 		for (CBotSchedule *sched : m_Schedules) {
@@ -209,6 +215,10 @@ public:
 	{
 		for (auto it = m_Schedules.begin(); it != m_Schedules.end(); ) {
 			if ((*it)->isID(iSchedule)) {
+				// the running task's route search is no use now
+				if (it == m_Schedules.begin())
+					CBotRouteScheduler::cancel(m_pBot);
+
 				m_Schedules.erase(it);
 				return;
 			} else {
@@ -234,6 +244,8 @@ public:
 		CBotSchedule *pSched = m_Schedules.front();
 		m_Schedules.pop_front();
 
+		CBotRouteScheduler::cancel(m_pBot);
+
 		// TODO: eradicate freeMemory from the codebase
 		pSched->freeMemory();
 
@@ -242,6 +254,9 @@ public:
 
 	void freeMemory ()
 	{
+		if (!m_Schedules.empty())
+			CBotRouteScheduler::cancel(m_pBot);
+
 		for (CBotSchedule *sched : m_Schedules) {
 			delete sched;
 		}
@@ -258,6 +273,9 @@ public:
 
 	void addFront ( CBotSchedule *pSchedule )
 	{
+		// the task that was running is put off, it asks again when it runs
+		CBotRouteScheduler::cancel(m_pBot);
+
 		pSchedule->init();
 		m_Schedules.push_front(pSchedule);
 	}
@@ -291,6 +309,7 @@ public:
 	}
 
 private:
+	CBot *m_pBot;
 	std::deque<CBotSchedule*> m_Schedules;
 };
 ///////////////////////////////////////////
@@ -37,6 +37,14 @@
 #include "bot_getprop.h"
 #include "bot_sigscan.h"
 #include "bot_mods.h"
+#include "bot_globals.h"
+
+#ifndef NT_GNU_BUILD_ID
+#define NT_GNU_BUILD_ID 3
+#endif
+
+std::vector<sigcache_entry_t> CSignatureFunction::m_Cache;
+bool CSignatureFunction::m_bCacheLoaded = false;
 
 CGameRulesObject *g_pGameRules_Obj = NULL;
 CCreateGameRulesObject *g_pGameRules_Create_Obj = NULL;
@@ -97,6 +105,7 @@ bool CSignatureFunction::getLibraryInfo(const void *libPtr, DynLibInfo &lib)
 
 
 	MEMORY_BASIC_INFORMATION info;
+	char path[MAX_PATH];
 	IMAGE_DOS_HEADER *dos;
 	IMAGE_NT_HEADERS *pe;
 	IMAGE_FILE_HEADER *file;
@@ -138,6 +147,16 @@ bool CSignatureFunction::getLibraryInfo(const void *libPtr, DynLibInfo &lib)
 	//Finally, we can do this
 	lib.memorySize = opt->SizeOfImage;
 
+	if (GetModuleFileNameA(reinterpret_cast<HMODULE>(info.AllocationBase), path, sizeof(path)) == 0)
+	{
+		return false;
+	}
+
+	setLibraryName(lib, path);
+
+	// changes with every link of the dll
+	Q_snprintf(lib.buildId, sizeof(lib.buildId), "pe-%08x-%08x", (unsigned int)file->TimeDateStamp, (unsigned int)opt->SizeOfImage);
+
 #else
 	Dl_info info;
 	Elf32_Ehdr *file;
@@ -184,6 +203,8 @@ bool CSignatureFunction::getLibraryInfo(const void *libPtr, DynLibInfo &lib)
 		return false;
 	}
 
+	setLibraryName(lib, info.dli_fname);
+
 	phdrCount = file->e_phnum;
 	phdr = reinterpret_cast<Elf32_Phdr *>(baseAddr + file->e_phoff);
 
@@ -205,6 +226,39 @@ bool CSignatureFunction::getLibraryInfo(const void *libPtr, DynLibInfo &lib)
 			break;
 		}
 	}
+
+	// use the GNU build id note if the library has one, otherwise just the size
+	Q_snprintf(lib.buildId, sizeof(lib.buildId), "elf-%08x", (unsigned int)lib.memorySize);
+
+	for (uint16_t i = 0; i < phdrCount; i++)
+	{
+		Elf32_Phdr &hdr = phdr[i];
+
+		if (hdr.p_type != PT_NOTE)
+			continue;
+
+		unsigned char *note = reinterpret_cast<unsigned char *>(baseAddr + hdr.p_vaddr);
+		unsigned char *noteEnd = note + hdr.p_memsz;
+
+		while (note + sizeof(Elf32_Nhdr) <= noteEnd)
+		{
+			Elf32_Nhdr *nhdr = reinterpret_cast<Elf32_Nhdr *>(note);
+			unsigned char *name = note + sizeof(Elf32_Nhdr);
+			unsigned char *desc = name + ((nhdr->n_namesz + 3) & ~3);
+
+			if (nhdr->n_type == NT_GNU_BUILD_ID && nhdr->n_namesz == 4 && memcmp(name, "GNU", 4) == 0 && desc + nhdr->n_descsz <= noteEnd)
+			{
+				size_t written = Q_snprintf(lib.buildId, sizeof(lib.buildId), "gnu-");
+
+				for (Elf32_Word j = 0; (j < nhdr->n_descsz) && (written + 3 <= sizeof(lib.buildId)); j++)
+					written += Q_snprintf(&lib.buildId[written], sizeof(lib.buildId) - written, "%02x", desc[j]);
+
+				break;
+			}
+
+			note = desc + ((nhdr->n_descsz + 3) & ~3);
+		}
+	}
 #endif
 
 	lib.baseAddress = reinterpret_cast<void *>(baseAddr);
@@ -212,11 +266,178 @@ bool CSignatureFunction::getLibraryInfo(const void *libPtr, DynLibInfo &lib)
 	return true;
 }
 
+bool CSignatureFunction::matchPattern(const char *ptr, const char *pattern, size_t len)
+{
+	for (register size_t i = 0; i < len; i++)
+	{
+		if (pattern[i] != '\x2A' && pattern[i] != ptr[i])
+			return false;
+	}
+
+	return true;
+}
+
+// FNV-1a
+unsigned int CSignatureFunction::hashPattern(const char *pattern, size_t len)
+{
+	unsigned int hash = 2166136261u;
+
+	for (size_t i = 0; i < len; i++)
+	{
+		hash ^= (unsigned char)pattern[i];
+		hash *= 16777619u;
+	}
+
+	return hash;
+}
+
+// cache entries name their library, one cache file is shared by every library scanned
+void CSignatureFunction::setLibraryName(DynLibInfo &lib, const char *path)
+{
+	const char *name = path;
+
+	for (const char *c = path; *c; c++)
+	{
+		if (*c == '/' || *c == '\\')
+			name = c + 1;
+	}
+
+	Q_strncpy(lib.name, name, sizeof(lib.name));
+
+	// the cache file is space separated
+	for (char *c = lib.name; *c; c++)
+	{
+		if (*c == ' ')
+			*c = '_';
+	}
+}
+
+bool CSignatureFunction::isCacheEntryFor(const sigcache_entry_t &entry, const DynLibInfo &lib)
+{
+	return (strcmp(entry.library, lib.name) == 0) && (strcmp(entry.buildId, lib.buildId) == 0);
+}
+
+void CSignatureFunction::loadCache()
+{
+	char filename[1024];
+	char line[256];
+	sigcache_entry_t entry;
+	unsigned long len, offset;
+
+	if (m_bCacheLoaded)
+		return;
+
+	m_bCacheLoaded = true;
+
+	CBotGlobals::buildFileName(filename, SIGCACHE_FILE, BOT_CONFIG_FOLDER, SIGCACHE_EXTENSION, true);
+
+	FILE *fp = fopen(filename, "r");
+
+	if (fp == NULL)
+		return;
+
+	while (fgets(line, sizeof(line), fp) != NULL)
+	{
+		if (line[0] == ';')
+			continue;
+
+		// library build hash length offset
+		if (sscanf(line, "%63s %63s %x %lu %lx", entry.library, entry.buildId, &entry.hash, &len, &offset) != 5)
+			continue;
+
+		entry.len = len;
+		entry.offset = offset;
+
+		m_Cache.push_back(entry);
+	}
+
+	fclose(fp);
+}
+
+void CSignatureFunction::saveCache(const DynLibInfo &lib)
+{
+	char filename[1024];
+
+	// entries from an older build of this library will never match again
+	for (size_t i = 0; i < m_Cache.size(); )
+	{
+		if (strcmp(m_Cache[i].library, lib.name) == 0 && strcmp(m_Cache[i].buildId, lib.buildId) != 0)
+			m_Cache.erase(m_Cache.begin() + i);
+		else
+			i++;
+	}
+
+	CBotGlobals::buildFileName(filename, SIGCACHE_FILE, BOT_CONFIG_FOLDER, SIGCACHE_EXTENSION, true);
+
+	FILE *fp = CBotGlobals::openFile(filename, "w");
+
+	if (fp == NULL)
+		return;
+
+	fprintf(fp, "; RCBot2 signature offsets, rebuilt automatically - safe to delete\n");
+	fprintf(fp, "; library build hash length offset\n");
+
+	for (size_t i = 0; i < m_Cache.size(); i++)
+		fprintf(fp, "%s %s %08x %lu %lx\n", m_Cache[i].library, m_Cache[i].buildId, m_Cache[i].hash, (unsigned long)m_Cache[i].len, (unsigned long)m_Cache[i].offset);
+
+	fclose(fp);
+}
+
+// scan for the longest run of literal bytes with memchr and only check the
+// full pattern where that run matches
+void *CSignatureFunction::scanPattern(const DynLibInfo &lib, const char *pattern, size_t len)
+{
+	size_t anchor = 0, anchorLen = 0;
+	const char *base, *end, *ptr, *last;
+
+	for (size_t i = 0; i < len; )
+	{
+		size_t j = i;
+
+		while (j < len && pattern[j] != '\x2A')
+			j++;
+
+		if (j - i > anchorLen)
+		{
+			anchor = i;
+			anchorLen = j - i;
+		}
+
+		i = j + 1;
+	}
+
+	base = reinterpret_cast<const char *>(lib.baseAddress);
+	end = base + lib.memorySize - len;
+
+	// all wildcards
+	if (anchorLen == 0)
+		return (base < end) ? const_cast<char *>(base) : NULL;
+
+	ptr = base + anchor;
+	last = end + anchor;
+
+	while (ptr < last)
+	{
+		ptr = reinterpret_cast<const char *>(memchr(ptr, pattern[anchor], last - ptr));
+
+		if (ptr == NULL)
+			break;
+
+		if (memcmp(ptr, pattern + anchor, anchorLen) == 0 && matchPattern(ptr - anchor, pattern, len))
+			return const_cast<char *>(ptr - anchor);
+
+		ptr++;
+	}
+
+	return NULL;
+}
+
 void *CSignatureFunction::findPattern(const void *libPtr, const char *pattern, size_t len)
 {
 	DynLibInfo lib;
-	bool found;
-	char *ptr, *end;
+	unsigned int hash;
+	char *base;
+	void *found;
 
 	memset(&lib, 0, sizeof(DynLibInfo));
 
@@ -225,28 +446,45 @@ void *CSignatureFunction::findPattern(const void *libPtr, const char *pattern, s
 		return NULL;
 	}
 
-	ptr = reinterpret_cast<char *>(lib.baseAddress);
-	end = ptr + lib.memorySize - len;
+	if (len >= lib.memorySize)
+		return NULL;
+
+	base = reinterpret_cast<char *>(lib.baseAddress);
+	hash = hashPattern(pattern, len);
+
+	loadCache();
+
+	// the cached offset is checked against the pattern before it is trusted
+	for (size_t i = 0; i < m_Cache.size(); i++)
+	{
+		if (m_Cache[i].hash != hash || m_Cache[i].len != len || !isCacheEntryFor(m_Cache[i], lib))
+			continue;
+
+		if (m_Cache[i].offset < lib.memorySize - len && matchPattern(base + m_Cache[i].offset, pattern, len))
+			return base + m_Cache[i].offset;
+
+		m_Cache.erase(m_Cache.begin() + i);
+		break;
+	}
+
+	found = scanPattern(lib, pattern, len);
 
-	while (ptr < end)
+	if (found != NULL)
 	{
-		found = true;
-		for (register size_t i = 0; i < len; i++)
-		{
-			if (pattern[i] != '\x2A' && pattern[i] != ptr[i])
-			{
-				found = false;
-				break;
-			}
-		}
+		sigcache_entry_t entry;
 
-		if (found)
-			return ptr;
+		Q_strncpy(entry.library, lib.name, sizeof(entry.library));
+		Q_strncpy(entry.buildId, lib.buildId, sizeof(entry.buildId));
+		entry.hash = hash;
+		entry.len = len;
+		entry.offset = reinterpret_cast<char *>(found) - base;
 
-		ptr++;
+		m_Cache.push_back(entry);
+
+		saveCache(lib);
 	}
 
-	return NULL;
+	return found;
 }
 // Sourcemod - Metamod - Allied Modders.net
 void *CSignatureFunction::findSignature(void *addrInBase, const char *signature)
@@ -3,12 +3,31 @@
 
 #include "bot_const.h"
 
+#include <vector>
+
+#define SIGCACHE_FILE "sigcache"
+#define SIGCACHE_EXTENSION "ini"
+#define SIGCACHE_MAX_BUILDID 64
+#define SIGCACHE_MAX_LIBNAME 64
+
 struct DynLibInfo
 {
 	void *baseAddress;
 	size_t memorySize;
+	char name[SIGCACHE_MAX_LIBNAME]; // file name of the library without its path
+	char buildId[SIGCACHE_MAX_BUILDID]; // identifies this build of the library
 };
 
+// where a signature was found last time, relative to the library base
+typedef struct
+{
+	char library[SIGCACHE_MAX_LIBNAME];
+	char buildId[SIGCACHE_MAX_BUILDID];
+	unsigned int hash;
+	size_t len;
+	size_t offset;
+}sigcache_entry_t;
+
 class CRCBotKeyValueList;
 
 class CSignatureFunction
@@ -22,7 +41,24 @@ private:
 
 	void *findPattern(const void *libPtr, const char *pattern, size_t len);
 
+	void *scanPattern(const DynLibInfo &lib, const char *pattern, size_t len);
+
 	void *findSignature ( void *addrInBase, const char *signature );
+
+	static bool matchPattern(const char *ptr, const char *pattern, size_t len);
+
+	static unsigned int hashPattern(const char *pattern, size_t len);
+
+	static void setLibraryName(DynLibInfo &lib, const char *path);
+
+	static bool isCacheEntryFor(const sigcache_entry_t &entry, const DynLibInfo &lib);
+
+	static void loadCache();
+
+	static void saveCache(const DynLibInfo &lib);
+
+	static std::vector<sigcache_entry_t> m_Cache;
+	static bool m_bCacheLoaded;
 protected:
 	void findFunc ( CRCBotKeyValueList &kv, const char *pKey, void *pAddrBase, const char *defaultsig );
 
@@ -37,6 +37,8 @@
 #include "bot_globals.h"
 #include "bot_squads.h"
 #include "bot_getprop.h"
+#include "bot_waypoint.h"
+#include "bot_waypoint_locations.h"
 
 #include <algorithm>
 
@@ -242,6 +244,7 @@ void CBotSquad::Init ()
 
 	m_theDesiredFormation = SQUAD_FORM_WEDGE; // default wedge formation
 	m_fDesiredSpread = SQUAD_DEFAULT_SPREAD; 
+	m_bSlotsValid = false;
 
 	m_CombatType = COMBAT_COMBAT;
 
@@ -296,22 +299,42 @@ void CBotSquad::ChangeLeader ( void )
 }
 
 Vector CBotSquad :: GetFormationVector ( edict_t *pEdict )
+{
+	edict_t *pLeader = GetLeader();
+
+	if ( pLeader == NULL )
+		return CBotGlobals::entityOrigin(pEdict);
+
+	UpdateFormation();
+
+	for ( size_t i = 0; i < m_Slots.size(); i ++ )
+	{
+		if ( m_Slots[i].pMember == pEdict )
+			return m_Slots[i].vPos;
+	}
+
+	// not a member
+	return CBotGlobals::entityOrigin(pLeader);
+}
+
+// works out every member's slot in one go when the leader has moved or
+// turned, members then just read theirs
+void CBotSquad :: UpdateFormation ( void )
 {
 	Vector vLeaderOrigin;
-	Vector vBase; 
 	Vector v_forward;
 	Vector v_right;
+	Vector vBase[2]; // offset from the leader for odd and even positions, before spread
 	QAngle angle_right;
-	// vBase = first : offset from leader origin without taking into consideration spread and position
-	int iPosition;
-	trace_t *tr = CBotGlobals::getTraceResult();
+	size_t iNumMembers = m_SquadMembers.size();
 
 	edict_t *pLeader = GetLeader();
-	
-	iPosition = GetFormationPosition(pEdict);
+
 	vLeaderOrigin = CBotGlobals::entityOrigin(pLeader);
 
-	int iMod = iPosition % 2;
+	if ( m_bSlotsValid && (m_Slots.size() == iNumMembers) && (m_vSlotsAngle == m_vLeaderAngle) &&
+		((vLeaderOrigin-m_vSlotsOrigin).Length() < SQUAD_FORMATION_MOVE) && (m_fSlotsTime > engine->Time()) )
+		return;
 
 	AngleVectors(m_vLeaderAngle,&v_forward); // leader body angles as base
 
@@ -326,59 +349,63 @@ Vector CBotSquad :: GetFormationVector ( edict_t *pEdict )
 	switch ( m_theDesiredFormation ) 
 	{
 	case SQUAD_FORM_VEE:
-		{
-			if ( iMod )			
-				vBase = (v_forward-v_right);			
-			else
-				vBase = (v_forward+v_right);
-		}
+		vBase[1] = (v_forward-v_right);
+		vBase[0] = (v_forward+v_right);
 		break;
 	case SQUAD_FORM_WEDGE:
-		{
-			if ( iMod )			
-				vBase = -(v_forward-v_right);			
-			else
-				vBase = -(v_forward+v_right);
-		}
+		vBase[1] = -(v_forward-v_right);
+		vBase[0] = -(v_forward+v_right);
 		break;
 	case SQUAD_FORM_LINE:
-		{
-
-			// have members on either side of leader
-
-			if ( iMod )			
-				vBase = v_right;			
-			else
-				vBase = -v_right;
-		}
+		// have members on either side of leader
+		vBase[1] = v_right;
+		vBase[0] = -v_right;
 		break;
 	case SQUAD_FORM_COLUMN:
-		{
-			vBase = -v_forward;
-		}
+		vBase[0] = vBase[1] = -v_forward;
 		break;
 	case SQUAD_FORM_ECH_LEFT:
-		{
-			vBase = -v_forward - v_right;
-		}
+		vBase[0] = vBase[1] = -v_forward - v_right;
 		break;
 	case SQUAD_FORM_ECH_RIGHT:
-		{
-			vBase = -v_forward + v_right;
-		}
+		vBase[0] = vBase[1] = -v_forward + v_right;
+		break;
+	default:
+		vBase[0] = vBase[1] = Vector(0,0,0);
 		break;
 	}
-	
-	vBase = (vBase * m_fDesiredSpread) * iPosition;
 
-	CBotGlobals::quickTraceline(pLeader,vLeaderOrigin,vLeaderOrigin+vBase);
+	m_Slots.resize(iNumMembers);
 
-	if ( tr->fraction < 1.0 )
+	for ( size_t i = 0; i < iNumMembers; i ++ )
 	{
-		return vLeaderOrigin + (vBase*tr->fraction*0.5f);
+		Vector vSlot = vLeaderOrigin + ((vBase[i%2] * m_fDesiredSpread) * (int)i);
+		Vector vPos = vSlot;
+		trace_t tr;
+		CWaypoint *pWpt;
+
+		// clearance from the leader to the slot, ignoring the leader but not
+		// players or NPCs in the way, so not served from the trace cache
+		CBotGlobals::quickTraceline(pLeader,vLeaderOrigin,vSlot,&tr);
+
+		// blocked : halfway to whatever is in the way
+		if ( tr.fraction < 1.0 )
+			vPos = vLeaderOrigin + ((vSlot-vLeaderOrigin)*tr.fraction*0.5f);
+
+		// only onto a waypoint the slot can see, not one behind a wall
+		pWpt = CWaypoints::getWaypoint(CWaypointLocations::NearestWaypoint(vPos,SQUAD_FORMATION_SNAP,-1,true));
+
+		if ( pWpt )
+			vPos = pWpt->getOrigin();
+
+		m_Slots[i].pMember = m_SquadMembers[i];
+		m_Slots[i].vPos = vPos;
 	}
 
-	return vLeaderOrigin+vBase;
+	m_vSlotsOrigin = vLeaderOrigin;
+	m_vSlotsAngle = m_vLeaderAngle;
+	m_fSlotsTime = engine->Time() + SQUAD_FORMATION_REFRESH;
+	m_bSlotsValid = true;
 }
 
 /**
@@ -395,6 +422,7 @@ void CBotSquad::removeMember ( edict_t *pMember )
 	auto it = std::find(m_SquadMembers.begin(), m_SquadMembers.end(), pMember);
 	if (it != m_SquadMembers.end()) {
 		m_SquadMembers.erase(it);
+		m_bSlotsValid = false;
 	}
 }
 
@@ -408,6 +436,7 @@ void CBotSquad::AddMember ( edict_t *pEdict )
 		newh = pEdict;
 
 		m_SquadMembers.push_back(newh);
+		m_bSlotsValid = false;
 
 		/*if ( (pBot=CBots::getBotPointer(pEdict))!=NULL )
 		{
@@ -31,10 +31,18 @@
 #ifndef __RCBOT_SQUADS_H__
 #define __RCBOT_SQUADS_H__
 
+#include <vector>
+
 #include "vector.h"
 #include "bot_ehandle.h"
 
 #define SQUAD_DEFAULT_SPREAD 80.0// say 50 units between each member...?
+// formation slots are worked out again when the leader moves this far...
+#define SQUAD_FORMATION_MOVE 24.0f
+// ...or after this long, in case the way got blocked or opened up
+#define SQUAD_FORMATION_REFRESH 1.0f
+// slots this near a waypoint stand on it
+#define SQUAD_FORMATION_SNAP 48.0f
 
 enum eSquadForm
 {
@@ -64,6 +72,12 @@ enum eTacticType
 	TACTIC_ATTACK
 };
 
+typedef struct
+{
+	edict_t *pMember;
+	Vector vPos;
+}squad_slot_t;
+
 class CBotSquad
 {
 public:
@@ -182,6 +196,7 @@ public:
 	inline void ChangeFormation ( eSquadForm theNewFormation )
 	{
 		m_theDesiredFormation = theNewFormation;
+		m_bSlotsValid = false;
 	}
 
 	inline float GetSpread ( void ) const
@@ -192,10 +207,12 @@ public:
 	inline void ChangeSpread ( float fNewSpread )
 	{
 		m_fDesiredSpread = fNewSpread;
+		m_bSlotsValid = false;
 	}
 
 	int GetFormationPosition ( edict_t *pEdict );
 
+	// members' formation slots are shared, worked out for the whole squad by UpdateFormation
 	Vector GetFormationVector ( edict_t *pEdict );
 
 	void UpdateAngles ( void );
@@ -231,6 +248,15 @@ private:
 	QAngle m_vLeaderAngle;
 	eTacticType m_Tactics;
 	bool m_bIsWaitingForOther;
+
+	void UpdateFormation ( void );
+
+	// every member's slot, in member order, for where the leader was
+	std::vector<squad_slot_t> m_Slots;
+	bool m_bSlotsValid;
+	Vector m_vSlotsOrigin;
+	QAngle m_vSlotsAngle;
+	float m_fSlotsTime;
 };
 
 //-------------------
@@ -49,6 +49,8 @@
 #include "bot_dod_bot.h"
 #include "bot_squads.h"
 #include "bot_waypoint_visibility.h"
+#include "bot_waypoint_indirect.h"
+#include "bot_route_scheduler.h"
 
 
 // desx and desy must be normalized
@@ -2029,6 +2031,7 @@ void CFindPathTask :: init ()
 	m_fRange = 0.0f;
 	m_iDangerPoint = -1;
 	m_bGetPassedIntAsWaypointId = false;
+	m_iRouteRequest = 0;
 	//setFailInterrupt(CONDITION_SEE_CUR_ENEMY);
 }
 
@@ -2044,6 +2047,25 @@ CFindPathTask :: CFindPathTask ( edict_t *pEdict )
 	m_bGetPassedIntAsWaypointId = false;
 }
 
+// retreating or fighting bots get their routes first, then objectives
+int CFindPathTask :: getRoutePriority ( CBot *pBot )
+{
+	CWaypoint *pGoal;
+
+	if ( (m_iDangerPoint != -1) || pBot->hasEnemy() )
+		return ROUTE_PRIORITY_COMBAT;
+
+	if ( m_flags.bits.m_bNoInterruptions )
+		return ROUTE_PRIORITY_OBJECTIVE;
+
+	pGoal = CWaypoints::getWaypoint(m_iWaypointId);
+
+	if ( (pGoal != NULL) && pGoal->hasSomeFlags(CWaypointTypes::W_FL_FLAG|CWaypointTypes::W_FL_CAPPOINT|CWaypointTypes::W_FL_DEFEND) )
+		return ROUTE_PRIORITY_OBJECTIVE;
+
+	return ROUTE_PRIORITY_ROAM;
+}
+
 void CFindPathTask :: debugString ( char *string )
 {
 	sprintf(string,"CFindPathTask\n m_iInt = %d\n m_vVector = (%0.4f,%0.4f,%0.4f)",m_iInt,m_vVector.x,m_vVector.y,m_vVector.z);
@@ -2077,6 +2099,7 @@ void CFindPathTask :: execute ( CBot *pBot, CBotSchedule *pSchedule )
 	if ( (m_iInt == 0) || (m_iInt == 1) )
 	{
 		IBotNavigator *pNav = pBot->getNavigator();
+		bool bRouteDone = false;
 
 		pBot->m_fWaypointStuckTime = 0;
 
@@ -2089,13 +2112,41 @@ void CFindPathTask :: execute ( CBot *pBot, CBotSchedule *pSchedule )
 		}
 #endif
 
-		if ( pNav->workRoute( pBot->getOrigin(),
+		if ( CBotRouteScheduler::isEnabled() )
+		{
+			// the search is done in CBotRouteScheduler::think, ask again if the
+			// request was cancelled, replaced or the goal has moved since
+			if ( (m_iInt == 0) || (CBotRouteScheduler::getState(pBot,m_iRouteRequest,m_vVector,m_iWaypointId) == ROUTE_NONE) )
+			{
+				m_iRouteRequest = CBotRouteScheduler::request(pBot,m_vVector,m_iWaypointId,m_flags.bits.m_bNoInterruptions,
+					pBot->getConditions(),m_iDangerPoint,getRoutePriority(pBot));
+			}
+
+			switch ( CBotRouteScheduler::getState(pBot,m_iRouteRequest,m_vVector,m_iWaypointId) )
+			{
+			case ROUTE_FAILED:
+				bFail = true;
+				bRouteDone = true;
+				break;
+			case ROUTE_DONE:
+				bRouteDone = true;
+				break;
+			default:
+				break;
+			}
+		}
+		else
+		{
+			bRouteDone = pNav->workRoute( pBot->getOrigin(),
 			                   m_vVector,
 							   &bFail,
 							   (m_iInt==0),
 							   m_flags.bits.m_bNoInterruptions, 
 							   m_iWaypointId,
-							   pBot->getConditions(), m_iDangerPoint ) )
+							   pBot->getConditions(), m_iDangerPoint );
+		}
+
+		if ( bRouteDone )
 		{
 			pBot->m_fWaypointStuckTime = engine->Time() + randomFloat(10.0f,15.0f);
 			pBot->moveFailed(); // reset
@@ -2248,6 +2299,25 @@ void CBotTF2FindPipeWaypoint :: execute (CBot *pBot,CBotSchedule *pSchedule)
 		return;
 	}
 
+	// worked out already
+	if ( CWaypointIndirectFire::isReady() )
+	{
+		int iLaunch, iAim;
+		float fLift;
+
+		if ( CWaypointIndirectFire::getSpot(m_iTargetWaypoint,INDIRECT_PIPE,pBot,m_vOrigin,&iLaunch,&iAim,&fLift) )
+		{
+			pSchedule->passInt(iLaunch);
+			pSchedule->passVector(CWaypoints::getWaypoint(iAim)->getOrigin());
+
+			complete();
+		}
+		else
+			fail();
+
+		return;
+	}
+
 	m_iters = 0;
 
 	// loop through every visible waypoint to target (can be unreachable)
@@ -3699,7 +3769,18 @@ void CThrowGrenadeTask ::execute (CBot *pBot,CBotSchedule *pSchedule)
 	{
 		m_fTime = engine->Time() + 2.5f;
 
-		if ( sv_gravity.IsValid() )
+		float fLift;
+		int iLaunch = CWaypointLocations::NearestWaypoint(pBot->getOrigin(),CWaypointLocations::REACHABLE_RANGE,-1,true,false,true,NULL,false,pBot->getTeam());
+		int iTarget = CWaypointLocations::NearestWaypoint(m_vLoc,BLAST_RADIUS,-1,true,true);
+		Vector vAim;
+
+		// standing on a launch spot for the target's waypoint : its arc is known
+		if ( CWaypointIndirectFire::getArc(iLaunch,iTarget,INDIRECT_GRENADE,&vAim) )
+			m_vLoc = vAim;
+		// low arc onto the target if it's in reach
+		else if ( CWaypointIndirectFire::arcLift(pBot->getEyePosition(),m_vLoc,INDIRECT_GRENADE,&fLift) )
+			m_vLoc.z = m_vLoc.z + fLift;
+		else if ( sv_gravity.IsValid() )
 		{
 			float fFraction = pBot->distanceFrom(m_vLoc)/MAX_GREN_THROW_DIST;
 			//m_vLoc.z = m_vLoc.z + getGrenadeZ(pBot->getOrigin(),m_vLoc,m_pWeapon->getProjectileSpeed());
@@ -4354,16 +4435,22 @@ void CBotTF2DemomanPipeEnemy :: execute (CBot *pBot,CBotSchedule *pSchedule)
 		Vector vOtherWaypoint = pSchedule->passedVector();
 		((CBotTF2*)pBot)->setStickyTrapType(m_vEnemy,TF_TRAP_TYPE_ENEMY);
 
-		// Need to Lob my pipes
-		if ( vOtherWaypoint.z > (m_vEnemy.z+32.0f) )
-		{
-			m_vAim = m_vEnemy; //(m_vEnemy - pBot->getOrigin())/2;
-			m_vAim.z = m_vEnemy.z + getGrenadeZ(pBot->getEdict(),m_pEnemy,pBot->getOrigin(),m_vEnemy,TF2_GRENADESPEED);//();//(sv_gravity->GetFloat() * randomFloat(0.9f,1.1f) * fFraction);
-		}
-		else
+		int iEnemyWaypoint = CWaypointLocations::NearestWaypoint(m_vEnemy,BLAST_RADIUS,-1,true,true);
+
+		// standing on a launch spot for the enemy's waypoint : its arc is known
+		if ( !CWaypointIndirectFire::getArc(pSchedule->passedInt(),iEnemyWaypoint,INDIRECT_PIPE,&m_vAim) )
 		{
-			// otherwise just aim at the closest waypoint
-			m_vAim = (vOtherWaypoint+m_vEnemy)/2;
+			// Need to Lob my pipes
+			if ( vOtherWaypoint.z > (m_vEnemy.z+32.0f) )
+			{
+				m_vAim = m_vEnemy; //(m_vEnemy - pBot->getOrigin())/2;
+				m_vAim.z = m_vEnemy.z + getGrenadeZ(pBot->getEdict(),m_pEnemy,pBot->getOrigin(),m_vEnemy,TF2_GRENADESPEED);//();//(sv_gravity->GetFloat() * randomFloat(0.9f,1.1f) * fFraction);
+			}
+			else
+			{
+				// otherwise just aim at the closest waypoint
+				m_vAim = (vOtherWaypoint+m_vEnemy)/2;
+			}
 		}
 
 		m_fHoldAttackTime = (pBot->distanceFrom(m_vEnemy)/512.0f) - 1.0f;
@@ -4691,8 +4778,13 @@ void CBotTF2Spam :: execute (CBot *pBot,CBotSchedule *pSchedule)
 		if ( m_pWeapon->getID() == TF2_WEAPON_GRENADELAUNCHER )
 		{
 			Vector vVisibleWaypoint = pSchedule->passedVector();
+			int iTargetWaypoint = CWaypointLocations::NearestWaypoint(m_vTarget,BLAST_RADIUS,-1,true,true);
+			Vector vAim;
 
-			if ( vVisibleWaypoint.z > (m_vTarget.z + 32.0f) ) // need to lob grenade
+			// standing on a launch spot for the target's waypoint : its arc is known
+			if ( pSchedule->hasPassInt() && CWaypointIndirectFire::getArc(pSchedule->passedInt(),iTargetWaypoint,INDIRECT_PIPE,&vAim) )
+				m_vTarget = vAim;
+			else if ( vVisibleWaypoint.z > (m_vTarget.z + 32.0f) ) // need to lob grenade
 				m_vTarget.z += getGrenadeZ(pBot->getEdict(),NULL,pBot->getOrigin(),m_vTarget,m_pWeapon->getProjectileSpeed());
 			else // mid point between waypoint and target as I won't see target
 				m_vTarget = (m_vTarget + vVisibleWaypoint) / 2;
@@ -199,7 +199,7 @@ public:
 
 	virtual void debugString ( char *string );
 private:
-
+	int getRoutePriority ( CBot *pBot );
 
 	Vector m_vVector;
 	MyEHandle m_pEdict;
@@ -208,6 +208,7 @@ private:
 	int m_iWaypointId;
 	int m_iDangerPoint;
 	float m_fRange;
+	unsigned int m_iRouteRequest;
 
 	union
 	{
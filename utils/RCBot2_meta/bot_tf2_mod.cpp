@@ -61,6 +61,10 @@ float CTeamFortress2Mod::m_fArenaPointOpenTime = 0.0f;
 float CTeamFortress2Mod::m_fPointTime = 0.0f;
 tf_sentry_t CTeamFortress2Mod::m_SentryGuns[MAX_PLAYERS];	// used to let bots know if sentries have been sapped or not
 tf_disp_t  CTeamFortress2Mod::m_Dispensers[MAX_PLAYERS];	// used to let bots know where friendly/enemy dispensers are
+tf_building_t CTeamFortress2Mod::m_Buildings[MAX_EDICTS];
+short int CTeamFortress2Mod::m_SapperBuilding[MAX_EDICTS];
+short int CTeamFortress2Mod::m_BuildingList[MAX_TF2_BUILDINGS];
+int CTeamFortress2Mod::m_iNumBuildings = 0;
 MyEHandle CTeamFortress2Mod::m_pResourceEntity = MyEHandle(NULL);
 MyEHandle CTeamFortress2Mod::m_pGameRules = MyEHandle(NULL);
 bool CTeamFortress2Mod::m_bAttackDefendMap = false;
@@ -287,6 +291,8 @@ void CTeamFortress2Mod :: mapInit ()
 		pMediGuns[i] = NULL;
 	}
 
+	resetBuildings();
+
 	m_bAttackDefendMap = false;
 	m_pBoss = NULL;
 	m_bBossSummoned = false;
@@ -298,15 +304,154 @@ void CTeamFortress2Mod :: mapInit ()
 
 int CTeamFortress2Mod :: getTeleporterWaypoint ( edict_t *pTele )
 {
-	int i;
+	tf_building_t *pEntry = getBuildingEntry(pTele);
 
-	for ( i = 0; i < MAX_PLAYERS; i ++ )
+	if ( (pEntry == NULL) || (pEntry->type != ENGI_TELE) )
+		return -1;
+
+	if ( m_Teleporters[pEntry->owner-1].exit.get() == pTele )
+		return m_Teleporters[pEntry->owner-1].m_iWaypoint;
+
+	return -1;
+}
+
+void CTeamFortress2Mod :: resetBuildings ()
+{
+	for ( int i = 0; i < MAX_EDICTS; i ++ )
 	{
-		if ( m_Teleporters[i].exit.get() == pTele )
-			return m_Teleporters[i].m_iWaypoint; 
+		m_Buildings[i].building = MyEHandle(NULL);
+		m_Buildings[i].sapper = MyEHandle(NULL);
+		m_Buildings[i].listindex = -1;
 	}
 
-	return -1;
+	memset(m_SapperBuilding,0,sizeof(short int)*MAX_EDICTS);
+	m_iNumBuildings = 0;
+
+	CClassInterface::unwatchAll();
+}
+
+void CTeamFortress2Mod :: addBuilding ( edict_t *pOwner, eEngiBuild type, edict_t *pBuilding )
+{
+	tf_building_t *pEntry;
+	int index = ENTINDEX(pBuilding);
+
+	if ( (index <= 0) || (index >= MAX_EDICTS) )
+		return;
+
+	pEntry = &(m_Buildings[index]);
+
+	if ( pEntry->listindex == -1 )
+	{
+		if ( m_iNumBuildings == MAX_TF2_BUILDINGS )
+		{
+			// drop any that were destroyed without an event
+			for ( int i = m_iNumBuildings-1; i >= 0; i -- )
+			{
+				if ( m_Buildings[m_BuildingList[i]].building.get() == NULL )
+					removeBuilding(m_BuildingList[i]);
+			}
+
+			if ( m_iNumBuildings == MAX_TF2_BUILDINGS )
+				return;
+		}
+
+		pEntry->listindex = m_iNumBuildings;
+		m_BuildingList[m_iNumBuildings++] = index;
+	}
+
+	pEntry->building = MyEHandle(pBuilding);
+	pEntry->sapper = MyEHandle();
+	pEntry->owner = ENTINDEX(pOwner);
+	pEntry->team = getTeam(pOwner);
+	pEntry->type = type;
+	// a building that was carried keeps its level
+	pEntry->level = MAX(1,CClassInterface::getTF2UpgradeLevel(pBuilding));
+
+	CClassInterface::watchEntity(pBuilding,(type == ENGI_SENTRY) ? GETPROP_SNAP_SENTRY : GETPROP_SNAP_BUILDING);
+}
+
+void CTeamFortress2Mod :: removeBuilding ( int index )
+{
+	tf_building_t *pEntry;
+	int listindex;
+	edict_t *pSapper;
+
+	if ( (index <= 0) || (index >= MAX_EDICTS) )
+		return;
+
+	pEntry = &(m_Buildings[index]);
+	listindex = pEntry->listindex;
+	pSapper = pEntry->sapper.get_old();
+
+	if ( listindex == -1 )
+		return;
+
+	// move the last one into this slot
+	m_iNumBuildings--;
+	m_BuildingList[listindex] = m_BuildingList[m_iNumBuildings];
+	m_Buildings[m_BuildingList[listindex]].listindex = listindex;
+
+	if ( pSapper && (m_SapperBuilding[ENTINDEX(pSapper)] == index) )
+		m_SapperBuilding[ENTINDEX(pSapper)] = 0;
+
+	pEntry->building = MyEHandle();
+	pEntry->sapper = MyEHandle();
+	pEntry->listindex = -1;
+
+	CClassInterface::unwatchEntity(index);
+}
+
+int CTeamFortress2Mod :: getBuildingLevel ( edict_t *pBuilding )
+{
+	tf_building_t *pEntry = getBuildingEntry(pBuilding);
+
+	if ( pEntry != NULL )
+		return pEntry->level;
+
+	return CClassInterface::getTF2UpgradeLevel(pBuilding);
+}
+
+void CTeamFortress2Mod :: buildingUpgraded ( int index )
+{
+	if ( (index <= 0) || (index >= MAX_EDICTS) )
+		return;
+
+	if ( (m_Buildings[index].building.get() != NULL) && (m_Buildings[index].level < 3) )
+		m_Buildings[index].level++;
+}
+
+edict_t *CTeamFortress2Mod :: nearestBuilding ( eEngiBuild type, int team, Vector vOrigin, float fMaxDistance )
+{
+	edict_t *pNearest = NULL;
+	edict_t *pBuilding;
+	tf_building_t *pEntry;
+	float fDist;
+	float fNearest = fMaxDistance;
+
+	for ( int i = m_iNumBuildings-1; i >= 0; i -- )
+	{
+		pEntry = &(m_Buildings[m_BuildingList[i]]);
+
+		if ( (pBuilding = pEntry->building.get()) == NULL )
+		{
+			// destroyed without an event, i is still safe to go on from after the swap
+			removeBuilding(m_BuildingList[i]);
+			continue;
+		}
+
+		if ( (pEntry->type != type) || (pEntry->team != team) )
+			continue;
+
+		fDist = (CBotGlobals::entityOrigin(pBuilding) - vOrigin).Length();
+
+		if ( fDist < fNearest )
+		{
+			pNearest = pBuilding;
+			fNearest = fDist;
+		}
+	}
+
+	return pNearest;
 }
 
 // Naris @ AlliedModders .net
@@ -606,56 +751,37 @@ bool CTeamFortress2Mod :: isRocket ( edict_t *pEntity, int iTeam )
 edict_t *CTeamFortress2Mod:: getMediGun ( edict_t *pPlayer )
 {
 	if ( CClassInterface::getTF2Class(pPlayer) == TF_CLASS_MEDIC )
+	{
+		// may not have had it yet when spawned
+		if ( pMediGuns[ENTINDEX(pPlayer)-1].get() == NULL )
+			findMediGun(pPlayer);
+
 		return pMediGuns[ENTINDEX(pPlayer)-1];
+	}
 	return NULL;
 }
 
 void CTeamFortress2Mod :: findMediGun ( edict_t *pPlayer )
 {
-	static int i;
-	static edict_t *pEnt;
-	static Vector vOrigin;
-
-	vOrigin = CBotGlobals::entityOrigin(pPlayer);
+	// only the medic's own weapons need searching, not every entity
+	edict_t *pMediGun = CWeapons::findWeapon(pPlayer,"tf_weapon_medigun");
 
-	for ( i = (gpGlobals->maxClients+1); i < gpGlobals->maxEntities; i ++ )
-	{
-		pEnt = INDEXENT(i);
-
-		if ( pEnt && CBotGlobals::entityIsValid(pEnt) )
-		{
-			if ( strcmp(pEnt->GetClassName(),"tf_weapon_medigun") == 0 )
-			{
-				if ( CBotGlobals::entityOrigin(pEnt) == vOrigin )
-				{
-					pMediGuns[ENTINDEX(pPlayer)-1] = pEnt;
-					break;
-				}
-			}
-		}
-	}
+	if ( pMediGun )
+		pMediGuns[ENTINDEX(pPlayer)-1] = pMediGun;
 }
 
 // get the teleporter exit of an entrance
 edict_t *CTeamFortress2Mod :: getTeleporterExit ( edict_t *pTele )
 {
-	int i;
-	edict_t *pExit;
+	tf_building_t *pEntry = getBuildingEntry(pTele);
 
-	for ( i = 0; i < MAX_PLAYERS; i ++ )
-	{
-		if ( m_Teleporters[i].entrance.get() == pTele )
-		{
-			if ( (pExit = m_Teleporters[i].exit.get()) != NULL )
-			{
-				return pExit;
-			}
+	if ( (pEntry == NULL) || (pEntry->type != ENGI_TELE) )
+		return nullptr;
 
-			return nullptr;
-		}
-	}
+	if ( m_Teleporters[pEntry->owner-1].entrance.get() != pTele )
+		return nullptr;
 
-	return nullptr;
+	return m_Teleporters[pEntry->owner-1].exit.get();
 }
 
 // check if the entity is a health kit
@@ -896,6 +1022,8 @@ void CTeamFortress2Mod :: teleporterBuilt ( edict_t *pOwner, eEngiBuild type, ed
 	else if ( CTeamFortress2Mod::isTeleporterExit(pBuilding,team) )
 		m_Teleporters[iIndex].exit = MyEHandle(pBuilding);
 
+	addBuilding(pOwner,type,pBuilding);
+
 	m_Teleporters[iIndex].sapper = MyEHandle();
 	m_Teleporters[iIndex].m_fLastTeleported = 0.0f;
 	m_Teleporters[iIndex].m_iWaypoint = CWaypointLocations::NearestWaypoint(CBotGlobals::entityOrigin(pBuilding),400.0f,-1,true);
@@ -930,50 +1058,21 @@ int CTeamFortress2Mod ::getHighestScore ()
 // check quickly by using the storage of sentryguns etc in the mod class
 bool CTeamFortress2Mod::buildingNearby ( int iTeam, Vector vOrigin )
 {
-	edict_t *pPlayer;
-	short int i;
-	short int sentryIndex;
+	tf_building_t *pEntry;
+	edict_t *pBuilding;
 
-	for ( i = 1; i <= gpGlobals->maxClients; i ++ )
+	for ( int i = 0; i < m_iNumBuildings; i ++ )
 	{
-		pPlayer = INDEXENT(i);
-
-		// crash bug fix 
-		if ( !pPlayer || pPlayer->IsFree() )
-			continue;
+		pEntry = &(m_Buildings[m_BuildingList[i]]);
 
-		sentryIndex = i - 1;
-
-		if ( CClassInterface::getTF2Class(pPlayer) != TF_CLASS_ENGINEER )
+		if ( pEntry->team != iTeam )
 			continue;
 
-		if ( CClassInterface::getTeam(pPlayer) != iTeam )
+		if ( (pBuilding = pEntry->building.get()) == NULL )
 			continue;
 
-		if (m_SentryGuns[sentryIndex].sentry.get())
-		{
-			if ((vOrigin - CBotGlobals::entityOrigin(m_SentryGuns[sentryIndex].sentry.get())).Length() < 100)
-				return true;
-		}
-
-		if (m_Dispensers[sentryIndex].disp.get())
-		{
-			if ((vOrigin - CBotGlobals::entityOrigin(m_Dispensers[sentryIndex].disp.get())).Length() < 100)
-				return true;
-		}
-
-		if (m_Teleporters[sentryIndex].entrance.get())
-		{
-			if ( (vOrigin-CBotGlobals::entityOrigin(m_Teleporters[sentryIndex].entrance.get())).Length() < 100 )
-				return true;
-		}
-
-		if (m_Teleporters[sentryIndex].exit.get())
-		{
-			if ( (vOrigin-CBotGlobals::entityOrigin(m_Teleporters[sentryIndex].exit.get())).Length() < 100 )
-				return true;
-		}
-
+		if ( (vOrigin - CBotGlobals::entityOrigin(pBuilding)).Length() < 100 )
+			return true;
 	}
 
 	return false;
@@ -1012,72 +1111,22 @@ edict_t *CTeamFortress2Mod::getBuilding (eEngiBuild object, edict_t *pOwner)
 // get the owner of 
 edict_t *CTeamFortress2Mod ::getBuildingOwner (eEngiBuild object, short index)
 {
-	static short int i;
-	static tf_tele_t *tele;
+	tf_building_t *pEntry;
 
-	switch ( object )
-	{
-	case ENGI_DISP:
-		for ( i = 0; i < MAX_PLAYERS; i ++ )
-		{
-			if ( m_Dispensers[i].disp.get() && (ENTINDEX(m_Dispensers[i].disp.get())==index) )
-				return INDEXENT(i+1);
-		}
-		//m_SentryGuns[i].
-		break;
-	case ENGI_SENTRY:
-		for ( i = 0; i < MAX_PLAYERS; i ++ )
-		{
-			if ( m_SentryGuns[i].sentry.get() && (ENTINDEX(m_SentryGuns[i].sentry.get())==index) )
-				return INDEXENT(i+1);
-		}
-		break;
-	case ENGI_TELE:
-		tele = m_Teleporters;
+	if ( (index <= 0) || (index >= MAX_EDICTS) )
+		return NULL;
 
-		for ( i = 0; i < MAX_PLAYERS; i ++ )
-		{
-			if ( tele->entrance.get() && (ENTINDEX(tele->entrance.get())==index) )
-				return INDEXENT(i+1);
-			if ( tele->exit.get() && (ENTINDEX(tele->exit.get())==index) )
-				return INDEXENT(i+1);
+	pEntry = getBuildingEntry(INDEXENT(index));
 
-			tele++;
-		}
-		break;
-	}
+	if ( (pEntry == NULL) || (pEntry->type != object) )
+		return NULL;
 
-	return NULL;
+	return INDEXENT(pEntry->owner);
 }
 
 edict_t *CTeamFortress2Mod :: nearestDispenser ( Vector vOrigin, int team )
 {
-	edict_t *pNearest = NULL;
-	edict_t *pDisp;
-	float fDist;
-	float fNearest = bot_use_disp_dist.GetFloat();
-
-	for ( unsigned int i = 0; i < MAX_PLAYERS; i ++ )
-	{
-		//m_Dispensers[i]
-		pDisp = m_Dispensers[i].disp.get();
-
-		if ( pDisp )
-		{
-			if ( CTeamFortress2Mod::getTeam(pDisp) == team )
-			{
-				fDist = (CBotGlobals::entityOrigin(pDisp) - vOrigin).Length();
-
-				if ( fDist < fNearest )
-				{
-					pNearest = pDisp;
-					fNearest = fDist;
-				}
-			}
-		}
-	}
-
-	return pNearest;
+	return nearestBuilding(ENGI_DISP,team,vOrigin,bot_use_disp_dist.GetFloat());
 }
 
 void CTeamFortress2Mod::sapperPlaced(edict_t *pOwner,eEngiBuild type,edict_t *pSapper)
@@ -1088,12 +1137,31 @@ void CTeamFortress2Mod::sapperPlaced(edict_t *pOwner,eEngiBuild type,edict_t *pS
 
 	if ( (index>=0) && (index<MAX_PLAYERS) )
 	{
+		edict_t *pBuilding = getBuilding(type,pOwner);
+		tf_building_t *pEntry;
+
 		if ( type == ENGI_TELE )
+		{
+			edict_t *pExit = m_Teleporters[index].exit.get();
+
 			m_Teleporters[index].sapper = MyEHandle(pSapper);
+
+			// the event doesn't say which end, take the one the sapper is on
+			if ( pBuilding && pExit && (pBuilding != pExit) && 
+				((CBotGlobals::entityOrigin(pExit)-CBotGlobals::entityOrigin(pSapper)).Length() < 
+				 (CBotGlobals::entityOrigin(pBuilding)-CBotGlobals::entityOrigin(pSapper)).Length()) )
+				pBuilding = pExit;
+		}
 		else if ( type == ENGI_DISP )
 			m_Dispensers[index].sapper = MyEHandle(pSapper);
 		else if ( type == ENGI_SENTRY )
 			m_SentryGuns[index].sapper = MyEHandle(pSapper);
+
+		if ( (pEntry = getBuildingEntry(pBuilding)) != NULL )
+		{
+			pEntry->sapper = MyEHandle(pSapper);
+			m_SapperBuilding[ENTINDEX(pSapper)] = ENTINDEX(pBuilding);
+		}
 	}
 }
 
@@ -1133,26 +1201,37 @@ void CTeamFortress2Mod:: addWaypointFlags (edict_t *pPlayer, edict_t *pEdict, in
 
 void CTeamFortress2Mod::sapperDestroyed(edict_t *pOwner,eEngiBuild type, edict_t *pSapper)
 {
-	static short int index; 
+	tf_building_t *pEntry;
+	int iSapper = ENTINDEX(pSapper);
+	int index;
 
-	for ( index = 0; index < MAX_PLAYERS; index ++ )
+	// pOwner is whoever destroyed the sapper, so find the building from the sapper
+	if ( (iSapper <= 0) || (iSapper >= MAX_EDICTS) || (m_SapperBuilding[iSapper] == 0) )
+		return;
+
+	pEntry = &(m_Buildings[m_SapperBuilding[iSapper]]);
+	m_SapperBuilding[iSapper] = 0;
+
+	if ( pEntry->sapper.get_old() != pSapper )
+		return;
+
+	pEntry->sapper = MyEHandle();
+	index = pEntry->owner-1;
+
+	if ( pEntry->type == ENGI_TELE )
 	{
-		if ( type == ENGI_TELE )
-		{
-			if ( m_Teleporters[index].sapper.get_old() == pSapper )
-				m_Teleporters[index].sapper = MyEHandle();
-			
-		}
-		else if ( type == ENGI_DISP )
-		{
-			if ( m_Dispensers[index].sapper.get_old() == pSapper )
-				m_Dispensers[index].sapper = MyEHandle();
-		}
-		else if ( type == ENGI_SENTRY )
-		{
-			if ( m_SentryGuns[index].sapper.get_old() == pSapper )
-				m_SentryGuns[index].sapper = MyEHandle();
-		}
+		if ( m_Teleporters[index].sapper.get_old() == pSapper )
+			m_Teleporters[index].sapper = MyEHandle();
+	}
+	else if ( pEntry->type == ENGI_DISP )
+	{
+		if ( m_Dispensers[index].sapper.get_old() == pSapper )
+			m_Dispensers[index].sapper = MyEHandle();
+	}
+	else if ( pEntry->type == ENGI_SENTRY )
+	{
+		if ( m_SentryGuns[index].sapper.get_old() == pSapper )
+			m_SentryGuns[index].sapper = MyEHandle();
 	}
 }
 
@@ -1277,9 +1356,6 @@ void CTeamFortress2Mod :: roundReset ()
 		// if all points are owned by RED at start up then its an attack defend map
 		setAttackDefendMap(i==numpoints);
 
-		m_ObjectiveResource.m_fUpdatePointTime = engine->Time() + rcbot_tf2_autoupdate_point_time.GetFloat();
-		m_ObjectiveResource.m_fNextCheckMonitoredPoint = engine->Time() + 0.2f;
-
 		m_ObjectiveResource.updatePoints();
 
 	}
@@ -1344,26 +1420,17 @@ void CTeamFortress2Mod::sentryBuilt(edict_t *pOwner, eEngiBuild type, edict_t *p
 			temp->sentry = MyEHandle(pBuilding);
 			temp->sapper = MyEHandle();
 			//m_SentryGuns[index].builder
+
+			addBuilding(pOwner,type,pBuilding);
 		}
 	}
 }
 
 bool CTeamFortress2Mod::isSentryGun (edict_t *pEdict )
 {
-	static short int i;
-	static tf_sentry_t *temp;
-
-	temp = m_SentryGuns;
+	tf_building_t *pEntry = getBuildingEntry(pEdict);
 
-	for ( i = 0; i < MAX_PLAYERS; i ++ )
-	{
-		if ( temp->sentry == pEdict )
-			return true;
-
-		temp++;
-	}
-
-	return false;
+	return (pEntry != NULL) && (pEntry->type == ENGI_SENTRY);
 }
 
 void CTeamFortress2Mod::dispenserBuilt(edict_t *pOwner, eEngiBuild type, edict_t *pBuilding )
@@ -1381,6 +1448,8 @@ void CTeamFortress2Mod::dispenserBuilt(edict_t *pOwner, eEngiBuild type, edict_t
 			temp->disp = MyEHandle(pBuilding);
 			temp->sapper = MyEHandle();
 			//m_Dispensers[index].builder = userid;
+
+			addBuilding(pOwner,type,pBuilding);
 		}
 	}
 }
@@ -7,86 +7,113 @@
 #include "bot_waypoint.h"
 #include "bot_globals.h"
 #include "bot_waypoint_locations.h"
+#include "bot_waypoint_flow.h"
 
-class CBotFuncResetAttackPoint : public IBotFunction
+void CTFObjectiveResource::updatePoints( bool bForce )
 {
-public:
-	CBotFuncResetAttackPoint(int team) { iTeam = team; }
-	void execute ( CBot *pBot )
-	{
-		if ( pBot->getTeam() == iTeam )
-			((CBotTF2*)pBot)->updateAttackPoints();
-	}
-private:
-	int iTeam;	
-};
+	bool bChanged = false;
 
-class CBotFuncResetDefendPoint : public IBotFunction
-{
-public:
-	CBotFuncResetDefendPoint(int team) { iTeam = team; }
-	void execute ( CBot *pBot )
+	if ( bForce )
+		m_fUpdatePointTime = engine->Time() + rcbot_tf2_autoupdate_point_time.GetFloat();
+
+	m_bPointsDirty = false;
+
+	for ( int team = TF2_TEAM_RED; team <= TF2_TEAM_BLUE; team ++ )
 	{
-		if ( pBot->getTeam() == iTeam )
-			((CBotTF2*)pBot)->updateDefendPoints();
+		unsigned int signature = getStateSignature(team);
+		bool bTeamChanged = false;
+
+		// nothing this team's points depend on has changed
+		if ( !bForce && (signature == m_iStateSignature[team-2]) )
+			continue;
+
+		m_iStateSignature[team-2] = signature;
+
+		// bots read the new points next time they think
+		if ( updateAttackPoints(team) )
+		{
+			m_iPointsVersion[team-2][TF2_POINT_ATTACK] = ++m_iVersion;
+			bTeamChanged = true;
+		}
+
+		if ( updateDefendPoints(team) )
+		{
+			m_iPointsVersion[team-2][TF2_POINT_DEFEND] = ++m_iVersion;
+			bTeamChanged = true;
+		}
+
+		if ( bTeamChanged || bForce )
+		{
+			updateFlowFields(team);
+			bChanged = true;
+		}
 	}
-private:
-	int iTeam;	
-};
 
+	if ( bChanged )
+		updateValidWaypointAreas();
+}
 
-class CBotFuncPointsUpdated : public IBotFunction
+// cheap enough to check every frame : only the netprops the attack and defend points are worked out from
+unsigned int CTFObjectiveResource :: getStateSignature ( int team )
 {
-public:
-	void execute ( CBot *pBot )
-	{
-		((CBotTF2*)pBot)->pointsUpdated();
-	}	
-};
+	unsigned int signature;
+	float fTime = engine->Time();
 
-void CTFObjectiveResource::updatePoints()
-{
-	static CBotFuncResetAttackPoint resetBlueAttack(TF2_TEAM_BLUE);
-	static CBotFuncResetDefendPoint resetBlueDefend(TF2_TEAM_BLUE);
-	static CBotFuncResetDefendPoint resetRedAttack(TF2_TEAM_RED);
-	static CBotFuncResetDefendPoint resetRedDefend(TF2_TEAM_RED);
-	static CBotFuncPointsUpdated pointsUpdated;
-	bool bChanged = false;
+	if ( m_iNumControlPoints == NULL )
+		return 0;
 
-	m_iMonitorPoint[0] = -1;
-	m_iMonitorPoint[1] = -1;
+	signature = CTeamFortress2Mod::hasRoundStarted() ? 1 : 0;
 
-	CTeamFortress2Mod::m_ObjectiveResource.resetValidWaypointAreas();
+	if ( CTeamFortress2Mod::isAttackDefendMap() )
+		signature |= 2;
 
-	if ( CTeamFortress2Mod::m_ObjectiveResource.updateAttackPoints(TF2_TEAM_BLUE) )
+	for ( int i = 0; i < *m_iNumControlPoints; i ++ )
 	{
-		CBots::botFunction(&resetBlueAttack);
-		bChanged = true;
+		unsigned int state = (unsigned int)GetOwningTeam(i) & 3;
+
+		if ( m_bCPIsVisible[i] )
+			state |= 4;
+		if ( m_flUnlockTimes[i] > fTime )
+			state |= 8;
+		if ( m_bCPLocked[i] )
+			state |= 16;
+		if ( TeamCanCapPoint(i,team) )
+			state |= 32;
+
+		signature = (signature * 31) + state;
 	}
 
-	if ( CTeamFortress2Mod::m_ObjectiveResource.updateAttackPoints(TF2_TEAM_RED) )
-	{
-		CBots::botFunction(&resetRedAttack);
-		bChanged = true;
-	}
+	return signature;
+}
 
-	if ( CTeamFortress2Mod::m_ObjectiveResource.updateDefendPoints(TF2_TEAM_BLUE) )
-	{
-		CBots::botFunction(&resetBlueDefend);
-		bChanged = true;
-	}
+void CTFObjectiveResource::updateFlowFields( int team )
+{
+	CWaypointBits capPoints;
+	CWaypointBits goals;
+
+	if ( m_iNumControlPoints == NULL )
+		return;
 
-	if ( CTeamFortress2Mod::m_ObjectiveResource.updateDefendPoints(TF2_TEAM_RED) )
+	CWaypoints::getFlaggedBits(&capPoints,CWaypointTypes::W_FL_CAPPOINT);
+
+	for ( int i = 0; i < *m_iNumControlPoints; i ++ )
 	{
-		CBots::botFunction(&resetRedDefend);
-		bChanged = true;
-	}
+		int iArea = m_IndexToWaypointAreaTranslation[i];
 
-	if ( bChanged )
-		CBots::botFunction(&pointsUpdated);
+		// no waypoint area for this point
+		if ( iArea == 0 )
+			continue;
+		if ( !m_ValidPoints[team-2][TF2_POINT_ATTACK][i].bValid && !m_ValidPoints[team-2][TF2_POINT_DEFEND][i].bValid )
+			continue;
 
-	CTeamFortress2Mod::m_ObjectiveResource.updateValidWaypointAreas();
+		for ( int iWpt = capPoints.next(0); iWpt != -1; iWpt = capPoints.next(iWpt+1) )
+		{
+			if ( CWaypoints::getWaypoint(iWpt)->getArea() == iArea )
+				goals.set(iWpt);
+		}
+	}
 
+	CWaypointFlowField::setObjectives(team,&goals);
 }
 // INPUT = Waypoint Area
 bool CTFObjectiveResource :: isWaypointAreaValid ( int wptarea, int waypointflags ) 
@@ -746,41 +773,12 @@ bool CTFObjectiveResource :: updateDefendPoints ( int team )
 
 void CTFObjectiveResource :: think ()
 {
-	if ( m_bInitialised && ( m_fNextCheckMonitoredPoint < engine->Time() ) )
-	{
-		bool bupdate = (m_fUpdatePointTime < engine->Time());
-
-		int team = 0;
+	if ( !m_bInitialised )
+		return;
 
-		do
-		{
-			if ( m_iMonitorPoint[team] != -1 )
-			{
-				for ( int j = 0; j < MAX_PREVIOUS_POINTS; j ++ )
-				{
-					int prev = GetPreviousPointForPoint(m_iMonitorPoint[team],(team+2),j);
-
-					if ( (prev != -1) && (GetOwningTeam(prev)!=(team+2)) )
-					{
-						bupdate = true;
-						break;
-					}
-				}
-			}
-			team++;
-		}while ((team < 2) && (bupdate==false));
-
-		if ( bupdate )
-		{
-			updatePoints();
-
-			m_fNextCheckMonitoredPoint = engine->Time() + 5.0f;
-			m_fUpdatePointTime = engine->Time() + rcbot_tf2_autoupdate_point_time.GetFloat();
-		}
-		else
-			m_fNextCheckMonitoredPoint = engine->Time() + 1.0f;
-	}
-	
+	// events mark the points dirty, otherwise only teams whose state signature changed are
+	// recomputed. The timer is a fallback for anything the signature doesn't cover
+	updatePoints(m_bPointsDirty || (m_fUpdatePointTime < engine->Time()));
 }
 
 // return true if bots should change attack point
@@ -875,8 +873,6 @@ bool CTFObjectiveResource :: updateAttackPoints ( int team )
 						else
 						{
 							arr[i].bValid = true;
-
-							m_iMonitorPoint[team-2] = i;
 						}
 					}
 				}
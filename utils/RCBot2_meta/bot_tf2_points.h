@@ -53,15 +53,19 @@ class CTFObjectiveResource
 public:
 	CTFObjectiveResource()
 	{
+		m_iVersion = 0;
 		reset();
 	}
 
 	void reset ()
 	{
+		// keep counting versions across maps so bots never mistake a new snapshot for an old one
+		int iVersion = m_iVersion;
+
 		memset(this,0,sizeof(CTFObjectiveResource));
 		memset(m_iControlPointWpt,0xFF,sizeof(int)*MAX_CONTROL_POINTS);
-		m_iMonitorPoint[0] = -1;
-		m_iMonitorPoint[1] = -1;
+
+		m_iVersion = iVersion;
 	}
 
 
@@ -71,7 +75,19 @@ public:
 	bool testProbWptArea ( int iWptArea, int iTeam );
 
 	void debugprint ( void );
-	void updatePoints();
+	// recompute attack/defend points of teams whose control point state changed
+	// bForce recomputes both teams e.g. at round start
+	void updatePoints( bool bForce = true );
+	// capture or round events : recompute points on the next frame
+	inline void pointsChanged () { m_bPointsDirty = true; }
+	// bots compare this with the version they last read to pick up new points
+	inline int getPointsVersion ( int team, ePointAttackDefend_s type )
+	{
+		if ( (team < 2) || (team > 3) ) // red or blue only
+			return 0;
+
+		return m_iPointsVersion[team-2][type];
+	}
 	bool TeamCanCapPoint( int index, int team )
 	{
 		AssertValidIndex(index);
@@ -255,9 +271,6 @@ public:
 	int *m_iOwner;//[8];
 	bool *m_bCPCapRateScalesWithPlayers;//[8];
 	bool *m_bPlayingMiniRounds;
-	// capindex of point being monitored to check previous points for both teams
-	int m_iMonitorPoint[2];
-	float m_fNextCheckMonitoredPoint;
 	
 	float m_fLastCaptureTime[MAX_CONTROL_POINTS];
 
@@ -266,10 +279,21 @@ public:
 	private:
 	bool m_bInitialised;
 
+	// signature of the netprops each team's points depend on
+	unsigned int getStateSignature ( int team );
+	// [team] -- last signature the points were worked out with
+	unsigned int m_iStateSignature[2];
+	bool m_bPointsDirty;
+	// [team][type] -- bumped from m_iVersion each time the points change
+	int m_iPointsVersion[2][2];
+	int m_iVersion;
+
 	//return a signature of the points structure. Bots will rethink their defend or attack point
 	// if the signature changes
 	bool updateAttackPoints ( int team );
 	bool updateDefendPoints ( int team );
+	// capture waypoints of a team's attack and defend points
+	void updateFlowFields ( int team );
 
 	inline void resetValidWaypointAreas() 
 	{ 
@@ -41,11 +41,26 @@
 
 #include "ndebugoverlay.h"
 
+#include <algorithm>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+#define BOT_VISIBLES_SSE
+#include <xmmintrin.h>
+#endif
+
 extern IVDebugOverlay *debugoverlay;
 ////////////////////////////////////////////
 
 byte CBotVisibles :: m_bPvs[MAX_MAP_CLUSTERS/8];
 
+int CBotVisibles :: m_iOriginsFrame = -1;
+int CBotVisibles :: m_iNumOrigins = 0;
+int CBotVisibles :: m_iOriginIndex[MAX_EDICTS];
+float CBotVisibles :: m_fOriginX[MAX_EDICTS];
+float CBotVisibles :: m_fOriginY[MAX_EDICTS];
+float CBotVisibles :: m_fOriginZ[MAX_EDICTS];
+bool CBotVisibles :: m_bInFront[MAX_EDICTS];
+
 ////////////////////////////////////////
 
 /*
@@ -230,7 +245,6 @@ void CBotVisibles :: updateVisibles ()
 
 	static int iTicks;
 	static int iMaxTicks;  //m_pBot->getProfile()->getVisionTicks();
-	static int iStartIndex;
 	static int iMaxClientTicks; 
 	static int iStartPlayerIndex;
 	static int iSpecialIndex;
@@ -251,7 +265,6 @@ void CBotVisibles :: updateVisibles ()
 	else
 		iMaxTicks = m_pBot->getProfile()->m_iVisionTicks;// bot_visrevs.GetInt();
 
-	iStartIndex = m_iCurrentIndex;
 
 	if ( rcbot_supermode.GetBool() )
 		iMaxClientTicks = (gpGlobals->maxClients/2)+1;
@@ -330,30 +343,51 @@ void CBotVisibles :: updateVisibles ()
 		}
 	}
 
-	while ( iTicks < iMaxTicks )
+	updateEntityOrigins();
+
+	// only spend ticks on entities in front of the bot, the rest can't be seen
+	// so only need clearing if they were visible before
 	{
-		bVisible = false;
+		Vector vForward;
+		int iNumOrigins = std::lower_bound(m_iOriginIndex,m_iOriginIndex+m_iNumOrigins,m_iMaxIndex) - m_iOriginIndex;
+		int iSlot = std::lower_bound(m_iOriginIndex,m_iOriginIndex+iNumOrigins,m_iCurrentIndex) - m_iOriginIndex;
+		int iChecked = 0;
 
-		pEntity = INDEXENT(m_iCurrentIndex);
+		AngleVectors(m_pBot->eyeAngles(),&vForward);
+		findInFront(m_pBot->getEyePosition(),vForward);
 
-		if ( (pEntity != pGroundEntity) && (m_iCurrentIndex != iSpecialIndex)  )
+		while ( (iTicks < iMaxTicks) && (iChecked < iNumOrigins) )
 		{
-			if ( CBotGlobals::entityIsValid(pEntity) )
-			{		
-				checkVisible(pEntity,&iTicks,&bVisible,m_iCurrentIndex);
+			int iThis;
+			int iIndex;
 
-				setVisible(pEntity,bVisible);
-				m_pBot->setVisible(pEntity,bVisible);
-			}
-		}
+			if ( iSlot >= iNumOrigins )
+				iSlot = 0; // back to start of non clients
+
+			iThis = iSlot++;
+			iIndex = m_iOriginIndex[iThis];
+
+			iChecked++;
+
+			if ( (iIndex == iSpecialIndex) || (!m_bInFront[iThis] && !isIndexVisible(iIndex-1)) )
+				continue;
+
+			pEntity = INDEXENT(iIndex);
 
-		m_iCurrentIndex ++;
+			if ( (pEntity == pGroundEntity) || !CBotGlobals::entityIsValid(pEntity) )
+				continue;
 
-		if ( m_iCurrentIndex >= m_iMaxIndex )
-			m_iCurrentIndex = CBotGlobals::maxClients()+1; // back to start of non clients
+			bVisible = false;
 
-		if ( m_iCurrentIndex == iStartIndex )
-			break; // back to where we started
+			if ( m_bInFront[iThis] )
+				checkVisible(pEntity,&iTicks,&bVisible,iIndex);
+
+			setVisible(pEntity,bVisible);
+			m_pBot->setVisible(pEntity,bVisible);
+		}
+
+		if ( iNumOrigins > 0 )
+			m_iCurrentIndex = (iSlot < iNumOrigins) ? m_iOriginIndex[iSlot] : m_iOriginIndex[0];
 	}
 
 
@@ -365,20 +399,92 @@ void CBotVisibles :: updateVisibles ()
 #endif
 }
 
+void CBotVisibles :: updateEntityOrigins ()
+{
+	edict_t *pEntity;
+	Vector vOrigin;
+
+	if ( m_iOriginsFrame == gpGlobals->framecount )
+		return;
+
+	m_iOriginsFrame = gpGlobals->framecount;
+	m_iNumOrigins = 0;
+
+	for ( int i = CBotGlobals::maxClients()+1; (i < gpGlobals->maxEntities) && (i < MAX_EDICTS); i ++ )
+	{
+		pEntity = INDEXENT(i);
+
+		if ( !CBotGlobals::entityIsValid(pEntity) )
+			continue;
+
+		vOrigin = CBotGlobals::entityOrigin(pEntity);
+
+		m_iOriginIndex[m_iNumOrigins] = i;
+		m_fOriginX[m_iNumOrigins] = vOrigin.x;
+		m_fOriginY[m_iNumOrigins] = vOrigin.y;
+		m_fOriginZ[m_iNumOrigins] = vOrigin.z;
+		m_iNumOrigins++;
+	}
+}
+
+// same test as CBot::FInViewCone, four at a time
+void CBotVisibles :: findInFront ( const Vector &vEye, const Vector &vForward )
+{
+	int i = 0;
+
+#ifdef BOT_VISIBLES_SSE
+	const __m128 eyeX = _mm_set1_ps(vEye.x);
+	const __m128 eyeY = _mm_set1_ps(vEye.y);
+	const __m128 eyeZ = _mm_set1_ps(vEye.z);
+	const __m128 fwdX = _mm_set1_ps(vForward.x);
+	const __m128 fwdY = _mm_set1_ps(vForward.y);
+	const __m128 fwdZ = _mm_set1_ps(vForward.z);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+
+	for ( ; (i+4) <= m_iNumOrigins; i += 4 )
+	{
+		__m128 dx = _mm_sub_ps(_mm_loadu_ps(&m_fOriginX[i]),eyeX);
+		__m128 dy = _mm_sub_ps(_mm_loadu_ps(&m_fOriginY[i]),eyeY);
+		__m128 dz = _mm_sub_ps(_mm_loadu_ps(&m_fOriginZ[i]),eyeZ);
+		__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx,fwdX),_mm_mul_ps(dy,fwdY)),_mm_mul_ps(dz,fwdZ));
+		__m128 lengthSqr = _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx,dx),_mm_mul_ps(dy,dy)),_mm_mul_ps(dz,dz));
+		int iMask = _mm_movemask_ps(_mm_and_ps(_mm_cmpgt_ps(dot,zero),_mm_cmpgt_ps(lengthSqr,one)));
+
+		m_bInFront[i] = (iMask & 1) != 0;
+		m_bInFront[i+1] = (iMask & 2) != 0;
+		m_bInFront[i+2] = (iMask & 4) != 0;
+		m_bInFront[i+3] = (iMask & 8) != 0;
+	}
+#endif
+
+	for ( ; i < m_iNumOrigins; i ++ )
+	{
+		float dx = m_fOriginX[i]-vEye.x;
+		float dy = m_fOriginY[i]-vEye.y;
+		float dz = m_fOriginZ[i]-vEye.z;
+
+		m_bInFront[i] = (((dx*vForward.x)+(dy*vForward.y)+(dz*vForward.z)) > 0) && (((dx*dx)+(dy*dy)+(dz*dz)) > 1.0f);
+	}
+}
+
 bool CBotVisibles :: isVisible ( edict_t *pEdict ) 
 { 
-	static int iIndex;
-	static int iByte;
-	static int iBit;
+	return isIndexVisible(ENTINDEX(pEdict)-1);
+}
 
-	iIndex = ENTINDEX(pEdict)-1;
-	iByte = iIndex/8;
-	iBit = iIndex%8;
+bool CBotVisibles :: isIndexVisible ( int iIndex ) 
+{ 
+	int iByte;
+	int iBit;
 
 	if ( iIndex < 0 )
 		return false;
 
-	if ( iByte > m_iMaxSize )
+	iByte = iIndex/8;
+	iBit = iIndex%8;
+
+	if ( iByte >= m_iMaxSize )
 		return false;
 
 	return ( (*(m_iIndicesVisible+iByte))&(1<<iBit))==(1<<iBit);
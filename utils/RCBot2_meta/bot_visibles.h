@@ -100,6 +100,7 @@ public:
 	void updateVisibles ();
 
 	bool isVisible ( edict_t *pEdict );
+	bool isIndexVisible ( int iIndex );
 	void setVisible ( edict_t *pEdict, bool bVisible );
 
 	void eachVisible ( CVisibleFunc *pFunc );
@@ -116,6 +117,19 @@ private:
 	
 	static byte m_bPvs[MAX_MAP_CLUSTERS/8];
 
+	// origins of the non player entities, taken once a frame for every bot
+	static void updateEntityOrigins ();
+	// sets m_bInFront for the entities in front of vEye looking along vForward
+	static void findInFront ( const Vector &vEye, const Vector &vForward );
+
+	static int m_iOriginsFrame;
+	static int m_iNumOrigins;
+	static int m_iOriginIndex[MAX_EDICTS]; // entity index, lowest first
+	static float m_fOriginX[MAX_EDICTS];
+	static float m_fOriginY[MAX_EDICTS];
+	static float m_fOriginZ[MAX_EDICTS];
+	static bool m_bInFront[MAX_EDICTS];
+
 	CBot *m_pBot;
 	// current entity index we are checking
 	int m_iCurrentIndex;
@@ -48,12 +48,21 @@
 #include "bot_waypoint.h"
 #include "bot_waypoint_locations.h"
 #include "bot_waypoint_visibility.h"
+#include "bot_waypoint_influence.h"
+#include "bot_waypoint_areas.h"
+#include "bot_waypoint_connectivity.h"
+#include "bot_waypoint_indirect.h"
+#include "bot_waypoint_autopath.h"
+#include "bot_waypoint_flow.h"
+#include "bot_waypoint_draw.h"
 #include "bot_wpt_color.h"
 #include "bot_profile.h"
 #include "bot_schedule.h"
 #include "bot_getprop.h"
 #include "bot_fortress.h"
 #include "bot_wpt_dist.h"
+#include "bot_persist.h"
+#include "tier0/platform.h"
 
 
 #include <vector>    //bir3yk
@@ -61,7 +70,15 @@
 
 int CWaypoints::m_iNumWaypoints = 0;
 CWaypoint CWaypoints::m_theWaypoints[CWaypoints::MAX_WAYPOINTS];
-float CWaypoints::m_fNextDrawWaypoints = 0;
+CWaypointBits CWaypoints::m_UsedBits;
+CWaypointBits CWaypoints::m_FlagBits[32];
+int CWaypointBits::m_iActiveWords = 0;
+bool CWaypoints::m_bIndexValid = false;
+unsigned int CWaypoints::m_iRevision = 1;
+unsigned int CWaypoints::m_iDrawSerial = 1;
+unsigned int CWaypoints::m_iTeamRevision = 0;
+bool CWaypoints::m_bDeferAreaChanges = false;
+std::vector<int> CWaypoints::m_DeferredAreas;
 int CWaypoints::m_iWaypointTexture = 0;
 CWaypointVisibilityTable * CWaypoints::m_pVisibilityTable = NULL;
 std::vector<CWaypointType*> CWaypointTypes::m_Types;
@@ -97,7 +114,15 @@ void CWaypointNavigator :: init ()
 	m_iPrevWaypoint = -1;
 	m_bWorkingRoute = false;
 
-	Q_memset(m_fBelief,0,sizeof(float)*CWaypoints::MAX_WAYPOINTS);
+	clearRepairRoute();
+	m_iRepairFailGoal = -1;
+	m_iRepairFails = 0;
+	m_bCorridor = false;
+
+	m_fBelief.clear();
+
+	paths.clear();
+	m_OpenedPaths.clear();
 
 	m_iFailedGoals.clear();
 }
@@ -108,7 +133,8 @@ bool CWaypointNavigator :: beliefLoad ( )
    int iDesiredSize;
    register unsigned short int i;
    register unsigned short int num;
-   unsigned short int filebelief [ CWaypoints::MAX_WAYPOINTS ];
+   std::vector<unsigned short int> filebelief;
+   std::vector<unsigned char> pending;
 
     char filename[1024];
 
@@ -121,35 +147,52 @@ bool CWaypointNavigator :: beliefLoad ( )
 
 	CBotGlobals::buildFileName(filename,mapname,BOT_WAYPOINT_FOLDER,"rcb",true);
 
-   FILE *bfp =  CBotGlobals::openFile(filename,"rb");
+   num = (unsigned short int)CWaypoints::numWaypoints();
+   iDesiredSize = num*sizeof(unsigned short int);
 
-   if ( bfp == NULL )
-   {
-	   Msg(" *** Can't open Waypoint belief array for reading!\n");
+   if ( num == 0 )
 	   return false;
-   }
-
-   fseek (bfp, 0, SEEK_END); // seek at end
 
-   iSize = ftell(bfp); // get file size
-   iDesiredSize = CWaypoints::numWaypoints()*sizeof(unsigned short int);
+   filebelief.assign(num,0);
 
-   // size not right, return false to re workout table
-   if ( iSize != iDesiredSize )
+   // another bot's save still on the worker is newer than the file, and
+   // waiting for it would hold up the game
+   if ( CBotPersist::getPending(filename,&pending) )
    {
-	   fclose(bfp);
-	   return false;
+	   if ( (int)pending.size() != iDesiredSize )
+		   return false;
+
+	   memcpy(&filebelief[0],&pending[0],iDesiredSize);
    }
+   else
+   {
+	   FILE *bfp =  CBotGlobals::openFile(filename,"rb");
 
-   fseek (bfp, 0, SEEK_SET); // seek at start
+	   if ( bfp == NULL )
+	   {
+		   Msg(" *** Can't open Waypoint belief array for reading!\n");
+		   return false;
+	   }
 
-   memset(filebelief,0,sizeof(unsigned short int)*CWaypoints::MAX_WAYPOINTS);
+	   fseek (bfp, 0, SEEK_END); // seek at end
 
-   fread(filebelief,sizeof(unsigned short int),CWaypoints::numWaypoints(),bfp);
+	   iSize = ftell(bfp); // get file size
+
+	   // size not right, return false to re workout table
+	   if ( iSize != iDesiredSize )
+	   {
+		   fclose(bfp);
+		   return false;
+	   }
+
+	   fseek (bfp, 0, SEEK_SET); // seek at start
+
+	   fread(&filebelief[0],sizeof(unsigned short int),num,bfp);
+
+	   fclose(bfp);
+   }
 
    // convert from short int to float
-   
-   num = (unsigned short int)CWaypoints::numWaypoints();
 
    // quick loop
    for ( i = 0; i < num; i ++ )
@@ -157,8 +200,6 @@ bool CWaypointNavigator :: beliefLoad ( )
 	   m_fBelief[i] = (((float)filebelief[i])/32767) * MAX_BELIEF;
    }
 
-   fclose(bfp);
-
    return true;
 }
 // update belief array with averaged belief for this team
@@ -168,59 +209,59 @@ bool CWaypointNavigator :: beliefSave ( bool bOverride )
    int iDesiredSize;
    register unsigned short int i;
    register unsigned short int num;
-   unsigned short int filebelief [ CWaypoints::MAX_WAYPOINTS ];
+   std::vector<unsigned short int> filebelief;
+   std::vector<unsigned char> pending;
+   CBotSaveBuffer buffer;
    char filename[1024];
    char mapname[512];
 
    if ( (m_pBot->getTeam() == m_iBeliefTeam) && !bOverride )
 	   return false;
 
-   memset(filebelief,0,sizeof(unsigned short int)*CWaypoints::MAX_WAYPOINTS);
+   num = (unsigned short int)CWaypoints::numWaypoints();
+
+   if ( num == 0 )
+	   return false;
+
+   filebelief.assign(num,0);
 
    // m_iBeliefTeam is the team we've been using -- we might have changed team now
    // so would need to change files if a different team
    // stick to the current team we've been using
    sprintf(mapname,"%s%d",CBotGlobals::getMapName(),m_iBeliefTeam);
    CBotGlobals::buildFileName(filename,mapname,BOT_WAYPOINT_FOLDER,"rcb",true);
+   iDesiredSize = num*sizeof(unsigned short int);
 
-   FILE *bfp = CBotGlobals::openFile(filename,"rb");
-
-   if ( bfp != NULL )
+   // merged with the newest save : one still waiting on the worker (all of a
+   // team's bots save to this file at a map change) or else the file, never
+   // waiting for the worker
+   if ( CBotPersist::getPending(filename,&pending) )
    {
-	   fseek (bfp, 0, SEEK_END); // seek at end
+	   if ( (int)pending.size() == iDesiredSize )
+		   memcpy(&filebelief[0],&pending[0],iDesiredSize);
+   }
+   else
+   {
+	   FILE *bfp = CBotGlobals::openFile(filename,"rb");
 
-	   iSize = ftell(bfp); // get file size
-	   iDesiredSize = CWaypoints::numWaypoints()*sizeof(unsigned short int);
-	    
-	   // size not right, return false to re workout table
-	   if ( iSize != iDesiredSize )
-	   {
-		   fclose(bfp);
-	   }
-	   else
+	   if ( bfp != NULL )
 	   {
-		   fseek (bfp, 0, SEEK_SET); // seek at start
+		   fseek (bfp, 0, SEEK_END); // seek at end
 
-		   if ( bfp )
-				fread(filebelief,sizeof(unsigned short int),CWaypoints::numWaypoints(),bfp);
+		   iSize = ftell(bfp); // get file size
+
+		   // size not right : start again from nothing
+		   if ( iSize == iDesiredSize )
+		   {
+			   fseek (bfp, 0, SEEK_SET); // seek at start
+			   fread(&filebelief[0],sizeof(unsigned short int),num,bfp);
+		   }
 
 		   fclose(bfp);
 	   }
    }
 
-   bfp =  CBotGlobals::openFile(filename,"wb");
-
-   if ( bfp == NULL )
-   {
-	   m_bLoadBelief = true;
-	   m_iBeliefTeam = m_pBot->getTeam();
-	   Msg(" *** Can't open Waypoint Belief array for writing!\n");
-	   return false;
-   }
-
    // convert from short int to float
-   
-   num = (unsigned short int)CWaypoints::numWaypoints();
 
    // quick loop
    for ( i = 0; i < num; i ++ )
@@ -228,11 +269,9 @@ bool CWaypointNavigator :: beliefSave ( bool bOverride )
 	   filebelief[i] = (filebelief[i]/2) + ((unsigned short int)((m_fBelief[i]/MAX_BELIEF) * 16383)); 
    }
 
-   fseek (bfp, 0, SEEK_SET); // seek at start
-
-   fwrite(filebelief,sizeof(unsigned short int),num,bfp);
+   buffer.write(&filebelief[0],sizeof(unsigned short int),num);
 
-   fclose(bfp);
+   CBotPersist::save(filename,buffer);
 
    // new team -- load belief 
     m_iBeliefTeam = m_pBot->getTeam();
@@ -438,11 +477,11 @@ CWaypoint *CWaypointNavigator :: chooseBestFromBeliefBetweenAreas ( std::vector<
 CWaypoint *CWaypointNavigator :: chooseBestFromBelief ( std::vector<CWaypoint*> &goals, bool bHighDanger, int iSearchFlags, int iTeam )
 {
 	CWaypoint *pWpt = NULL;
-	CWaypoint *pCheck;
 
 	float fBelief = 0;
 	float fSelect;
 	float bBeliefFactor = 1.0f;
+	int iWpt;
 
 	// simple checks
 	switch ( goals.size() )
@@ -451,72 +490,28 @@ CWaypoint *CWaypointNavigator :: chooseBestFromBelief ( std::vector<CWaypoint*>
 	case 1:return goals[0];
 	default:
 		{
+			// sentry, sniper and teammate avoidance comes from the influence map
+			std::vector<float> weights(goals.size());
+
 			for (size_t i = 0; i < goals.size(); i ++ )
 			{
-				bBeliefFactor = 1.0f;
-
-				if ( iSearchFlags & WPT_SEARCH_AVOID_SENTRIES )
-				{
-					for ( int j = 1; j <= gpGlobals->maxClients; j ++ )
-					{
-						edict_t *pSentry = CTeamFortress2Mod::getSentryGun(j-1);
-
-						if ( pSentry != NULL )
-						{
-							if ( goals[i]->distanceFrom(CBotGlobals::entityOrigin(pSentry)) < 200.0f )
-							{
-								bBeliefFactor *= 0.1f;
-							}
-						}
-					}
-				}
-
-				if ( iSearchFlags & WPT_SEARCH_AVOID_SNIPERS )
-				{
-					for ( int j = 1; j <= gpGlobals->maxClients; j ++ )
-					{
-						edict_t *pPlayer = INDEXENT(i);
-
-						if ( (pPlayer != NULL) && !pPlayer->IsFree() && (CClassInterface::getTF2Class(pPlayer)==TF_CLASS_SNIPER) )
-						{
-							if ( ( iTeam == 0 ) || ( iTeam == CClassInterface::getTeam(pPlayer) ) )
-							{
-								if ( goals[i]->distanceFrom(CBotGlobals::entityOrigin(pPlayer)) < 200.0f )
-								{
-									bBeliefFactor *= 0.1f;
-								}
-							}
-						}
-					}
-				}
+				iWpt = CWaypoints::getWaypointIndex(goals[i]);
 
-				if ( iSearchFlags & WPT_SEARCH_AVOID_TEAMMATE )
-				{
-					for ( int j = 1; j <= gpGlobals->maxClients; j ++ )
-					{
-						edict_t *pPlayer = INDEXENT(i);
+				bBeliefFactor = 1.0f;
 
-						if ( (pPlayer != NULL) && !pPlayer->IsFree() )
-						{
-							if ( ( iTeam == 0 ) || ( iTeam == CClassInterface::getTeam(pPlayer) ) )
-							{
-								if ( goals[i]->distanceFrom(CBotGlobals::entityOrigin(pPlayer)) < 200.0f )
-								{
-									bBeliefFactor *= 0.1f;
-								}
-							}
-						}
-					}
-				}
+				if ( iSearchFlags )
+					bBeliefFactor = CWaypointInfluence::getGoalFactor(iWpt,iSearchFlags,iTeam);
 
 				if ( bHighDanger )
 				{
-					fBelief += bBeliefFactor * (1.0f + (m_fBelief[CWaypoints::getWaypointIndex(goals[i])]));	
+					weights[i] = bBeliefFactor * (1.0f + (m_fBelief[iWpt]));
 				}
 				else
 				{
-					fBelief += bBeliefFactor * (1.0f + (MAX_BELIEF - (m_fBelief[CWaypoints::getWaypointIndex(goals[i])])));
+					weights[i] = bBeliefFactor * (1.0f + (MAX_BELIEF - (m_fBelief[iWpt])));
 				}
+
+				fBelief += weights[i];
 			}
 
 			fSelect = randomFloat(0,fBelief);
@@ -525,70 +520,11 @@ CWaypoint *CWaypointNavigator :: chooseBestFromBelief ( std::vector<CWaypoint*>
 			
 			for (size_t i = 0; i < goals.size(); i++)
 			{
-				pCheck = goals[i];
-
-				bBeliefFactor = 1.0f;
-
-				if ( iSearchFlags & WPT_SEARCH_AVOID_SENTRIES )
-				{
-					for ( int j = 0; j < MAX_PLAYERS; j ++ )
-					{
-						edict_t *pSentry = CTeamFortress2Mod::getSentryGun(j);
-
-						if ( pSentry != NULL )
-						{
-							if ( goals[i]->distanceFrom(CBotGlobals::entityOrigin(pSentry)) < 200.0f )
-							{
-								bBeliefFactor *= 0.1f;
-							}
-						}
-					}
-				}
-
-				if ( iSearchFlags & WPT_SEARCH_AVOID_SNIPERS )
-				{
-					for ( int j = 1; j <= gpGlobals->maxClients; j ++ )
-					{
-						edict_t *pPlayer = INDEXENT(i);
-
-						if ( (pPlayer != NULL) && !pPlayer->IsFree() && (CClassInterface::getTF2Class(pPlayer)==TF_CLASS_SNIPER) )
-						{
-							if ( goals[i]->distanceFrom(CBotGlobals::entityOrigin(pPlayer)) < 200.0f )
-							{
-								bBeliefFactor *= 0.1f;
-							}
-						}
-					}
-				}
-
-				if ( iSearchFlags & WPT_SEARCH_AVOID_TEAMMATE )
-				{
-					for ( int j = 1; j <= gpGlobals->maxClients; j ++ )
-					{
-						edict_t *pPlayer = INDEXENT(i);
-
-						if ( (pPlayer != NULL) && !pPlayer->IsFree() )
-						{
-							if ( goals[i]->distanceFrom(CBotGlobals::entityOrigin(pPlayer)) < 200.0f )
-							{
-								bBeliefFactor *= 0.1f;
-							}
-						}
-					}
-				}
-
-				if ( bHighDanger )
-				{
-					fBelief += bBeliefFactor * (1.0f + (m_fBelief[CWaypoints::getWaypointIndex(goals[i])]));
-				}
-				else
-				{
-					fBelief += bBeliefFactor * (1.0f + (MAX_BELIEF - (m_fBelief[CWaypoints::getWaypointIndex(goals[i])])));
-				}
+				fBelief += weights[i];
 
 				if ( fSelect <= fBelief )
 				{
-					pWpt = pCheck;
+					pWpt = goals[i];
 					break;
 				}
 			}
@@ -801,11 +737,29 @@ void CWaypointNavigator :: open ( AStarNode *pNode )
 { 
 	if ( !pNode->isOpen() )
 	{
+		m_OpenedPaths.push_back(pNode->getWaypoint());
 		pNode->open();
 		//m_theOpenList.push_back(pNode);
 		m_theOpenList.add(pNode);
 	}
 }
+// AStar Algorithm : forget the last search, only the nodes it opened were changed
+void CWaypointNavigator :: resetPaths ()
+{
+	static const AStarNode empty;
+	unsigned int iNumWaypoints = (unsigned int)CWaypoints::numWaypoints();
+
+	for ( unsigned int i = 0; i < m_OpenedPaths.size(); i ++ )
+	{
+		if ( (unsigned int)m_OpenedPaths[i] < paths.size() )
+			paths[m_OpenedPaths[i]] = empty;
+	}
+
+	m_OpenedPaths.clear();
+
+	if ( paths.size() < iNumWaypoints )
+		paths.resize(iNumWaypoints);
+}
 // AStar Algorithm : get the waypoint with lowest cost
 AStarNode *CWaypointNavigator :: nextNode ()
 {
@@ -838,6 +792,43 @@ void CWaypointNavigator :: failMove ()
 	m_lastFailedPath.iTo = m_iCurrentWaypoint;
 	m_lastFailedPath.bSkipped = false;
 
+	// keep what is left of the route after the waypoint we couldn't reach
+	clearRepairRoute();
+
+	if ( m_iRepairFailGoal == m_iGoalWaypoint )
+		m_iRepairFails++;
+	else
+	{
+		m_iRepairFailGoal = m_iGoalWaypoint;
+		m_iRepairFails = 1;
+	}
+
+	// repairs keep failing on the way to this goal : give up on it
+	if ( rcbot_nav_repair.GetBool() && !m_currentRoute.empty() && (m_iRepairFails <= MAX_ROUTE_REPAIRS) )
+	{
+		std::stack<int> route = m_currentRoute;
+
+		while ( !route.empty() )
+		{
+			m_RepairRoute.push_back(route.top());
+			m_RepairBits.set(route.top());
+			route.pop();
+		}
+
+		m_iRepairGoal = m_iGoalWaypoint;
+		m_fRepairTime = engine->Time() + 10.0f;
+	}
+
+	// the goal is still reachable along the kept route : don't fail it, or
+	// the next search would pick another goal and the route couldn't be reused
+	if ( canRepairRoute() )
+		return;
+
+	clearRepairRoute();
+
+	m_iRepairFailGoal = -1;
+	m_iRepairFails = 0;
+
 	if ( std::find(m_iFailedGoals.begin(), m_iFailedGoals.end(), m_iGoalWaypoint) == m_iFailedGoals.end() )
 	{
 		m_iFailedGoals.push_back(m_iGoalWaypoint);
@@ -845,6 +836,105 @@ void CWaypointNavigator :: failMove ()
 	}
 }
 
+void CWaypointNavigator :: clearRepairRoute ()
+{
+	// only the bits that were set, not the whole set
+	for ( unsigned int i = 0; i < m_RepairRoute.size(); i ++ )
+		m_RepairBits.reset(m_RepairRoute[i]);
+
+	m_RepairRoute.clear();
+	m_iRepairGoal = -1;
+	m_fRepairTime = 0.0f;
+	m_bRepairing = false;
+}
+
+// the kept route can only be rejoined if it still leads to the goal and
+// nothing on it has become dangerous or impassable since
+bool CWaypointNavigator :: canRepairRoute ()
+{
+	CWaypoint *pWpt;
+	CWaypoint *pPrev;
+	WaypointList::iterator it;
+
+	if ( m_RepairRoute.empty() || (m_fRepairTime < engine->Time()) )
+		return false;
+
+	// the goal may have moved to another waypoint further along (or before)
+	// the kept route
+	if ( m_iRepairGoal != m_iGoalWaypoint )
+	{
+		it = std::find(m_RepairRoute.begin(),m_RepairRoute.end(),m_iGoalWaypoint);
+
+		if ( it == m_RepairRoute.end() )
+			return false;
+
+		for ( WaypointList::iterator itBit = it+1; itBit != m_RepairRoute.end(); itBit ++ )
+			m_RepairBits.reset(*itBit);
+
+		m_RepairRoute.erase(it+1,m_RepairRoute.end());
+		m_iRepairGoal = m_iGoalWaypoint;
+	}
+
+	for ( unsigned int i = 0; i < m_RepairRoute.size(); i ++ )
+	{
+		pWpt = CWaypoints::getWaypoint(m_RepairRoute[i]);
+
+		if ( !pWpt->isUsed() || (m_fBelief[m_RepairRoute[i]] > (MAX_BELIEF*0.5f)) )
+			return false;
+
+		// the edge into the first kept waypoint is replaced by the repair search
+		if ( i == 0 )
+			continue;
+
+		pPrev = CWaypoints::getWaypoint(m_RepairRoute[i-1]);
+
+		// doors and other path conditions may have changed, this includes the goal
+		if ( !m_pBot->canGotoWaypoint(pPrev->getOrigin(),pWpt,pPrev) )
+			return false;
+	}
+
+	return true;
+}
+
+// route from the team's flow field if this bot can take all of it
+bool CWaypointNavigator :: followFlowField ()
+{
+	WaypointList route;
+	float fDistance;
+	int iPrev = m_iCurrentWaypoint;
+
+	if ( !CWaypointFlowField::getRoute(m_iCurrentWaypoint,m_iGoalWaypoint,m_pBot->getTeam(),&route,&fDistance) )
+		return false;
+
+	for ( unsigned int i = 0; i < route.size(); i ++ )
+	{
+		CWaypoint *pPrev = CWaypoints::getWaypoint(iPrev);
+		int iWpt = route[i];
+
+		// the field doesn't know about this bot's danger or failed paths
+		if ( m_fBelief[iWpt] > (MAX_BELIEF*0.5f) )
+			return false;
+		if ( m_lastFailedPath.bValid && (m_lastFailedPath.iFrom == iPrev) && (m_lastFailedPath.iTo == iWpt) )
+			return false;
+		if ( (iWpt != m_iGoalWaypoint) && !m_pBot->canGotoWaypoint(pPrev->getOrigin(),CWaypoints::getWaypoint(iWpt),pPrev) )
+			return false;
+
+		iPrev = iWpt;
+	}
+
+	clearRepairRoute();
+	setRoute(route,fDistance);
+
+	CWaypointDistances::setDistance(m_iCurrentWaypoint,m_iGoalWaypoint,fDistance);
+
+	return true;
+}
+
+bool CWaypointNavigator :: isRepairNode ( int iWpt )
+{
+	return m_RepairBits.get(iWpt);
+}
+
 float CWaypointNavigator :: distanceTo ( Vector vOrigin )
 {
 	int iGoal;
@@ -941,8 +1031,67 @@ bool CWaypointNavigator :: workRoute ( Vector vFrom,
 		// reset
 		m_iLastFailedWpt = -1;
 
+		// no paths lead there for this team : don't bother searching
+		if ( rcbot_nav_connectivity.GetBool() && !CWaypointConnectivity::canReach(m_iCurrentWaypoint,m_iGoalWaypoint,m_pBot->getTeam()) )
+		{
+			if ( CClients::clientsDebugging(BOT_DEBUG_NAV) )
+				CClients::clientDebugMsg(BOT_DEBUG_NAV,"goal waypoint can't be reached",m_pBot);
+
+			if ( std::find(m_iFailedGoals.begin(), m_iFailedGoals.end(), m_iGoalWaypoint) == m_iFailedGoals.end() )
+			{
+				m_iFailedGoals.push_back(m_iGoalWaypoint);
+				m_fNextClearFailedGoals = engine->Time() + randomFloat(8.0f,30.0f);
+			}
+
+			*bFail = true;
+			m_bWorkingRoute = false;
+			return true;
+		}
+
+		// objective goals : the team's flow field already knows the way
+		if ( (iDangerId == -1) && !(iConditions & CONDITION_COVERT) && rcbot_nav_flow.GetBool() && followFlowField() )
+		{
+			if ( CClients::clientsDebugging(BOT_DEBUG_NAV) )
+				CClients::clientDebugMsg(BOT_DEBUG_NAV,"following objective flow field",m_pBot);
+
+			m_bWorkingRoute = false;
+			return true;
+		}
+
+		m_bRepairing = canRepairRoute();
+
+		if ( !m_bRepairing )
+			clearRepairRoute();
+		else if ( CClients::clientsDebugging(BOT_DEBUG_NAV) )
+			CClients::clientDebugMsg(BOT_DEBUG_NAV,"repairing previous route",m_pBot);
+
+		// long routes : only search the areas the area graph goes through
+		eAreaCorridor iCorridor = AREA_CORRIDOR_NONE;
+
+		if ( !m_bRepairing && rcbot_nav_areas.GetBool() )
+			iCorridor = CWaypointAreaGraph::getCorridor(m_iCurrentWaypoint,m_iGoalWaypoint,m_pBot->getTeam(),&m_Corridor);
+
+		// no area route for this team : a full search would find nothing either
+		if ( iCorridor == AREA_CORRIDOR_UNREACHABLE )
+		{
+			if ( CClients::clientsDebugging(BOT_DEBUG_NAV) )
+				CClients::clientDebugMsg(BOT_DEBUG_NAV,"no area route to goal waypoint",m_pBot);
+
+			if ( std::find(m_iFailedGoals.begin(), m_iFailedGoals.end(), m_iGoalWaypoint) == m_iFailedGoals.end() )
+			{
+				m_iFailedGoals.push_back(m_iGoalWaypoint);
+				m_fNextClearFailedGoals = engine->Time() + randomFloat(8.0f,30.0f);
+			}
+
+			*bFail = true;
+			m_bWorkingRoute = false;
+			return true;
+		}
+
+		m_bCorridor = (iCorridor == AREA_CORRIDOR_FOUND);
+
 		clearOpenList();
-		Q_memset(paths,0,sizeof(AStarNode)*CWaypoints::MAX_WAYPOINTS);
+		resetPaths();
 
 		AStarNode *curr = &paths[m_iCurrentWaypoint];
 		curr->setWaypoint(m_iCurrentWaypoint);
@@ -993,6 +1142,8 @@ bool CWaypointNavigator :: workRoute ( Vector vFrom,
 	int iLastNode = -1;
 
 	float fBeliefSensitivity = 1.5f;
+	float fThreat;
+	int iTeam = m_pBot->getTeam();
 
 	if ( iConditions & CONDITION_COVERT )
 		fBeliefSensitivity = 2.0f;
@@ -1008,7 +1159,7 @@ bool CWaypointNavigator :: workRoute ( Vector vFrom,
 
 		iCurrentNode = curr->getWaypoint();
 		
-		bFoundGoal = (iCurrentNode == m_iGoalWaypoint);
+		bFoundGoal = (iCurrentNode == m_iGoalWaypoint) || (m_bRepairing && isRepairNode(iCurrentNode));
 
 		if ( bFoundGoal )
 			break;
@@ -1045,6 +1196,13 @@ bool CWaypointNavigator :: workRoute ( Vector vFrom,
 				}
 			}
 
+			if ( m_bCorridor && !m_Corridor.get(iSucc) )
+				continue;
+
+			// added since this search started
+			if ( iSucc >= (int)paths.size() )
+				continue;
+
 			succ = &paths[iSucc];
 			succWpt = CWaypoints::getWaypoint(iSucc);
 #ifndef __linux__
@@ -1118,6 +1276,12 @@ bool CWaypointNavigator :: workRoute ( Vector vFrom,
 			else
 				succ->setCost(fCost+(m_fBelief[iSucc]*(fBeliefSensitivity-m_pBot->getProfile()->m_fBraveness)));	
 
+			// enemy sentry guns and snipers that can see this waypoint
+			fThreat = CWaypointInfluence::getThreat(iSucc,iTeam);
+
+			if ( fThreat > 0 )
+				succ->setCost(succ->getCost()+(fThreat*(fBeliefSensitivity-m_pBot->getProfile()->m_fBraveness)));
+
 			succ->setWaypoint(iSucc);
 
 			if ( !succ->heuristicSet() )		
@@ -1148,6 +1312,23 @@ bool CWaypointNavigator :: workRoute ( Vector vFrom,
 		return false; // not finished yet, wait for next iteration
 	}
 
+	if ( !bFoundGoal && m_bCorridor )
+	{
+		// no way through the corridor for this bot (team only paths etc)
+		// search all waypoints instead
+		m_bCorridor = false;
+
+		clearOpenList();
+		resetPaths();
+
+		curr = &paths[m_iCurrentWaypoint];
+		curr->setWaypoint(m_iCurrentWaypoint);
+		curr->setHeuristic(m_pBot->distanceFrom(vTo));
+		open(curr);
+
+		return false;
+	}
+
 	m_bWorkingRoute = false;
 	
 	clearOpenList(); // finished
@@ -1156,6 +1337,8 @@ bool CWaypointNavigator :: workRoute ( Vector vFrom,
 	{
 		*bFail = true;
 
+		clearRepairRoute();
+
 		//no other path
 		if ( m_lastFailedPath.bSkipped )
 			m_lastFailedPath.bValid = false;
@@ -1183,6 +1366,28 @@ bool CWaypointNavigator :: workRoute ( Vector vFrom,
 	float fDistance = 0.0;
 	int iParent;
 
+	if ( m_bRepairing )
+	{
+		// the search stopped on the kept route : the route from here on is
+		// the kept one, only the way back onto it is new
+		int iRejoin = curr->getWaypoint();
+		int iRepairNode = (int)m_RepairRoute.size()-1;
+
+		while ( (iRepairNode > 0) && (m_RepairRoute[iRepairNode] != iRejoin) )
+		{
+			m_currentRoute.push(m_RepairRoute[iRepairNode]);
+			m_oldRoute.push(m_RepairRoute[iRepairNode]);
+
+			fDistance += (CWaypoints::getWaypoint(m_RepairRoute[iRepairNode])->getOrigin() - CWaypoints::getWaypoint(m_RepairRoute[iRepairNode-1])->getOrigin()).Length();
+
+			iRepairNode--;
+		}
+
+		iCurrentNode = iRejoin;
+
+		clearRepairRoute();
+	}
+
 	while ( (iCurrentNode != -1) && (iCurrentNode != m_iCurrentWaypoint ) && (iLoops <= iNumWaypoints) )
 	{
 		iLoops++;
@@ -1230,6 +1435,52 @@ bool CWaypointNavigator :: workRoute ( Vector vFrom,
 
     return true; 
 }
+bool CWaypointNavigator :: getRoute ( WaypointList *pRoute )
+{
+	std::stack<int> route = m_currentRoute;
+
+	if ( m_bWorkingRoute || route.empty() )
+		return false;
+
+	while ( !route.empty() )
+	{
+		pRoute->push_back(route.top());
+		route.pop();
+	}
+
+	return true;
+}
+
+bool CWaypointNavigator :: setRoute ( const WaypointList &route, float fDistance )
+{
+	if ( route.empty() || (CWaypoints::getWaypoint(route.back()) == NULL) )
+		return false;
+
+	clearOpenList();
+	clearRepairRoute();
+	m_bWorkingRoute = false;
+	m_bCorridor = false;
+
+	while ( !m_oldRoute.empty() )
+		m_oldRoute.pop();
+
+	while ( !m_currentRoute.empty() )
+		m_currentRoute.pop();
+
+	// same order as workRoute builds them, the goal first
+	for ( int i = (int)route.size()-1; i >= 0; i -- )
+	{
+		m_currentRoute.push(route[i]);
+		m_oldRoute.push(route[i]);
+	}
+
+	m_iGoalWaypoint = route.back();
+	m_fGoalDistance = fDistance;
+	m_vGoal = CWaypoints::getWaypoint(m_iGoalWaypoint)->getOrigin();
+
+	return true;
+}
+
 // if bot has a current position to walk to return the boolean
 bool CWaypointNavigator :: hasNextPoint ()
 {
@@ -1716,6 +1967,7 @@ void CWaypoint :: draw ( edict_t *pEdict, bool bDrawPaths, unsigned short int iD
 void CWaypoint :: clearPaths ()
 {
 	m_thePaths.clear();
+	CWaypoints::areaChanged(m_iArea);
 }
 // get the distance from this waypoint from vector position vOrigin
 float CWaypoint :: distanceFrom ( Vector vOrigin )
@@ -1767,14 +2019,9 @@ bool CWaypoints :: save ( bool bVisiblityMade, edict_t *pPlayer, const char *psz
 	char filename[1024];
 	char szAuthorName[32];
 
-	CBotGlobals::buildFileName(filename,CBotGlobals::getMapName(),BOT_WAYPOINT_FOLDER,BOT_WAYPOINT_EXTENSION,true);
-
-	FILE *bfp = CBotGlobals::openFile(filename,"wb");
+	CBotSaveBuffer buffer;
 
-	if ( bfp == NULL )
-	{
-		return false; // give up
-	}
+	CBotGlobals::buildFileName(filename,CBotGlobals::getMapName(),BOT_WAYPOINT_FOLDER,BOT_WAYPOINT_EXTENSION,true);
 
 	int iSize = numWaypoints();
 
@@ -1838,18 +2085,19 @@ bool CWaypoints :: save ( bool bVisiblityMade, edict_t *pPlayer, const char *psz
 	strcpy(header.szMapName,CBotGlobals::getMapName());
 	//////////////////////////////////////////////
 
-	fwrite(&header,sizeof(CWaypointHeader),1,bfp);
-	fwrite(&authorinfo,sizeof(CWaypointAuthorInfo),1,bfp);
+	buffer.write(&header,sizeof(CWaypointHeader),1);
+	buffer.write(&authorinfo,sizeof(CWaypointAuthorInfo),1);
 
 	for ( int i = 0; i < iSize; i ++ )
 	{
 		CWaypoint *pWpt = &m_theWaypoints[i];
 
 		// save individual waypoint and paths
-		pWpt->save(bfp);
+		pWpt->save(&buffer);
 	}
 
-	fclose(bfp);
+	// the worker says when it's written or if it can't be
+	CBotPersist::save(filename,buffer,"waypoints saved",pPlayer);
 
 	//CWaypointDistances::reset();
 
@@ -1863,6 +2111,11 @@ bool CWaypoints :: load (const char *szMapName)
 {
 	char filename[1024];	
 
+	invalidateIndex();
+	CWaypointAreaGraph::reset();
+	CWaypointFlowField::reset();
+	CWaypointConnectivity::reset();
+
 	strcpy(m_szWelcomeMessage,"No waypoints for this map");
 
 	// open explicit map name waypoints
@@ -1871,6 +2124,8 @@ bool CWaypoints :: load (const char *szMapName)
 	else
 		CBotGlobals::buildFileName(filename,szMapName,BOT_WAYPOINT_FOLDER,BOT_WAYPOINT_EXTENSION,true);
 
+	CBotPersist::wait(filename);
+
 	FILE *bfp = CBotGlobals::openFile(filename,"rb");
 
 	if ( bfp == NULL )
@@ -1936,12 +2191,19 @@ bool CWaypoints :: load (const char *szMapName)
 
 	int iSize = header.iNumWaypoints;
 
+	if ( (iSize < 0) || (iSize > MAX_WAYPOINTS) )
+	{
+		CBotGlobals::botMessage(NULL,0,"Error loading waypoints: %d waypoints, this build allows %d",iSize,MAX_WAYPOINTS);
+		fclose(bfp);
+		return false;
+	}
+
 	// ok lets read the waypoints
 	// initialize
 	
 	CWaypoints::init(authorinfo.szAuthor,authorinfo.szModifiedBy);
 
-	m_iNumWaypoints = iSize;
+	setNumWaypoints(iSize);
 
 	bool bWorkVisibility = true;
 
@@ -1971,7 +2233,10 @@ bool CWaypoints :: load (const char *szMapName)
 
 	// if we're loading from another map just do this again!
 	if ( szMapName == NULL )
+	{
 		CWaypointDistances::load();
+		CWaypointIndirectFire::load();
+	}
 
 	// script coupled to waypoints too
 	//CPoints::loadMapScript();
@@ -1998,32 +2263,32 @@ void CWaypoint :: init ()
 	m_fCheckReachableTime = 0;
 }
 
-void CWaypoint :: save ( FILE *bfp )
+void CWaypoint :: save ( CBotSaveBuffer *pBuffer )
 {
-	fwrite(&m_vOrigin,sizeof(Vector),1,bfp);
+	pBuffer->write(&m_vOrigin,sizeof(Vector),1);
 	// aim of vector (used with certain waypoint types)
-	fwrite(&m_iAimYaw,sizeof(int),1,bfp);
-	fwrite(&m_iFlags,sizeof(int),1,bfp);
+	pBuffer->write(&m_iAimYaw,sizeof(int),1);
+	pBuffer->write(&m_iFlags,sizeof(int),1);
 	// not deleted
-	fwrite(&m_bUsed,sizeof(bool),1,bfp);
+	pBuffer->write(&m_bUsed,sizeof(bool),1);
 
 	int iPaths = numPaths();
-	fwrite(&iPaths,sizeof(int),1,bfp);
+	pBuffer->write(&iPaths,sizeof(int),1);
 
 	for ( int n = 0; n < iPaths; n ++ )
 	{			
 		int iPath = getPath(n);
-		fwrite(&iPath,sizeof(int),1,bfp);		
+		pBuffer->write(&iPath,sizeof(int),1);		
 	}
 
 	if ( CWaypoints::WAYPOINT_VERSION >= 2 )
 	{
-		fwrite(&m_iArea,sizeof(int),1,bfp);
+		pBuffer->write(&m_iArea,sizeof(int),1);
 	}
 
 	if ( CWaypoints::WAYPOINT_VERSION >= 3 ) 
 	{
-		fwrite(&m_fRadius,sizeof(float),1,bfp);
+		pBuffer->write(&m_fRadius,sizeof(float),1);
 	}
 }
 
@@ -2071,34 +2336,21 @@ bool CWaypoint :: checkGround ()
 // draw waypoints to this client pClient
 void CWaypoints :: drawWaypoints( CClient *pClient )
 {
-	float fTime = engine->Time();
-	CWaypoint *pWpt;
-	//////////////////////////////////////////
-	// TODO
-	// draw time currently part of CWaypoints
-	// once we can send sprites to individual players
-	// make draw waypoints time part of CClient
-	if ( m_fNextDrawWaypoints > fTime )
-		return;
-
-	m_fNextDrawWaypoints = engine->Time() + 1.0f;
-	/////////////////////////////////////////////////
 	pClient->updateCurrentWaypoint();
 
-	CWaypointLocations::DrawWaypoints(pClient,CWaypointLocations::REACHABLE_RANGE);
-
-	if ( pClient->isPathWaypointOn() )
-	{
-		pWpt = CWaypoints::getWaypoint(pClient->currentWaypoint());
-
-		// valid waypoint
-		if ( pWpt )
-			pWpt->drawPaths(pClient->getPlayer(),pClient->getDrawType());
-	}
+	CWaypointDrawList::draw(pClient);
 }
 
 void CWaypoints :: init (const char *pszAuthor, const char *pszModifiedBy)
 {
+	invalidateIndex();
+	CWaypointInfluence::reset();
+	CWaypointAreaGraph::reset();
+	CWaypointFlowField::reset();
+	CWaypointConnectivity::reset();
+	CWaypointIndirectFire::reset();
+	CWaypointAutoPath::reset();
+
 	if ( pszAuthor != NULL )
 	{
 		strncpy(m_szAuthor,pszAuthor,31);
@@ -2115,15 +2367,18 @@ void CWaypoints :: init (const char *pszAuthor, const char *pszModifiedBy)
 	else
 		m_szModifiedBy[0] = 0;
 
-	m_iNumWaypoints = 0;
-	m_fNextDrawWaypoints = 0;
+	CWaypointDrawList::reset();
 
-	for ( int i = 0; i < MAX_WAYPOINTS; i ++ )
+	// waypoints past m_iNumWaypoints haven't been used since the last init
+	for ( int i = 0; i < m_iNumWaypoints; i ++ )
 		m_theWaypoints[i].init();
 
-	Q_memset(m_theWaypoints,0,sizeof(CWaypoint)*MAX_WAYPOINTS);	
+	Q_memset(m_theWaypoints,0,sizeof(CWaypoint)*m_iNumWaypoints);	
+
+	setNumWaypoints(0);
 
 	CWaypointLocations::Init();
+	drawChanged();
 	CWaypointDistances::reset();
 	m_pVisibilityTable->ClearVisibilityTable();
 }
@@ -2175,6 +2430,7 @@ void CWaypoints :: deleteWaypoint ( int iIndex )
 	Vector vOrigin = m_theWaypoints[iIndex].getOrigin();
 	float fOrigin[3] = { vOrigin.x, vOrigin.y, vOrigin.z };
 	CWaypointLocations::DeleteWptLocation(iIndex,fOrigin);
+	drawChanged();
 
 	// delete any paths pointing to this waypoint
 	deletePathsTo(iIndex);
@@ -2212,10 +2468,257 @@ void CWaypoints :: shiftAreas (int val)
 	}
 }
 
+void CWaypoints :: areaChanged ( int iArea )
+{
+	if ( m_bDeferAreaChanges )
+	{
+		if ( std::find(m_DeferredAreas.begin(),m_DeferredAreas.end(),iArea) == m_DeferredAreas.end() )
+			m_DeferredAreas.push_back(iArea);
+
+		return;
+	}
+
+	m_iRevision++;
+	CWaypointAreaGraph::invalidateArea(iArea);
+	CWaypointFlowField::invalidate();
+}
+
+void CWaypoints :: endAreaChanges ()
+{
+	m_bDeferAreaChanges = false;
+
+	if ( m_DeferredAreas.empty() )
+		return;
+
+	for ( unsigned int i = 0; i < m_DeferredAreas.size(); i ++ )
+		CWaypointAreaGraph::invalidateArea(m_DeferredAreas[i]);
+
+	m_iRevision++;
+	CWaypointFlowField::invalidate();
+
+	m_DeferredAreas.clear();
+}
+
+// rebuilt lazily after waypoints are loaded, added, deleted or have flags changed
+void CWaypoints :: updateIndex ()
+{
+	if ( m_bIndexValid )
+		return;
+
+	m_UsedBits.clear();
+
+	for ( register short int j = 0; j < 32; j ++ )
+		m_FlagBits[j].clear();
+
+	for ( register short int i = 0; i < m_iNumWaypoints; i ++ )
+	{
+		CWaypoint *pWpt = &m_theWaypoints[i];
+		int iFlags;
+
+		if ( !pWpt->isUsed() )
+			continue;
+
+		m_UsedBits.set(i);
+
+		iFlags = pWpt->getFlags();
+
+		while ( iFlags != 0 )
+		{
+			int iBit = CWaypointBits::lowestBit((unsigned int)iFlags);
+
+			m_FlagBits[iBit].set(i);
+			iFlags &= iFlags - 1;
+		}
+	}
+
+	m_bIndexValid = true;
+}
+
+// used waypoints with some (or all) of iFlags, every used waypoint if iFlags is -1
+void CWaypoints :: getFlaggedBits ( CWaypointBits *pBits, int iFlags, bool bAllFlags )
+{
+	updateIndex();
+
+	if ( iFlags == -1 )
+	{
+		*pBits = m_UsedBits;
+		return;
+	}
+
+	if ( bAllFlags )
+		pBits->fill();
+	else
+		pBits->clear();
+
+	for ( unsigned int iBits = (unsigned int)iFlags; iBits != 0; iBits &= iBits - 1 )
+	{
+		if ( bAllFlags )
+			pBits->andWith(m_FlagBits[CWaypointBits::lowestBit(iBits)]);
+		else
+			pBits->orWith(m_FlagBits[CWaypointBits::lowestBit(iBits)]);
+	}
+
+	pBits->andWith(m_UsedBits);
+}
+
+typedef struct
+{
+	double fNearestTotal, fNearestMax;
+	double fRouteTotal, fRouteMax;
+	double fQueryTotal, fQueryMax;
+	int iFound;
+}wpt_bench_t;
+
+static inline void benchmarkTime ( double fStart, double *fTotal, double *fMax )
+{
+	double fTime = Plat_FloatTime() - fStart;
+
+	*fTotal += fTime;
+
+	if ( fTime > *fMax )
+		*fMax = fTime;
+}
+
+// iSearches nearest waypoint lookups, goal queries and route searches between
+// the pairs of waypoints in iFrom and iTo
+static void benchmarkSearches ( CWaypointNavigator *pNav, CBot *pBot, const WaypointList &iFrom, const WaypointList &iTo, wpt_bench_t *pBench )
+{
+	memset(pBench,0,sizeof(wpt_bench_t));
+
+	for ( unsigned int i = 0; i < iFrom.size(); i ++ )
+	{
+		CWaypoint *pFrom = CWaypoints::getWaypoint(iFrom[i]);
+		CWaypoint *pTo = CWaypoints::getWaypoint(iTo[i]);
+		CWaypointBits goals;
+		bool bFail = false;
+		bool bDone;
+		int iLoops = 0;
+		double fStart;
+
+		fStart = Plat_FloatTime();
+		CWaypointLocations::NearestWaypoint(pFrom->getOrigin(),CWaypointLocations::REACHABLE_RANGE,-1,false,false,false,NULL,false,pBot->getTeam());
+		benchmarkTime(fStart,&pBench->fNearestTotal,&pBench->fNearestMax);
+
+		fStart = Plat_FloatTime();
+		CWaypoints::getFlaggedBits(&goals,CWaypointTypes::W_FL_DEFEND|CWaypointTypes::W_FL_SENTRY);
+		benchmarkTime(fStart,&pBench->fQueryTotal,&pBench->fQueryMax);
+
+		fStart = Plat_FloatTime();
+
+		bDone = pNav->workRoute(pFrom->getOrigin(),pTo->getOrigin(),&bFail,true,true,iTo[i]);
+
+		while ( !bDone && (iLoops++ < CWaypoints::numWaypoints()) )
+			bDone = pNav->workRoute(pFrom->getOrigin(),pTo->getOrigin(),&bFail,false,true,iTo[i]);
+
+		benchmarkTime(fStart,&pBench->fRouteTotal,&pBench->fRouteMax);
+
+		if ( bDone && !bFail )
+			pBench->iFound++;
+	}
+}
+
+static void benchmarkPrint ( edict_t *pPrintTo, const char *szWhat, int iCount, int iSearches, const wpt_bench_t *pBench )
+{
+	CBotGlobals::botMessage(pPrintTo,0,"%s %5d : nearest avg %0.3f us max %0.3f us, goal query avg %0.3f us, route %d of %d found avg %0.3f us max %0.3f us",
+		szWhat,iCount,
+		(pBench->fNearestTotal/iSearches)*1000000.0,pBench->fNearestMax*1000000.0,
+		(pBench->fQueryTotal/iSearches)*1000000.0,
+		pBench->iFound,iSearches,(pBench->fRouteTotal/iSearches)*1000000.0,pBench->fRouteMax*1000000.0);
+}
+
+// times nearest waypoint lookups, goal queries and route searches between
+// random used waypoints on a private navigator so the bot's own route is left
+// alone, with the distance cache read only. Two sweeps :
+// - endpoints drawn from the first 64, 128, 256... used waypoints
+// - the same searches with the waypoint bitsets sized for 1024, 2048... up to
+//   RCBOT_MAX_WAYPOINTS waypoints, as a bigger waypoint file would size them,
+//   to show the cost doesn't grow with the waypoint limit
+void CWaypoints :: benchmark ( CBot *pBot, edict_t *pPrintTo, int iSearches )
+{
+	CWaypointBits used;
+	WaypointList candidates;
+	WaypointList iFrom, iTo;
+	CWaypointNavigator *pNav;
+	wpt_bench_t bench;
+	int iCount;
+	int i;
+
+	getFlaggedBits(&used,-1);
+
+	for ( i = used.next(0); i != -1; i = used.next(i+1) )
+		candidates.push_back(i);
+
+	if ( (candidates.size() < 2) || (iSearches <= 0) )
+	{
+		CBotGlobals::botMessage(pPrintTo,0,"need at least two waypoints to benchmark");
+		return;
+	}
+
+	pNav = new CWaypointNavigator(pBot);
+	CWaypointDistances::setReadOnly(true);
+
+	CBotGlobals::botMessage(pPrintTo,0,"%d waypoints (%d used), this build allows %d",m_iNumWaypoints,(int)candidates.size(),MAX_WAYPOINTS);
+
+	iCount = 64;
+
+	while ( true )
+	{
+		if ( iCount > (int)candidates.size() )
+			iCount = (int)candidates.size();
+
+		iFrom.clear();
+		iTo.clear();
+
+		for ( i = 0; i < iSearches; i ++ )
+		{
+			iFrom.push_back(candidates[randomInt(0,iCount-1)]);
+			iTo.push_back(candidates[randomInt(0,iCount-1)]);
+		}
+
+		benchmarkSearches(pNav,pBot,iFrom,iTo,&bench);
+		benchmarkPrint(pPrintTo,"endpoints from",iCount,iSearches,&bench);
+
+		if ( iCount == (int)candidates.size() )
+			break;
+
+		iCount *= 2;
+	}
+
+	// iFrom and iTo now hold searches across every used waypoint
+	for ( iCount = 1024; iCount < m_iNumWaypoints; iCount *= 2 )
+		;
+
+	while ( true )
+	{
+		if ( iCount > MAX_WAYPOINTS )
+			iCount = MAX_WAYPOINTS;
+
+		CWaypointBits::setActive(iCount);
+
+		benchmarkSearches(pNav,pBot,iFrom,iTo,&bench);
+		benchmarkPrint(pPrintTo,"capacity",iCount,iSearches,&bench);
+
+		if ( iCount == MAX_WAYPOINTS )
+			break;
+
+		iCount *= 2;
+	}
+
+	CWaypointBits::setActive(m_iNumWaypoints);
+
+	CWaypointDistances::setReadOnly(false);
+
+	// never freeMapMemory() here, that would save this navigator's belief
+	delete pNav;
+
+	CBotGlobals::botMessage(pPrintTo,0,"visibility : %u pairs in %u KB, distance cache : %u pairs",
+		m_pVisibilityTable->numVisiblePairs(),m_pVisibilityTable->memoryUsed()/1024,CWaypointDistances::numPairs());
+}
+
 int CWaypoints :: getClosestFlagged ( int iFlags, Vector &vOrigin, int iTeam, float *fReturnDist, unsigned char *failedwpts )
 {
 	int i = 0;
-	int size = numWaypoints();
+	CWaypointBits goals;
 
 	float fDist = 8192.0;
 	float distance;
@@ -2225,7 +2728,9 @@ int CWaypoints :: getClosestFlagged ( int iFlags, Vector &vOrigin, int iTeam, fl
 	CWaypoint *pWpt;
 	CBotMod *pCurrentMod = CBotGlobals::getCurrentMod();
 
-	for ( i = 0; i < size; i ++ )
+	getFlaggedBits(&goals,iFlags,true);
+
+	for ( i = goals.next(0); i != -1; i = goals.next(i+1) )
 	{
 		pWpt = &m_theWaypoints[i];
 
@@ -2235,24 +2740,21 @@ int CWaypoints :: getClosestFlagged ( int iFlags, Vector &vOrigin, int iTeam, fl
 		if ( failedwpts[i] == 1 )
 			continue;
 
-		if ( pWpt->isUsed() && pWpt->forTeam(iTeam) )
+		if ( pWpt->forTeam(iTeam) )
 		{
-			if ( pWpt->hasFlag(iFlags) )
-			{
-				// BUG FIX for DOD:S 
-				if (!pCurrentMod->isWaypointAreaValid(pWpt->getArea(), iFlags)) // CTeamFortress2Mod::m_ObjectiveResource.isWaypointAreaValid(pWpt->getArea()) )
-					continue;
+			// BUG FIX for DOD:S 
+			if (!pCurrentMod->isWaypointAreaValid(pWpt->getArea(), iFlags)) // CTeamFortress2Mod::m_ObjectiveResource.isWaypointAreaValid(pWpt->getArea()) )
+				continue;
 
-				if ( (iFrom == -1) )
-					distance = (pWpt->getOrigin()-vOrigin).Length();
-				else
-					distance = CWaypointDistances::getDistance(iFrom,i);
+			if ( (iFrom == -1) )
+				distance = (pWpt->getOrigin()-vOrigin).Length();
+			else
+				distance = CWaypointDistances::getDistance(iFrom,i);
 
-				if ( distance < fDist)
-				{
-					fDist = distance;
-					iwpt = i;
-				}
+			if ( distance < fDist)
+			{
+				fDist = distance;
+				iwpt = i;
 			}
 		}
 	}
@@ -2444,22 +2946,25 @@ int CWaypoints :: addWaypoint ( edict_t *pPlayer, Vector vOrigin, int iFlags, bo
 
 	///////////////////////////////////////////////////
 	m_theWaypoints[iIndex] = CWaypoint(vOrigin,iFlags);	
+	invalidateIndex();
 	m_theWaypoints[iIndex].setAim(iYaw);
 	m_theWaypoints[iIndex].setArea(iArea);
 	m_theWaypoints[iIndex].setRadius(fRadius);
 	// increase max waypoints used
 	if ( iIndex == m_iNumWaypoints )
-		m_iNumWaypoints++;	
+		setNumWaypoints(m_iNumWaypoints+1);
 	///////////////////////////////////////////////////
 
 	float fOrigin[3] = {vOrigin.x,vOrigin.y,vOrigin.z};
 
 	CWaypointLocations::AddWptLocation(iIndex,fOrigin);
+	// in the location grid now, the draw lists can find it
+	drawChanged();
 	m_pVisibilityTable->workVisibilityForWaypoint(iIndex,true);
 
 	if ( bAutoPath && !(iFlags & CWaypointTypes::W_FL_UNREACHABLE) )
 	{
-		CWaypointLocations::AutoPath(pPlayer,iIndex);
+		CWaypointAutoPath::add(pPlayer,iIndex);
 	}
 
 	return iIndex;
@@ -2476,38 +2981,41 @@ int CWaypoints :: numWaypoints ()
 	return m_iNumWaypoints;
 }
 
+void CWaypoints :: setNumWaypoints ( int iNum )
+{
+	m_iNumWaypoints = iNum;
+	CWaypointBits::setActive(iNum);
+}
+
 ///////////
 
 int CWaypoints :: nearestWaypointGoal ( int iFlags, Vector &origin, float fDist, int iTeam )
 {
 	register short int i;
-	static int size;
+	CWaypointBits goals;
 
 	float distance;
 	int iwpt = -1;
 
 	CWaypoint *pWpt;
 
-	size = numWaypoints();
-
 	CBotMod *pCurrentMod = CBotGlobals::getCurrentMod();
 
-	for ( i = 0; i < size; i ++ )
+	getFlaggedBits(&goals,iFlags,true);
+
+	for ( i = goals.next(0); i != -1; i = goals.next(i+1) )
 	{
 		pWpt = &m_theWaypoints[i];
 
-		if ( pWpt->isUsed() && pWpt->forTeam(iTeam) )
+		if ( pWpt->forTeam(iTeam) )
 		{
-			if ( (iFlags == -1) || pWpt->hasFlag(iFlags) )
+			// FIX DODS bug
+			if (pCurrentMod->isWaypointAreaValid(pWpt->getArea(), iFlags)) // CTeamFortress2Mod::m_ObjectiveResource.isWaypointAreaValid(pWpt->getArea()))
 			{
-				// FIX DODS bug
-				if (pCurrentMod->isWaypointAreaValid(pWpt->getArea(), iFlags)) // CTeamFortress2Mod::m_ObjectiveResource.isWaypointAreaValid(pWpt->getArea()))
+				if ( (distance = pWpt->distanceFrom(origin)) < fDist)
 				{
-					if ( (distance = pWpt->distanceFrom(origin)) < fDist)
-					{
-						fDist = distance;
-						iwpt = i;
-					}
+					fDist = distance;
+					iwpt = i;
 				}
 			}
 		}
@@ -2519,48 +3027,45 @@ int CWaypoints :: nearestWaypointGoal ( int iFlags, Vector &origin, float fDist,
 CWaypoint *CWaypoints :: randomRouteWaypoint ( CBot *pBot, Vector vOrigin, Vector vGoal, int iTeam, int iArea )
 {
 	register short int i;
-	static short int size;
 	static CWaypointNavigator *pNav;
 	
 	pNav = (CWaypointNavigator*)pBot->getNavigator();
 
-	size = numWaypoints();
-
 	std::vector<CWaypoint*> goals;
+	CWaypointBits routes;
+
+	getFlaggedBits(&routes,CWaypointTypes::W_FL_ROUTE,true);
 
-	for ( i = 0; i < size; i ++ )
+	for ( i = routes.next(0); i != -1; i = routes.next(i+1) )
 	{
 		CWaypoint *pWpt = &m_theWaypoints[i];
 
-		if ( pWpt->isUsed() && pWpt->forTeam(iTeam) )// && (pWpt->getArea() == iArea) )
+		if ( pWpt->forTeam(iTeam) )// && (pWpt->getArea() == iArea) )
 		{
-			if ( pWpt->hasFlag(CWaypointTypes::W_FL_ROUTE) )
-			{
-			    if ((pWpt->getArea() != iArea) )
-					continue;
+		    if ((pWpt->getArea() != iArea) )
+				continue;
 
-				// CHECK THAT ROUTE WAYPOINT IS USEFUL...
+			// CHECK THAT ROUTE WAYPOINT IS USEFUL...
 
-				Vector vRoute = pWpt->getOrigin();
+			Vector vRoute = pWpt->getOrigin();
 
-				if ( (vRoute - vOrigin).Length() < ((vGoal - vOrigin).Length()+128.0f) )
-				{
-				//if ( CWaypointDistances::getDistance() )
-					/*Vector vecLOS;
-					float flDot;
-					Vector vForward;
-					// in fov? Check angle to edict
-					vForward = vGoal - vOrigin;
-					vForward = vForward/vForward.Length(); // normalise
+			if ( (vRoute - vOrigin).Length() < ((vGoal - vOrigin).Length()+128.0f) )
+			{
+			//if ( CWaypointDistances::getDistance() )
+				/*Vector vecLOS;
+				float flDot;
+				Vector vForward;
+				// in fov? Check angle to edict
+				vForward = vGoal - vOrigin;
+				vForward = vForward/vForward.Length(); // normalise
 
-					vecLOS = vRoute - vOrigin;
-					vecLOS = vecLOS/vecLOS.Length(); // normalise
+				vecLOS = vRoute - vOrigin;
+				vecLOS = vecLOS/vecLOS.Length(); // normalise
 
-					flDot = DotProduct (vecLOS , vForward );
+				flDot = DotProduct (vecLOS , vForward );
 
-					if ( flDot > 0.17f ) // 80 degrees*/
-					goals.push_back(pWpt);
-				}
+				if ( flDot > 0.17f ) // 80 degrees*/
+				goals.push_back(pWpt);
 			}
 		}
 	}
@@ -2634,6 +3139,18 @@ CWaypoint *CWaypoints :: nearestPipeWaypoint ( Vector vTarget, Vector vOrigin, i
 	if ( pTarget == NULL )
 		return NULL;
 
+	// worked out already
+	if ( CWaypointIndirectFire::isReady() )
+	{
+		int iLaunch;
+		float fLift;
+
+		if ( CWaypointIndirectFire::getSpot(iTarget,INDIRECT_PIPE,NULL,vOrigin,&iLaunch,iAiming,&fLift) )
+			return CWaypoints::getWaypoint(iLaunch);
+
+		return NULL;
+	}
+
 	CWaypointVisibilityTable *pTable = CWaypoints::getVisiblity();	
 
 	register short int numwaypoints = (short int)numWaypoints();
@@ -2732,12 +3249,10 @@ void CWaypoints :: checkAreas ( edict_t *pActivator )
 CWaypoint *CWaypoints :: randomWaypointGoalNearestArea ( int iFlags, int iTeam, int iArea, bool bForceArea, CBot *pBot, bool bHighDanger, Vector *origin, int iIgnore, bool bIgnoreBelief, int iWpt1 )
 {
 	register short int i;
-	static short int size; 
+	CWaypointBits candidates;
 	CWaypoint *pWpt;
 	AStarNode *node;
 	float fDist;
-	
-	size = numWaypoints();
 
 	// TODO inline AStarNode entries
 	std::vector<AStarNode*> goals;
@@ -2747,42 +3262,41 @@ CWaypoint *CWaypoints :: randomWaypointGoalNearestArea ( int iFlags, int iTeam,
 	if ( iWpt1 == -1 )
 	   iWpt1 = CWaypointLocations::NearestWaypoint(*origin,200,-1);
 
-	for ( i = 0; i < size; i ++ )
+	getFlaggedBits(&candidates,iFlags);
+
+	for ( i = candidates.next(0); i != -1; i = candidates.next(i+1) )
 	{
 		if ( i == iIgnore )
 			continue;
 
 		pWpt = &m_theWaypoints[i];
 
-		if ( pWpt->isUsed() && pWpt->forTeam(iTeam) )// && (pWpt->getArea() == iArea) )
+		if ( pWpt->forTeam(iTeam) )// && (pWpt->getArea() == iArea) )
 		{
-			if ( (iFlags == -1) || pWpt->hasSomeFlags(iFlags) )
-			{
-				//DOD:S Bug
-				if (!bForceArea && !pCurrentMod->isWaypointAreaValid(pWpt->getArea(), iFlags))
-					continue;
-				else if ( bForceArea && (pWpt->getArea() != iArea) )
-					continue;
+			//DOD:S Bug
+			if (!bForceArea && !pCurrentMod->isWaypointAreaValid(pWpt->getArea(), iFlags))
+				continue;
+			else if ( bForceArea && (pWpt->getArea() != iArea) )
+				continue;
 
-				node = new AStarNode();
+			node = new AStarNode();
 
-				if ( iWpt1 != -1 )
-				{
-					fDist = CWaypointDistances::getDistance(iWpt1,i);					
-				}
-				else 
-				{
-					fDist = pWpt->distanceFrom(*origin);
-				}
-				
-				if ( fDist == 0.0f )
-					fDist = 0.1f;
-
-				node->setWaypoint(i);
-				node->setHeuristic(131072.0f/(fDist*fDist));
-			
-				goals.push_back(node);
+			if ( iWpt1 != -1 )
+			{
+				fDist = CWaypointDistances::getDistance(iWpt1,i);					
+			}
+			else 
+			{
+				fDist = pWpt->distanceFrom(*origin);
 			}
+			
+			if ( fDist == 0.0f )
+				fDist = 0.1f;
+
+			node->setWaypoint(i);
+			node->setHeuristic(131072.0f/(fDist*fDist));
+		
+			goals.push_back(node);
 		}
 	}
 
@@ -2816,7 +3330,7 @@ CWaypoint *CWaypoints :: randomWaypointGoalNearestArea ( int iFlags, int iTeam,
 CWaypoint *CWaypoints :: randomWaypointGoalBetweenArea ( int iFlags, int iTeam, int iArea, bool bForceArea, CBot *pBot, bool bHighDanger, Vector *org1, Vector *org2, bool bIgnoreBelief, int iWpt1, int iWpt2 )
 {
 	register short int i;
-	static short int size; 
+	CWaypointBits candidates;
 	CWaypoint *pWpt;
 	AStarNode *node;
 	float fCost = 0;
@@ -2826,45 +3340,42 @@ CWaypoint *CWaypoints :: randomWaypointGoalBetweenArea ( int iFlags, int iTeam,
 	if ( iWpt2 == -1 )
 		iWpt2 = CWaypointLocations::NearestWaypoint(*org2,200,-1);
 
-	size = numWaypoints();
-
 	// TODO inline AStarNode instead of doing manual `new`s
 	std::vector<AStarNode*> goals;
 
-	for ( i = 0; i < size; i ++ )
+	getFlaggedBits(&candidates,iFlags);
+
+	for ( i = candidates.next(0); i != -1; i = candidates.next(i+1) )
 	{
 		pWpt = &m_theWaypoints[i];
 
-		if ( pWpt->isUsed() && pWpt->forTeam(iTeam) )// && (pWpt->getArea() == iArea) )
+		if ( pWpt->forTeam(iTeam) )// && (pWpt->getArea() == iArea) )
 		{
-			if ( (iFlags == -1) || pWpt->hasSomeFlags(iFlags) )
-			{
 
-				if ( !bForceArea && !CTeamFortress2Mod::m_ObjectiveResource.isWaypointAreaValid(pWpt->getArea()) )
-					continue;
-				else if ( bForceArea && (pWpt->getArea() != iArea) )
-					continue;
+			if ( !bForceArea && !CTeamFortress2Mod::m_ObjectiveResource.isWaypointAreaValid(pWpt->getArea()) )
+				continue;
+			else if ( bForceArea && (pWpt->getArea() != iArea) )
+				continue;
 
-				fCost = 0;
+			fCost = 0;
 
-				node = new AStarNode();
+			node = new AStarNode();
 
-				node->setWaypoint(i);
+			node->setWaypoint(i);
 
-				if ( iWpt1 != -1 )
-					fCost = 131072.0f/CWaypointDistances::getDistance(iWpt1,i);
-				else
-					fCost = 131072.0f/pWpt->distanceFrom(*org1);
+			if ( iWpt1 != -1 )
+				fCost = 131072.0f/CWaypointDistances::getDistance(iWpt1,i);
+			else
+				fCost = 131072.0f/pWpt->distanceFrom(*org1);
 
-				if ( iWpt2 != -1 )
-					fCost +=  131072.0f/CWaypointDistances::getDistance(iWpt2,i);
-				else
-					fCost += 131072.0f/pWpt->distanceFrom(*org2);
+			if ( iWpt2 != -1 )
+				fCost +=  131072.0f/CWaypointDistances::getDistance(iWpt2,i);
+			else
+				fCost += 131072.0f/pWpt->distanceFrom(*org2);
 
-				node->setHeuristic(fCost);
-			
-				goals.push_back(node);
-			}
+			node->setHeuristic(fCost);
+		
+			goals.push_back(node);
 		}
 	}
 
@@ -2898,33 +3409,30 @@ CWaypoint *CWaypoints :: randomWaypointGoalBetweenArea ( int iFlags, int iTeam,
 CWaypoint *CWaypoints :: randomWaypointGoal ( int iFlags, int iTeam, int iArea, bool bForceArea, CBot *pBot, bool bHighDanger, int iSearchFlags, int iIgnore )
 {
 	register short int i;
-	static short int size; 
+	CWaypointBits candidates;
 	CWaypoint *pWpt;
 
-	size = numWaypoints();
-
 	std::vector<CWaypoint*> goals;
 
 	CBotMod *pCurrentMod = CBotGlobals::getCurrentMod();
 
-	for ( i = 0; i < size; i ++ )
+	getFlaggedBits(&candidates,iFlags);
+
+	for ( i = candidates.next(0); i != -1; i = candidates.next(i+1) )
 	{
 		if ( iIgnore == i )
 			continue;
 
 		pWpt = &m_theWaypoints[i];
 
-		if ( pWpt->isUsed() && pWpt->forTeam(iTeam) )// && (pWpt->getArea() == iArea) )
+		if ( pWpt->forTeam(iTeam) )// && (pWpt->getArea() == iArea) )
 		{
-			if ( (iFlags == -1) || pWpt->hasSomeFlags(iFlags) )
-			{
-				if (!bForceArea && !pCurrentMod->isWaypointAreaValid(pWpt->getArea(), iFlags))
-					continue;
-				else if ( bForceArea && (pWpt->getArea() != iArea) )
-					continue;
+			if (!bForceArea && !pCurrentMod->isWaypointAreaValid(pWpt->getArea(), iFlags))
+				continue;
+			else if ( bForceArea && (pWpt->getArea() != iArea) )
+				continue;
 
-				goals.push_back(pWpt);
-			}
+			goals.push_back(pWpt);
 		}
 	}
 
@@ -2938,7 +3446,7 @@ CWaypoint *CWaypoints :: randomWaypointGoal ( int iFlags, int iTeam, int iArea,
 
 			pNav = (CWaypointNavigator*)pBot->getNavigator();
 
-			pWpt = pNav->chooseBestFromBelief(goals, bHighDanger, iSearchFlags);
+			pWpt = pNav->chooseBestFromBelief(goals, bHighDanger, iSearchFlags, iTeam);
 		}
 		else
 			pWpt = goals[ randomInt(0, goals.size() - 1) ];
@@ -2956,12 +3464,15 @@ int CWaypoints :: randomFlaggedWaypoint (int iTeam)
 // get the next free slot to save a waypoint to
 int CWaypoints :: freeWaypointIndex ()
 {
-	for ( int i = 0; i < MAX_WAYPOINTS; i ++ )
+	for ( int i = 0; i < m_iNumWaypoints; i ++ )
 	{
 		if ( !m_theWaypoints[i].isUsed() )
 			return i;
 	}
 
+	if ( m_iNumWaypoints < MAX_WAYPOINTS )
+		return m_iNumWaypoints;
+
 	return -1;
 }
 
@@ -3076,6 +3587,9 @@ bool CWaypoint :: addPathTo ( int iWaypointIndex )
 	m_thePaths.push_back(iWaypointIndex);
 	pTo->addPathFrom(CWaypoints::getWaypointIndex(this));
 
+	CWaypoints::areaChanged(m_iArea);
+	CWaypoints::areaChanged(pTo->getArea());
+
 	return true;
 }
 
@@ -3095,6 +3609,9 @@ void CWaypoint :: removePathTo ( int iWaypointIndex )
 	{
 		m_thePaths.erase(std::remove(m_thePaths.begin(), m_thePaths.end(), iWaypointIndex), m_thePaths.end());
 		pOther->removePathFrom(CWaypoints::getWaypointIndex(this));
+
+		CWaypoints::areaChanged(m_iArea);
+		CWaypoints::areaChanged(pOther->getArea());
 	}
 
 	return;
@@ -3375,7 +3892,7 @@ void CWaypointTest :: go ( edict_t *pPlayer )
 
 		pNav = pBot->getNavigator();
 
-		for ( i = 0; i < CWaypoints::MAX_WAYPOINTS; i ++ )
+		for ( i = 0; i < CWaypoints::numWaypoints(); i ++ )
 		{
 			pWpt1 = CWaypoints::getWaypoint(i);
 			
@@ -3396,7 +3913,7 @@ void CWaypointTest :: go ( edict_t *pPlayer )
 			
 			if ( iCheck != 0 )
 			{
-				for ( j = 0; j < CWaypoints::MAX_WAYPOINTS; j ++ )
+				for ( j = 0; j < CWaypoints::numWaypoints(); j ++ )
 				{
 
 					if ( i == j )
@@ -37,6 +37,15 @@
 #include <vector>
 using WaypointList = std::vector<int>;
 
+#ifdef _MSC_VER
+#include <intrin.h> // _BitScanForward
+#endif
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 1))
+#define WAYPOINT_BITS_SSE
+#include <xmmintrin.h>
+#endif
+
 #include "bot.h"
 #include "bot_client.h"
 #include "bot_wpt_color.h"
@@ -44,8 +53,19 @@ using WaypointList = std::vector<int>;
 
 //#include "bot_navigator.h"
 
+// most waypoints a map can have. Only the waypoints in use are searched and
+// per bot search state, visibility and distances grow with those, so raising
+// this costs memory for the waypoint array only. Indices must fit a short int
+#ifndef RCBOT_MAX_WAYPOINTS
+#define RCBOT_MAX_WAYPOINTS 16384
+#endif
+
+static_assert(RCBOT_MAX_WAYPOINTS <= 32767, "waypoint indices must fit a short int");
+
 class CWaypointVisibilityTable;
 class CClient;
+class CBotSaveBuffer;
+class CWaypointBits;
 
 
 class CWaypointAuthorInfo
@@ -252,10 +272,8 @@ public:
 
 	bool checkGround ();
 
-	inline void setAim ( int iYaw )
-	{
-		m_iAimYaw = iYaw;
-	}
+	// aim, radius and origin changes are redrawn to editors straight away
+	inline void setAim ( int iYaw );
 
 	inline float getAimYaw ()
 	{
@@ -269,21 +287,13 @@ public:
 
 	void init ();
 
-	inline void addFlag ( int iFlag )
-	{
-		m_iFlags |= iFlag;
-	}
+	// flag and used changes keep the CWaypoints goal index up to date
+	inline void addFlag ( int iFlag );
 
-	inline void removeFlag ( int iFlag )
-	{
-		m_iFlags &= ~iFlag;
-	}
+	inline void removeFlag ( int iFlag );
 
 	// removes all waypoint flags
-	inline void removeFlags ()
-	{
-		m_iFlags = 0;
-	}
+	inline void removeFlags ();
 
 	inline bool hasFlag ( int iFlag )
 	{
@@ -295,11 +305,7 @@ public:
 		return (m_iFlags & iFlag) > 0;
 	}
 
-	inline void move ( Vector origin )
-	{
-		// move to new origin
-		m_vOrigin = origin;
-	}
+	inline void move ( Vector origin );
 
 	void checkAreas ( edict_t *pActivator );
 
@@ -337,13 +343,13 @@ public:
 	}
 
 	inline int getArea () { return m_iArea; }
-	inline void setArea (int area) { m_iArea = area; }
+	inline void setArea ( int area );
 
 	void drawPaths ( edict_t *pEdict, unsigned short int iDrawType );
 
 	void drawPathBeam ( CWaypoint *to, unsigned short int iDrawType );
 
-	inline void setUsed ( bool bUsed ){	m_bUsed = bUsed;}
+	inline void setUsed ( bool bUsed );
 
 	inline void clearPaths ();
 
@@ -363,7 +369,7 @@ public:
 
 	void load ( FILE *bfp, int iVersion );
 
-	void save ( FILE *bfp );
+	void save ( CBotSaveBuffer *pBuffer );
 
 	inline int getFlags (){return m_iFlags;}
 
@@ -371,7 +377,7 @@ public:
 
 	inline float getRadius () { return m_fRadius; }
 
-	inline void setRadius ( float fRad ) { m_fRadius = fRad; }
+	inline void setRadius ( float fRad );
 
 	Vector applyRadius ();
 
@@ -402,7 +408,7 @@ private:
 class CWaypoints
 {
 public:
-	static const int MAX_WAYPOINTS = 1024;
+	static const int MAX_WAYPOINTS = RCBOT_MAX_WAYPOINTS;
 	static const int WAYPOINT_VERSION = 4; // waypoint version 4 add author information
 
 	static const int W_FILE_FL_VISIBILITY = 1;
@@ -454,7 +460,7 @@ public:
 
 	static CWaypoint *getNextCoverPoint ( CBot *pBot, CWaypoint *pCurrent, CWaypoint *pBlocking );
 
-	// save waypoints
+	// save waypoints, the file is written on the save worker which tells pPlayer once it is
 	static bool save ( bool bVisiblityMade, edict_t *pPlayer = NULL, const char *pszAuthor = NULL, const char *pszModifier = NULL );
 	// load waypoints
 	static bool load (const char *szMapName = NULL);
@@ -492,10 +498,44 @@ public:
 	static bool isModified () { return (m_szModifiedBy[0]!=0); }
 	static const char *getModifier() { return m_szModifiedBy; }
 	static const char *getWelcomeMessage () { return m_szWelcomeMessage; }
+
+	// goal query index : a bitset of used waypoints per waypoint flag
+	static inline void invalidateIndex () { m_bIndexValid = false; m_iRevision++; m_iDrawSerial++; }
+	// paths or waypoints in iArea changed, for the area graph
+	static void areaChanged ( int iArea );
+	// collect areaChanged() calls until endAreaChanges(), which bumps the
+	// revision once for everything changed in between
+	static inline void beginAreaChanges () { m_bDeferAreaChanges = true; }
+	static void endAreaChanges ();
+	// which waypoints a team can use changed without any waypoint changing (e.g. round over)
+	static inline void teamFiltersChanged () { m_iTeamRevision++; }
+	// changes whenever waypoints, flags or paths change
+	static inline unsigned int revision () { return m_iRevision; }
+	static inline unsigned int teamRevision () { return m_iTeamRevision; }
+	// what editors are drawn changed : waypoints added, deleted, moved, or their
+	// flags, aim or radius. Kept apart from revision() so drawing doesn't
+	// depend on which changes the route caches care about
+	static inline void drawChanged () { m_iDrawSerial++; }
+	static inline unsigned int drawSerial () { return m_iDrawSerial; }
+	static void getFlaggedBits ( CWaypointBits *pBits, int iFlags, bool bAllFlags = false );
+
+	// times nearest waypoint, goal query and route searches on a private navigator
+	// for pBot at growing waypoint counts and waypoint capacities
+	static void benchmark ( CBot *pBot, edict_t *pPrintTo, int iSearches );
 private:
+	static void setNumWaypoints ( int iNum );
+	static void updateIndex ();
+
 	static CWaypoint m_theWaypoints[MAX_WAYPOINTS];	
 	static int m_iNumWaypoints;
-	static float m_fNextDrawWaypoints;
+	static CWaypointBits m_UsedBits;
+	static CWaypointBits m_FlagBits[32];
+	static bool m_bIndexValid;
+	static unsigned int m_iRevision;
+	static unsigned int m_iTeamRevision;
+	static unsigned int m_iDrawSerial;
+	static bool m_bDeferAreaChanges;
+	static std::vector<int> m_DeferredAreas;
 	static int m_iWaypointTexture;
 	static CWaypointVisibilityTable *m_pVisibilityTable;
 	static char m_szAuthor[32];
@@ -503,5 +543,205 @@ private:
 	static char m_szWelcomeMessage[128];
 };
 
+// one bit per waypoint index, same bit order as a row of the visibility table
+// set operations and iteration only cover the words holding waypoints in use
+class CWaypointBits
+{
+public:
+	// whole 128 bit blocks
+	static const int NUM_WORDS = ((CWaypoints::MAX_WAYPOINTS+127)/128)*4;
+
+	// called by CWaypoints when the number of waypoints in use changes
+	static inline void setActive ( int iNumWaypoints )
+	{
+		m_iActiveWords = ((iNumWaypoints+127)/128)*4;
+
+		if ( m_iActiveWords > NUM_WORDS )
+			m_iActiveWords = NUM_WORDS;
+	}
+
+	inline void clear () { memset(m_iWords,0,sizeof(m_iWords)); }
+	inline void fill () { memset(m_iWords,0xFF,sizeof(m_iWords)); }
+	inline void set ( int i ) { m_iWords[i>>5] |= (1u<<(i&31)); }
+	inline void reset ( int i ) { m_iWords[i>>5] &= ~(1u<<(i&31)); }
+	inline bool get ( int i ) const { return (m_iWords[i>>5] & (1u<<(i&31))) != 0; }
+
+	// copy iNumBytes of bits packed lowest bit first (little endian)
+	inline void fromBytes ( const unsigned char *pBytes, int iNumBytes )
+	{
+		clear();
+
+		if ( iNumBytes > (int)sizeof(m_iWords) )
+			iNumBytes = sizeof(m_iWords);
+
+		memcpy(m_iWords,pBytes,iNumBytes);
+	}
+
+	inline void orWith ( const CWaypointBits &other )
+	{
+#ifdef WAYPOINT_BITS_SSE
+		for ( int i = 0; i < m_iActiveWords; i += 4 )
+		{
+			__m128 a = _mm_loadu_ps((const float*)&m_iWords[i]);
+			__m128 b = _mm_loadu_ps((const float*)&other.m_iWords[i]);
+
+			_mm_storeu_ps((float*)&m_iWords[i],_mm_or_ps(a,b));
+		}
+#else
+		for ( int i = 0; i < m_iActiveWords; i ++ )
+			m_iWords[i] |= other.m_iWords[i];
+#endif
+	}
+
+	inline void andWith ( const CWaypointBits &other )
+	{
+#ifdef WAYPOINT_BITS_SSE
+		for ( int i = 0; i < m_iActiveWords; i += 4 )
+		{
+			__m128 a = _mm_loadu_ps((const float*)&m_iWords[i]);
+			__m128 b = _mm_loadu_ps((const float*)&other.m_iWords[i]);
+
+			_mm_storeu_ps((float*)&m_iWords[i],_mm_and_ps(a,b));
+		}
+#else
+		for ( int i = 0; i < m_iActiveWords; i ++ )
+			m_iWords[i] &= other.m_iWords[i];
+#endif
+	}
+
+	// remove every bit set in other
+	inline void andNotWith ( const CWaypointBits &other )
+	{
+#ifdef WAYPOINT_BITS_SSE
+		for ( int i = 0; i < m_iActiveWords; i += 4 )
+		{
+			__m128 a = _mm_loadu_ps((const float*)&m_iWords[i]);
+			__m128 b = _mm_loadu_ps((const float*)&other.m_iWords[i]);
+
+			_mm_storeu_ps((float*)&m_iWords[i],_mm_andnot_ps(b,a));
+		}
+#else
+		for ( int i = 0; i < m_iActiveWords; i ++ )
+			m_iWords[i] &= ~other.m_iWords[i];
+#endif
+	}
+
+	// first set bit at or after i, -1 if none
+	inline int next ( int i ) const
+	{
+		int iWord = i>>5;
+		unsigned int iBits;
+
+		if ( (i < 0) || (iWord >= m_iActiveWords) )
+			return -1;
+
+		iBits = m_iWords[iWord] & (0xFFFFFFFFu << (i&31));
+
+		while ( iBits == 0 )
+		{
+			if ( ++iWord >= m_iActiveWords )
+				return -1;
+
+			iBits = m_iWords[iWord];
+		}
+
+		return (iWord<<5) + lowestBit(iBits);
+	}
+
+	inline int count () const
+	{
+		int iCount = 0;
+
+		for ( int i = 0; i < m_iActiveWords; i ++ )
+			iCount += bitCount(m_iWords[i]);
+
+		return iCount;
+	}
+
+	static inline int lowestBit ( unsigned int iBits )
+	{
+#ifdef _MSC_VER
+		unsigned long iIndex;
+		_BitScanForward(&iIndex,iBits);
+		return (int)iIndex;
+#else
+		return __builtin_ctz(iBits);
+#endif
+	}
+
+	static inline int bitCount ( unsigned int iBits )
+	{
+#ifdef _MSC_VER
+		iBits = iBits - ((iBits >> 1) & 0x55555555u);
+		iBits = (iBits & 0x33333333u) + ((iBits >> 2) & 0x33333333u);
+		return (int)((((iBits + (iBits >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+#else
+		return __builtin_popcount(iBits);
+#endif
+	}
+private:
+	unsigned int m_iWords[NUM_WORDS];
+
+	static int m_iActiveWords;
+};
+
+inline void CWaypoint :: addFlag ( int iFlag )
+{
+	m_iFlags |= iFlag;
+	CWaypoints::invalidateIndex();
+	// team only and unreachable waypoints are left out of the area graph
+	CWaypoints::areaChanged(m_iArea);
+}
+
+inline void CWaypoint :: removeFlag ( int iFlag )
+{
+	m_iFlags &= ~iFlag;
+	CWaypoints::invalidateIndex();
+	CWaypoints::areaChanged(m_iArea);
+}
+
+inline void CWaypoint :: removeFlags ()
+{
+	m_iFlags = 0;
+	CWaypoints::invalidateIndex();
+	CWaypoints::areaChanged(m_iArea);
+}
+
+inline void CWaypoint :: setAim ( int iYaw )
+{
+	m_iAimYaw = iYaw;
+	CWaypoints::drawChanged();
+}
+
+inline void CWaypoint :: setRadius ( float fRad )
+{
+	m_fRadius = fRad;
+	CWaypoints::drawChanged();
+}
+
+inline void CWaypoint :: move ( Vector origin )
+{
+	// move to new origin
+	m_vOrigin = origin;
+	CWaypoints::drawChanged();
+}
+
+inline void CWaypoint :: setUsed ( bool bUsed )
+{
+	m_bUsed = bUsed;
+	CWaypoints::invalidateIndex();
+	CWaypoints::areaChanged(m_iArea);
+}
+
+inline void CWaypoint :: setArea ( int area )
+{
+	if ( area != m_iArea )
+	{
+		CWaypoints::areaChanged(m_iArea);
+		CWaypoints::areaChanged(area);
+	}
+
+	m_iArea = area;
+}
 
 #endif
\ No newline at end of file
@@ -0,0 +1,489 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#include "engine_wrappers.h"
+
+#include "bot.h"
+#include "bot_globals.h"
+#include "bot_waypoint.h"
+#include "bot_waypoint_areas.h"
+
+#include <queue>
+#include <functional>
+
+typedef std::pair<float,int> area_search_node_t;
+typedef std::priority_queue<area_search_node_t,std::vector<area_search_node_t>,std::greater<area_search_node_t> > area_search_queue_t;
+
+std::vector<CWaypointBits> CWaypointAreaGraph::m_Members;
+std::vector<bool> CWaypointAreaGraph::m_bMembersDirty;
+int CWaypointAreaGraph::m_iNumOutside = 0;
+bool CWaypointAreaGraph::m_bDirty = true;
+wpt_area_graph_t CWaypointAreaGraph::m_Teams[MAX_AREA_GRAPH_TEAMS];
+wpt_area_costs_t CWaypointAreaGraph::m_FromStart;
+wpt_area_costs_t CWaypointAreaGraph::m_ToGoal;
+wpt_area_costs_t CWaypointAreaGraph::m_Best;
+wpt_area_costs_t CWaypointAreaGraph::m_Across;
+std::vector<int> CWaypointAreaGraph::m_iParent;
+std::vector<bool> CWaypointAreaGraph::m_bAdded;
+
+void CWaypointAreaGraph :: reset ()
+{
+	wpt_area_costs_t *pScratch[4] = { &m_FromStart, &m_ToGoal, &m_Best, &m_Across };
+
+	m_Members.clear();
+	m_bMembersDirty.clear();
+	m_iNumOutside = 0;
+	m_bDirty = true;
+
+	for ( int i = 0; i < MAX_AREA_GRAPH_TEAMS; i ++ )
+	{
+		m_Teams[i].areas.clear();
+		m_Teams[i].iPortalIndex.clear();
+		m_Teams[i].iTeamRevision = 0;
+		m_Teams[i].bDirty = true;
+	}
+
+	for ( int i = 0; i < 4; i ++ )
+	{
+		pScratch[i]->costs.clear();
+		pScratch[i]->touched.clear();
+	}
+
+	m_iParent.clear();
+}
+
+void CWaypointAreaGraph :: invalidateArea ( int iArea )
+{
+	// waypoints leaving or joining the graph are counted again
+	m_bDirty = true;
+
+	if ( !isValidArea(iArea) )
+		return;
+
+	// new areas are picked up by update()
+	if ( iArea < (int)m_Members.size() )
+		m_bMembersDirty[iArea] = true;
+
+	for ( int i = 0; i < MAX_AREA_GRAPH_TEAMS; i ++ )
+	{
+		if ( iArea < (int)m_Teams[i].areas.size() )
+			m_Teams[i].areas[iArea].bDirty = true;
+
+		m_Teams[i].bDirty = true;
+	}
+}
+
+void CWaypointAreaGraph :: resetCosts ( wpt_area_costs_t &costs )
+{
+	size_t iNumWaypoints = (size_t)CWaypoints::numWaypoints();
+
+	for ( size_t i = 0; i < costs.touched.size(); i ++ )
+		costs.costs[costs.touched[i]] = FLT_MAX;
+
+	costs.touched.clear();
+
+	if ( costs.costs.size() < iNumWaypoints )
+		costs.costs.resize(iNumWaypoints,FLT_MAX);
+}
+
+// area members are the same for every team
+void CWaypointAreaGraph :: updateMembers ()
+{
+	int iNumWaypoints = CWaypoints::numWaypoints();
+	register short int i;
+	int iArea;
+
+	if ( !m_bDirty )
+		return;
+
+	m_iNumOutside = 0;
+
+	// make room for any new areas
+	for ( i = 0; i < iNumWaypoints; i ++ )
+	{
+		CWaypoint *pWpt = CWaypoints::getWaypoint(i);
+
+		if ( !pWpt->isUsed() )
+			continue;
+
+		iArea = pWpt->getArea();
+
+		if ( !isValidArea(iArea) )
+			m_iNumOutside++;
+		else if ( iArea >= (int)m_Members.size() )
+		{
+			m_Members.resize(iArea+1);
+			m_bMembersDirty.resize(iArea+1,true);
+		}
+	}
+
+	for ( size_t j = 0; j < m_Members.size(); j ++ )
+	{
+		if ( m_bMembersDirty[j] )
+			m_Members[j].clear();
+	}
+
+	for ( i = 0; i < iNumWaypoints; i ++ )
+	{
+		CWaypoint *pWpt = CWaypoints::getWaypoint(i);
+
+		iArea = pWpt->getArea();
+
+		if ( pWpt->isUsed() && isValidArea(iArea) && m_bMembersDirty[iArea] )
+			m_Members[iArea].set(i);
+	}
+
+	m_bMembersDirty.assign(m_Members.size(),false);
+
+	m_bDirty = false;
+}
+
+void CWaypointAreaGraph :: update ( int iTeam )
+{
+	wpt_area_graph_t *pGraph = &m_Teams[iTeam];
+	int iNumWaypoints = CWaypoints::numWaypoints();
+	register short int i;
+	int iArea;
+
+	updateMembers();
+
+	// team only waypoints may have changed
+	if ( pGraph->iTeamRevision != CWaypoints::teamRevision() )
+	{
+		for ( size_t j = 0; j < pGraph->areas.size(); j ++ )
+			pGraph->areas[j].bDirty = true;
+
+		pGraph->iTeamRevision = CWaypoints::teamRevision();
+		pGraph->bDirty = true;
+	}
+
+	if ( pGraph->areas.size() < m_Members.size() )
+	{
+		size_t iOldSize = pGraph->areas.size();
+
+		pGraph->areas.resize(m_Members.size());
+
+		for ( size_t j = iOldSize; j < pGraph->areas.size(); j ++ )
+			pGraph->areas[j].bDirty = true;
+
+		pGraph->bDirty = true;
+	}
+
+	if ( !pGraph->bDirty )
+		return;
+
+	pGraph->iPortalIndex.resize(iNumWaypoints,-1);
+
+	for ( i = 0; i < iNumWaypoints; i ++ )
+	{
+		CWaypoint *pWpt = CWaypoints::getWaypoint(i);
+
+		iArea = pWpt->getArea();
+
+		if ( !pWpt->isUsed() || !isValidArea(iArea) || (iArea >= (int)pGraph->areas.size()) || pGraph->areas[iArea].bDirty )
+			pGraph->iPortalIndex[i] = -1;
+	}
+
+	for ( size_t j = 0; j < pGraph->areas.size(); j ++ )
+	{
+		if ( pGraph->areas[j].bDirty )
+			rebuildArea(pGraph,j,iTeam);
+	}
+
+	pGraph->bDirty = false;
+}
+
+// a portal is a waypoint the team can use next to any waypoint in another
+// area, the neighbour may be a start or goal the team can't otherwise use
+void CWaypointAreaGraph :: rebuildArea ( wpt_area_graph_t *pGraph, int iArea, int iTeam )
+{
+	wpt_area_t *pArea = &pGraph->areas[iArea];
+	CWaypointBits *pMembers = &m_Members[iArea];
+	int iWpt;
+	size_t iNumPortals;
+
+	pArea->portals.clear();
+
+	for ( iWpt = pMembers->next(0); iWpt != -1; iWpt = pMembers->next(iWpt+1) )
+	{
+		CWaypoint *pWpt = CWaypoints::getWaypoint(iWpt);
+		bool bPortal = false;
+
+		if ( !CWaypointConnectivity::passable(pWpt,iTeam) )
+			continue;
+
+		for ( int j = 0; !bPortal && (j < pWpt->numPaths()); j ++ )
+		{
+			CWaypoint *pOther = CWaypoints::getWaypoint(pWpt->getPath(j));
+
+			bPortal = pOther->isUsed() && (pOther->getArea() != iArea);
+		}
+
+		for ( int j = 0; !bPortal && (j < pWpt->numPathsToThisWaypoint()); j ++ )
+		{
+			CWaypoint *pOther = CWaypoints::getWaypoint(pWpt->getPathToThisWaypoint(j));
+
+			bPortal = pOther->isUsed() && (pOther->getArea() != iArea);
+		}
+
+		if ( bPortal )
+		{
+			pGraph->iPortalIndex[iWpt] = pArea->portals.size();
+			pArea->portals.push_back(iWpt);
+		}
+	}
+
+	iNumPortals = pArea->portals.size();
+	pArea->costs.assign(iNumPortals*iNumPortals,FLT_MAX);
+
+	for ( size_t k = 0; k < iNumPortals; k ++ )
+	{
+		areaCosts(pArea->portals[k],false,iTeam,m_Across);
+
+		for ( size_t l = 0; l < iNumPortals; l ++ )
+			pArea->costs[(k*iNumPortals)+l] = m_Across.costs[pArea->portals[l]];
+	}
+
+	pArea->bDirty = false;
+}
+
+// dijkstra over the waypoints sharing iWpt's area that the team can use
+void CWaypointAreaGraph :: areaCosts ( int iWpt, bool bReverse, int iTeam, wpt_area_costs_t &costs )
+{
+	area_search_queue_t open;
+	CWaypoint *pWpt = CWaypoints::getWaypoint(iWpt);
+	int iArea = pWpt->getArea();
+
+	resetCosts(costs);
+
+	setCost(costs,iWpt,0);
+	open.push(area_search_node_t(0.0f,iWpt));
+
+	while ( !open.empty() )
+	{
+		area_search_node_t node = open.top();
+		int iNumPaths;
+
+		open.pop();
+
+		if ( node.first > costs.costs[node.second] )
+			continue;
+
+		pWpt = CWaypoints::getWaypoint(node.second);
+		iNumPaths = bReverse ? pWpt->numPathsToThisWaypoint() : pWpt->numPaths();
+
+		for ( int i = 0; i < iNumPaths; i ++ )
+		{
+			int iNext = bReverse ? pWpt->getPathToThisWaypoint(i) : pWpt->getPath(i);
+			CWaypoint *pNext = CWaypoints::getWaypoint(iNext);
+			float fCost;
+
+			if ( (pNext->getArea() != iArea) || !CWaypointConnectivity::passable(pNext,iTeam) )
+				continue;
+
+			fCost = node.first + pNext->distanceFrom(pWpt->getOrigin());
+
+			if ( fCost < costs.costs[iNext] )
+			{
+				setCost(costs,iNext,fCost);
+				open.push(area_search_node_t(fCost,iNext));
+			}
+		}
+	}
+}
+
+eAreaCorridor CWaypointAreaGraph :: getCorridor ( int iFrom, int iTo, int iTeam, CWaypointBits *pCorridor )
+{
+	CWaypoint *pFrom = CWaypoints::getWaypoint(iFrom);
+	CWaypoint *pTo = CWaypoints::getWaypoint(iTo);
+	wpt_area_graph_t *pGraph;
+	int iFromArea, iToArea;
+	area_search_queue_t open;
+
+	float fGoal = FLT_MAX;
+	int iLast = -1;
+	bool bFound = false;
+
+	if ( (pFrom == NULL) || (pTo == NULL) )
+		return AREA_CORRIDOR_NONE;
+	if ( (iTeam < 0) || (iTeam >= MAX_AREA_GRAPH_TEAMS) )
+		return AREA_CORRIDOR_NONE;
+
+	update(iTeam);
+
+	pGraph = &m_Teams[iTeam];
+	iFromArea = pFrom->getArea();
+	iToArea = pTo->getArea();
+
+	if ( (iFromArea == iToArea) || !isValidArea(iFromArea) || !isValidArea(iToArea) )
+		return AREA_CORRIDOR_NONE;
+	if ( (iFromArea >= (int)pGraph->areas.size()) || (iToArea >= (int)pGraph->areas.size()) )
+		return AREA_CORRIDOR_NONE;
+
+	areaCosts(iFrom,false,iTeam,m_FromStart);
+	areaCosts(iTo,true,iTeam,m_ToGoal);
+
+	resetCosts(m_Best);
+
+	if ( m_iParent.size() < m_Best.costs.size() )
+		m_iParent.resize(m_Best.costs.size(),-1);
+
+	// leave the start area through any of its portals
+	for ( size_t i = 0; i < pGraph->areas[iFromArea].portals.size(); i ++ )
+	{
+		int iPortal = pGraph->areas[iFromArea].portals[i];
+
+		if ( m_FromStart.costs[iPortal] < FLT_MAX )
+		{
+			setCost(m_Best,iPortal,m_FromStart.costs[iPortal]);
+			m_iParent[iPortal] = -1;
+			open.push(area_search_node_t(m_FromStart.costs[iPortal],iPortal));
+		}
+	}
+
+	// or straight from the start, it isn't a portal if the team can't use it
+	for ( int i = 0; i < pFrom->numPaths(); i ++ )
+	{
+		int iNext = pFrom->getPath(i);
+		CWaypoint *pNext = CWaypoints::getWaypoint(iNext);
+		float fCost = pNext->distanceFrom(pFrom->getOrigin());
+
+		if ( iNext == iTo )
+		{
+			bFound = true;
+			fGoal = fCost;
+		}
+		else if ( (iNext < (int)pGraph->iPortalIndex.size()) && (pGraph->iPortalIndex[iNext] != -1) && (pNext->getArea() != iFromArea) && (fCost < m_Best.costs[iNext]) )
+		{
+			setCost(m_Best,iNext,fCost);
+			m_iParent[iNext] = -1;
+			open.push(area_search_node_t(fCost,iNext));
+		}
+	}
+
+	while ( !open.empty() )
+	{
+		area_search_node_t node = open.top();
+		int iPortal = node.second;
+		CWaypoint *pPortal = CWaypoints::getWaypoint(iPortal);
+		wpt_area_t *pArea = &pGraph->areas[pPortal->getArea()];
+		size_t iNumPortals = pArea->portals.size();
+		size_t k = pGraph->iPortalIndex[iPortal];
+
+		open.pop();
+
+		if ( node.first > m_Best.costs[iPortal] )
+			continue;
+		if ( node.first >= fGoal )
+			break;
+
+		if ( (pPortal->getArea() == iToArea) && (m_ToGoal.costs[iPortal] < FLT_MAX) && ((node.first+m_ToGoal.costs[iPortal]) < fGoal) )
+		{
+			fGoal = node.first + m_ToGoal.costs[iPortal];
+			iLast = iPortal;
+			bFound = true;
+		}
+
+		// across the area
+		for ( size_t l = 0; l < iNumPortals; l ++ )
+		{
+			float fCost = pArea->costs[(k*iNumPortals)+l];
+			int iNext = pArea->portals[l];
+
+			if ( fCost == FLT_MAX )
+				continue;
+
+			fCost += node.first;
+
+			if ( fCost < m_Best.costs[iNext] )
+			{
+				setCost(m_Best,iNext,fCost);
+				m_iParent[iNext] = iPortal;
+				open.push(area_search_node_t(fCost,iNext));
+			}
+		}
+
+		// into the next area
+		for ( int i = 0; i < pPortal->numPaths(); i ++ )
+		{
+			int iNext = pPortal->getPath(i);
+			CWaypoint *pNext = CWaypoints::getWaypoint(iNext);
+			float fCost = node.first + pNext->distanceFrom(pPortal->getOrigin());
+
+			// the goal isn't a portal if the team can't use it
+			if ( iNext == iTo )
+			{
+				if ( fCost < fGoal )
+				{
+					fGoal = fCost;
+					iLast = iPortal;
+					bFound = true;
+				}
+
+				continue;
+			}
+
+			if ( (iNext >= (int)pGraph->iPortalIndex.size()) || (pGraph->iPortalIndex[iNext] == -1) || (pNext->getArea() == pPortal->getArea()) )
+				continue;
+
+			if ( fCost < m_Best.costs[iNext] )
+			{
+				setCost(m_Best,iNext,fCost);
+				m_iParent[iNext] = iPortal;
+				open.push(area_search_node_t(fCost,iNext));
+			}
+		}
+	}
+
+	// every waypoint the team can use is in the graph, so no waypoint search can get there either
+	if ( !bFound )
+		return (m_iNumOutside > 0) ? AREA_CORRIDOR_NONE : AREA_CORRIDOR_UNREACHABLE;
+
+	m_bAdded.assign(m_Members.size(),false);
+
+	pCorridor->clear();
+	pCorridor->orWith(m_Members[iFromArea]);
+	pCorridor->orWith(m_Members[iToArea]);
+	m_bAdded[iFromArea] = true;
+	m_bAdded[iToArea] = true;
+
+	for ( int iPortal = iLast; iPortal != -1; iPortal = m_iParent[iPortal] )
+	{
+		int iArea = CWaypoints::getWaypoint(iPortal)->getArea();
+
+		if ( !m_bAdded[iArea] )
+		{
+			pCorridor->orWith(m_Members[iArea]);
+			m_bAdded[iArea] = true;
+		}
+	}
+
+	return AREA_CORRIDOR_FOUND;
+}
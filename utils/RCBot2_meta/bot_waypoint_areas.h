@@ -0,0 +1,124 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#ifndef __RCBOT_WAYPOINT_AREAS_H__
+#define __RCBOT_WAYPOINT_AREAS_H__
+
+#include <float.h>
+#include <vector>
+
+#include "bot_waypoint.h"
+#include "bot_waypoint_connectivity.h"
+
+// waypoint areas above this aren't part of the area graph
+#define MAX_AREA_GRAPH_AREAS 256
+// each team has its own portals, team only waypoints are left out
+#define MAX_AREA_GRAPH_TEAMS MAX_CONNECTIVITY_TEAMS
+
+typedef enum
+{
+	AREA_CORRIDOR_NONE = 0,	// same area or not in the graph : search all waypoints
+	AREA_CORRIDOR_FOUND,
+	AREA_CORRIDOR_UNREACHABLE // no area route for the team, no search can find one
+}eAreaCorridor;
+
+typedef struct
+{
+	std::vector<int> portals; // waypoints the team can use with a path into or out of another area
+	std::vector<float> costs; // portal to portal within this area, portals.size() squared
+	bool bDirty;
+}wpt_area_t;
+
+typedef struct
+{
+	std::vector<wpt_area_t> areas;
+	std::vector<int> iPortalIndex; // one per waypoint in use
+	unsigned int iTeamRevision; // CWaypoints::teamRevision() when built
+	bool bDirty;
+}wpt_area_graph_t;
+
+// costs per waypoint kept between searches, only the ones set are reset
+typedef struct
+{
+	std::vector<float> costs;
+	std::vector<int> touched;
+}wpt_area_costs_t;
+
+// area level view of the waypoints : the areas linked by their portal
+// waypoints, used to pick which areas a long route goes through before
+// the waypoint search. Areas are rebuilt only when their waypoints change
+class CWaypointAreaGraph
+{
+public:
+	static void reset ();
+
+	// paths, areas or waypoints in iArea changed
+	static void invalidateArea ( int iArea );
+
+	// waypoints in the areas the cheapest area level route for iTeam from
+	// iFrom to iTo goes through
+	static eAreaCorridor getCorridor ( int iFrom, int iTo, int iTeam, CWaypointBits *pCorridor );
+
+private:
+	static void update ( int iTeam );
+	static void updateMembers ();
+	static void rebuildArea ( wpt_area_graph_t *pGraph, int iArea, int iTeam );
+	// cost to (or from if bReverse) every waypoint in the area of iWpt without leaving it
+	static void areaCosts ( int iWpt, bool bReverse, int iTeam, wpt_area_costs_t &costs );
+
+	static void resetCosts ( wpt_area_costs_t &costs );
+
+	static inline void setCost ( wpt_area_costs_t &costs, int iWpt, float fCost )
+	{
+		if ( costs.costs[iWpt] == FLT_MAX )
+			costs.touched.push_back(iWpt);
+
+		costs.costs[iWpt] = fCost;
+	}
+
+	static inline bool isValidArea ( int iArea ) { return (iArea >= 0) && (iArea < MAX_AREA_GRAPH_AREAS); }
+
+	static std::vector<CWaypointBits> m_Members; // used waypoints in each area
+	static std::vector<bool> m_bMembersDirty;
+	static int m_iNumOutside; // used waypoints in no area of the graph
+	static bool m_bDirty;
+
+	static wpt_area_graph_t m_Teams[MAX_AREA_GRAPH_TEAMS];
+
+	// search scratch, sized to the waypoints once
+	static wpt_area_costs_t m_FromStart;
+	static wpt_area_costs_t m_ToGoal;
+	static wpt_area_costs_t m_Best;
+	static wpt_area_costs_t m_Across;
+	static std::vector<int> m_iParent;
+	static std::vector<bool> m_bAdded;
+};
+
+#endif
@@ -0,0 +1,236 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#include "engine_wrappers.h"
+
+#include "bot.h"
+#include "bot_cvars.h"
+#include "bot_globals.h"
+#include "bot_waypoint.h"
+#include "bot_waypoint_locations.h"
+#include "bot_waypoint_autopath.h"
+
+#include "tier0/platform.h"
+
+std::vector<wpt_autopath_pair_t> CWaypointAutoPath::m_Pairs;
+std::unordered_set<unsigned int> CWaypointAutoPath::m_Queued;
+unsigned int CWaypointAutoPath::m_iNext = 0;
+std::vector<wpt_autopath_ground_t> CWaypointAutoPath::m_Ground;
+MyEHandle CWaypointAutoPath::m_pPlayer;
+
+void CWaypointAutoPath :: reset ()
+{
+	m_Pairs.clear();
+	m_Queued.clear();
+	m_iNext = 0;
+	m_Ground.clear();
+	m_pPlayer = MyEHandle();
+}
+
+void CWaypointAutoPath :: add ( edict_t *pPlayer, int iWpt )
+{
+	m_pPlayer = MyEHandle(pPlayer);
+
+	CWaypointLocations::AutoPath(pPlayer,iWpt);
+
+	if ( rcbot_autopath_budget.GetInt() <= 0 )
+		workAll();
+}
+
+void CWaypointAutoPath :: addPair ( int iWpt1, int iWpt2, float fWidth )
+{
+	wpt_autopath_pair_t pair;
+
+	if ( iWpt1 == iWpt2 )
+		return;
+
+	if ( iWpt1 > iWpt2 )
+	{
+		int iTemp = iWpt1;
+
+		iWpt1 = iWpt2;
+		iWpt2 = iTemp;
+	}
+
+	// already waiting, from the other waypoint's side
+	if ( !m_Queued.insert(pairKey(iWpt1,iWpt2)).second )
+		return;
+
+	pair.iWpt1 = iWpt1;
+	pair.iWpt2 = iWpt2;
+	pair.fWidth = fWidth;
+
+	m_Pairs.push_back(pair);
+}
+
+int CWaypointAutoPath :: addAll ( edict_t *pPlayer )
+{
+	int iNumWaypoints = CWaypoints::numWaypoints();
+	int iAdded = 0;
+
+	m_pPlayer = MyEHandle(pPlayer);
+
+	for ( int i = 0; i < iNumWaypoints; i ++ )
+	{
+		CWaypoint *pWpt = CWaypoints::getWaypoint(i);
+
+		if ( !pWpt->isUsed() || pWpt->hasFlag(CWaypointTypes::W_FL_UNREACHABLE) )
+			continue;
+
+		CWaypointLocations::AutoPath(pPlayer,i);
+		iAdded++;
+	}
+
+	return iAdded;
+}
+
+void CWaypointAutoPath :: work ()
+{
+	double fBudget = rcbot_autopath_budget.GetFloat() / 1000000.0;
+	double fStart;
+
+	if ( pending() == 0 )
+		return;
+
+	fStart = Plat_FloatTime();
+
+	// the areas of this frame's new paths are changed together at the end
+	CWaypoints::beginAreaChanges();
+
+	// always do one so a small budget can't stop pathing altogether
+	do
+	{
+		workPair(&m_Pairs[m_iNext++]);
+	}
+	while ( (pending() > 0) && ((Plat_FloatTime() - fStart) < fBudget) );
+
+	CWaypoints::endAreaChanges();
+
+	if ( pending() == 0 )
+	{
+		m_Pairs.clear();
+		m_Queued.clear();
+		m_iNext = 0;
+	}
+}
+
+void CWaypointAutoPath :: workAll ()
+{
+	CWaypoints::beginAreaChanges();
+
+	while ( pending() > 0 )
+		workPair(&m_Pairs[m_iNext++]);
+
+	CWaypoints::endAreaChanges();
+
+	m_Pairs.clear();
+	m_Queued.clear();
+	m_iNext = 0;
+}
+
+const wpt_autopath_ground_t *CWaypointAutoPath :: ground ( int iWpt, const Vector &vOrigin )
+{
+	wpt_autopath_ground_t *pGround;
+
+	if ( (unsigned int)iWpt >= m_Ground.size() )
+	{
+		wpt_autopath_ground_t unknown;
+
+		unknown.bValid = false;
+		m_Ground.resize(iWpt+1,unknown);
+	}
+
+	pGround = &m_Ground[iWpt];
+
+	// found already, unless the waypoint has moved or been replaced since
+	if ( !pGround->bValid || (pGround->vOrigin != vOrigin) )
+	{
+		pGround->vOrigin = vOrigin;
+		pGround->vGround = CBotGlobals::groundBelow(m_pPlayer.get(),vOrigin);
+		pGround->bWater = (enginetrace->GetPointContents(vOrigin) == CONTENTS_WATER);
+		pGround->bValid = true;
+	}
+
+	return pGround;
+}
+
+// same as walkableFromTo both ways between the pair, but the sides of the path
+// and the ground under each end are only traced once
+void CWaypointAutoPath :: workPair ( const wpt_autopath_pair_t *pPair )
+{
+	CWaypoint *pWpt1 = CWaypoints::getWaypoint(pPair->iWpt1);
+	CWaypoint *pWpt2 = CWaypoints::getWaypoint(pPair->iWpt2);
+	const wpt_autopath_ground_t *pGround1;
+	const wpt_autopath_ground_t *pGround2;
+	edict_t *pPlayer = m_pPlayer.get();
+	Vector vOrigin1, vOrigin2;
+	float fDistance;
+
+	// deleted while waiting
+	if ( !pWpt1 || !pWpt2 || !pWpt1->isUsed() || !pWpt2->isUsed() )
+		return;
+
+	vOrigin1 = pWpt1->getOrigin();
+	vOrigin2 = pWpt2->getOrigin();
+	fDistance = (vOrigin1-vOrigin2).Length();
+
+	if ( (fDistance > bot_waypointpathdist.GetFloat()) || (fDistance > CWaypointLocations::REACHABLE_RANGE) )
+		return;
+
+	if ( !CBotGlobals::isVisible(vOrigin1,vOrigin2) )
+		return;
+
+	if ( vOrigin1 == vOrigin2 )
+	{
+		pWpt1->addPathTo(pPair->iWpt2);
+		pWpt2->addPathTo(pPair->iWpt1);
+		return;
+	}
+
+	pGround1 = ground(pPair->iWpt1,vOrigin1);
+	pGround2 = ground(pPair->iWpt2,vOrigin2);
+
+	// can swim there
+	if ( pGround1->bWater && pGround2->bWater )
+	{
+		pWpt1->addPathTo(pPair->iWpt2);
+		pWpt2->addPathTo(pPair->iWpt1);
+		return;
+	}
+
+	if ( !CBotGlobals::walkableSidesClear(vOrigin1,vOrigin2,pPair->fWidth) )
+		return;
+
+	if ( CBotGlobals::canStepFromTo(pPlayer,vOrigin1,vOrigin2,pGround1->vGround,pGround2->vGround) )
+		pWpt1->addPathTo(pPair->iWpt2);
+
+	if ( CBotGlobals::canStepFromTo(pPlayer,vOrigin2,vOrigin1,pGround2->vGround,pGround1->vGround) )
+		pWpt2->addPathTo(pPair->iWpt1);
+}
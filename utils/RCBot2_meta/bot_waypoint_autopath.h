@@ -0,0 +1,94 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#ifndef __RCBOT_WAYPOINT_AUTOPATH_H__
+#define __RCBOT_WAYPOINT_AUTOPATH_H__
+
+#include <vector>
+#include <unordered_set>
+
+#include "bot_ehandle.h"
+
+typedef struct
+{
+	short int iWpt1; // lower index, both directions are checked together
+	short int iWpt2;
+	float fWidth; // walkable width of whoever placed the waypoint
+}wpt_autopath_pair_t;
+
+typedef struct
+{
+	Vector vOrigin; // the waypoint was here when the ground was found
+	Vector vGround;
+	bool bWater;
+	bool bValid;
+}wpt_autopath_ground_t;
+
+// paths between new waypoints and the waypoints around them are found
+// after the bots think within rcbot_autopath_budget microseconds a frame
+// instead of all at once when the waypoint is added. Each pair is only
+// looked at once for both directions and the ground under each waypoint
+// is found once however many pairs it is in
+class CWaypointAutoPath
+{
+public:
+	static void reset ();
+
+	// queue paths between iWpt and the waypoints around it
+	static void add ( edict_t *pPlayer, int iWpt );
+	// queue one pair of waypoints
+	static void addPair ( int iWpt1, int iWpt2, float fWidth );
+	// queue every waypoint for re-pathing the whole map
+	static int addAll ( edict_t *pPlayer );
+
+	// called every frame
+	static void work ();
+	// finish everything queued now
+	static void workAll ();
+
+	static inline unsigned int pending () { return m_Pairs.size() - m_iNext; }
+
+private:
+	static void workPair ( const wpt_autopath_pair_t *pPair );
+	static const wpt_autopath_ground_t *ground ( int iWpt, const Vector &vOrigin );
+
+	static inline unsigned int pairKey ( int iWpt1, int iWpt2 )
+	{
+		return (((unsigned int)iWpt1)<<16)|((unsigned int)iWpt2);
+	}
+
+	static std::vector<wpt_autopath_pair_t> m_Pairs;
+	static std::unordered_set<unsigned int> m_Queued;
+	static unsigned int m_iNext;
+	static std::vector<wpt_autopath_ground_t> m_Ground;
+	static MyEHandle m_pPlayer; // paths are traced ignoring this player
+};
+
+#endif
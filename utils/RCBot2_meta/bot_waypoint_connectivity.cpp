@@ -0,0 +1,415 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#include "engine_wrappers.h"
+
+#include "bot.h"
+#include "bot_globals.h"
+#include "bot_waypoint.h"
+#include "bot_waypoint_connectivity.h"
+
+#include <algorithm>
+
+// most waypoint ids listed per lint category
+#define CONNECTIVITY_LINT_LIST 24
+
+wpt_connectivity_t CWaypointConnectivity::m_Teams[MAX_CONNECTIVITY_TEAMS];
+
+void CWaypointConnectivity :: reset ()
+{
+	for ( int i = 0; i < MAX_CONNECTIVITY_TEAMS; i ++ )
+	{
+		m_Teams[i].iRevision = 0;
+		m_Teams[i].iTeamRevision = 0;
+		m_Teams[i].iNumComponents = 0;
+		m_Teams[i].iComponent.clear();
+		m_Teams[i].compPaths.clear();
+		m_Teams[i].reach.clear();
+		m_Teams[i].iCachedWords = 0;
+	}
+}
+
+wpt_connectivity_t *CWaypointConnectivity :: getLabels ( int iTeam )
+{
+	wpt_connectivity_t *pLabels;
+
+	if ( (iTeam < 0) || (iTeam >= MAX_CONNECTIVITY_TEAMS) )
+		return NULL;
+
+	pLabels = &m_Teams[iTeam];
+
+	// waypoints, paths, flags or team rules changed since
+	if ( (pLabels->iRevision != CWaypoints::revision()) || (pLabels->iTeamRevision != CWaypoints::teamRevision()) )
+		label(pLabels,iTeam);
+
+	return pLabels;
+}
+
+int CWaypointConnectivity :: getComponent ( int iWpt, int iTeam )
+{
+	wpt_connectivity_t *pLabels = getLabels(iTeam);
+
+	if ( (pLabels == NULL) || (iWpt < 0) || (iWpt >= (int)pLabels->iComponent.size()) )
+		return -1;
+
+	return pLabels->iComponent[iWpt];
+}
+
+// tarjan's algorithm without recursion, paths lead only into waypoints the team
+// can use so unusable waypoints end up on their own
+void CWaypointConnectivity :: label ( wpt_connectivity_t *pLabels, int iTeam )
+{
+	int iNumWaypoints = CWaypoints::numWaypoints();
+	std::vector<int> index(iNumWaypoints,-1);
+	std::vector<int> lowlink(iNumWaypoints,0);
+	std::vector<bool> onStack(iNumWaypoints,false);
+	std::vector<int> stack;
+	std::vector< std::pair<int,int> > calls; // waypoint, next path to look at
+	int iNextIndex = 0;
+
+	pLabels->iNumComponents = 0;
+	pLabels->iComponent.assign(iNumWaypoints,-1);
+	pLabels->compPaths.clear();
+	pLabels->reach.clear();
+	pLabels->iCachedWords = 0;
+
+	for ( int iStart = 0; iStart < iNumWaypoints; iStart ++ )
+	{
+		if ( (index[iStart] != -1) || !CWaypoints::getWaypoint(iStart)->isUsed() )
+			continue;
+
+		index[iStart] = lowlink[iStart] = iNextIndex++;
+		stack.push_back(iStart);
+		onStack[iStart] = true;
+		calls.push_back(std::pair<int,int>(iStart,0));
+
+		while ( !calls.empty() )
+		{
+			int iWpt = calls.back().first;
+			CWaypoint *pWpt = CWaypoints::getWaypoint(iWpt);
+
+			if ( calls.back().second < pWpt->numPaths() )
+			{
+				int iSucc = pWpt->getPath(calls.back().second++);
+				CWaypoint *pSucc = CWaypoints::getWaypoint(iSucc);
+
+				if ( (pSucc == NULL) || !passable(pSucc,iTeam) )
+					continue;
+
+				if ( index[iSucc] == -1 )
+				{
+					index[iSucc] = lowlink[iSucc] = iNextIndex++;
+					stack.push_back(iSucc);
+					onStack[iSucc] = true;
+					calls.push_back(std::pair<int,int>(iSucc,0));
+				}
+				else if ( onStack[iSucc] && (index[iSucc] < lowlink[iWpt]) )
+					lowlink[iWpt] = index[iSucc];
+
+				continue;
+			}
+
+			calls.pop_back();
+
+			if ( lowlink[iWpt] == index[iWpt] )
+			{
+				int iMember;
+
+				do
+				{
+					iMember = stack.back();
+					stack.pop_back();
+					onStack[iMember] = false;
+					pLabels->iComponent[iMember] = pLabels->iNumComponents;
+				} while ( iMember != iWpt );
+
+				pLabels->iNumComponents++;
+			}
+
+			if ( !calls.empty() && (lowlink[iWpt] < lowlink[calls.back().first]) )
+				lowlink[calls.back().first] = lowlink[iWpt];
+		}
+	}
+
+	// paths between components
+	pLabels->compPaths.resize(pLabels->iNumComponents);
+	pLabels->reach.resize(pLabels->iNumComponents);
+
+	for ( int i = 0; i < iNumWaypoints; i ++ )
+	{
+		CWaypoint *pWpt = CWaypoints::getWaypoint(i);
+		int iComp = pLabels->iComponent[i];
+
+		if ( iComp == -1 )
+			continue;
+
+		for ( int j = 0; j < pWpt->numPaths(); j ++ )
+		{
+			int iSucc = pWpt->getPath(j);
+			CWaypoint *pSucc = CWaypoints::getWaypoint(iSucc);
+
+			if ( (pSucc == NULL) || !passable(pSucc,iTeam) || (pLabels->iComponent[iSucc] == iComp) )
+				continue;
+
+			pLabels->compPaths[iComp].push_back(pLabels->iComponent[iSucc]);
+		}
+	}
+
+	for ( int i = 0; i < pLabels->iNumComponents; i ++ )
+	{
+		std::vector<int> &succs = pLabels->compPaths[i];
+
+		std::sort(succs.begin(),succs.end());
+		succs.erase(std::unique(succs.begin(),succs.end()),succs.end());
+	}
+
+	pLabels->iRevision = CWaypoints::revision();
+	pLabels->iTeamRevision = CWaypoints::teamRevision();
+}
+
+void CWaypointConnectivity :: componentsFrom ( wpt_connectivity_t *pLabels, int iComp, std::vector<unsigned int> &bits )
+{
+	std::vector<int> open;
+
+	bits.assign((pLabels->iNumComponents+31)/32,0);
+
+	bits[iComp>>5] |= (1u<<(iComp&31));
+	open.push_back(iComp);
+
+	while ( !open.empty() )
+	{
+		std::vector<int> &succs = pLabels->compPaths[open.back()];
+
+		open.pop_back();
+
+		for ( size_t i = 0; i < succs.size(); i ++ )
+		{
+			int iSucc = succs[i];
+
+			if ( bits[iSucc>>5] & (1u<<(iSucc&31)) )
+				continue;
+
+			bits[iSucc>>5] |= (1u<<(iSucc&31));
+			open.push_back(iSucc);
+		}
+	}
+}
+
+bool CWaypointConnectivity :: reaches ( wpt_connectivity_t *pLabels, int iFromComp, int iToComp )
+{
+	if ( iFromComp == iToComp )
+		return true;
+	// paths only lead to lower numbered components
+	if ( iToComp > iFromComp )
+		return false;
+	// straight there
+	if ( std::binary_search(pLabels->compPaths[iFromComp].begin(),pLabels->compPaths[iFromComp].end(),iToComp) )
+		return true;
+
+	std::vector<unsigned int> &row = pLabels->reach[iFromComp];
+
+	if ( row.empty() )
+	{
+		unsigned int iWords = (pLabels->iNumComponents+31)/32;
+
+		if ( (pLabels->iCachedWords + iWords) > MAX_CONNECTIVITY_CACHE_WORDS )
+		{
+			std::vector<unsigned int> bits;
+
+			componentsFrom(pLabels,iFromComp,bits);
+
+			return (bits[iToComp>>5] & (1u<<(iToComp&31))) != 0;
+		}
+
+		componentsFrom(pLabels,iFromComp,row);
+		pLabels->iCachedWords += iWords;
+	}
+
+	return (row[iToComp>>5] & (1u<<(iToComp&31))) != 0;
+}
+
+bool CWaypointConnectivity :: canReach ( int iFrom, int iTo, int iTeam )
+{
+	wpt_connectivity_t *pLabels;
+	CWaypoint *pTo;
+	int iFromComp;
+
+	if ( iFrom == iTo )
+		return true;
+
+	pLabels = getLabels(iTeam);
+
+	// don't know
+	if ( (pLabels == NULL) || !CWaypoints::validWaypointIndex(iFrom) || !CWaypoints::validWaypointIndex(iTo) )
+		return true;
+
+	iFromComp = pLabels->iComponent[iFrom];
+	pTo = CWaypoints::getWaypoint(iTo);
+
+	if ( (iFromComp == -1) || !pTo->isUsed() )
+		return true;
+
+	if ( passable(pTo,iTeam) )
+		return reaches(pLabels,iFromComp,pLabels->iComponent[iTo]);
+
+	// the route may end on a goal the team can't otherwise use, through
+	// any of the waypoints leading into it
+	for ( int i = 0; i < pTo->numPathsToThisWaypoint(); i ++ )
+	{
+		int iPrev = pTo->getPathToThisWaypoint(i);
+		CWaypoint *pPrev = CWaypoints::getWaypoint(iPrev);
+
+		if ( (pPrev == NULL) || !pPrev->isUsed() )
+			continue;
+
+		if ( (iPrev == iFrom) || (passable(pPrev,iTeam) && reaches(pLabels,iFromComp,pLabels->iComponent[iPrev])) )
+			return true;
+	}
+
+	return false;
+}
+
+static void lintList ( edict_t *pPrintTo, const char *szWhat, std::vector<int> &wpts )
+{
+	char szList[256];
+	size_t iLen = 0;
+
+	szList[0] = 0;
+
+	for ( size_t i = 0; (i < wpts.size()) && (i < CONNECTIVITY_LINT_LIST); i ++ )
+	{
+		int iWritten = snprintf(&szList[iLen],sizeof(szList)-iLen,"%d ",wpts[i]);
+
+		if ( (iWritten < 0) || ((iLen+iWritten) >= sizeof(szList)) )
+			break;
+
+		iLen += iWritten;
+	}
+
+	CBotGlobals::botMessage(pPrintTo,0,"%d %s%s %s%s",(int)wpts.size(),szWhat,wpts.empty()?"":":",szList,(wpts.size()>CONNECTIVITY_LINT_LIST)?"...":"");
+}
+
+void CWaypointConnectivity :: lint ( edict_t *pPrintTo, int iTeam )
+{
+	wpt_connectivity_t *pLabels = getLabels(iTeam);
+	int iNumWaypoints = CWaypoints::numWaypoints();
+	std::vector<int> iCompSize;
+	std::vector<unsigned int> fromMain;
+	std::vector<unsigned int> toMain;
+	std::vector<int> isolated;
+	std::vector<int> deadends;
+	std::vector<int> traps;
+	std::vector<int> unreachable;
+	int iMain = -1;
+
+	if ( pLabels == NULL )
+	{
+		CBotGlobals::botMessage(pPrintTo,0,"team must be 0 to %d",MAX_CONNECTIVITY_TEAMS-1);
+		return;
+	}
+
+	iCompSize.assign(pLabels->iNumComponents,0);
+
+	for ( int i = 0; i < iNumWaypoints; i ++ )
+	{
+		int iComp = pLabels->iComponent[i];
+
+		if ( (iComp != -1) && passable(CWaypoints::getWaypoint(i),iTeam) )
+		{
+			iCompSize[iComp]++;
+
+			if ( (iMain == -1) || (iCompSize[iComp] > iCompSize[iMain]) )
+				iMain = iComp;
+		}
+	}
+
+	CBotGlobals::botMessage(pPrintTo,0,"team %d : %d connected groups of waypoints, largest has %d",iTeam,pLabels->iNumComponents,(iMain==-1)?0:iCompSize[iMain]);
+
+	if ( iMain == -1 )
+		return;
+
+	// everywhere the largest group leads to, and everywhere leading back into it
+	componentsFrom(pLabels,iMain,fromMain);
+
+	toMain.assign(fromMain.size(),0);
+	toMain[iMain>>5] |= (1u<<(iMain&31));
+
+	// components only have paths to lower numbers, so go up from the largest
+	for ( int iComp = iMain+1; iComp < pLabels->iNumComponents; iComp ++ )
+	{
+		std::vector<int> &succs = pLabels->compPaths[iComp];
+
+		for ( size_t j = 0; j < succs.size(); j ++ )
+		{
+			if ( toMain[succs[j]>>5] & (1u<<(succs[j]&31)) )
+			{
+				toMain[iComp>>5] |= (1u<<(iComp&31));
+				break;
+			}
+		}
+	}
+
+	for ( int i = 0; i < iNumWaypoints; i ++ )
+	{
+		CWaypoint *pWpt = CWaypoints::getWaypoint(i);
+		int iComp = pLabels->iComponent[i];
+		bool bFromMain, bToMain;
+
+		// team only and unreachable waypoints are meant to be left out
+		if ( (iComp == -1) || !passable(pWpt,iTeam) )
+			continue;
+
+		if ( (pWpt->numPaths() == 0) && (pWpt->numPathsToThisWaypoint() == 0) )
+		{
+			isolated.push_back(i);
+			continue;
+		}
+
+		bFromMain = (fromMain[iComp>>5] & (1u<<(iComp&31))) != 0;
+		bToMain = (toMain[iComp>>5] & (1u<<(iComp&31))) != 0;
+
+		// on its own with no usable path out
+		if ( pLabels->compPaths[iComp].empty() && (iCompSize[iComp] == 1) && (iComp != iMain) )
+		{
+			deadends.push_back(i);
+			continue;
+		}
+
+		if ( bFromMain && !bToMain )
+			traps.push_back(i);
+		else if ( !bFromMain )
+			unreachable.push_back(i);
+	}
+
+	lintList(pPrintTo,"waypoints without paths",isolated);
+	lintList(pPrintTo,"dead ends (no way on from them)",deadends);
+	lintList(pPrintTo,"one way traps (reachable but no way back)",traps);
+	lintList(pPrintTo,"waypoints the largest group can't reach",unreachable);
+}
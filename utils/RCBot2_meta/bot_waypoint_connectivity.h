@@ -0,0 +1,87 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#ifndef __RCBOT_WAYPOINT_CONNECTIVITY_H__
+#define __RCBOT_WAYPOINT_CONNECTIVITY_H__
+
+#include <vector>
+
+#include "bot_waypoint.h"
+
+// team numbers with their own labels, 0 ignores team only waypoints
+#define MAX_CONNECTIVITY_TEAMS 4
+// words of cached reachability rows kept before rows are worked out per query
+#define MAX_CONNECTIVITY_CACHE_WORDS 262144
+
+typedef struct
+{
+	unsigned int iRevision; // CWaypoints::revision() when labelled, 0 if never
+	unsigned int iTeamRevision;
+	int iNumComponents;
+	std::vector<int> iComponent; // one per waypoint in use, -1 if unused
+	std::vector< std::vector<int> > compPaths; // components reached in one step from each component
+	std::vector< std::vector<unsigned int> > reach; // components reachable from each component, empty until asked for
+	unsigned int iCachedWords;
+}wpt_connectivity_t;
+
+// strongly connected components of the waypoint paths a team can use.
+// Components are numbered so a path between two of them always goes from
+// a higher number to a lower one, routes that can't exist are refused
+// without searching
+class CWaypointConnectivity
+{
+public:
+	static void reset ();
+
+	// false only if iTeam's bots can never get from iFrom to iTo
+	static bool canReach ( int iFrom, int iTo, int iTeam );
+
+	static int getComponent ( int iWpt, int iTeam );
+
+	// prints dead ends, one way traps and waypoints that can't be reached
+	static void lint ( edict_t *pPrintTo, int iTeam );
+
+	// waypoints a team's bots may route through (the goal itself is always allowed),
+	// the parts of CBot::canGotoWaypoint that don't change while bots play
+	static inline bool passable ( CWaypoint *pWpt, int iTeam )
+	{
+		return pWpt->isUsed() && !pWpt->hasFlag(CWaypointTypes::W_FL_UNREACHABLE) && pWpt->forTeam(iTeam);
+	}
+
+private:
+	static wpt_connectivity_t *getLabels ( int iTeam );
+	static void label ( wpt_connectivity_t *pLabels, int iTeam );
+	static bool reaches ( wpt_connectivity_t *pLabels, int iFromComp, int iToComp );
+	static void componentsFrom ( wpt_connectivity_t *pLabels, int iComp, std::vector<unsigned int> &bits );
+
+	static wpt_connectivity_t m_Teams[MAX_CONNECTIVITY_TEAMS];
+};
+
+#endif
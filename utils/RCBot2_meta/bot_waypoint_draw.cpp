@@ -0,0 +1,245 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#include "engine_wrappers.h"
+
+#include "bot.h"
+#include "bot_cvars.h"
+#include "bot_client.h"
+#include "bot_globals.h"
+#include "bot_waypoint.h"
+#include "bot_waypoint_locations.h"
+#include "bot_waypoint_draw.h"
+
+#include <algorithm>
+
+wpt_draw_client_t CWaypointDrawList::m_Clients[MAX_PLAYERS];
+int CWaypointDrawList::m_iFrame = -1;
+int CWaypointDrawList::m_iDrawing = 0;
+int CWaypointDrawList::m_iDrawingLast = 0;
+
+static bool drawEntryByPriority ( const wpt_draw_entry_t *a, const wpt_draw_entry_t *b )
+{
+	return a->fPriority > b->fPriority;
+}
+
+void CWaypointDrawList :: reset ()
+{
+	for ( int i = 0; i < MAX_PLAYERS; i ++ )
+	{
+		m_Clients[i].pPlayer = MyEHandle();
+		m_Clients[i].bValid = false;
+		m_Clients[i].entries.clear();
+	}
+
+	m_iFrame = -1;
+	m_iDrawing = 0;
+	m_iDrawingLast = 0;
+}
+
+// this editor's share of the waypoints and paths drawn this frame, 0 for no limit
+int CWaypointDrawList :: budget ()
+{
+	int iBudget = rcbot_wpt_draw_budget.GetInt();
+
+	if ( m_iFrame != gpGlobals->framecount )
+	{
+		m_iFrame = gpGlobals->framecount;
+		m_iDrawingLast = m_iDrawing;
+		m_iDrawing = 0;
+	}
+
+	m_iDrawing++;
+
+	if ( iBudget <= 0 )
+		return 0;
+
+	// split between the editors drawing last frame
+	return MAX(1,iBudget/MAX(1,m_iDrawingLast));
+}
+
+// find the waypoints this editor can see again if it's needed
+void CWaypointDrawList :: update ( CClient *pClient, wpt_draw_client_t *pDraw )
+{
+	static WaypointList drawable;
+	std::vector<wpt_draw_entry_t> entries;
+	Vector vOrigin = pClient->getOrigin();
+	int iCluster;
+	unsigned int iOld = 0;
+	// new edits and draw types are drawn straight away
+	bool bKeepTimes = pDraw->bValid && (pDraw->iDrawSerial == CWaypoints::drawSerial()) && (pDraw->iDrawType == pClient->getDrawType());
+
+	if ( bKeepTimes && (pDraw->iShowFlags == pClient->getShowWaypointFlags()) &&
+		((vOrigin - pDraw->vOrigin).LengthSqr() < (WPT_DRAW_MOVE_DIST*WPT_DRAW_MOVE_DIST)) )
+		return;
+
+	iCluster = engine->GetClusterForOrigin(vOrigin);
+
+	if ( !pDraw->bValid || (iCluster != pDraw->iCluster) )
+	{
+		engine->GetPVSForCluster(iCluster,sizeof(pDraw->pvs),pDraw->pvs);
+		pDraw->iCluster = iCluster;
+	}
+
+	CWaypointLocations::GetDrawable(pClient,pDraw->pvs,sizeof(pDraw->pvs),&drawable);
+
+	std::sort(drawable.begin(),drawable.end());
+
+	entries.reserve(drawable.size());
+
+	for ( unsigned int i = 0; i < drawable.size(); i ++ )
+	{
+		wpt_draw_entry_t entry;
+
+		entry.iWpt = drawable[i];
+		entry.fDrawnUntil = 0;
+		entry.fPriority = 0;
+
+		// still showing from the last list
+		if ( bKeepTimes )
+		{
+			while ( (iOld < pDraw->entries.size()) && (pDraw->entries[iOld].iWpt < entry.iWpt) )
+				iOld++;
+
+			if ( (iOld < pDraw->entries.size()) && (pDraw->entries[iOld].iWpt == entry.iWpt) )
+				entry.fDrawnUntil = pDraw->entries[iOld].fDrawnUntil;
+		}
+
+		entries.push_back(entry);
+	}
+
+	pDraw->entries.swap(entries);
+
+	if ( !bKeepTimes )
+		pDraw->fPathsDrawnUntil = 0;
+
+	pDraw->vOrigin = vOrigin;
+	pDraw->iDrawSerial = CWaypoints::drawSerial();
+	pDraw->iShowFlags = pClient->getShowWaypointFlags();
+	pDraw->iDrawType = pClient->getDrawType();
+	pDraw->bValid = true;
+}
+
+// paths of the waypoint the editor is at, returns the number drawn
+int CWaypointDrawList :: drawPaths ( CClient *pClient, wpt_draw_client_t *pDraw, float fTime )
+{
+	CWaypoint *pWpt;
+	int iWpt = pClient->currentWaypoint();
+
+	if ( !pClient->isPathWaypointOn() || (iWpt == -1) )
+	{
+		pDraw->iPathsWpt = -1;
+		return 0;
+	}
+
+	if ( (iWpt == pDraw->iPathsWpt) && (pDraw->fPathsDrawnUntil > (fTime + WPT_DRAW_REFRESH)) )
+		return 0;
+
+	pWpt = CWaypoints::getWaypoint(iWpt);
+
+	if ( pWpt == NULL )
+		return 0;
+
+	pWpt->drawPaths(pClient->getPlayer(),pClient->getDrawType());
+
+	pDraw->iPathsWpt = iWpt;
+	pDraw->fPathsDrawnUntil = fTime + WPT_DRAW_LIFE;
+
+	return pWpt->numPaths();
+}
+
+void CWaypointDrawList :: draw ( CClient *pClient )
+{
+	static std::vector<wpt_draw_entry_t*> pending;
+	edict_t *pPlayer = pClient->getPlayer();
+	wpt_draw_client_t *pDraw = &m_Clients[CClients::slotOfEdict(pPlayer)];
+	float fTime = engine->Time();
+	int iBudget = budget();
+	int iDrawn;
+	Vector vOrigin;
+	Vector vAim;
+	Vector vDir;
+	float fDist;
+
+	// someone else in this slot now
+	if ( pDraw->pPlayer.get() != pPlayer )
+	{
+		pDraw->pPlayer = MyEHandle(pPlayer);
+		pDraw->bValid = false;
+		pDraw->entries.clear();
+		pDraw->iPathsWpt = -1;
+		pDraw->fPathsDrawnUntil = 0;
+	}
+
+	update(pClient,pDraw);
+
+	// paths first, they're what's being edited
+	iDrawn = drawPaths(pClient,pDraw,fTime);
+
+	pending.clear();
+
+	for ( unsigned int i = 0; i < pDraw->entries.size(); i ++ )
+	{
+		if ( pDraw->entries[i].fDrawnUntil <= (fTime + WPT_DRAW_REFRESH) )
+			pending.push_back(&pDraw->entries[i]);
+	}
+
+	if ( pending.empty() )
+		return;
+
+	if ( (iBudget > 0) && ((int)pending.size() > (iBudget - iDrawn)) )
+	{
+		unsigned int iCount = (unsigned int)MAX(1,iBudget - iDrawn);
+
+		// closest to the crosshair, then closest to the editor
+		vOrigin = CBotGlobals::entityOrigin(pPlayer);
+		AngleVectors(CBotGlobals::playerAngles(pPlayer),&vAim);
+
+		for ( unsigned int i = 0; i < pending.size(); i ++ )
+		{
+			vDir = CWaypoints::getWaypoint(pending[i]->iWpt)->getOrigin() - vOrigin;
+			fDist = vDir.Length();
+
+			if ( fDist > 0 )
+				pending[i]->fPriority = (DotProduct(vDir,vAim)/fDist) - (fDist/(CWaypointLocations::REACHABLE_RANGE*4));
+			else
+				pending[i]->fPriority = 1.0f;
+		}
+
+		std::partial_sort(pending.begin(),pending.begin()+iCount,pending.end(),drawEntryByPriority);
+		pending.resize(iCount);
+	}
+
+	for ( unsigned int i = 0; i < pending.size(); i ++ )
+	{
+		CWaypoints::getWaypoint(pending[i]->iWpt)->draw(pPlayer,false,pClient->getDrawType());
+		pending[i]->fDrawnUntil = fTime + WPT_DRAW_LIFE;
+	}
+}
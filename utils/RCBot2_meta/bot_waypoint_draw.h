@@ -0,0 +1,92 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#ifndef __RCBOT_WAYPOINT_DRAW_H__
+#define __RCBOT_WAYPOINT_DRAW_H__
+
+#include <vector>
+
+#include "bot_ehandle.h"
+
+// waypoint overlays and beams last this long
+#define WPT_DRAW_LIFE 1.0f
+// redrawn this long before they go so they don't flicker
+#define WPT_DRAW_REFRESH 0.1f
+// the list is found again once the editor moves this far
+#define WPT_DRAW_MOVE_DIST 32.0f
+
+class CClient;
+
+typedef struct
+{
+	int iWpt;
+	float fDrawnUntil;
+	float fPriority;
+}wpt_draw_entry_t;
+
+typedef struct
+{
+	MyEHandle pPlayer;
+	bool bValid;
+	Vector vOrigin; // where the list was found from
+	int iCluster;
+	byte pvs[MAX_MAP_CLUSTERS/8];
+	unsigned int iDrawSerial; // CWaypoints::drawSerial() it was found at
+	int iShowFlags;
+	unsigned short int iDrawType;
+	std::vector<wpt_draw_entry_t> entries; // in waypoint index order
+	int iPathsWpt;
+	float fPathsDrawnUntil;
+}wpt_draw_client_t;
+
+// waypoints drawn to each editor. The ones in view are found again only
+// when the editor moves or waypoints change, and the PVS only when the
+// editor changes cluster. Each frame only waypoints whose overlay is about
+// to go are drawn again, nearest the crosshair first, and all editors
+// share rcbot_wpt_draw_budget waypoints and path beams a frame
+class CWaypointDrawList
+{
+public:
+	static void reset ();
+
+	static void draw ( CClient *pClient );
+
+private:
+	static void update ( CClient *pClient, wpt_draw_client_t *pDraw );
+	static int drawPaths ( CClient *pClient, wpt_draw_client_t *pDraw, float fTime );
+	static int budget ();
+
+	static wpt_draw_client_t m_Clients[MAX_PLAYERS];
+	static int m_iFrame;
+	static int m_iDrawing; // editors drawing this frame
+	static int m_iDrawingLast;
+};
+
+#endif
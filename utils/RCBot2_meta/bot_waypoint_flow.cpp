@@ -0,0 +1,220 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#include "engine_wrappers.h"
+
+#include "bot.h"
+#include "bot_globals.h"
+#include "bot_mods.h"
+#include "bot_waypoint.h"
+#include "bot_waypoint_flow.h"
+
+#include <float.h>
+#include <queue>
+#include <functional>
+
+typedef std::pair<float,int> flow_search_node_t;
+typedef std::priority_queue<flow_search_node_t,std::vector<flow_search_node_t>,std::greater<flow_search_node_t> > flow_search_queue_t;
+
+wpt_flow_field_t CWaypointFlowField::m_Fields[MAX_FLOW_FIELDS];
+
+void CWaypointFlowField :: reset ()
+{
+	for ( int i = 0; i < MAX_FLOW_FIELDS; i ++ )
+		m_Fields[i].iGoal = -1;
+}
+
+void CWaypointFlowField :: invalidate ()
+{
+	for ( int i = 0; i < MAX_FLOW_FIELDS; i ++ )
+		m_Fields[i].bStale = true;
+}
+
+int CWaypointFlowField :: numFields ()
+{
+	int iNum = 0;
+
+	for ( int i = 0; i < MAX_FLOW_FIELDS; i ++ )
+	{
+		if ( m_Fields[i].iGoal != -1 )
+			iNum++;
+	}
+
+	return iNum;
+}
+
+wpt_flow_field_t *CWaypointFlowField :: findField ( int iGoal, int iTeam )
+{
+	for ( int i = 0; i < MAX_FLOW_FIELDS; i ++ )
+	{
+		if ( (m_Fields[i].iGoal == iGoal) && (m_Fields[i].iTeam == iTeam) )
+			return &m_Fields[i];
+	}
+
+	return NULL;
+}
+
+void CWaypointFlowField :: setObjectives ( int iTeam, CWaypointBits *pGoals )
+{
+	int i;
+
+	// drop goals that aren't objectives any more
+	for ( i = 0; i < MAX_FLOW_FIELDS; i ++ )
+	{
+		if ( (m_Fields[i].iGoal != -1) && (m_Fields[i].iTeam == iTeam) && !pGoals->get(m_Fields[i].iGoal) )
+			m_Fields[i].iGoal = -1;
+	}
+
+	for ( i = pGoals->next(0); i != -1; i = pGoals->next(i+1) )
+	{
+		wpt_flow_field_t *pField = findField(i,iTeam);
+
+		if ( pField == NULL )
+		{
+			for ( int j = 0; (pField == NULL) && (j < MAX_FLOW_FIELDS); j ++ )
+			{
+				if ( m_Fields[j].iGoal == -1 )
+					pField = &m_Fields[j];
+			}
+
+			// bots will search for the rest themselves
+			if ( pField == NULL )
+				break;
+
+			pField->iGoal = i;
+			pField->iTeam = iTeam;
+		}
+
+		build(pField);
+	}
+}
+
+// dijkstra from the goal along the paths leading into each waypoint
+void CWaypointFlowField :: build ( wpt_flow_field_t *pField )
+{
+	flow_search_queue_t open;
+	CBotMod *pMod = CBotGlobals::getCurrentMod();
+	CWaypoint *pWpt;
+	register short int i;
+
+	pField->iNext.assign(CWaypoints::numWaypoints(),-1);
+	pField->fDistance.assign(CWaypoints::numWaypoints(),FLT_MAX);
+
+	pField->bStale = false;
+
+	if ( CWaypoints::getWaypoint(pField->iGoal) == NULL )
+		return;
+
+	pField->iNext[pField->iGoal] = pField->iGoal;
+	pField->fDistance[pField->iGoal] = 0;
+	open.push(flow_search_node_t(0.0f,pField->iGoal));
+
+	while ( !open.empty() )
+	{
+		flow_search_node_t node = open.top();
+		int iNumPaths;
+
+		open.pop();
+
+		if ( node.first > pField->fDistance[node.second] )
+			continue;
+
+		pWpt = CWaypoints::getWaypoint(node.second);
+		iNumPaths = pWpt->numPathsToThisWaypoint();
+
+		for ( i = 0; i < iNumPaths; i ++ )
+		{
+			int iPrev = pWpt->getPathToThisWaypoint(i);
+			CWaypoint *pPrev = CWaypoints::getWaypoint(iPrev);
+			float fCost;
+
+			// the team parts of CBot::canGotoWaypoint, each bot checks
+			// the rest when it follows the field
+			if ( !pPrev->isUsed() || pPrev->hasFlag(CWaypointTypes::W_FL_UNREACHABLE) || !pPrev->forTeam(pField->iTeam) )
+				continue;
+			if ( pPrev->hasFlag(CWaypointTypes::W_FL_AREAONLY) && !pMod->isWaypointAreaValid(pPrev->getArea(),pPrev->getFlags()) )
+				continue;
+
+			if ( pPrev->hasFlag(CWaypointTypes::W_FL_TELEPORT_CHEAT) )
+				fCost = node.first;
+			else
+				fCost = node.first + pPrev->distanceFrom(pWpt->getOrigin());
+
+			if ( fCost < pField->fDistance[iPrev] )
+			{
+				pField->fDistance[iPrev] = fCost;
+				pField->iNext[iPrev] = node.second;
+				open.push(flow_search_node_t(fCost,iPrev));
+			}
+		}
+	}
+}
+
+bool CWaypointFlowField :: getRoute ( int iFrom, int iGoal, int iTeam, WaypointList *pRoute, float *fDistance )
+{
+	wpt_flow_field_t *pField;
+	int iCurrent;
+	int iLoops = 0;
+
+	if ( (iFrom == iGoal) || (iFrom < 0) )
+		return false;
+
+	pField = findField(iGoal,iTeam);
+
+	if ( pField == NULL )
+		return false;
+
+	if ( pField->bStale )
+		build(pField);
+
+	if ( (iFrom >= (int)pField->iNext.size()) || (pField->iNext[iFrom] == -1) )
+		return false;
+
+	*fDistance = 0;
+
+	iCurrent = iFrom;
+
+	while ( iCurrent != iGoal )
+	{
+		int iNext = pField->iNext[iCurrent];
+
+		if ( (iNext == -1) || (++iLoops > CWaypoints::numWaypoints()) )
+		{
+			pRoute->clear();
+			return false;
+		}
+
+		*fDistance += CWaypoints::getWaypoint(iNext)->distanceFrom(CWaypoints::getWaypoint(iCurrent)->getOrigin());
+		pRoute->push_back(iNext);
+		iCurrent = iNext;
+	}
+
+	return true;
+}
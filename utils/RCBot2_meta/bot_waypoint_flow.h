@@ -0,0 +1,75 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#ifndef __RCBOT_WAYPOINT_FLOW_H__
+#define __RCBOT_WAYPOINT_FLOW_H__
+
+#include "bot_waypoint.h"
+
+// objective goal waypoints with a flow field, shared by all teams
+#define MAX_FLOW_FIELDS 32
+
+typedef struct
+{
+	int iGoal; // -1 if the slot is free
+	int iTeam;
+	bool bStale; // waypoints changed since it was built
+	std::vector<short int> iNext; // next waypoint towards the goal, -1 if it can't get there
+	std::vector<float> fDistance; // route distance to the goal, one per waypoint in use
+}wpt_flow_field_t;
+
+// next waypoint towards each objective goal from every waypoint, one field
+// per team and goal. Fields are rebuilt when the objectives change so bots
+// heading for an objective follow the field instead of running A*
+class CWaypointFlowField
+{
+public:
+	static void reset ();
+
+	// paths or waypoints changed, fields are rebuilt when next used
+	static void invalidate ();
+
+	// the goal waypoints of iTeam's objectives changed : keep a field for
+	// each of them and rebuild the lot as waypoint areas may have opened
+	static void setObjectives ( int iTeam, CWaypointBits *pGoals );
+
+	// route from iFrom to iGoal, not including iFrom, false if there's no field for it
+	static bool getRoute ( int iFrom, int iGoal, int iTeam, WaypointList *pRoute, float *fDistance );
+
+	static int numFields ();
+
+private:
+	static wpt_flow_field_t *findField ( int iGoal, int iTeam );
+	static void build ( wpt_flow_field_t *pField );
+
+	static wpt_flow_field_t m_Fields[MAX_FLOW_FIELDS];
+};
+
+#endif
@@ -0,0 +1,423 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#include "engine_wrappers.h"
+
+#include "bot.h"
+#include "bot_cvars.h"
+#include "bot_globals.h"
+#include "bot_fortress.h"
+#include "bot_dod_bot.h"
+#include "bot_waypoint.h"
+#include "bot_waypoint_visibility.h"
+#include "bot_waypoint_indirect.h"
+#include "bot_persist.h"
+
+#include <math.h>
+
+typedef struct
+{
+	float fSpeed;
+	float fGravity; // fraction of sv_gravity, 0 flies straight
+	float fMaxRange;
+}wpt_indirect_projectile_t;
+
+static const wpt_indirect_projectile_t g_IndirectProjectiles[INDIRECT_MAX] =
+{
+	{ TF2_GRENADESPEED, 1.0f, TF2_STICKYGRENADE_MAX_DISTANCE },
+	{ WPT_INDIRECT_GRENADE_SPEED, 1.0f, MAX_GREN_THROW_DIST }
+};
+
+std::vector<wpt_indirect_spot_t> CWaypointIndirectFire::m_Spots;
+bool CWaypointIndirectFire::m_bReady = false;
+int CWaypointIndirectFire::m_iNextTarget = 0;
+unsigned int CWaypointIndirectFire::m_iRevision = 0;
+float CWaypointIndirectFire::m_fGravity = 800.0f;
+
+void CWaypointIndirectFire :: reset ()
+{
+	std::vector<wpt_indirect_spot_t>().swap(m_Spots);
+	m_bReady = false;
+	m_iNextTarget = 0;
+	m_iRevision = 0;
+}
+
+float CWaypointIndirectFire :: gravity ()
+{
+	return sv_gravity.IsValid() ? sv_gravity.GetFloat() : 800.0f;
+}
+
+bool CWaypointIndirectFire :: arcLift ( const Vector &vFrom, const Vector &vTo, int iProjectile, float *fLift )
+{
+	const wpt_indirect_projectile_t *pProjectile = &g_IndirectProjectiles[iProjectile];
+	Vector vComp = vTo - vFrom;
+	float x = vComp.Length2D();
+	float y = vComp.z;
+	float g, v2, fDisc;
+
+	if ( vComp.Length() > pProjectile->fMaxRange )
+		return false;
+
+	if ( (pProjectile->fGravity == 0) || (x < 1.0f) )
+	{
+		*fLift = 0;
+		return true;
+	}
+
+	g = gravity() * pProjectile->fGravity;
+	v2 = pProjectile->fSpeed * pProjectile->fSpeed;
+	fDisc = (v2*v2) - (g*((g*x*x)+(2*y*v2)));
+
+	if ( fDisc < 0 )
+		return false;
+
+	// low arc : height above the aim point to look at is x * tan(angle) - y
+	*fLift = ((v2 - sqrt(fDisc))/g) - y;
+
+	return true;
+}
+
+// keeps the best WPT_INDIRECT_MAX_SPOTS launch spots for each projectile : the
+// nearer the aim waypoint is to the target the better, and launch spots close
+// to the aim waypoint are a little better
+int CWaypointIndirectFire :: buildTarget ( int iTarget )
+{
+	CWaypointVisibilityTable *pTable = CWaypoints::getVisiblity();
+	CWaypoint *pTarget = CWaypoints::getWaypoint(iTarget);
+	CWaypointBits targetVis;
+	CWaypointBits aimVis;
+	int iAims[WPT_INDIRECT_MAX_AIMS];
+	float fAimDist[WPT_INDIRECT_MAX_AIMS];
+	float fScores[INDIRECT_MAX][WPT_INDIRECT_MAX_SPOTS];
+	int iNumAims = 0;
+	int iTicks = 1;
+	int i, j, k;
+
+	if ( !pTarget->isUsed() )
+		return iTicks;
+
+	pTable->GetVisibleFrom(iTarget,&targetVis);
+
+	for ( i = targetVis.next(0); i != -1; i = targetVis.next(i+1) )
+	{
+		CWaypoint *pAim = CWaypoints::getWaypoint(i);
+		float fDist;
+
+		iTicks++;
+
+		if ( (i == iTarget) || !pAim->isUsed() )
+			continue;
+
+		fDist = pTarget->distanceFrom(pAim->getOrigin());
+
+		if ( fDist > WPT_INDIRECT_AIM_RANGE )
+			continue;
+
+		// insertion sort, nearest first
+		for ( j = iNumAims; (j > 0) && (fAimDist[j-1] > fDist); j -- )
+		{
+			if ( j < WPT_INDIRECT_MAX_AIMS )
+			{
+				iAims[j] = iAims[j-1];
+				fAimDist[j] = fAimDist[j-1];
+			}
+		}
+
+		if ( j < WPT_INDIRECT_MAX_AIMS )
+		{
+			iAims[j] = i;
+			fAimDist[j] = fDist;
+
+			if ( iNumAims < WPT_INDIRECT_MAX_AIMS )
+				iNumAims++;
+		}
+	}
+
+	for ( i = 0; i < iNumAims; i ++ )
+	{
+		CWaypoint *pAim = CWaypoints::getWaypoint(iAims[i]);
+
+		pTable->GetVisibleFrom(iAims[i],&aimVis);
+
+		for ( j = aimVis.next(0); j != -1; j = aimVis.next(j+1) )
+		{
+			CWaypoint *pLaunch = CWaypoints::getWaypoint(j);
+			float fRange;
+
+			iTicks++;
+
+			// must stay hidden from the target
+			if ( (j == iTarget) || (j == iAims[i]) || targetVis.get(j) )
+				continue;
+
+			if ( !pLaunch->isUsed() || pLaunch->hasFlag(CWaypointTypes::W_FL_UNREACHABLE) )
+				continue;
+
+			fRange = pLaunch->distanceFrom(pAim->getOrigin());
+
+			if ( fRange < WPT_INDIRECT_MIN_RANGE )
+				continue;
+
+			for ( int iProjectile = 0; iProjectile < INDIRECT_MAX; iProjectile ++ )
+			{
+				wpt_indirect_spot_t *pSpots = getSpots(iTarget,iProjectile);
+				float fScore = fAimDist[i] + (fRange*0.5f);
+				float fLift;
+				int iSlot = -1;
+
+				if ( !arcLift(pLaunch->getOrigin(),pAim->getOrigin(),iProjectile,&fLift) )
+					continue;
+
+				// one spot per launch waypoint, keeping the better of the two
+				for ( k = 0; k < WPT_INDIRECT_MAX_SPOTS; k ++ )
+				{
+					if ( pSpots[k].iLaunch == j )
+					{
+						iSlot = k;
+						break;
+					}
+				}
+
+				if ( iSlot != -1 )
+				{
+					if ( fScore >= fScores[iProjectile][iSlot] )
+						continue;
+				}
+				else
+				{
+					// a free slot, or the worst spot if this one is better
+					for ( k = 0; k < WPT_INDIRECT_MAX_SPOTS; k ++ )
+					{
+						if ( pSpots[k].iLaunch == -1 )
+						{
+							iSlot = k;
+							break;
+						}
+						else if ( (iSlot == -1) || (fScores[iProjectile][k] > fScores[iProjectile][iSlot]) )
+							iSlot = k;
+					}
+
+					if ( (pSpots[iSlot].iLaunch != -1) && (fScores[iProjectile][iSlot] <= fScore) )
+						continue;
+				}
+
+				pSpots[iSlot].iLaunch = j;
+				pSpots[iSlot].iAim = iAims[i];
+				pSpots[iSlot].iLift = (short int)MAX(-32000.0f,MIN(32000.0f,fLift));
+				fScores[iProjectile][iSlot] = fScore;
+			}
+		}
+	}
+
+	return iTicks;
+}
+
+void CWaypointIndirectFire :: work ()
+{
+	int iNumWaypoints = CWaypoints::numWaypoints();
+	int iTicks = 0;
+
+	// waypoints changed : start again
+	if ( (m_bReady || (m_iNextTarget > 0)) && (m_iRevision != CWaypoints::revision()) )
+	{
+		m_bReady = false;
+		m_iNextTarget = 0;
+	}
+
+	if ( m_bReady || (iNumWaypoints == 0) || (CWaypoints::getVisiblity() == NULL) || CWaypoints::getVisiblity()->needToWorkVisibility() )
+		return;
+
+	if ( m_iNextTarget == 0 )
+	{
+		wpt_indirect_spot_t empty;
+
+		empty.iLaunch = -1;
+		empty.iAim = -1;
+		empty.iLift = WPT_INDIRECT_NO_ARC;
+
+		m_Spots.assign(iNumWaypoints*INDIRECT_MAX*WPT_INDIRECT_MAX_SPOTS,empty);
+		m_iRevision = CWaypoints::revision();
+		m_fGravity = gravity();
+	}
+
+	while ( (m_iNextTarget < iNumWaypoints) && (iTicks < WPT_INDIRECT_TICKS) )
+		iTicks += buildTarget(m_iNextTarget++);
+
+	if ( m_iNextTarget >= iNumWaypoints )
+	{
+		m_iNextTarget = 0;
+		m_bReady = true;
+
+		if ( save() )
+			Msg(" *** saved indirect fire spots ***\n");
+	}
+}
+
+bool CWaypointIndirectFire :: getSpot ( int iTarget, int iProjectile, CBot *pBot, const Vector &vFrom, int *iLaunch, int *iAim, float *fLift )
+{
+	float fNearest = 0;
+	bool bFound = false;
+
+	if ( !isReady() || !CWaypoints::validWaypointIndex(iTarget) )
+		return false;
+
+	for ( int iType = 0; iType < INDIRECT_MAX; iType ++ )
+	{
+		wpt_indirect_spot_t *pSpots;
+
+		if ( (iProjectile != -1) && (iType != iProjectile) )
+			continue;
+
+		pSpots = getSpots(iTarget,iType);
+
+		for ( int k = 0; k < WPT_INDIRECT_MAX_SPOTS; k ++ )
+		{
+			CWaypoint *pLaunch = CWaypoints::getWaypoint(pSpots[k].iLaunch);
+			CWaypoint *pAim = CWaypoints::getWaypoint(pSpots[k].iAim);
+			float fDist;
+
+			if ( (pLaunch == NULL) || (pAim == NULL) )
+				continue;
+
+			if ( pBot && !pBot->canGotoWaypoint(pLaunch->getOrigin(),pLaunch) )
+				continue;
+
+			fDist = pLaunch->distanceFrom(vFrom) + pLaunch->distanceFrom(pAim->getOrigin());
+
+			if ( !bFound || (fDist < fNearest) )
+			{
+				*iLaunch = pSpots[k].iLaunch;
+				*iAim = pSpots[k].iAim;
+				*fLift = (float)pSpots[k].iLift;
+				fNearest = fDist;
+				bFound = true;
+			}
+		}
+	}
+
+	return bFound;
+}
+
+bool CWaypointIndirectFire :: getArc ( int iLaunch, int iTarget, int iProjectile, Vector *vAim )
+{
+	wpt_indirect_spot_t *pSpots;
+
+	if ( !isReady() || !CWaypoints::validWaypointIndex(iTarget) )
+		return false;
+
+	pSpots = getSpots(iTarget,iProjectile);
+
+	for ( int k = 0; k < WPT_INDIRECT_MAX_SPOTS; k ++ )
+	{
+		if ( (pSpots[k].iLaunch == iLaunch) && (iLaunch != -1) )
+		{
+			*vAim = CWaypoints::getWaypoint(pSpots[k].iAim)->getOrigin() + Vector(0,0,pSpots[k].iLift);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+void CWaypointIndirectFire :: load ()
+{
+	char filename[1024];
+	char *szMapName = CBotGlobals::getMapName();
+	wpt_indirect_hdr_t hdr;
+	FILE *bfp;
+	int iNumWaypoints = CWaypoints::numWaypoints();
+	size_t iNumSpots = iNumWaypoints*INDIRECT_MAX*WPT_INDIRECT_MAX_SPOTS;
+
+	reset();
+
+	if ( (szMapName == NULL) || !*szMapName )
+		return;
+
+	CBotGlobals::buildFileName(filename,szMapName,BOT_WAYPOINT_FOLDER,BOT_WAYPOINT_INDIRECT_EXTENSION,true);
+	CBotPersist::wait(filename);
+
+	bfp = CBotGlobals::openFile(filename,"rb");
+
+	if ( bfp == NULL )
+		return; // worked out again
+
+	// waypoints or gravity changed since : worked out again
+	if ( (fread(&hdr,sizeof(wpt_indirect_hdr_t),1,bfp) == 1) && (hdr.version == WPT_INDIRECT_VER) &&
+		(hdr.numwaypoints == iNumWaypoints) && (fabs(hdr.gravity - gravity()) < 1.0f) )
+	{
+		m_Spots.resize(iNumSpots);
+
+		if ( (iNumSpots > 0) && (fread(&m_Spots[0],sizeof(wpt_indirect_spot_t),iNumSpots,bfp) == iNumSpots) )
+		{
+			m_bReady = true;
+
+			for ( size_t i = 0; m_bReady && (i < iNumSpots); i ++ )
+			{
+				m_bReady = (m_Spots[i].iLaunch < iNumWaypoints) && (m_Spots[i].iAim < iNumWaypoints) &&
+					((m_Spots[i].iLaunch == -1) || (m_Spots[i].iAim >= 0));
+			}
+		}
+
+		if ( m_bReady )
+		{
+			m_iRevision = CWaypoints::revision();
+			m_fGravity = hdr.gravity;
+		}
+		else
+			m_Spots.clear();
+	}
+
+	fclose(bfp);
+}
+
+bool CWaypointIndirectFire :: save ()
+{
+	char filename[1024];
+	char *szMapName = CBotGlobals::getMapName();
+	wpt_indirect_hdr_t hdr;
+	CBotSaveBuffer buffer;
+
+	if ( !isReady() || m_Spots.empty() || (szMapName == NULL) || !*szMapName )
+		return false;
+
+	CBotGlobals::buildFileName(filename,szMapName,BOT_WAYPOINT_FOLDER,BOT_WAYPOINT_INDIRECT_EXTENSION,true);
+
+	hdr.version = WPT_INDIRECT_VER;
+	hdr.numwaypoints = CWaypoints::numWaypoints();
+	hdr.gravity = m_fGravity;
+
+	buffer.reserve(sizeof(wpt_indirect_hdr_t) + (m_Spots.size()*sizeof(wpt_indirect_spot_t)));
+	buffer.write(&hdr,sizeof(wpt_indirect_hdr_t),1);
+	buffer.write(&m_Spots[0],sizeof(wpt_indirect_spot_t),m_Spots.size());
+
+	CBotPersist::save(filename,buffer);
+
+	return true;
+}
@@ -0,0 +1,118 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#ifndef __RCBOT_WAYPOINT_INDIRECT_H__
+#define __RCBOT_WAYPOINT_INDIRECT_H__
+
+#include <vector>
+
+#include "bot_waypoint.h"
+
+#define BOT_WAYPOINT_INDIRECT_EXTENSION "rci"
+#define WPT_INDIRECT_VER 0x02
+
+// launch spots kept for each target waypoint and projectile
+#define WPT_INDIRECT_MAX_SPOTS 4
+// waypoints near the target to land shots on, nearest first
+#define WPT_INDIRECT_MAX_AIMS 8
+#define WPT_INDIRECT_AIM_RANGE 512.0f
+#define WPT_INDIRECT_MIN_RANGE 128.0f
+// candidate launch spots looked at per frame while the table is built
+#define WPT_INDIRECT_TICKS 8192
+// thrown DOD grenades land about MAX_GREN_THROW_DIST away at most
+#define WPT_INDIRECT_GRENADE_SPEED 900.0f
+// no arc from the launch spot reaches the aim waypoint
+#define WPT_INDIRECT_NO_ARC -32768
+
+enum
+{
+	INDIRECT_PIPE = 0, // TF2 grenade and sticky launchers
+	INDIRECT_GRENADE, // DOD hand grenades
+	INDIRECT_MAX
+};
+
+typedef struct
+{
+	int version;
+	int numwaypoints;
+	float gravity;
+}wpt_indirect_hdr_t;
+
+typedef struct
+{
+	short int iLaunch; // can't be seen from the target, -1 if unused
+	short int iAim; // seen from both the target and the launch spot
+	short int iLift; // aim this far above iAim from iLaunch to land there
+}wpt_indirect_spot_t;
+
+// hidden launch spots for lobbing or bouncing projectiles onto each
+// waypoint, worked out from the visibility table a few targets a frame
+// and saved with the waypoints, so finding where to shell an enemy from
+// is one lookup instead of searching the waypoints around it
+class CWaypointIndirectFire
+{
+public:
+	static void reset ();
+
+	static void load ();
+	static bool save ();
+
+	// builds the table once visibility is known, called every frame
+	static void work ();
+
+	static inline bool isReady () { return m_bReady && (m_iRevision == CWaypoints::revision()); }
+
+	// best launch spot for shooting at iTarget, nearest vFrom and reachable for pBot
+	// (if not NULL). iProjectile is one of INDIRECT_* or -1 for any
+	static bool getSpot ( int iTarget, int iProjectile, CBot *pBot, const Vector &vFrom, int *iLaunch, int *iAim, float *fLift );
+
+	// where to aim from iLaunch to land on iTarget, false if iLaunch isn't one of its launch spots
+	static bool getArc ( int iLaunch, int iTarget, int iProjectile, Vector *vAim );
+
+	// how far above vTo to aim from vFrom for the low arc onto vTo, false if out of reach
+	static bool arcLift ( const Vector &vFrom, const Vector &vTo, int iProjectile, float *fLift );
+
+private:
+	static int buildTarget ( int iTarget );
+	static float gravity ();
+
+	static inline wpt_indirect_spot_t *getSpots ( int iTarget, int iProjectile )
+	{
+		return &m_Spots[((iTarget*INDIRECT_MAX)+iProjectile)*WPT_INDIRECT_MAX_SPOTS];
+	}
+
+	static std::vector<wpt_indirect_spot_t> m_Spots;
+	static bool m_bReady;
+	static int m_iNextTarget; // building if above zero
+	static unsigned int m_iRevision; // CWaypoints::revision() the table is for
+	static float m_fGravity;
+};
+
+#endif
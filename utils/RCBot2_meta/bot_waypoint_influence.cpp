@@ -0,0 +1,261 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#include "engine_wrappers.h"
+
+#include "iplayerinfo.h"
+
+#include "bot.h"
+#include "bot_cvars.h"
+#include "bot_globals.h"
+#include "bot_navigator.h"
+#include "bot_waypoint.h"
+#include "bot_waypoint_influence.h"
+#include "bot_waypoint_locations.h"
+#include "bot_waypoint_visibility.h"
+#include "bot_getprop.h"
+#include "bot_fortress.h"
+
+enum
+{
+	INFLUENCE_SENTRY = 0,
+	INFLUENCE_SNIPER,
+	INFLUENCE_PLAYER,
+	INFLUENCE_SENTRY_COVER,
+	INFLUENCE_SNIPER_SIGHT
+};
+
+std::vector<wpt_influence_t> CWaypointInfluence::m_Influence[INFLUENCE_MAX_TEAMS];
+float CWaypointInfluence::m_fNextUpdate = 0;
+bool CWaypointInfluence::m_bHasInfluence = false;
+
+void CWaypointInfluence :: reset ()
+{
+	for ( int i = 0; i < INFLUENCE_MAX_TEAMS; i ++ )
+		m_Influence[i].clear();
+
+	m_fNextUpdate = 0;
+	m_bHasInfluence = false;
+}
+
+void CWaypointInfluence :: update ()
+{
+	float fInterval = rcbot_influence_time.GetFloat();
+	bool bTF2 = CBotGlobals::isMod(MOD_TF2);
+
+	if ( fInterval <= 0.0f )
+	{
+		if ( m_bHasInfluence )
+			reset();
+
+		return;
+	}
+
+	if ( m_fNextUpdate > engine->Time() )
+		return;
+
+	m_fNextUpdate = engine->Time() + fInterval;
+
+	for ( int i = 0; i < INFLUENCE_MAX_TEAMS; i ++ )
+	{
+		m_Influence[i].resize(CWaypoints::numWaypoints());
+
+		if ( !m_Influence[i].empty() )
+			memset(&m_Influence[i][0],0,sizeof(wpt_influence_t)*m_Influence[i].size());
+	}
+
+	m_bHasInfluence = true;
+
+	if ( CWaypoints::numWaypoints() == 0 )
+		return;
+
+	for ( register short int i = 1; i <= gpGlobals->maxClients; i ++ )
+	{
+		edict_t *pPlayer = INDEXENT(i);
+		IPlayerInfo *p;
+		Vector vOrigin;
+		int iTeam;
+
+		if ( (pPlayer == NULL) || pPlayer->IsFree() )
+			continue;
+
+		if ( bTF2 )
+		{
+			edict_t *pSentry = CTeamFortress2Mod::getSentryGun(i-1);
+
+			if ( pSentry != NULL )
+			{
+				Vector vSentry = CBotGlobals::entityOrigin(pSentry);
+				int iSentryTeam = CClassInterface::getTeam(pSentry);
+
+				addNear(vSentry,iSentryTeam,INFLUENCE_SENTRY);
+				addSight(vSentry,TF2_MAX_SENTRYGUN_RANGE,iSentryTeam,INFLUENCE_SENTRY_COVER);
+			}
+		}
+
+		p = playerinfomanager->GetPlayerInfo(pPlayer);
+
+		if ( !p || !p->IsConnected() || p->IsDead() || p->IsObserver() )
+			continue;
+
+		iTeam = CClassInterface::getTeam(pPlayer);
+		vOrigin = CBotGlobals::entityOrigin(pPlayer);
+
+		addNear(vOrigin,iTeam,INFLUENCE_PLAYER);
+
+		if ( bTF2 && (CClassInterface::getTF2Class(pPlayer) == TF_CLASS_SNIPER) )
+		{
+			addNear(vOrigin,iTeam,INFLUENCE_SNIPER);
+			addSight(vOrigin,INFLUENCE_SNIPER_DIST,iTeam,INFLUENCE_SNIPER_SIGHT);
+		}
+	}
+}
+
+void CWaypointInfluence :: add ( int iWpt, int iTeam, int iType )
+{
+	int iSlots[2] = { 0, iTeam };
+	int iNumSlots = ((iTeam > 0) && (iTeam < INFLUENCE_MAX_TEAMS)) ? 2 : 1;
+
+	if ( (iWpt < 0) || (iWpt >= (int)m_Influence[0].size()) )
+		return;
+
+	for ( int i = 0; i < iNumSlots; i ++ )
+	{
+		wpt_influence_t *pInfluence = &m_Influence[iSlots[i]][iWpt];
+		unsigned char *pCount;
+
+		switch ( iType )
+		{
+		case INFLUENCE_SENTRY:
+			pCount = &pInfluence->iSentries;
+			break;
+		case INFLUENCE_SNIPER:
+			pCount = &pInfluence->iSnipers;
+			break;
+		case INFLUENCE_PLAYER:
+			pCount = &pInfluence->iPlayers;
+			break;
+		case INFLUENCE_SENTRY_COVER:
+			pCount = &pInfluence->iSentryCover;
+			break;
+		default:
+			pCount = &pInfluence->iSniperSight;
+			break;
+		}
+
+		if ( *pCount < 255 )
+			(*pCount)++;
+	}
+}
+
+// waypoints within INFLUENCE_NEAR_DIST, the neighbouring location buckets are always big enough
+void CWaypointInfluence :: addNear ( const Vector &vOrigin, int iTeam, int iType )
+{
+	WaypointList nearby;
+	Vector vLoc = vOrigin;
+
+	CWaypointLocations::GetAllInArea(vLoc,&nearby,-1);
+
+	for ( size_t i = 0; i < nearby.size(); i ++ )
+	{
+		CWaypoint *pWpt = CWaypoints::getWaypoint(nearby[i]);
+
+		if ( (pWpt != NULL) && pWpt->isUsed() && (pWpt->distanceFrom(vOrigin) < INFLUENCE_NEAR_DIST) )
+			add(nearby[i],iTeam,iType);
+	}
+}
+
+// waypoints within fRange that the waypoint nearest vOrigin can see
+void CWaypointInfluence :: addSight ( const Vector &vOrigin, float fRange, int iTeam, int iType )
+{
+	CWaypointVisibilityTable *pVisTable = CWaypoints::getVisiblity();
+	int iFrom = CWaypointLocations::NearestWaypoint(vOrigin,INFLUENCE_NEAR_DIST*2,-1,true);
+	int iNumWaypoints = CWaypoints::numWaypoints();
+
+	if ( iFrom == -1 )
+		return;
+
+	for ( register short int i = 0; i < iNumWaypoints; i ++ )
+	{
+		CWaypoint *pWpt = CWaypoints::getWaypoint(i);
+
+		if ( !pWpt->isUsed() )
+			continue;
+
+		if ( (i != iFrom) && !pVisTable->GetVisibilityFromTo(iFrom,i) )
+			continue;
+
+		if ( pWpt->distanceFrom(vOrigin) < fRange )
+			add(i,iTeam,iType);
+	}
+}
+
+float CWaypointInfluence :: getGoalFactor ( int iWpt, int iSearchFlags, int iTeam )
+{
+	int iSlot = ((iTeam > 0) && (iTeam < INFLUENCE_MAX_TEAMS)) ? iTeam : 0;
+	int iCount = 0;
+	float fFactor = 1.0f;
+
+	if ( (iWpt < 0) || (iWpt >= (int)m_Influence[0].size()) )
+		return fFactor;
+
+	// any team's sentry gun
+	if ( iSearchFlags & WPT_SEARCH_AVOID_SENTRIES )
+		iCount += m_Influence[0][iWpt].iSentries;
+	if ( iSearchFlags & WPT_SEARCH_AVOID_SNIPERS )
+		iCount += m_Influence[iSlot][iWpt].iSnipers;
+	if ( iSearchFlags & WPT_SEARCH_AVOID_TEAMMATE )
+		iCount += m_Influence[iSlot][iWpt].iPlayers;
+
+	while ( iCount-- > 0 )
+		fFactor *= 0.1f;
+
+	return fFactor;
+}
+
+float CWaypointInfluence :: getThreat ( int iWpt, int iTeam )
+{
+	int iSentries, iSnipers;
+
+	if ( (iWpt < 0) || (iWpt >= (int)m_Influence[0].size()) )
+		return 0.0f;
+
+	iSentries = m_Influence[0][iWpt].iSentryCover;
+	iSnipers = m_Influence[0][iWpt].iSniperSight;
+
+	// leave out our own team
+	if ( (iTeam > 0) && (iTeam < INFLUENCE_MAX_TEAMS) )
+	{
+		iSentries -= m_Influence[iTeam][iWpt].iSentryCover;
+		iSnipers -= m_Influence[iTeam][iWpt].iSniperSight;
+	}
+
+	return (iSentries*INFLUENCE_SENTRY_COST) + (iSnipers*INFLUENCE_SNIPER_COST);
+}
@@ -0,0 +1,80 @@
+/*
+ *    This file is part of RCBot.
+ *
+ *    RCBot by Paul Murphy adapted from Botman's HPB Bot 2 template.
+ *
+ *    RCBot is free software; you can redistribute it and/or modify it
+ *    under the terms of the GNU General Public License as published by the
+ *    Free Software Foundation; either version 2 of the License, or (at
+ *    your option) any later version.
+ *
+ *    RCBot is distributed in the hope that it will be useful, but
+ *    WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *    General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with RCBot; if not, write to the Free Software Foundation,
+ *    Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+ *
+ *    In addition, as a special exception, the author gives permission to
+ *    link the code of this program with the Half-Life Game Engine ("HL
+ *    Engine") and Modified Game Libraries ("MODs") developed by Valve,
+ *    L.L.C ("Valve").  You must obey the GNU General Public License in all
+ *    respects for all of the code used other than the HL Engine and MODs
+ *    from Valve.  If you modify this file, you may extend this exception
+ *    to your version of the file, but you are not obligated to do so.  If
+ *    you do not wish to do so, delete this exception statement from your
+ *    version.
+ *
+ */
+#ifndef __RCBOT_WAYPOINT_INFLUENCE_H__
+#define __RCBOT_WAYPOINT_INFLUENCE_H__
+
+#include "bot_waypoint.h"
+
+// team slots, slot 0 counts every team
+#define INFLUENCE_MAX_TEAMS 4
+// sentry guns, snipers or players this close to a goal make it less likely to be picked
+#define INFLUENCE_NEAR_DIST 200.0f
+#define INFLUENCE_SNIPER_DIST 4096.0f
+// extra route cost for each enemy sentry or sniper that can see a waypoint
+#define INFLUENCE_SENTRY_COST 400.0f
+#define INFLUENCE_SNIPER_COST 200.0f
+
+typedef struct
+{
+	unsigned char iSentries; // sentry guns near the waypoint
+	unsigned char iSnipers; // snipers near the waypoint
+	unsigned char iPlayers; // players near the waypoint
+	unsigned char iSentryCover; // sentry guns that can see the waypoint
+	unsigned char iSniperSight; // snipers that can see the waypoint
+}wpt_influence_t;
+
+// per team sentry, sniper and player influence over waypoints, worked out
+// once every rcbot_influence_time seconds and read by goal selection and routing
+class CWaypointInfluence
+{
+public:
+	static void reset ();
+
+	static void update ();
+
+	// belief weight multiplier for a goal with WPT_SEARCH_AVOID_* flags
+	static float getGoalFactor ( int iWpt, int iSearchFlags, int iTeam );
+
+	// route cost from enemy sentry guns and snipers that can see the waypoint
+	static float getThreat ( int iWpt, int iTeam );
+
+private:
+	static void addNear ( const Vector &vOrigin, int iTeam, int iType );
+	static void addSight ( const Vector &vOrigin, float fRange, int iTeam, int iType );
+	static void add ( int iWpt, int iTeam, int iType );
+
+	// one per waypoint in use at the last update
+	static std::vector<wpt_influence_t> m_Influence[INFLUENCE_MAX_TEAMS];
+	static float m_fNextUpdate;
+	static bool m_bHasInfluence;
+};
+
+#endif
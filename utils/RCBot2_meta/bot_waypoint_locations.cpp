@@ -35,6 +35,7 @@
 #include "bot_waypoint.h"
 #include "bot_waypoint_visibility.h"
 #include "bot_waypoint_locations.h"
+#include "bot_waypoint_autopath.h"
 #include "bot_globals.h"
 
 #include <vector>    //bir3yk
@@ -50,7 +51,7 @@ bool CWaypointLocations :: m_bIgnoreBox = false;
 
 unsigned char *CWaypointLocations :: resetFailedWaypoints (WaypointList *iIgnoreWpts)
 {
-	Q_memset(g_iFailedWaypoints,0,sizeof(unsigned char)*CWaypoints::MAX_WAYPOINTS);
+	Q_memset(g_iFailedWaypoints,0,sizeof(unsigned char)*CWaypoints::numWaypoints());
 	
 	if ( iIgnoreWpts )
 	{   
@@ -166,55 +167,76 @@ void CWaypointLocations :: GetAllInArea ( Vector &vOrigin, WaypointList *pWaypoi
 }
 
 
+// waypoints in the location buckets around vOrigin
+void CWaypointLocations :: GetAreaBits ( const Vector &vOrigin, CWaypointBits *pBits )
+{
+	int iLoc = READ_LOC(vOrigin.x);
+	int jLoc = READ_LOC(vOrigin.y);
+	int kLoc = READ_LOC(vOrigin.z);
+
+	int iMinLoci,iMaxLoci,iMinLocj,iMaxLocj,iMinLock,iMaxLock;
+
+	pBits->clear();
+
+	getMinMaxs(iLoc,jLoc,kLoc,&iMinLoci,&iMinLocj,&iMinLock,&iMaxLoci,&iMaxLocj,&iMaxLock);
+
+	for (int i = iMinLoci; i <= iMaxLoci; i++ )
+	{
+		for (int j = iMinLocj; j <= iMaxLocj; j++ )
+		{
+			for (int k = iMinLock; k <= iMaxLock; k++ )
+			{
+				WaypointList &arr = m_iLocations[i][j][k];
+
+				for (size_t l = 0; l < arr.size(); l++)
+					pBits->set(arr[l]);
+			}
+		}
+	}
+}
+
 // @param iFrom waypoint number from a and b within distance
 void CWaypointLocations :: GetAllVisible ( int iFrom, int iOther, Vector &vOrigin, 
 										  Vector &vOther, float fEDist, WaypointList *iVisible, 
 										  WaypointList *iInvisible )
 {
 	CWaypoint *pWpt;
-	int iLoc = READ_LOC(vOrigin.x);
-	int jLoc = READ_LOC(vOrigin.y);
-	int kLoc = READ_LOC(vOrigin.z);
-
-	int i,j,k;
 	int iWpt;
 
-	int iMinLoci,iMaxLoci,iMinLocj,iMaxLocj,iMinLock,iMaxLock;
+	CWaypointBits area;
+	CWaypointBits visible;
+	CWaypointBits listed;
 
 	CWaypointVisibilityTable *pTable = CWaypoints::getVisiblity();
 	
 	if ( (iFrom == -1) || !pTable)
 		return;
 
-	getMinMaxs(iLoc,jLoc,kLoc,&iMinLoci,&iMinLocj,&iMinLock,&iMaxLoci,&iMaxLocj,&iMaxLock);
+	GetAreaBits(vOrigin,&area);
 
-	for ( i = iMinLoci; i <= iMaxLoci; i++ )
+	// iFrom should be the enemy waypoint
+	pTable->GetVisibleFrom(iFrom,&visible);
+
+	// already in the visible list
+	listed.clear();
+
+	for (size_t l = 0; l < iVisible->size(); l++)
 	{
-		for ( j = iMinLocj; j <= iMaxLocj; j++ )
-		{
-			for ( k = iMinLock; k <= iMaxLock; k++ )
-			{
-				auto &arr = m_iLocations[i][j][k];
-				for (size_t l = 0; l < m_iLocations[i][j][k].size(); l++)
-				{
-					iWpt = arr[l];
-					pWpt = CWaypoints::getWaypoint(iWpt);
+		if ( (*iVisible)[l] >= 0 )
+			listed.set((*iVisible)[l]);
+	}
 
-					//int iWpt = tempStack.ChooseFromStack();
-					
-					// within range only deal with these waypoints
-					if ( (pWpt->distanceFrom(vOrigin) < fEDist) && (pWpt->distanceFrom(vOther) < fEDist) )
-					{
-						// iFrom should be the enemy waypoint
-						if ( pTable->GetVisibilityFromTo(iFrom,iWpt) ) //|| pTable->GetVisibilityFromTo(iOther,iWpt) )
-						{   //CBotGlobals::isVisible(vVisibleFrom,CWaypoints::getWaypoint(iWpt)->getOrigin()) )
-							iVisible->push_back(iWpt);
-						}
-						else if (std::find(iVisible->begin(), iVisible->end(), iWpt) == iVisible->end())
-							iInvisible->push_back(iWpt);
-					}
-				}
-			}
+	for ( iWpt = area.next(0); iWpt != -1; iWpt = area.next(iWpt+1) )
+	{
+		pWpt = CWaypoints::getWaypoint(iWpt);
+
+		// within range only deal with these waypoints
+		if ( (pWpt->distanceFrom(vOrigin) < fEDist) && (pWpt->distanceFrom(vOther) < fEDist) )
+		{
+			if ( visible.get(iWpt) )
+				iVisible->push_back(iWpt);
+			else if ( !listed.get(iWpt) )
+				iInvisible->push_back(iWpt);
 		}
 	}
 }
@@ -229,10 +251,6 @@ void CWaypointLocations :: AutoPathInBucket ( edict_t *pPlayer, int i, int j, in
 	Vector vWptOrigin = pWpt->getOrigin();
 	Vector vOtherWptOrigin;
 
-	trace_t tr;
-
-	//CTraceFilterWorldOnly filter;
-
 	auto &arr = m_iLocations[i][j][k];
 	size_t size = arr.size();
 	
@@ -255,21 +273,9 @@ void CWaypointLocations :: AutoPathInBucket ( edict_t *pPlayer, int i, int j, in
 	//	if ( fabs(vOtherWptOrigin.z-vWptOrigin.z) > 128 )
 		//	continue;
 
+		// traced later by CWaypointAutoPath
 		if ( (vWptOrigin-vOtherWptOrigin).Length() <= bot_waypointpathdist.GetFloat() )
-		{
-			if ( CBotGlobals::isVisible(vWptOrigin,vOtherWptOrigin) )
-			{
-				if ( CBotGlobals::walkableFromTo(pPlayer, vWptOrigin,vOtherWptOrigin) )
-				{
-					pWpt->addPathTo(iWpt);			
-				}
-
-				if ( CBotGlobals::walkableFromTo(pPlayer,vOtherWptOrigin,vWptOrigin) )
-				{
-					pOtherWpt->addPathTo(iWptFrom);		
-				}
-			}
-		}
+			CWaypointAutoPath::addPair(iWptFrom,iWpt,CBotGlobals::walkableWidth(pPlayer));
 	}
 }
 
@@ -310,106 +316,60 @@ int CWaypointLocations :: GetCoverWaypoint ( Vector vPlayerOrigin, Vector vCover
 		return -1;
 
 	float fNearestDist = fMaxDist;
+	float fDist;
 	
 	int iNearestIndex = -1;
+	int iWpt;
+
+	CWaypointBits candidates;
+	CWaypointBits filter;
+	CWaypoint *pWpt;
 
-	int iLoc = READ_LOC(vPlayerOrigin.x);
-	int jLoc = READ_LOC(vPlayerOrigin.y);
-	int kLoc = READ_LOC(vPlayerOrigin.z);
+	// used waypoints near the player that can't be seen from the cover waypoint
+	GetAreaBits(vPlayerOrigin,&candidates);
 
-	int i,j,k;
+	CWaypoints::getFlaggedBits(&filter,-1);
+	candidates.andWith(filter);
 
-	int iMinLoci,iMaxLoci,iMinLocj,iMaxLocj,iMinLock,iMaxLock;
+	CWaypoints::getVisiblity()->GetVisibleFrom(iWaypoint,&filter);
+	candidates.andNotWith(filter);
 
-	getMinMaxs(iLoc,jLoc,kLoc,&iMinLoci,&iMinLocj,&iMinLock,&iMaxLoci,&iMaxLocj,&iMaxLock);
+	CWaypoints::getFlaggedBits(&filter,CWaypointTypes::W_FL_UNREACHABLE,true);
+	candidates.andNotWith(filter);
+
+	candidates.reset(iWaypoint);
 
-	Q_memset(g_iFailedWaypoints,0,sizeof(unsigned char)*CWaypoints::MAX_WAYPOINTS);
-	
 	if ( iIgnoreWpts )
 	{   
-		//dataStack<int> ignoreWptStack = *iIgnoreWpts;
-		int iWpt;
-		
-		//while ( !ignoreWptStack.IsEmpty() )
 		for (size_t l = 0; l < iIgnoreWpts->size(); l++)
 		{
 			if ( (iWpt = (*iIgnoreWpts)[l]) != -1 )
-				g_iFailedWaypoints[iWpt] = 1;
+				candidates.reset(iWpt);
 		}
 	}
 
-	for ( i = iMinLoci; i <= iMaxLoci; i++ )
-	{
-		for ( j = iMinLocj; j <= iMaxLocj; j++ )
-		{
-			for ( k = iMinLock; k <= iMaxLock; k++ )
-			{
-				// check each area around the current area
-				// for closer waypoints
-				FindNearestCoverWaypointInBucket(i,j,k,vPlayerOrigin,&fNearestDist,&iNearestIndex,iIgnoreWpts,iWaypoint,vGoalOrigin,iTeam,fMinDist);
-			}
-		}
-	}
-
-	return iNearestIndex;
-}
-
-void CWaypointLocations :: FindNearestCoverWaypointInBucket ( int i, int j, int k, 
-															 const Vector &vOrigin, float *pfMinDist, 
-															 int *piIndex, 
-															 WaypointList *iIgnoreWpts, 
-															 int iCoverFromWpt, Vector *vGoalOrigin, 
-															 int iTeam, float fMinDist )
-// Search for the nearest waypoint : I.e.
-// Find the waypoint that is closest to vOrigin from the distance pfMinDist
-// And set the piIndex to the waypoint index if closer.
-{
-	//dataStack <int> tempStack = m_iLocations[i][j][k];
-	
-	CWaypoint *curr_wpt;
-	int iSelectedIndex;
-	float fDist;
-	WaypointList &arr = m_iLocations[i][j][k];
-	size_t size = arr.size();
-	//CBotMod *curmod = CBotGlobals::getCurrentMod();
-
-	for (size_t l = 0; l < size; l++)
-	//while ( !tempStack.IsEmpty() )
+	for ( iWpt = candidates.next(0); iWpt != -1; iWpt = candidates.next(iWpt+1) )
 	{
-		iSelectedIndex = arr[l];//tempStack.ChooseFromStack();
+		pWpt = CWaypoints::getWaypoint(iWpt);
 
-		if ( iCoverFromWpt == iSelectedIndex )
+	    if ( !pWpt->forTeam(iTeam) )
 			continue;
-		if ( g_iFailedWaypoints[iSelectedIndex] )
-		    continue;
 
-		curr_wpt = CWaypoints::getWaypoint(iSelectedIndex);
-
-		if ( !curr_wpt->isUsed() )
-			continue; 
-		if ( curr_wpt->hasFlag(CWaypointTypes::W_FL_UNREACHABLE) )
-			continue;
-	    if ( !curr_wpt->forTeam(iTeam) )
-		{
-			continue;
-		}
-		if ( CWaypoints::getVisiblity()->GetVisibilityFromTo(iCoverFromWpt,iSelectedIndex) )
-			continue;
-
-
-		(fDist = curr_wpt->distanceFrom(vOrigin));
+		fDist = pWpt->distanceFrom(vPlayerOrigin);
 
 		if ( vGoalOrigin != NULL )
 		{
-			fDist += curr_wpt->distanceFrom(*vGoalOrigin);
+			fDist += pWpt->distanceFrom(*vGoalOrigin);
 		}
 
-		if ( (fDist > fMinDist) && (fDist < *pfMinDist) )
+		if ( (fDist > fMinDist) && (fDist < fNearestDist) )
 		{
-			*piIndex = iSelectedIndex;
-			*pfMinDist = fDist;			
+			iNearestIndex = iWpt;
+			fNearestDist = fDist;			
 		}
 	}
+
+	return iNearestIndex;
 }
 
 ////////////////////////////////////
@@ -638,8 +598,9 @@ void CWaypointLocations :: FindNearestInBucket ( int i, int j, int k, const Vect
 				{
 					if ( pPlayer != NULL )
 					{
-						CBotGlobals::quickTraceline(pPlayer,vOrigin,curr_wpt->getOrigin());
-						bAdd = CBotGlobals::getTraceResult()->fraction>=1.0f;
+						trace_t tr;
+
+						bAdd = CBotGlobals::quickTraceline(pPlayer,vOrigin,curr_wpt->getOrigin(),&tr)>=1.0f;
 					}
 					else
 						bAdd = CBotGlobals::isVisible(vOrigin,curr_wpt->getOrigin());
@@ -682,7 +643,7 @@ int CWaypointLocations :: NearestWaypoint ( const Vector &vOrigin, float fNeares
 
 	if ( !bNearestAimingOnly )
 	{
-		Q_memset(g_iFailedWaypoints,0,sizeof(unsigned char)*CWaypoints::MAX_WAYPOINTS);
+		Q_memset(g_iFailedWaypoints,0,sizeof(unsigned char)*CWaypoints::numWaypoints());
 		
 		if ( iFailedWpts )
 		{   
@@ -730,31 +691,20 @@ int CWaypointLocations :: NearestWaypoint ( const Vector &vOrigin, float fNeares
 
 //////////////////////////////////
 // Draw waypoints around a player
-void CWaypointLocations :: DrawWaypoints ( CClient *pClient, float fDist )
+void CWaypointLocations :: GetDrawable ( CClient *pClient, const byte *pPvs, int iPvsSize, WaypointList *pList )
 {
-	static byte m_bPvs[MAX_MAP_CLUSTERS/8];
-	static int clusterIndex;
-	static short int size;
-	static int iWpt;
-	static CWaypoint *pWpt;
-	static Vector vWpt;
-	//static bool bDrawPaths;
-	static unsigned short int iDrawType;
-	static Vector vOrigin;
-	static edict_t *pEntity;
+	CWaypoint *pWpt;
+	Vector vWpt;
+	Vector vOrigin = pClient->getOrigin();
 
 	int iLoc = READ_LOC(vOrigin.x);
 	int jLoc = READ_LOC(vOrigin.y);
 	int kLoc = READ_LOC(vOrigin.z);
 
-	pEntity = pClient->getPlayer();
-	vOrigin = pClient->getOrigin();
-	//bDrawPaths = false;
-	iDrawType = pClient->getDrawType();
-
 	int iMinLoci,iMaxLoci,iMinLocj,iMaxLocj,iMinLock,iMaxLock;
 	getMinMaxs(iLoc,jLoc,kLoc,&iMinLoci,&iMinLocj,&iMinLock,&iMaxLoci,&iMaxLocj,&iMaxLock);
 
+	pList->clear();
 
 	for (int i = iMinLoci; i <= iMaxLoci; i++)
 	{
@@ -762,13 +712,11 @@ void CWaypointLocations :: DrawWaypoints ( CClient *pClient, float fDist )
 		{
 			for (int k = iMinLock; k <= iMaxLock; k++)
 			{
-				// TODO use a type alias for this
 				WaypointList &arr = m_iLocations[i][j][k];
+
 				for (size_t l = 0; l < arr.size(); l++)
 				{
-					iWpt = arr[l];
-
-					pWpt = CWaypoints::getWaypoint(iWpt);//tempStack.ChooseFromStack());
+					pWpt = CWaypoints::getWaypoint(arr[l]);
 
 					if ( !pWpt->isUsed() ) // deleted
 						continue;
@@ -783,20 +731,13 @@ void CWaypointLocations :: DrawWaypoints ( CClient *pClient, float fDist )
 
 					vWpt = pWpt->getOrigin();
 
-					if ( fabs(vWpt.z - vOrigin.z) <= 256.0 ) // also in z range
-					{
-						//if ( CBotGlobals::FInViewCone(pEntity) )
-						{
-							// from Valve developer community wiki
-							// http://developer.valvesoftware.com/wiki/Transforming_the_Multiplayer_SDK_into_Coop
-
-							clusterIndex = engine->GetClusterForOrigin( vOrigin );
-							engine->GetPVSForCluster( clusterIndex, sizeof(m_bPvs), m_bPvs );							
+					if ( fabs(vWpt.z - vOrigin.z) > 256.0 ) // also in z range
+						continue;
 
-							if ( engine->CheckOriginInPVS( vWpt, m_bPvs, sizeof( m_bPvs ) ) )
-								pWpt->draw(pEntity,pClient->isPathWaypointOn()&&(pClient->currentWaypoint()==iWpt),iDrawType);
-						}
-					}
+					// from Valve developer community wiki
+					// http://developer.valvesoftware.com/wiki/Transforming_the_Multiplayer_SDK_into_Coop
+					if ( engine->CheckOriginInPVS( vWpt, pPvs, iPvsSize ) )
+						pList->push_back(arr[l]);
 				}
 			}
 		}
@@ -114,14 +114,17 @@ public:
 									    int *iMinLoc, int *jMinLoc, int *kMinLoc,
 									    int *iMaxLoc, int *jMaxLoc, int *kMaxLoc );
 
+	// waypoints in the location buckets around vOrigin
+	static void GetAreaBits ( const Vector &vOrigin, CWaypointBits *pBits );
+
 	static int GetCoverWaypoint ( Vector vPlayerOrigin, Vector vCoverFrom, WaypointList *iIgnoreWpts, Vector *vGoalOrigin = NULL, int iTeam = 0, float fMinDist = MIN_COVER_MOVE_DIST, float fMaxDist = HALF_MAX_MAP_SIZE );
 
-	static void FindNearestCoverWaypointInBucket ( int i, int j, int k, const Vector &vOrigin, float *pfMinDist, int *piIndex, WaypointList *iIgnoreWpts, int iCoverFromWpt, Vector *vGoalOrigin = NULL, int iTeam = 0, float fMinDist = MIN_COVER_MOVE_DIST );
 
 	static void AddWptLocation ( int iIndex, const float *fOrigin );
 
 	static void FindNearestInBucket ( int i, int j, int k, const Vector &vOrigin, float *pfMinDist, int *piIndex,int iIgnoreWpt, bool bGetVisible = true, bool bGetUnreachable = false, bool bIsBot = false, WaypointList *iFailedWpts = NULL, bool bNearestAimingOnly = false, int iTeam = 0, bool bCheckArea = false, bool bGetVisibleFromOther = false, Vector vOther = Vector(0,0,0), int iFlagsOnly = 0, edict_t *pPlayer = NULL );
-	static void DrawWaypoints ( CClient *pClient, float fDist );
+	// waypoints around pClient it shows and pPvs can see, for CWaypointDrawList
+	static void GetDrawable ( CClient *pClient, const byte *pPvs, int iPvsSize, WaypointList *pList );
 	
 	static void DeleteWptLocation ( int iIndex, const float *fOrigin );
 	
@@ -135,6 +138,7 @@ public:
 
 	///////////
 
+	// queue pairs of iWpt and nearby waypoints with CWaypointAutoPath
 	static void AutoPath ( edict_t *pPlayer, int iWpt );
 
 	static void AutoPathInBucket ( edict_t *pPlayer, int i, int j, int k, int iWpt );
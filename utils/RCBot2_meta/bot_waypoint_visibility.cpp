@@ -34,6 +34,7 @@
 #include "bot_waypoint.h"
 #include "bot_waypoint_visibility.h"
 #include "bot_globals.h"
+#include "bot_persist.h"
 #include <stdio.h>
 
 /*unsigned char *CWaypointVisibilityTable :: m_VisTable = NULL;
@@ -150,40 +151,206 @@ void CWaypointVisibilityTable :: WorkOutVisibilityTable ()
 	}
 }
 
+void CWaypointVisibilityTable :: useBits ( wpt_vis_row_t *pRow )
+{
+	int iBytes = (CWaypoints::numWaypoints()>>3)+1;
+
+	if ( !pRow->visible.empty() && ((pRow->visible.back()>>3) >= iBytes) )
+		iBytes = (pRow->visible.back()>>3)+1;
+
+	pRow->bits.assign(iBytes,0);
+
+	for ( unsigned int i = 0; i < pRow->visible.size(); i ++ )
+		pRow->bits[pRow->visible[i]>>3] |= (1<<(pRow->visible[i]&7));
+
+	std::vector<unsigned short int>().swap(pRow->visible);
+}
+
+void CWaypointVisibilityTable :: SetVisibilityFromTo ( int iFrom, int iTo, bool bVisible )
+{
+	wpt_vis_row_t *pRow;
+
+	if ( (iFrom < 0) || (iTo < 0) || (iFrom >= CWaypoints::MAX_WAYPOINTS) || (iTo >= CWaypoints::MAX_WAYPOINTS) )
+		return;
+
+	if ( iFrom >= (int)m_Rows.size() )
+	{
+		if ( !bVisible )
+			return;
+
+		m_Rows.resize(iFrom+1);
+	}
+
+	pRow = &m_Rows[iFrom];
+
+	if ( !pRow->bits.empty() )
+	{
+		int iByte = iTo>>3;
+		unsigned char iBit = (1<<(iTo&7));
+
+		if ( iByte >= (int)pRow->bits.size() )
+		{
+			if ( !bVisible )
+				return;
+
+			pRow->bits.resize(iByte+1,0);
+		}
+
+		if ( bVisible && !(pRow->bits[iByte] & iBit) )
+		{
+			pRow->bits[iByte] |= iBit;
+			m_iNumPairs++;
+		}
+		else if ( !bVisible && (pRow->bits[iByte] & iBit) )
+		{
+			pRow->bits[iByte] &= ~iBit;
+			m_iNumPairs--;
+		}
+
+		return;
+	}
+
+	// rows are mostly worked out in order so this is usually the end
+	std::vector<unsigned short int>::iterator it = std::lower_bound(pRow->visible.begin(),pRow->visible.end(),(unsigned short int)iTo);
+	bool bListed = (it != pRow->visible.end()) && (*it == iTo);
+
+	if ( bVisible && !bListed )
+	{
+		pRow->visible.insert(it,(unsigned short int)iTo);
+		m_iNumPairs++;
+
+		if ( (pRow->visible.size()*sizeof(unsigned short int)) > (size_t)((CWaypoints::numWaypoints()>>3)+1) )
+			useBits(pRow);
+	}
+	else if ( !bVisible && bListed )
+	{
+		pRow->visible.erase(it);
+		m_iNumPairs--;
+	}
+}
+
+void CWaypointVisibilityTable :: GetVisibleFrom ( int iFrom, CWaypointBits *pBits )
+{
+	if ( (iFrom < 0) || (iFrom >= (int)m_Rows.size()) )
+	{
+		pBits->clear();
+		return;
+	}
+
+	wpt_vis_row_t *pRow = &m_Rows[iFrom];
+
+	if ( !pRow->bits.empty() )
+		pBits->fromBytes(&pRow->bits[0],pRow->bits.size());
+	else
+	{
+		pBits->clear();
+
+		for ( unsigned int i = 0; i < pRow->visible.size(); i ++ )
+			pBits->set(pRow->visible[i]);
+	}
+}
+
+unsigned int CWaypointVisibilityTable :: memoryUsed ()
+{
+	unsigned int iBytes = m_Rows.capacity()*sizeof(wpt_vis_row_t);
+
+	for ( unsigned int i = 0; i < m_Rows.size(); i ++ )
+		iBytes += (m_Rows[i].visible.capacity()*sizeof(unsigned short int)) + m_Rows[i].bits.capacity();
+
+	return iBytes;
+}
+
+// sparse file : per waypoint the number it can see, then their indices
 bool CWaypointVisibilityTable :: SaveToFile ( void )
 {
     char filename[1024];
 	wpt_vis_header_t header;
+	int iMagic = WPT_VIS_SPARSE_MAGIC;
+	int iNumWaypoints = CWaypoints::numWaypoints();
+	std::vector<unsigned short int> visible;
+	CBotSaveBuffer buffer;
 
 	CBotGlobals::buildFileName(filename,CBotGlobals::getMapName(),BOT_WAYPOINT_FOLDER,"rcv",true);
 
-	FILE *bfp = CBotGlobals::openFile(filename,"wb");
-
-   if ( bfp == NULL )
-   {
-	   CBotGlobals::botMessage(NULL,0,"Can't open Waypoint Visibility table for writing!");
-	   return false;
-   }
-
-	header.numwaypoints = CWaypoints::numWaypoints();
+	memset(&header,0,sizeof(wpt_vis_header_t));
+	header.numwaypoints = iNumWaypoints;
 	strncpy(header.szMapName,CBotGlobals::getMapName(),63);
 	header.waypoint_version = CWaypoints::WAYPOINT_VERSION;
 
-	fwrite(&header,sizeof(wpt_vis_header_t),1,bfp);
-	fwrite(m_VisTable,sizeof(byte),g_iMaxVisibilityByte,bfp);
+	buffer.write(&header,sizeof(wpt_vis_header_t),1);
+	buffer.write(&iMagic,sizeof(int),1);
 
-   fclose(bfp);
+	for ( int i = 0; i < iNumWaypoints; i ++ )
+	{
+		unsigned short int iCount;
+
+		visible.clear();
+
+		if ( i < (int)m_Rows.size() )
+		{
+			wpt_vis_row_t *pRow = &m_Rows[i];
+
+			if ( pRow->bits.empty() )
+				visible = pRow->visible;
+			else
+			{
+				for ( int j = 0; (j < iNumWaypoints) && ((j>>3) < (int)pRow->bits.size()); j ++ )
+				{
+					if ( pRow->bits[j>>3] & (1<<(j&7)) )
+						visible.push_back((unsigned short int)j);
+				}
+			}
+		}
+
+		iCount = (unsigned short int)visible.size();
 
-   return true;
+		buffer.write(&iCount,sizeof(unsigned short int),1);
+
+		if ( iCount > 0 )
+			buffer.write(&visible[0],sizeof(unsigned short int),iCount);
+	}
+
+	// failures are reported when the worker gets to it
+	CBotPersist::save(filename,buffer);
+
+	return true;
+}
+
+// the old 1024 x 1024 bit table, converted as it's read
+bool CWaypointVisibilityTable :: readLegacy ( FILE *bfp, int numwaypoints )
+{
+	unsigned char row[WPT_VIS_LEGACY_WAYPOINTS/8];
+
+	if ( numwaypoints > WPT_VIS_LEGACY_WAYPOINTS )
+		return false;
+
+	for ( int i = 0; i < numwaypoints; i ++ )
+	{
+		if ( fread(row,sizeof(unsigned char),sizeof(row),bfp) != sizeof(row) )
+			return false;
+
+		for ( int j = 0; j < numwaypoints; j ++ )
+		{
+			if ( row[j>>3] & (1<<(j&7)) )
+				SetVisibilityFromTo(i,j,true);
+		}
+	}
+
+	return true;
 }
 
 bool CWaypointVisibilityTable :: ReadFromFile ( int numwaypoints )
 {
     char filename[1024];
+	long iFileSize;
+	int iMagic = 0;
+	bool bRead = true;
+	std::vector<unsigned short int> visible;
 
 	wpt_vis_header_t header;
 
 	CBotGlobals::buildFileName(filename,CBotGlobals::getMapName(),BOT_WAYPOINT_FOLDER,"rcv",true);
+	CBotPersist::wait(filename);
 
    FILE *bfp =  CBotGlobals::openFile(filename,"rb");
 
@@ -193,18 +360,65 @@ bool CWaypointVisibilityTable :: ReadFromFile ( int numwaypoints )
 	   return false;
    }
 
-   fread(&header,sizeof(wpt_vis_header_t),1,bfp);
+   fseek(bfp,0,SEEK_END);
+   iFileSize = ftell(bfp);
+   fseek(bfp,0,SEEK_SET);
 
-   if ( header.numwaypoints != numwaypoints )
-	   return false;
-   if ( header.waypoint_version != CWaypoints::WAYPOINT_VERSION )
-	   return false;
-   if ( strncmp(header.szMapName,CBotGlobals::getMapName(),63) )
+   if ( (fread(&header,sizeof(wpt_vis_header_t),1,bfp) != 1) ||
+	   (header.numwaypoints != numwaypoints) ||
+	   (header.waypoint_version != CWaypoints::WAYPOINT_VERSION) ||
+	   strncmp(header.szMapName,CBotGlobals::getMapName(),63) )
+   {
+	   fclose(bfp);
 	   return false;
+   }
+
+   ClearVisibilityTable();
 
-   fread(m_VisTable,sizeof(byte),g_iMaxVisibilityByte,bfp);
+   if ( iFileSize == (long)(sizeof(wpt_vis_header_t)+WPT_VIS_LEGACY_BYTES) )
+	   bRead = readLegacy(bfp,numwaypoints);
+   else if ( (fread(&iMagic,sizeof(int),1,bfp) != 1) || (iMagic != WPT_VIS_SPARSE_MAGIC) )
+	   bRead = false;
+   else
+   {
+	   for ( int i = 0; bRead && (i < numwaypoints); i ++ )
+	   {
+		   unsigned short int iCount;
+
+		   if ( (fread(&iCount,sizeof(unsigned short int),1,bfp) != 1) || (iCount > numwaypoints) )
+		   {
+			   bRead = false;
+			   break;
+		   }
+
+		   if ( iCount == 0 )
+			   continue;
+
+		   visible.resize(iCount);
+
+		   if ( fread(&visible[0],sizeof(unsigned short int),iCount,bfp) != iCount )
+		   {
+			   bRead = false;
+			   break;
+		   }
+
+		   for ( unsigned int j = 0; j < iCount; j ++ )
+		   {
+			   if ( visible[j] >= numwaypoints )
+			   {
+				   bRead = false;
+				   break;
+			   }
+
+			   SetVisibilityFromTo(i,visible[j],true);
+		   }
+	   }
+   }
 
    fclose(bfp);
 
-   return true;
-}
\ No newline at end of file
+   if ( !bRead )
+	   ClearVisibilityTable();
+
+   return bRead;
+}
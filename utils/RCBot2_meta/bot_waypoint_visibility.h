@@ -33,7 +33,13 @@
 
 #include "bot_waypoint.h"
 
-const int g_iMaxVisibilityByte = (CWaypoints::MAX_WAYPOINTS*CWaypoints::MAX_WAYPOINTS)/8; // divide by 8 bits, need byte number
+#include <algorithm>
+
+// .rcv files from before the sparse table : a 1024 x 1024 bit table
+#define WPT_VIS_LEGACY_WAYPOINTS 1024
+#define WPT_VIS_LEGACY_BYTES ((WPT_VIS_LEGACY_WAYPOINTS*WPT_VIS_LEGACY_WAYPOINTS)/8)
+// follows the header in sparse .rcv files
+#define WPT_VIS_SPARSE_MAGIC 0x53564352
 
 typedef struct
 {
@@ -42,25 +48,31 @@ typedef struct
 	char szMapName[64];
 }wpt_vis_header_t;
 
+// waypoints visible from one waypoint : a sorted list of indices until
+// a row of bits would take less memory, then the bits instead
+typedef struct
+{
+	std::vector<unsigned short int> visible;
+	std::vector<unsigned char> bits;
+}wpt_vis_row_t;
+
 class CWaypointVisibilityTable
 {
 public:
 	CWaypointVisibilityTable()
 	{
-		m_VisTable = NULL;
 		bWorkVisibility = false;
 		iCurFrom = 0;
 		iCurTo = 0;
 		m_iPrevPercent = 0;
 		m_fNextShowMessageTime = 0;
+		m_iNumPairs = 0;
 	}
 
 	void workVisibility ();
 
 	void init ()
 	{
-		int iSize = g_iMaxVisibilityByte;
-
 		/////////////////////////////
 		// for "concurrent" reading of 
 		// visibility throughout frames
@@ -70,11 +82,9 @@ public:
 		iCurTo = 0;
 		////////////////////////////
 
-		//create a heap...
-		m_VisTable = new unsigned char[iSize];
-
 		m_iPrevPercent = 0;
-		memset(m_VisTable,0,iSize);
+		m_Rows.clear();
+		m_iNumPairs = 0;
 	}
 
 	bool SaveToFile ( void );
@@ -85,26 +95,24 @@ public:
 
 	bool GetVisibilityFromTo ( int iFrom, int iTo )
 	{
-		// work out the position 
-		int iPosition = (iFrom*CWaypoints::MAX_WAYPOINTS)+iTo;
+		if ( (iFrom < 0) || (iTo < 0) || (iFrom >= (int)m_Rows.size()) )
+			return false;
 
-		int iByte = (int)(iPosition/8);
-		int iBit = iPosition%8;
+		const wpt_vis_row_t *pRow = &m_Rows[iFrom];
 
-		if ( iByte < g_iMaxVisibilityByte )
-		{			
-			unsigned char *ToReturn = (m_VisTable+iByte);
-			
-			return ( (*ToReturn & (1<<iBit)) > 0 );
-		}
+		if ( !pRow->bits.empty() )
+			return ((iTo>>3) < (int)pRow->bits.size()) && ((pRow->bits[iTo>>3] & (1<<(iTo&7))) != 0);
 
-		return false;
+		return std::binary_search(pRow->visible.begin(),pRow->visible.end(),(unsigned short int)iTo);
 	}
 
+	// every waypoint iFrom can see, a whole row of the table at once
+	void GetVisibleFrom ( int iFrom, CWaypointBits *pBits );
+
 	void ClearVisibilityTable ( void )
 	{
-		if ( m_VisTable )
-			memset(m_VisTable,0,g_iMaxVisibilityByte);
+		m_Rows.clear();
+		m_iNumPairs = 0;
 
 		/////////////////////////////
 		// for "concurrent" reading of 
@@ -117,11 +125,8 @@ public:
 
 	void FreeVisibilityTable ( void )
 	{
-		if ( m_VisTable != NULL )
-		{
-			delete m_VisTable;
-			m_VisTable = NULL;
-		}
+		std::vector<wpt_vis_row_t>().swap(m_Rows);
+		m_iNumPairs = 0;
 
 		/////////////////////////////
 		// for "concurrent" reading of 
@@ -132,38 +137,28 @@ public:
 		////////////////////////////
 	}
 
-	void SetVisibilityFromTo ( int iFrom, int iTo, bool bVisible )
-	{
-		int iPosition = (iFrom*CWaypoints::MAX_WAYPOINTS)+iTo;
-
-		int iByte = (int)(iPosition/8);
-		int iBit = iPosition%8;
-
-		if ( iByte < g_iMaxVisibilityByte )
-		{
-			unsigned char *ToChange = (m_VisTable+iByte);
-			
-			if ( bVisible )
-				*ToChange |= (1<<iBit);
-			else
-				*ToChange &= ~(1<<iBit);
-		}
-	}
+	void SetVisibilityFromTo ( int iFrom, int iTo, bool bVisible );
 
 	void WorkOutVisibilityTable ( );
 
 	inline bool needToWorkVisibility() { return bWorkVisibility; }
 	inline void setWorkVisiblity ( bool bSet ) { bWorkVisibility = bSet; }
 
+	inline unsigned int numVisiblePairs () { return m_iNumPairs; }
+	// bytes held by the rows
+	unsigned int memoryUsed ();
+
 private:
+	void useBits ( wpt_vis_row_t *pRow );
+	bool readLegacy ( FILE *bfp, int numwaypoints );
 
 	bool bWorkVisibility;
 	unsigned short int iCurFrom;
 	unsigned short int iCurTo;
 	static const int WAYPOINT_VIS_TICKS = 64;
-	unsigned char *m_VisTable;
+	std::vector<wpt_vis_row_t> m_Rows;
+	unsigned int m_iNumPairs;
 	float m_fNextShowMessageTime;
 	int m_iPrevPercent;
-	// use a heap of 1 byte * size to keep things simple.
 };
 #endif
\ No newline at end of file
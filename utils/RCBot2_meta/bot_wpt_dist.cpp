@@ -3,16 +3,24 @@
 #include "bot_wpt_dist.h"
 #include "bot_globals.h"
 #include "bot_waypoint.h"
+#include "bot_persist.h"
 
 typedef struct
 {
 	int version;
 	int numwaypoints;
-	int maxwaypoints;
+	int numpairs; // followed by numpairs of wpt_dist_pair_t
 }wpt_dist_hdr_t;
 
-int CWaypointDistances::m_Distances [CWaypoints::MAX_WAYPOINTS][CWaypoints::MAX_WAYPOINTS];
+typedef struct
+{
+	unsigned int key;
+	int distance;
+}wpt_dist_pair_t;
+
+std::unordered_map<unsigned int,int> CWaypointDistances::m_Distances;
 float CWaypointDistances::m_fSaveTime = 0;
+bool CWaypointDistances::m_bReadOnly = false;
 
 void CWaypointDistances :: load ()
 {
@@ -23,6 +31,7 @@ void CWaypointDistances :: load ()
 	if ( szMapName  && *szMapName )
 	{
 		CBotGlobals::buildFileName(filename,szMapName,BOT_WAYPOINT_FOLDER,BOT_WAYPOINT_DST_EXTENSION,true);
+		CBotPersist::wait(filename);
 
 		FILE *bfp = CBotGlobals::openFile(filename,"rb");
 
@@ -31,11 +40,20 @@ void CWaypointDistances :: load ()
 			return; // give up
 		}
 
-		fread(&hdr,sizeof(wpt_dist_hdr_t),1,bfp);
-
-		if ( (hdr.maxwaypoints == CWaypoints::MAX_WAYPOINTS) && (hdr.numwaypoints == CWaypoints::numWaypoints()) && (hdr.version == WPT_DIST_VER) )
+		// older versions held the whole table, they're just thrown away
+		if ( (fread(&hdr,sizeof(wpt_dist_hdr_t),1,bfp) == 1) && (hdr.numwaypoints == CWaypoints::numWaypoints()) && (hdr.version == WPT_DIST_VER) &&
+			(hdr.numpairs >= 0) && (hdr.numpairs <= WPT_DIST_MAX_PAIRS) )
 		{
-			fread(m_Distances,sizeof(int),CWaypoints::MAX_WAYPOINTS * CWaypoints::MAX_WAYPOINTS,bfp);
+			wpt_dist_pair_t pair;
+
+			m_Distances.clear();
+			m_Distances.reserve(hdr.numpairs);
+
+			for ( int i = 0; (i < hdr.numpairs) && (fread(&pair,sizeof(wpt_dist_pair_t),1,bfp) == 1); i ++ )
+			{
+				if ( ((int)(pair.key>>16) < hdr.numwaypoints) && ((int)(pair.key&0xFFFF) < hdr.numwaypoints) )
+					m_Distances[pair.key] = pair.distance;
+			}
 		}
 
 		m_fSaveTime = engine->Time() + 100.0f;
@@ -54,36 +72,41 @@ void CWaypointDistances :: save ()
 		if ( szMapName && *szMapName )
 		{
 			wpt_dist_hdr_t hdr;
+			CBotSaveBuffer buffer;
 
 			CBotGlobals::buildFileName(filename,szMapName,BOT_WAYPOINT_FOLDER,BOT_WAYPOINT_DST_EXTENSION,true);
 
-			FILE *bfp = CBotGlobals::openFile(filename,"wb");
+			hdr.numpairs = m_Distances.size();
+			hdr.numwaypoints = CWaypoints::numWaypoints();
+			hdr.version = WPT_DIST_VER;
+
+			buffer.reserve(sizeof(wpt_dist_hdr_t) + (hdr.numpairs*sizeof(wpt_dist_pair_t)));
+			buffer.write(&hdr,sizeof(wpt_dist_hdr_t),1);
 
-			if ( bfp == NULL )
+			for ( std::unordered_map<unsigned int,int>::iterator it = m_Distances.begin(); it != m_Distances.end(); ++ it )
 			{
-				m_fSaveTime = engine->Time() + 100.0f;
-				return; // give up
-			}
+				wpt_dist_pair_t pair;
 
-			hdr.maxwaypoints = CWaypoints::MAX_WAYPOINTS;
-			hdr.numwaypoints = CWaypoints::numWaypoints();
-			hdr.version = WPT_DIST_VER;
+				pair.key = it->first;
+				pair.distance = it->second;
 
-			fwrite(&hdr,sizeof(wpt_dist_hdr_t),1,bfp);
+				buffer.write(&pair,sizeof(wpt_dist_pair_t),1);
+			}
 
-			fwrite(m_Distances,sizeof(int),CWaypoints::MAX_WAYPOINTS * CWaypoints::MAX_WAYPOINTS,bfp);
+			// written on the worker, the table can change straight away
+			CBotPersist::save(filename,buffer);
 
 			m_fSaveTime = engine->Time() + 100.0f;
-
-			fclose(bfp);
 		}
 	//}
 }
 
 float CWaypointDistances :: getDistance ( int iFrom, int iTo )
 {
-	if ( m_Distances[iFrom][iTo] == -1 )
+	std::unordered_map<unsigned int,int>::iterator it = m_Distances.find(key(iFrom,iTo));
+
+	if ( it == m_Distances.end() )
 		return (CWaypoints::getWaypoint(iFrom)->getOrigin()-CWaypoints::getWaypoint(iTo)->getOrigin()).Length();
 
-	return (float)m_Distances[iFrom][iTo];
+	return (float)it->second;
 }
\ No newline at end of file
@@ -3,10 +3,15 @@
 
 #include "bot_waypoint.h"
 
-#define WPT_DIST_VER 0x03
+#include <unordered_map>
+
+#define WPT_DIST_VER 0x04
 
 #define BOT_WAYPOINT_DST_EXTENSION "rcd"
 
+// route distances found between waypoints, only the pairs searched so far are kept
+#define WPT_DIST_MAX_PAIRS 262144
+
 class CWaypointDistances
 {
 public:
@@ -19,12 +24,26 @@ public:
 
 	static inline bool isSet ( int iFrom, int iTo )
 	{
-		return m_Distances[iFrom][iTo] >= 0;
+		return m_Distances.find(key(iFrom,iTo)) != m_Distances.end();
 	}
 
 	static inline void setDistance ( int iFrom, int iTo, float fDist )
 	{
-		m_Distances[iFrom][iTo] = (int)fDist;
+		if ( m_bReadOnly )
+			return;
+
+		// full : keep updating the pairs already known
+		if ( m_Distances.size() >= WPT_DIST_MAX_PAIRS )
+		{
+			std::unordered_map<unsigned int,int>::iterator it = m_Distances.find(key(iFrom,iTo));
+
+			if ( it != m_Distances.end() )
+				it->second = (int)fDist;
+
+			return;
+		}
+
+		m_Distances[key(iFrom,iTo)] = (int)fDist;
 	}
 
 	static void load ();
@@ -33,11 +52,22 @@ public:
 
 	static void reset ()
 	{
-		memset(m_Distances,0xFF,sizeof(int)*CWaypoints::MAX_WAYPOINTS*CWaypoints::MAX_WAYPOINTS);
+		m_Distances.clear();
 	}
+
+	static inline unsigned int numPairs () { return m_Distances.size(); }
+
+	// benchmarks and replays search routes without filling the cache
+	static inline void setReadOnly ( bool bReadOnly ) { m_bReadOnly = bReadOnly; }
 private:
-	static int m_Distances [CWaypoints::MAX_WAYPOINTS][CWaypoints::MAX_WAYPOINTS];
+	static inline unsigned int key ( int iFrom, int iTo )
+	{
+		return (((unsigned int)iFrom)<<16) | ((unsigned int)iTo & 0xFFFF);
+	}
+
+	static std::unordered_map<unsigned int,int> m_Distances;
 	static float m_fSaveTime;
+	static bool m_bReadOnly;
 
 };
 